@@ -0,0 +1,97 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/serialize/database.hpp"
+#include "electroslag/animation/animation_clip.hpp"
+
+namespace electroslag {
+    namespace animation {
+        animation_clip::animation_clip(serialize::archive_reader_interface* ar)
+            : m_duration(0.0f)
+        {
+            int32_t channel_count = 0;
+            if (!ar->read_int32("channel_count", &channel_count) || channel_count < 0) {
+                throw load_object_failure("channel_count");
+            }
+            m_channels.reserve(channel_count);
+
+            serialize::database* db = serialize::get_database();
+            std::string channel_name;
+            serialize::enumeration_namer namer(channel_count, 'c');
+            while (!namer.used_all_names()) {
+                channel_name = namer.get_next_name();
+
+                unsigned long long target_hash = 0;
+                if (!ar->read_name_hash(channel_name + "_target", &target_hash)) {
+                    throw load_object_failure("target");
+                }
+
+                uint64_t property_hash = 0;
+                if (!ar->read_uint64(channel_name + "_property", &property_hash)) {
+                    throw load_object_failure("property");
+                }
+
+                unsigned long long track_hash = 0;
+                if (!ar->read_name_hash(channel_name + "_track", &track_hash)) {
+                    throw load_object_failure("track");
+                }
+
+                insert_channel(target_hash, property_hash, db->find_object_ref<keyframe_track>(track_hash));
+            }
+        }
+
+        void animation_clip::save_to_archive(serialize::archive_writer_interface* ar)
+        {
+            channel_vector::iterator c(m_channels.begin());
+            while (c != m_channels.end()) {
+                c->track->save_to_archive(ar);
+                ++c;
+            }
+
+            serializable_object::save_to_archive(ar);
+
+            int channel_count = get_channel_count();
+            ar->write_int32("channel_count", channel_count);
+
+            std::string channel_name;
+            serialize::enumeration_namer namer(channel_count, 'c');
+            c = m_channels.begin();
+            while (c != m_channels.end()) {
+                channel_name = namer.get_next_name();
+
+                ar->write_name_hash(channel_name + "_target", c->target_hash);
+                ar->write_uint64(channel_name + "_property", c->property_hash);
+                ar->write_name_hash(channel_name + "_track", c->track->get_hash());
+
+                ++c;
+            }
+        }
+
+        void animation_clip::insert_channel(
+            unsigned long long target_hash,
+            unsigned long long property_hash,
+            keyframe_track::ref const& track
+            )
+        {
+            if (!track.is_valid()) {
+                throw parameter_failure("track");
+            }
+
+            m_channels.emplace_back(target_hash, property_hash, track);
+            m_duration = max(m_duration, track->get_duration());
+        }
+    }
+}
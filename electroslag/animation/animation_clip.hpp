@@ -0,0 +1,98 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/serialize/serializable_object.hpp"
+#include "electroslag/serialize/archive_interface.hpp"
+#include "electroslag/animation/keyframe_track.hpp"
+
+namespace electroslag {
+    namespace animation {
+        // A set of tracks played together, each driving one property of a named target.
+        class animation_clip
+            : public referenced_object
+            , public serialize::serializable_object<animation_clip> {
+        public:
+            typedef reference<animation_clip> ref;
+
+            struct channel {
+                channel(
+                    unsigned long long new_target_hash,
+                    unsigned long long new_property_hash,
+                    keyframe_track::ref const& new_track
+                    )
+                    : target_hash(new_target_hash)
+                    , property_hash(new_property_hash)
+                    , track(new_track)
+                {}
+
+                unsigned long long target_hash;
+                unsigned long long property_hash;
+                keyframe_track::ref track;
+            };
+        private:
+            typedef std::vector<channel> channel_vector;
+        public:
+            typedef channel_vector::const_iterator const_channel_iterator;
+
+            static ref create()
+            {
+                return (ref(new animation_clip()));
+            }
+
+            // Implement serializable_object
+            explicit animation_clip(serialize::archive_reader_interface* ar);
+            virtual void save_to_archive(serialize::archive_writer_interface* ar);
+
+            void insert_channel(
+                unsigned long long target_hash,
+                unsigned long long property_hash,
+                keyframe_track::ref const& track
+                );
+
+            const_channel_iterator begin_channels() const
+            {
+                return (m_channels.begin());
+            }
+
+            const_channel_iterator end_channels() const
+            {
+                return (m_channels.end());
+            }
+
+            int get_channel_count() const
+            {
+                return (static_cast<int>(m_channels.size()));
+            }
+
+            float get_duration() const
+            {
+                return (m_duration);
+            }
+
+        private:
+            animation_clip()
+                : m_duration(0.0f)
+            {}
+
+            channel_vector m_channels;
+            float m_duration;
+
+            // Disallowed operations:
+            explicit animation_clip(animation_clip const&);
+            animation_clip& operator =(animation_clip const&);
+        };
+    }
+}
@@ -29,7 +29,7 @@ namespace electroslag {
             virtual ~constant_value_controller()
             {}
 
-            virtual property_value_state update_value(int /*millisec_elapsed*/, value_type* in_out_value)
+            virtual property_value_state update_value(double /*millisec_elapsed*/, value_type* in_out_value)
             {
                 if (*in_out_value != m_value) {
                     *in_out_value = m_value;
@@ -40,6 +40,13 @@ namespace electroslag {
                 }
             }
 
+            virtual bool get_batch_parameters(property_batch_kind* out_kind, value_type* out_parameter) const
+            {
+                *out_kind = property_batch_kind_constant;
+                *out_parameter = m_value;
+                return (true);
+            }
+
         protected:
             explicit constant_value_controller(value_type const& value)
                 : m_value(value)
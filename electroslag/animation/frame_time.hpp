@@ -0,0 +1,131 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+
+namespace electroslag {
+    namespace animation {
+        // The most frames that can be in flight at once; state read by a frame's work
+        // items is kept once per frame slot.
+        static constexpr int const max_frame_slots = 4;
+
+        // How much time a frame of animation covers. Without a fixed step, properties
+        // advance by millisec_elapsed. With one, properties advance in whole steps of
+        // fixed_step_millisec and present a blend of their last two steps.
+        struct frame_time {
+            frame_time()
+                : millisec_elapsed(0.0)
+                , fixed_step_millisec(0.0)
+                , fixed_steps(0)
+                , interpolation(1.0f)
+                , frame_slot(0)
+            {}
+
+            bool is_fixed_step() const
+            {
+                return (fixed_step_millisec > 0.0);
+            }
+
+            double millisec_elapsed;
+            double fixed_step_millisec;
+            int fixed_steps;
+            float interpolation;
+
+            // Which frame slot, in [0, max_frame_slots), the frame is using.
+            int frame_slot;
+        };
+
+        // Accumulates frame time and turns it into a whole number of fixed steps,
+        // so animation cost and results don't depend on the render rate.
+        class fixed_step_accumulator {
+        public:
+            static int const default_max_steps = 8;
+
+            fixed_step_accumulator()
+                : m_step_millisec(0.0)
+                , m_accumulated_millisec(0.0)
+                , m_max_steps(default_max_steps)
+            {}
+
+            bool is_enabled() const
+            {
+                return (m_step_millisec > 0.0);
+            }
+
+            double get_step_millisec() const
+            {
+                return (m_step_millisec);
+            }
+
+            // Zero or less disables fixed stepping.
+            void set_step_millisec(double step_millisec)
+            {
+                m_step_millisec = (step_millisec > 0.0) ? step_millisec : 0.0;
+                m_accumulated_millisec = 0.0;
+            }
+
+            int get_max_steps() const
+            {
+                return (m_max_steps);
+            }
+
+            void set_max_steps(int max_steps)
+            {
+                ELECTROSLAG_CHECK(max_steps > 0);
+                m_max_steps = max_steps;
+            }
+
+            void reset()
+            {
+                m_accumulated_millisec = 0.0;
+            }
+
+            frame_time advance(double millisec_elapsed)
+            {
+                frame_time time;
+                time.millisec_elapsed = millisec_elapsed;
+
+                if (!is_enabled()) {
+                    return (time);
+                }
+
+                m_accumulated_millisec += millisec_elapsed;
+
+                int steps = static_cast<int>(m_accumulated_millisec / m_step_millisec);
+                if (steps > m_max_steps) {
+                    // Too far behind to catch up; drop the excess rather than
+                    // spending ever longer frames on simulation.
+                    steps = m_max_steps;
+                    m_accumulated_millisec = m_step_millisec * steps;
+                }
+                m_accumulated_millisec -= m_step_millisec * steps;
+
+                time.fixed_step_millisec = m_step_millisec;
+                time.fixed_steps = steps;
+                time.interpolation = static_cast<float>(m_accumulated_millisec / m_step_millisec);
+                return (time);
+            }
+
+        private:
+            double m_step_millisec;
+            double m_accumulated_millisec;
+            int m_max_steps;
+
+            // Disallowed operations:
+            explicit fixed_step_accumulator(fixed_step_accumulator const&);
+            fixed_step_accumulator& operator =(fixed_step_accumulator const&);
+        };
+    }
+}
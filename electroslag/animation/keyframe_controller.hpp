@@ -0,0 +1,106 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/animation/property_controller_typed_interface.hpp"
+#include "electroslag/animation/keyframe_track.hpp"
+
+namespace electroslag {
+    namespace animation {
+        inline void keyframe_value_from_floats(float const* v, float* out_value)
+        {
+            *out_value = v[0];
+        }
+
+        inline void keyframe_value_from_floats(float const* v, glm::f32vec2* out_value)
+        {
+            *out_value = glm::f32vec2(v[0], v[1]);
+        }
+
+        inline void keyframe_value_from_floats(float const* v, glm::f32vec3* out_value)
+        {
+            *out_value = glm::f32vec3(v[0], v[1], v[2]);
+        }
+
+        inline void keyframe_value_from_floats(float const* v, glm::f32vec4* out_value)
+        {
+            *out_value = glm::f32vec4(v[0], v[1], v[2], v[3]);
+        }
+
+        inline void keyframe_value_from_floats(float const* v, glm::f32quat* out_value)
+        {
+            // Tracks store quaternions x, y, z, w.
+            *out_value = glm::f32quat(v[3], v[0], v[1], v[2]);
+        }
+
+        // Plays a keyframe track, optionally looping, on a single property.
+        template<class T>
+        class keyframe_controller : public property_controller_typed_interface<T> {
+        public:
+            static property_controller_interface::ref create(keyframe_track::ref const& track, bool loop)
+            {
+                return (property_controller_interface::ref(new keyframe_controller(track, loop)));
+            }
+
+            virtual ~keyframe_controller()
+            {}
+
+            virtual property_value_state update_value(double millisec_elapsed, value_type* in_out_value)
+            {
+                m_time += static_cast<float>(millisec_elapsed / 1000.0);
+
+                float duration = m_track->get_duration();
+                if (m_loop && duration > 0.0f && m_time > duration) {
+                    m_time = std::fmod(m_time, duration);
+                }
+
+                float v[keyframe_track::max_components];
+                m_track->sample(m_time, &m_cursor, v);
+
+                value_type new_value;
+                keyframe_value_from_floats(v, &new_value);
+                if (new_value != *in_out_value) {
+                    *in_out_value = new_value;
+                    return (property_value_state_changed);
+                }
+                else {
+                    return (property_value_state_no_change);
+                }
+            }
+
+        protected:
+            keyframe_controller(keyframe_track::ref const& track, bool loop)
+                : m_track(track)
+                , m_time(0.0f)
+                , m_loop(loop)
+            {
+                if (!m_track.is_valid() || m_track->get_component_count() * sizeof(float) != sizeof(value_type)) {
+                    throw parameter_failure("track");
+                }
+            }
+
+        private:
+            keyframe_track::ref m_track;
+            keyframe_cursor m_cursor;
+            float m_time;
+            bool m_loop;
+
+            // Disallowed operations:
+            keyframe_controller();
+            explicit keyframe_controller(keyframe_controller const&);
+            keyframe_controller& operator =(keyframe_controller const&);
+        };
+    }
+}
@@ -0,0 +1,105 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/animation/keyframe_times.hpp"
+
+namespace electroslag {
+    namespace animation {
+        keyframe_times::keyframe_times(serialize::archive_reader_interface* ar)
+        {
+            int key_count = 0;
+            if (!ar->read_int32("key_count", &key_count) || key_count <= 0) {
+                throw load_object_failure("key_count");
+            }
+
+            m_times.resize(key_count);
+            if (!ar->read_buffer("times", m_times.data(), key_count * sizeof(float))) {
+                throw load_object_failure("times");
+            }
+
+            check_times();
+        }
+
+        keyframe_times::keyframe_times(float const* times, int key_count)
+        {
+            if (key_count <= 0) {
+                throw parameter_failure("key_count");
+            }
+
+            m_times.assign(times, times + key_count);
+            check_times();
+        }
+
+        void keyframe_times::save_to_archive(serialize::archive_writer_interface* ar)
+        {
+            serializable_object::save_to_archive(ar);
+
+            int key_count = get_key_count();
+            ar->write_int32("key_count", key_count);
+            ar->write_buffer("times", m_times.data(), key_count * sizeof(float));
+        }
+
+        int keyframe_times::locate(float time, keyframe_cursor* cursor, float* out_fraction) const
+        {
+            int key_count = get_key_count();
+            int key = cursor->key;
+            if (key < 0 || key >= key_count) {
+                key = 0;
+            }
+
+            if (time <= m_times[0]) {
+                key = 0;
+                *out_fraction = 0.0f;
+            }
+            else if (time >= m_times[key_count - 1]) {
+                key = key_count - 1;
+                *out_fraction = 0.0f;
+            }
+            else {
+                // Playback usually stays inside the cached key or moves to the next one.
+                if (time < m_times[key]) {
+                    key = static_cast<int>(std::upper_bound(m_times.begin(), m_times.end(), time) - m_times.begin()) - 1;
+                }
+                else if (time >= m_times[key + 1]) {
+                    if (key + 2 < key_count && time < m_times[key + 2]) {
+                        key += 1;
+                    }
+                    else {
+                        key = static_cast<int>(std::upper_bound(m_times.begin() + key + 1, m_times.end(), time) - m_times.begin()) - 1;
+                    }
+                }
+
+                float key_time = m_times[key];
+                *out_fraction = (time - key_time) / (m_times[key + 1] - key_time);
+            }
+
+            cursor->key = key;
+            return (key);
+        }
+
+        void keyframe_times::check_times() const
+        {
+            // Keys must be strictly increasing for locate to work.
+            std::vector<float>::const_iterator t(m_times.begin() + 1);
+            while (t != m_times.end()) {
+                if (*t <= *(t - 1)) {
+                    throw parameter_failure("keyframe times must increase");
+                }
+                ++t;
+            }
+        }
+    }
+}
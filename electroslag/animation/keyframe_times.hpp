@@ -0,0 +1,79 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/serialize/serializable_object.hpp"
+#include "electroslag/serialize/archive_interface.hpp"
+
+namespace electroslag {
+    namespace animation {
+        // Remembers where the last sample landed, so playback that moves forward
+        // in time finds its keys without searching.
+        struct keyframe_cursor {
+            keyframe_cursor()
+                : key(0)
+            {}
+
+            int key;
+        };
+
+        // Key times in seconds, shared by every track keyed at the same times.
+        class keyframe_times
+            : public referenced_object
+            , public serialize::serializable_object<keyframe_times> {
+        public:
+            typedef reference<keyframe_times> ref;
+
+            static ref create(float const* times, int key_count)
+            {
+                return (ref(new keyframe_times(times, key_count)));
+            }
+
+            // Implement serializable_object
+            explicit keyframe_times(serialize::archive_reader_interface* ar);
+            virtual void save_to_archive(serialize::archive_writer_interface* ar);
+
+            int get_key_count() const
+            {
+                return (static_cast<int>(m_times.size()));
+            }
+
+            float get_time(int key) const
+            {
+                return (m_times[key]);
+            }
+
+            float get_duration() const
+            {
+                return (m_times.back());
+            }
+
+            // Find the key at or before time, and how far time is toward the next key.
+            int locate(float time, keyframe_cursor* cursor, float* out_fraction) const;
+
+        private:
+            keyframe_times(float const* times, int key_count);
+
+            void check_times() const;
+
+            std::vector<float> m_times;
+
+            // Disallowed operations:
+            keyframe_times();
+            explicit keyframe_times(keyframe_times const&);
+            keyframe_times& operator =(keyframe_times const&);
+        };
+    }
+}
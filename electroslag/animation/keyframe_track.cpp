@@ -0,0 +1,262 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/serialize/database.hpp"
+#include "electroslag/animation/keyframe_track.hpp"
+
+namespace electroslag {
+    namespace animation {
+        keyframe_track::keyframe_track(serialize::archive_reader_interface* ar)
+            : m_value_type(keyframe_value_type_unknown)
+            , m_interpolation(keyframe_interpolation_unknown)
+            , m_component_count(0)
+        {
+            unsigned long long times_hash = 0;
+            if (!ar->read_name_hash("times", &times_hash)) {
+                throw load_object_failure("times");
+            }
+            m_times = serialize::get_database()->find_object_ref<keyframe_times>(times_hash);
+
+            if (!ar->read_enumeration("value_type", &m_value_type, keyframe_value_type_strings)) {
+                throw load_object_failure("value_type");
+            }
+            m_component_count = get_value_type_components(m_value_type);
+
+            if (!ar->read_enumeration("interpolation", &m_interpolation, keyframe_interpolation_strings)) {
+                throw load_object_failure("interpolation");
+            }
+
+            if (!ar->read_buffer("range_min", m_range_min, sizeof(m_range_min))) {
+                throw load_object_failure("range_min");
+            }
+
+            if (!ar->read_buffer("range_scale", m_range_scale, sizeof(m_range_scale))) {
+                throw load_object_failure("range_scale");
+            }
+
+            int key_values = m_times->get_key_count() * get_values_per_key() * m_component_count;
+            m_keys.resize(key_values);
+            if (!ar->read_buffer("keys", m_keys.data(), key_values * sizeof(uint16_t))) {
+                throw load_object_failure("keys");
+            }
+        }
+
+        keyframe_track::keyframe_track(
+            keyframe_times::ref const& times,
+            keyframe_value_type value_type,
+            keyframe_interpolation interpolation,
+            float const* values
+            )
+            : m_times(times)
+            , m_value_type(value_type)
+            , m_interpolation(interpolation)
+            , m_component_count(get_value_type_components(value_type))
+        {
+            if (!m_times.is_valid()) {
+                throw parameter_failure("times");
+            }
+
+            if (interpolation <= keyframe_interpolation_unknown || interpolation >= keyframe_interpolation_count) {
+                throw parameter_failure("interpolation");
+            }
+
+            // Find each component's range across every key (and tangent.)
+            int key_values = m_times->get_key_count() * get_values_per_key() * m_component_count;
+            for (int c = 0; c < max_components; ++c) {
+                m_range_min[c] = 0.0f;
+                m_range_scale[c] = 0.0f;
+            }
+
+            float range_max[max_components];
+            for (int c = 0; c < m_component_count; ++c) {
+                m_range_min[c] = values[c];
+                range_max[c] = values[c];
+            }
+
+            for (int v = 0; v < key_values; ++v) {
+                int c = v % m_component_count;
+                m_range_min[c] = min(m_range_min[c], values[v]);
+                range_max[c] = max(range_max[c], values[v]);
+            }
+
+            for (int c = 0; c < m_component_count; ++c) {
+                m_range_scale[c] = (range_max[c] - m_range_min[c]) / 65535.0f;
+            }
+
+            // Quantize with rounding to the nearest step.
+            m_keys.resize(key_values);
+            for (int v = 0; v < key_values; ++v) {
+                int c = v % m_component_count;
+                float q = 0.0f;
+                if (m_range_scale[c] > 0.0f) {
+                    q = ((values[v] - m_range_min[c]) / m_range_scale[c]) + 0.5f;
+                }
+                m_keys[v] = static_cast<uint16_t>(min(max(q, 0.0f), 65535.0f));
+            }
+        }
+
+        void keyframe_track::save_to_archive(serialize::archive_writer_interface* ar)
+        {
+            m_times->save_to_archive(ar);
+
+            serializable_object::save_to_archive(ar);
+
+            ar->write_name_hash("times", m_times->get_hash());
+            ar->write_int32("value_type", m_value_type);
+            ar->write_int32("interpolation", m_interpolation);
+            ar->write_buffer("range_min", m_range_min, sizeof(m_range_min));
+            ar->write_buffer("range_scale", m_range_scale, sizeof(m_range_scale));
+            ar->write_buffer("keys", m_keys.data(), static_cast<int>(m_keys.size() * sizeof(uint16_t)));
+        }
+
+        void keyframe_track::sample(float time, keyframe_cursor* cursor, float* out_value) const
+        {
+            float fraction = 0.0f;
+            int key = m_times->locate(time, cursor, &fraction);
+            evaluate(key, fraction, out_value);
+        }
+
+        // static
+        void keyframe_track::sample_tracks(
+            int track_count,
+            keyframe_track const* const* tracks,
+            float time,
+            keyframe_cursor* cursors,
+            float* const* out_values
+            )
+        {
+            keyframe_times const* last_times = 0;
+            int key = 0;
+            float fraction = 0.0f;
+
+            for (int t = 0; t < track_count; ++t) {
+                keyframe_track const* track = tracks[t];
+
+                // Tracks from one importer sampler set usually sit next to each other.
+                keyframe_times const* times = track->m_times.get_pointer();
+                if (times != last_times) {
+                    key = times->locate(time, &cursors[t], &fraction);
+                    last_times = times;
+                }
+                else {
+                    cursors[t].key = key;
+                }
+
+                track->evaluate(key, fraction, out_values[t]);
+            }
+        }
+
+        // static
+        int keyframe_track::get_value_type_components(keyframe_value_type value_type)
+        {
+            switch (value_type) {
+            case keyframe_value_type_float:
+                return (1);
+
+            case keyframe_value_type_vec2:
+                return (2);
+
+            case keyframe_value_type_vec3:
+                return (3);
+
+            case keyframe_value_type_vec4:
+            case keyframe_value_type_quat:
+                return (4);
+
+            default:
+                throw parameter_failure("value_type");
+            }
+        }
+
+        void keyframe_track::decode(int key, int value_in_key, float* out_value) const
+        {
+            uint16_t const* k = &m_keys[((key * get_values_per_key()) + value_in_key) * m_component_count];
+            for (int c = 0; c < m_component_count; ++c) {
+                out_value[c] = m_range_min[c] + (k[c] * m_range_scale[c]);
+            }
+        }
+
+        void keyframe_track::evaluate(int key, float fraction, float* out_value) const
+        {
+            bool quaternion = (m_value_type == keyframe_value_type_quat);
+            int last_key = m_times->get_key_count() - 1;
+
+            if (m_interpolation == keyframe_interpolation_step || key == last_key || fraction <= 0.0f) {
+                decode(key, (m_interpolation == keyframe_interpolation_cubic) ? 1 : 0, out_value);
+                if (quaternion) {
+                    glm::f32vec4 q(glm::normalize(glm::f32vec4(out_value[0], out_value[1], out_value[2], out_value[3])));
+                    out_value[0] = q.x; out_value[1] = q.y; out_value[2] = q.z; out_value[3] = q.w;
+                }
+                return;
+            }
+
+            float from[max_components];
+            float to[max_components];
+
+            if (m_interpolation == keyframe_interpolation_cubic) {
+                // Hermite spline; tangents are scaled by the time between keys.
+                float from_out_tangent[max_components];
+                float to_in_tangent[max_components];
+                decode(key, 1, from);
+                decode(key, 2, from_out_tangent);
+                decode(key + 1, 0, to_in_tangent);
+                decode(key + 1, 1, to);
+
+                float key_delta = m_times->get_time(key + 1) - m_times->get_time(key);
+                float t = fraction;
+                float t2 = t * t;
+                float t3 = t2 * t;
+                float h00 = (2.0f * t3) - (3.0f * t2) + 1.0f;
+                float h10 = (t3 - (2.0f * t2) + t) * key_delta;
+                float h01 = (-2.0f * t3) + (3.0f * t2);
+                float h11 = (t3 - t2) * key_delta;
+
+                for (int c = 0; c < m_component_count; ++c) {
+                    out_value[c] = (h00 * from[c]) + (h10 * from_out_tangent[c]) + (h01 * to[c]) + (h11 * to_in_tangent[c]);
+                }
+            }
+            else if (quaternion && m_interpolation == keyframe_interpolation_linear) {
+                decode(key, 0, from);
+                decode(key + 1, 0, to);
+                glm::f32quat from_q(glm::normalize(glm::f32quat(from[3], from[0], from[1], from[2])));
+                glm::f32quat to_q(glm::normalize(glm::f32quat(to[3], to[0], to[1], to[2])));
+
+                glm::f32quat q(glm::slerp(from_q, to_q, fraction));
+                out_value[0] = q.x; out_value[1] = q.y; out_value[2] = q.z; out_value[3] = q.w;
+                return;
+            }
+            else {
+                decode(key, 0, from);
+                decode(key + 1, 0, to);
+
+                // Keep nlerp on the shortest path.
+                float to_sign = 1.0f;
+                if (quaternion && ((from[0] * to[0]) + (from[1] * to[1]) + (from[2] * to[2]) + (from[3] * to[3])) < 0.0f) {
+                    to_sign = -1.0f;
+                }
+
+                for (int c = 0; c < m_component_count; ++c) {
+                    out_value[c] = from[c] + (((to[c] * to_sign) - from[c]) * fraction);
+                }
+            }
+
+            if (quaternion) {
+                glm::f32vec4 q(glm::normalize(glm::f32vec4(out_value[0], out_value[1], out_value[2], out_value[3])));
+                out_value[0] = q.x; out_value[1] = q.y; out_value[2] = q.z; out_value[3] = q.w;
+            }
+        }
+    }
+}
@@ -0,0 +1,153 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/serialize/serializable_object.hpp"
+#include "electroslag/serialize/archive_interface.hpp"
+#include "electroslag/animation/keyframe_times.hpp"
+
+namespace electroslag {
+    namespace animation {
+        enum keyframe_interpolation {
+            keyframe_interpolation_unknown = -1,
+            keyframe_interpolation_step,
+            keyframe_interpolation_linear, // Quaternions slerp.
+            keyframe_interpolation_nlerp,  // Quaternions normalized lerp; otherwise linear.
+            keyframe_interpolation_cubic,  // Hermite; each key stores in tangent, value, out tangent.
+            keyframe_interpolation_count // Ensure this is the last enum entry
+        };
+
+        static char const* const keyframe_interpolation_strings[keyframe_interpolation_count] = {
+            "keyframe_interpolation_step",
+            "keyframe_interpolation_linear",
+            "keyframe_interpolation_nlerp",
+            "keyframe_interpolation_cubic"
+        };
+
+        enum keyframe_value_type {
+            keyframe_value_type_unknown = -1,
+            keyframe_value_type_float,
+            keyframe_value_type_vec2,
+            keyframe_value_type_vec3,
+            keyframe_value_type_vec4,
+            keyframe_value_type_quat, // Stored x, y, z, w.
+            keyframe_value_type_count // Ensure this is the last enum entry
+        };
+
+        static char const* const keyframe_value_type_strings[keyframe_value_type_count] = {
+            "keyframe_value_type_float",
+            "keyframe_value_type_vec2",
+            "keyframe_value_type_vec3",
+            "keyframe_value_type_vec4",
+            "keyframe_value_type_quat"
+        };
+
+        // A curve of values over a shared set of key times. Values are quantized to
+        // 16 bits per component against the track's own range.
+        class keyframe_track
+            : public referenced_object
+            , public serialize::serializable_object<keyframe_track> {
+        public:
+            typedef reference<keyframe_track> ref;
+
+            static int const max_components = 4;
+
+            // values holds get_values_per_key() values for each key time.
+            static ref create(
+                keyframe_times::ref const& times,
+                keyframe_value_type value_type,
+                keyframe_interpolation interpolation,
+                float const* values
+                )
+            {
+                return (ref(new keyframe_track(times, value_type, interpolation, values)));
+            }
+
+            // Implement serializable_object
+            explicit keyframe_track(serialize::archive_reader_interface* ar);
+            virtual void save_to_archive(serialize::archive_writer_interface* ar);
+
+            keyframe_times::ref const& get_times() const
+            {
+                return (m_times);
+            }
+
+            keyframe_value_type get_value_type() const
+            {
+                return (m_value_type);
+            }
+
+            keyframe_interpolation get_interpolation() const
+            {
+                return (m_interpolation);
+            }
+
+            int get_component_count() const
+            {
+                return (m_component_count);
+            }
+
+            int get_values_per_key() const
+            {
+                return ((m_interpolation == keyframe_interpolation_cubic) ? 3 : 1);
+            }
+
+            float get_duration() const
+            {
+                return (m_times->get_duration());
+            }
+
+            // Writes get_component_count() floats.
+            void sample(float time, keyframe_cursor* cursor, float* out_value) const;
+
+            // Sample many tracks at one time; tracks that share key times share the key search.
+            static void sample_tracks(
+                int track_count,
+                keyframe_track const* const* tracks,
+                float time,
+                keyframe_cursor* cursors,
+                float* const* out_values
+                );
+
+        private:
+            keyframe_track(
+                keyframe_times::ref const& times,
+                keyframe_value_type value_type,
+                keyframe_interpolation interpolation,
+                float const* values
+                );
+
+            static int get_value_type_components(keyframe_value_type value_type);
+
+            void evaluate(int key, float fraction, float* out_value) const;
+            void decode(int key, int value_in_key, float* out_value) const;
+
+            keyframe_times::ref m_times;
+            keyframe_value_type m_value_type;
+            keyframe_interpolation m_interpolation;
+            int m_component_count;
+
+            // value = range_min + key * range_scale, per component.
+            float m_range_min[max_components];
+            float m_range_scale[max_components];
+            std::vector<uint16_t> m_keys;
+
+            // Disallowed operations:
+            keyframe_track();
+            explicit keyframe_track(keyframe_track const&);
+            keyframe_track& operator =(keyframe_track const&);
+        };
+    }
+}
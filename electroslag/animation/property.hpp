@@ -15,6 +15,9 @@
 
 #pragma once
 #include "electroslag/animation/property_controller_typed_interface.hpp"
+#include "electroslag/animation/frame_time.hpp"
+#include "electroslag/animation/property_pool.hpp"
+#include "electroslag/animation/property_manager.hpp"
 
 namespace electroslag {
     namespace animation {
@@ -26,12 +29,21 @@ namespace electroslag {
             typedef typename property_controller_typed_interface<T>::ref controller_ref;
 
             property()
+                : m_fixed_step(false)
+                , m_pool_slot(property_pool<T>::no_slot)
             {}
 
             explicit property(T const& initial_value)
                 : m_value(initial_value)
+                , m_fixed_step(false)
+                , m_pool_slot(property_pool<T>::no_slot)
             {}
 
+            ~property()
+            {
+                release_pool_slot();
+            }
+
             static unsigned long long get_name_hash()
             {
                 return (NameHash);
@@ -55,33 +67,95 @@ namespace electroslag {
             void reset_value(T const& reset_value)
             {
                 m_value = reset_value;
+                m_fixed_step = false;
                 clear_controller();
             }
 
-            property_value_state update(int millisec_elapsed)
+            property_value_state update(frame_time const& time)
             {
-                if (m_controller.is_valid()) {
-                    return (m_controller->update_value(millisec_elapsed, &m_value));
+                if (m_pool_slot != property_pool<T>::no_slot) {
+                    // The property manager already evaluated this frame's value.
+                    return (get_pool()->read_value(m_pool_slot, time.frame_slot, &m_value));
                 }
-                else {
+                else if (!m_controller.is_valid()) {
                     return (property_value_state_no_change);
                 }
+                else if (!time.is_fixed_step()) {
+                    m_fixed_step = false;
+                    return (m_controller->update_value(time.millisec_elapsed, &m_value));
+                }
+
+                // Step the controller at a fixed rate and present a blend of the
+                // last two steps, so motion stays smooth between steps.
+                if (!m_fixed_step) {
+                    m_previous_step_value = m_value;
+                    m_step_value = m_value;
+                    m_fixed_step = true;
+                }
+
+                property_value_state state = property_value_state_no_change;
+                for (int step = 0; step < time.fixed_steps; ++step) {
+                    m_previous_step_value = m_step_value;
+                    if (m_controller->update_value(time.fixed_step_millisec, &m_step_value) == property_value_state_changed) {
+                        state = property_value_state_changed;
+                    }
+                }
+
+                value_type presented_value(interpolate_property_value(m_previous_step_value, m_step_value, time.interpolation));
+                if (presented_value != m_value) {
+                    m_value = presented_value;
+                    state = property_value_state_changed;
+                }
+                return (state);
             }
 
             void clear_controller()
             {
+                release_pool_slot();
                 m_controller.reset();
+                m_fixed_step = false;
             }
 
             void set_controller(property_controller_interface::ref& controller)
             {
+                release_pool_slot();
                 m_controller = controller.cast<controller_type>();
+                m_fixed_step = false;
+
+                // Simple controllers are handed to a pool and evaluated in bulk.
+                property_batch_kind kind = property_batch_kind_unknown;
+                value_type parameter;
+                if (m_controller.is_valid() && m_controller->get_batch_parameters(&kind, &parameter)) {
+                    m_pool_slot = get_pool()->insert(kind, m_value, parameter);
+                    m_controller.reset();
+                }
             }
 
         private:
+            static property_pool<T>* get_pool()
+            {
+                return (get_property_manager_internal()->get_property_pool<T>());
+            }
+
+            void release_pool_slot()
+            {
+                if (m_pool_slot != property_pool<T>::no_slot) {
+                    get_pool()->release(m_pool_slot);
+                    m_pool_slot = property_pool<T>::no_slot;
+                }
+            }
+
             value_type m_value;
             controller_ref m_controller;
 
+            // Only used when updating with a fixed step.
+            value_type m_previous_step_value;
+            value_type m_step_value;
+            bool m_fixed_step;
+
+            // Handle in to the property manager's pool for batched controllers.
+            int m_pool_slot;
+
             // Disallowed operations:
             explicit property(property const&);
             property& operator =(property const&);
@@ -24,6 +24,14 @@ namespace electroslag {
             property_value_state_changed
         };
 
+        // Controllers that can be evaluated in bulk by the property manager.
+        enum property_batch_kind {
+            property_batch_kind_unknown = -1,
+            property_batch_kind_velocity,
+            property_batch_kind_constant,
+            property_batch_kind_count
+        };
+
         template<class T>
         class property_controller_typed_interface : public property_controller_interface {
         public:
@@ -33,7 +41,13 @@ namespace electroslag {
             virtual ~property_controller_typed_interface()
             {}
 
-            virtual property_value_state update_value(int millisec_elapsed, value_type* in_out_value) = 0;
+            virtual property_value_state update_value(double millisec_elapsed, value_type* in_out_value) = 0;
+
+            // Return true if the controller is fully described by a batch kind and parameter.
+            virtual bool get_batch_parameters(property_batch_kind* /*out_kind*/, value_type* /*out_parameter*/) const
+            {
+                return (false);
+            }
 
         protected:
             property_controller_typed_interface()
@@ -67,5 +67,15 @@ namespace electroslag {
             }
             m_pending_controller_changes.clear();
         }
+
+        void property_manager::evaluate_property_pools(frame_time const& time)
+        {
+            m_float_pool.evaluate(time);
+            m_vec2_pool.evaluate(time);
+            m_vec3_pool.evaluate(time);
+            m_vec4_pool.evaluate(time);
+            m_quat_pool.evaluate(time);
+            m_mat4_pool.evaluate(time);
+        }
     }
 }
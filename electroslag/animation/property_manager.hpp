@@ -16,6 +16,7 @@
 #pragma once
 #include "electroslag/threading/mutex.hpp"
 #include "electroslag/animation/property_manager_interface.hpp"
+#include "electroslag/animation/property_pool.hpp"
 
 namespace electroslag {
     namespace animation {
@@ -31,9 +32,24 @@ namespace electroslag {
 
             void apply_controller_changes();
 
+            // Evaluate every pooled property for the frame; properties read the results back.
+            void evaluate_property_pools(frame_time const& time);
+
+            template<class T>
+            property_pool<T>* get_property_pool();
+
         private:
             mutable threading::mutex m_mutex;
 
+            // Declared before the pending changes, which may hold the last reference
+            // to objects whose properties release pool slots.
+            property_pool<float> m_float_pool;
+            property_pool<glm::f32vec2> m_vec2_pool;
+            property_pool<glm::f32vec3> m_vec3_pool;
+            property_pool<glm::f32vec4> m_vec4_pool;
+            property_pool<glm::f32quat> m_quat_pool;
+            property_pool<glm::f32mat4> m_mat4_pool;
+
             enum controller_change_action {
                 controller_change_action_unknown = -1,
                 controller_change_action_set,
@@ -76,6 +92,42 @@ namespace electroslag {
             property_manager& operator =(property_manager const&);
         };
 
+        template<>
+        inline property_pool<float>* property_manager::get_property_pool<float>()
+        {
+            return (&m_float_pool);
+        }
+
+        template<>
+        inline property_pool<glm::f32vec2>* property_manager::get_property_pool<glm::f32vec2>()
+        {
+            return (&m_vec2_pool);
+        }
+
+        template<>
+        inline property_pool<glm::f32vec3>* property_manager::get_property_pool<glm::f32vec3>()
+        {
+            return (&m_vec3_pool);
+        }
+
+        template<>
+        inline property_pool<glm::f32vec4>* property_manager::get_property_pool<glm::f32vec4>()
+        {
+            return (&m_vec4_pool);
+        }
+
+        template<>
+        inline property_pool<glm::f32quat>* property_manager::get_property_pool<glm::f32quat>()
+        {
+            return (&m_quat_pool);
+        }
+
+        template<>
+        inline property_pool<glm::f32mat4>* property_manager::get_property_pool<glm::f32mat4>()
+        {
+            return (&m_mat4_pool);
+        }
+
         property_manager* get_property_manager_internal();
     }
 }
@@ -0,0 +1,36 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/animation/property_pool.hpp"
+
+namespace electroslag {
+    namespace animation {
+        void add_scaled_floats(float* values, float const* rates, float scale, int count)
+        {
+            int i = 0;
+            __m128 scale_4 = _mm_set1_ps(scale);
+            for (; i + 4 <= count; i += 4) {
+                __m128 value_4 = _mm_loadu_ps(values + i);
+                __m128 rate_4 = _mm_loadu_ps(rates + i);
+                _mm_storeu_ps(values + i, _mm_add_ps(value_4, _mm_mul_ps(rate_4, scale_4)));
+            }
+
+            for (; i < count; ++i) {
+                values[i] += rates[i] * scale;
+            }
+        }
+    }
+}
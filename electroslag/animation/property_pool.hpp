@@ -0,0 +1,361 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/threading/mutex.hpp"
+#include "electroslag/animation/property_controller_typed_interface.hpp"
+#include "electroslag/animation/frame_time.hpp"
+
+namespace electroslag {
+    namespace animation {
+        template<class T>
+        inline T interpolate_property_value(T const& from, T const& to, float t)
+        {
+            return (from + ((to - from) * t));
+        }
+
+        inline glm::f32quat interpolate_property_value(glm::f32quat const& from, glm::f32quat const& to, float t)
+        {
+            return (glm::slerp(from, to, t));
+        }
+
+        // values[i] += rates[i] * scale, four floats at a time.
+        void add_scaled_floats(float* values, float const* rates, float scale, int count);
+
+        // Property values driven by batchable controllers live here, packed together
+        // by controller kind, so a whole pool is evaluated in a few tight loops per
+        // frame instead of one virtual call per property. Slots are stable handles;
+        // the dense arrays behind them are compacted as properties leave the pool.
+        //
+        // Work items of earlier frames can still be reading while the next frame is
+        // evaluated, so results are published by slot in to a separate copy per frame
+        // slot. A frame's copy is only rewritten when that frame slot comes around
+        // again, by which time nothing reads it.
+        template<class T>
+        class property_pool {
+        public:
+            typedef T value_type;
+            static int const no_slot = -1;
+
+            property_pool()
+                : m_mutex(ELECTROSLAG_STRING_AND_HASH("m:property_pool"))
+                , m_publish_count(0)
+            {}
+
+            int insert(property_batch_kind kind, value_type const& value, value_type const& parameter)
+            {
+                ELECTROSLAG_CHECK(kind > property_batch_kind_unknown && kind < property_batch_kind_count);
+                threading::lock_guard pool_lock(&m_mutex);
+
+                int slot = no_slot;
+                if (m_free_slots.empty()) {
+                    slot = static_cast<int>(m_slot_kind.size());
+                    m_slot_kind.emplace_back(kind);
+                    m_slot_index.emplace_back(0);
+                }
+                else {
+                    slot = m_free_slots.back();
+                    m_free_slots.pop_back();
+                    m_slot_kind[slot] = kind;
+                }
+
+                batch* b = &m_batches[kind];
+                m_slot_index[slot] = static_cast<int>(b->slots.size());
+                b->slots.emplace_back(slot);
+                b->values.emplace_back(value);
+                b->parameters.emplace_back(parameter);
+                b->previous_step_values.emplace_back(value);
+                b->step_values.emplace_back(value);
+                b->changed.emplace_back(0);
+                b->step_started.emplace_back(0);
+
+                return (slot);
+            }
+
+            // Released slots are compacted at the next evaluate, and only handed out
+            // again once no frame's published values refer to them.
+            void release(int slot)
+            {
+                threading::lock_guard pool_lock(&m_mutex);
+                m_pending_releases.emplace_back(slot);
+            }
+
+            // Slots that have not been published for the frame yet read as unchanged,
+            // leaving out_value alone.
+            property_value_state read_value(int slot, int frame_slot, value_type* out_value) const
+            {
+                ELECTROSLAG_CHECK(frame_slot >= 0 && frame_slot < max_frame_slots);
+                published_values const* p = &m_published[frame_slot];
+                if (slot >= static_cast<int>(p->states.size()) || p->states[slot] == published_state_absent) {
+                    return (property_value_state_no_change);
+                }
+
+                *out_value = p->values[slot];
+                return ((p->states[slot] == published_state_changed) ? property_value_state_changed : property_value_state_no_change);
+            }
+
+            void evaluate(frame_time const& time)
+            {
+                threading::lock_guard pool_lock(&m_mutex);
+                compact();
+                evaluate_velocity(time, &m_batches[property_batch_kind_velocity]);
+                evaluate_constant(time, &m_batches[property_batch_kind_constant]);
+                publish(time.frame_slot);
+            }
+
+        private:
+            ELECTROSLAG_STATIC_CHECK(sizeof(T) % sizeof(float) == 0, "Pooled property values must be made of floats");
+            static int const floats_per_value = sizeof(T) / sizeof(float);
+
+            struct batch {
+                int size() const
+                {
+                    return (static_cast<int>(slots.size()));
+                }
+
+                std::vector<int> slots;
+                std::vector<value_type> values;
+                std::vector<value_type> parameters;
+
+                // Only used when updating with a fixed step.
+                std::vector<value_type> previous_step_values;
+                std::vector<value_type> step_values;
+
+                std::vector<byte> changed;
+                std::vector<byte> step_started;
+            };
+
+            static float* get_floats(std::vector<value_type>& v)
+            {
+                return (reinterpret_cast<float*>(v.data()));
+            }
+
+            static float const* get_floats(std::vector<value_type> const& v)
+            {
+                return (reinterpret_cast<float const*>(v.data()));
+            }
+
+            void compact()
+            {
+                std::vector<int>::const_iterator r(m_pending_releases.begin());
+                while (r != m_pending_releases.end()) {
+                    int slot = *r;
+                    batch* b = &m_batches[m_slot_kind[slot]];
+
+                    // Move the last entry in to the hole so the arrays stay dense.
+                    int i = m_slot_index[slot];
+                    int last = b->size() - 1;
+                    if (i != last) {
+                        b->slots[i] = b->slots[last];
+                        b->values[i] = b->values[last];
+                        b->parameters[i] = b->parameters[last];
+                        b->previous_step_values[i] = b->previous_step_values[last];
+                        b->step_values[i] = b->step_values[last];
+                        b->changed[i] = b->changed[last];
+                        b->step_started[i] = b->step_started[last];
+                        m_slot_index[b->slots[i]] = i;
+                    }
+
+                    b->slots.pop_back();
+                    b->values.pop_back();
+                    b->parameters.pop_back();
+                    b->previous_step_values.pop_back();
+                    b->step_values.pop_back();
+                    b->changed.pop_back();
+                    b->step_started.pop_back();
+
+                    m_slot_kind[slot] = property_batch_kind_unknown;
+                    m_retired_slots.emplace_back(slot, m_publish_count);
+                    ++r;
+                }
+                m_pending_releases.clear();
+            }
+
+            void publish(int frame_slot)
+            {
+                ELECTROSLAG_CHECK(frame_slot >= 0 && frame_slot < max_frame_slots);
+                published_values* p = &m_published[frame_slot];
+
+                int slot_count = static_cast<int>(m_slot_kind.size());
+                p->values.resize(slot_count);
+                p->states.assign(slot_count, published_state_absent);
+
+                for (int k = 0; k < property_batch_kind_count; ++k) {
+                    batch const* b = &m_batches[k];
+                    int count = b->size();
+                    for (int i = 0; i < count; ++i) {
+                        int slot = b->slots[i];
+                        p->values[slot] = b->values[i];
+                        p->states[slot] = b->changed[i] ? published_state_changed : published_state_no_change;
+                    }
+                }
+
+                // Once every frame slot has been published since a slot was released,
+                // no frame can still see its old value.
+                ++m_publish_count;
+                while (!m_retired_slots.empty() && m_publish_count - m_retired_slots.front().publish_count >= max_frame_slots) {
+                    m_free_slots.emplace_back(m_retired_slots.front().slot);
+                    m_retired_slots.pop_front();
+                }
+            }
+
+            static void start_fixed_steps(batch* b)
+            {
+                int count = b->size();
+                for (int i = 0; i < count; ++i) {
+                    if (!b->step_started[i]) {
+                        b->previous_step_values[i] = b->values[i];
+                        b->step_values[i] = b->values[i];
+                        b->step_started[i] = 1;
+                    }
+                }
+            }
+
+            // Present a blend of the last two steps, so motion stays smooth between steps.
+            static void present_fixed_steps(batch* b, float interpolation)
+            {
+                int count = b->size();
+                for (int i = 0; i < count; ++i) {
+                    value_type presented_value(interpolate_property_value(
+                        b->previous_step_values[i],
+                        b->step_values[i],
+                        interpolation
+                        ));
+                    if (presented_value != b->values[i]) {
+                        b->values[i] = presented_value;
+                        b->changed[i] = 1;
+                    }
+                }
+            }
+
+            static void evaluate_velocity(frame_time const& time, batch* b)
+            {
+                int count = b->size();
+                if (count == 0) {
+                    return;
+                }
+
+                if (!time.is_fixed_step()) {
+                    std::fill(b->step_started.begin(), b->step_started.end(), static_cast<byte>(0));
+                    if (time.millisec_elapsed > 0.0) {
+                        add_scaled_floats(
+                            get_floats(b->values),
+                            get_floats(b->parameters),
+                            static_cast<float>(time.millisec_elapsed),
+                            count * floats_per_value
+                            );
+                        std::fill(b->changed.begin(), b->changed.end(), static_cast<byte>(1));
+                    }
+                    else {
+                        std::fill(b->changed.begin(), b->changed.end(), static_cast<byte>(0));
+                    }
+                    return;
+                }
+
+                start_fixed_steps(b);
+
+                byte stepped = (time.fixed_steps > 0) ? 1 : 0;
+                std::fill(b->changed.begin(), b->changed.end(), stepped);
+                for (int step = 0; step < time.fixed_steps; ++step) {
+                    b->previous_step_values = b->step_values;
+                    add_scaled_floats(
+                        get_floats(b->step_values),
+                        get_floats(b->parameters),
+                        static_cast<float>(time.fixed_step_millisec),
+                        count * floats_per_value
+                        );
+                }
+
+                present_fixed_steps(b, time.interpolation);
+            }
+
+            static void evaluate_constant(frame_time const& time, batch* b)
+            {
+                int count = b->size();
+                if (count == 0) {
+                    return;
+                }
+
+                if (!time.is_fixed_step()) {
+                    std::fill(b->step_started.begin(), b->step_started.end(), static_cast<byte>(0));
+                    for (int i = 0; i < count; ++i) {
+                        if (b->values[i] != b->parameters[i]) {
+                            b->values[i] = b->parameters[i];
+                            b->changed[i] = 1;
+                        }
+                        else {
+                            b->changed[i] = 0;
+                        }
+                    }
+                    return;
+                }
+
+                start_fixed_steps(b);
+
+                std::fill(b->changed.begin(), b->changed.end(), static_cast<byte>(0));
+                for (int step = 0; step < time.fixed_steps; ++step) {
+                    for (int i = 0; i < count; ++i) {
+                        b->previous_step_values[i] = b->step_values[i];
+                        if (b->step_values[i] != b->parameters[i]) {
+                            b->step_values[i] = b->parameters[i];
+                            b->changed[i] = 1;
+                        }
+                    }
+                }
+
+                present_fixed_steps(b, time.interpolation);
+            }
+
+            threading::mutex m_mutex;
+
+            // Slot handle to batch and dense index.
+            std::vector<property_batch_kind> m_slot_kind;
+            std::vector<int> m_slot_index;
+            std::vector<int> m_free_slots;
+            std::vector<int> m_pending_releases;
+
+            struct retired_slot {
+                retired_slot(int new_slot, long long new_publish_count)
+                    : slot(new_slot)
+                    , publish_count(new_publish_count)
+                {}
+
+                int slot;
+                long long publish_count;
+            };
+            std::deque<retired_slot> m_retired_slots;
+
+            batch m_batches[property_batch_kind_count];
+
+            // Evaluated values by slot, one copy per frame slot.
+            enum published_state : byte {
+                published_state_no_change = 0,
+                published_state_changed = 1,
+                published_state_absent = 2
+            };
+
+            struct published_values {
+                std::vector<value_type> values;
+                std::vector<published_state> states;
+            };
+            published_values m_published[max_frame_slots];
+            long long m_publish_count;
+
+            // Disallowed operations:
+            explicit property_pool(property_pool const&);
+            property_pool& operator =(property_pool const&);
+        };
+    }
+}
@@ -0,0 +1,106 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/logger.hpp"
+#include "electroslag/ui/ui_interface.hpp"
+#include "electroslag/animation/property_pool.hpp"
+#include "electroslag/animation/velocity_controller.hpp"
+#include "electroslag/animation/property_pool_benchmark.hpp"
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+namespace electroslag {
+    namespace animation {
+        void benchmark_property_pools(int property_count, int frame_count)
+        {
+            ELECTROSLAG_CHECK(property_count > 0 && frame_count > 0);
+            ui::timer_interface* timer = ui::get_ui()->get_timer();
+
+            frame_time time;
+            time.millisec_elapsed = 16.0;
+
+            // The per-property path, as property::update runs it for controllers that
+            // can't be pooled.
+            typedef property_controller_typed_interface<glm::f32vec3> controller_type;
+            std::vector<controller_type::ref> controllers;
+            std::vector<glm::f32vec3> per_property_values(property_count, glm::f32vec3(0.0f));
+            for (int i = 0; i < property_count; ++i) {
+                glm::f32vec3 velocity(static_cast<float>(i % 7), static_cast<float>(i % 11), static_cast<float>(i % 13));
+                controllers.emplace_back(velocity_controller<glm::f32vec3>::create(velocity * 0.001f).cast<controller_type>());
+            }
+
+            int per_property_changes = 0;
+            long long begin = timer->read_nanoseconds();
+            for (int f = 0; f < frame_count; ++f) {
+                for (int i = 0; i < property_count; ++i) {
+                    if (controllers[i]->update_value(time.millisec_elapsed, &per_property_values[i]) == property_value_state_changed) {
+                        ++per_property_changes;
+                    }
+                }
+            }
+            long long per_property_nanoseconds = timer->read_nanoseconds() - begin;
+
+            // The pooled path: one evaluate per frame, then every property reads its slot.
+            property_pool<glm::f32vec3> pool;
+            std::vector<int> slots;
+            std::vector<glm::f32vec3> pooled_values(property_count, glm::f32vec3(0.0f));
+            for (int i = 0; i < property_count; ++i) {
+                glm::f32vec3 velocity(static_cast<float>(i % 7), static_cast<float>(i % 11), static_cast<float>(i % 13));
+                slots.emplace_back(pool.insert(property_batch_kind_velocity, pooled_values[i], velocity * 0.001f));
+            }
+
+            int pooled_changes = 0;
+            begin = timer->read_nanoseconds();
+            for (int f = 0; f < frame_count; ++f) {
+                time.frame_slot = f % max_frame_slots;
+                pool.evaluate(time);
+                for (int i = 0; i < property_count; ++i) {
+                    if (pool.read_value(slots[i], time.frame_slot, &pooled_values[i]) == property_value_state_changed) {
+                        ++pooled_changes;
+                    }
+                }
+            }
+            long long pooled_nanoseconds = timer->read_nanoseconds() - begin;
+
+            // Both paths integrate the same velocities, so they should agree closely.
+            float max_difference = 0.0f;
+            for (int i = 0; i < property_count; ++i) {
+                glm::f32vec3 difference(glm::abs(per_property_values[i] - pooled_values[i]));
+                max_difference = max(max_difference, max(difference.x, max(difference.y, difference.z)));
+            }
+
+            std::vector<int>::const_iterator s(slots.begin());
+            while (s != slots.end()) {
+                pool.release(*s);
+                ++s;
+            }
+
+            double per_property_millisec = static_cast<double>(per_property_nanoseconds) / (1000000.0 * frame_count);
+            double pooled_millisec = static_cast<double>(pooled_nanoseconds) / (1000000.0 * frame_count);
+            ELECTROSLAG_LOG_MESSAGE(
+                "property_pool benchmark - [properties:%d] [frames:%d] [per_property:%.3fms] [pooled:%.3fms] [speedup:%.2fx] [changes:%d/%d] [max_difference:%g]",
+                property_count,
+                frame_count,
+                per_property_millisec,
+                pooled_millisec,
+                (pooled_millisec > 0.0) ? (per_property_millisec / pooled_millisec) : 0.0,
+                per_property_changes,
+                pooled_changes,
+                static_cast<double>(max_difference)
+                );
+        }
+    }
+}
+#endif
@@ -0,0 +1,27 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+namespace electroslag {
+    namespace animation {
+        // Times velocity driven vec3 properties evaluated through a property_pool
+        // against the same properties updated one virtual controller call at a time,
+        // and logs the per-frame cost of each.
+        void benchmark_property_pools(int property_count, int frame_count);
+    }
+}
+#endif
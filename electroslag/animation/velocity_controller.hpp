@@ -29,10 +29,10 @@ namespace electroslag {
             virtual ~velocity_controller()
             {}
 
-            virtual property_value_state update_value(int millisec_elapsed, value_type* in_out_value)
+            virtual property_value_state update_value(double millisec_elapsed, value_type* in_out_value)
             {
-                if (millisec_elapsed > 0) {
-                    *in_out_value = *in_out_value + (m_velocity * millisec_elapsed);
+                if (millisec_elapsed > 0.0) {
+                    *in_out_value = *in_out_value + (m_velocity * static_cast<float>(millisec_elapsed));
                     return (property_value_state_changed);
                 }
                 else {
@@ -40,6 +40,13 @@ namespace electroslag {
                 }
             }
 
+            virtual bool get_batch_parameters(property_batch_kind* out_kind, value_type* out_parameter) const
+            {
+                *out_kind = property_batch_kind_velocity;
+                *out_parameter = m_velocity;
+                return (true);
+            }
+
         protected:
             explicit velocity_controller(value_type const& velocity)
                 : m_velocity(velocity)
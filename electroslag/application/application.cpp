@@ -22,6 +22,14 @@
 #include "electroslag/ui/ui_interface.hpp"
 #include "electroslag/graphics/graphics_interface.hpp"
 #include "electroslag/renderer/renderer_interface.hpp"
+#include "electroslag/animation/property_pool_benchmark.hpp"
+#include "electroslag/renderer/deformer_check.hpp"
+#include "electroslag/renderer/geometry_descriptor.hpp"
+#include "electroslag/renderer/occlusion_buffer_check.hpp"
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+#include "electroslag/mesh/meshlet_builder_check.hpp"
+#include "electroslag/mesh/quadric_simplifier_check.hpp"
+#endif
 
 namespace electroslag {
     namespace application {
@@ -32,7 +40,17 @@ namespace electroslag {
 #if !defined(ELECTROSLAG_BUILD_SHIP)
             , m_dump_content(false)
             , m_optimize_content(false)
+            , m_gpu_timing(false)
+            , m_warm_shaders(false)
+            , m_benchmark_property_pools(false)
+            , m_self_test(false)
 #endif
+            , m_shader_cache(true)
+            , m_texture_upload_megabytes(4.0f)
+            , m_texture_memory_megabytes(256.0f)
+            , m_fixed_step_millisec(0.0)
+            , m_frame_pacing_mode(renderer::frame_pacing_mode_throughput)
+            , m_frames_in_flight(renderer::max_frames_in_flight)
             , m_renderer_ready(false)
         {
             // Initialization that has to occur after global constructors.
@@ -51,12 +69,15 @@ namespace electroslag {
 
 #if !defined(ELECTROSLAG_BUILD_SHIP)
             int current_log_enable = l->get_log_enable();
-            if (m_dump_content) {
+            if (m_dump_content || m_benchmark_property_pools || m_self_test) {
                 current_log_enable |= log_enable_bit_message;
             }
             if (m_optimize_content) {
                 current_log_enable |= log_enable_bit_serialize;
             }
+            if (m_gpu_timing) {
+                current_log_enable |= log_enable_bit_graphics;
+            }
             l->set_log_enable(current_log_enable);
 
             if (m_dump_content) {
@@ -110,13 +131,87 @@ namespace electroslag {
 
                 // TODO: Default timeout is 30s. Might need to wait more than that here.
                 serialize::load_record::ref content_load_record(m_async_content_loader->get_wait());
+                optimize_geometry(content_load_record.get_pointer());
                 serialize::get_database()->save_objects("content.bin", content_load_record);
             }
+            else if (m_benchmark_property_pools) {
+                animation::benchmark_property_pools(100000, 300);
+            }
+            else if (m_self_test) {
+                bool passed = renderer::check_deformation();
+                passed = mesh::check_lod_chain() && passed;
+                passed = mesh::check_meshlets() && passed;
+                passed = renderer::check_occlusion_buffer() && passed;
+                if (!passed) {
+                    return (EXIT_FAILURE);
+                }
+            }
 #endif
 
             return (EXIT_SUCCESS);
         }
 
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+        // static
+        void application::optimize_geometry(serialize::load_record* record)
+        {
+            static int const lod_chain_max_levels = 6;
+            static int const meshlet_max_triangles = 64;
+
+            // Geometry that shares a level 0 range shares its triangle order, so meshlets are
+            // only built for the first of them; the others still draw the range whole.
+            typedef std::vector<std::pair<graphics::buffer_descriptor const*, int> > index_range_vector;
+            index_range_vector meshlet_ranges;
+
+            serialize::serializable_object_interface* obj = record->get_loaded_object_head();
+            while (obj != 0) {
+                renderer::geometry_descriptor* geometry = dynamic_cast<renderer::geometry_descriptor*>(obj);
+                if (!geometry || geometry->get_primitive_stream()->get_prim_type() != graphics::primitive_type_triangle) {
+                    obj = obj->get_next_loaded_object();
+                    continue;
+                }
+
+                // Content loaded from an optimized archive already has its levels.
+                if (geometry->get_lod_count() == 1) {
+                    try {
+                        geometry->generate_lod_chain(lod_chain_max_levels);
+                        ELECTROSLAG_LOG_SERIALIZE(
+                            "Geometry %s has %d levels of detail.",
+                            geometry->get_name().c_str(),
+                            geometry->get_lod_count()
+                            );
+                    }
+                    catch (std::exception const& e) {
+                        // Quantized positions can't be simplified; the geometry is saved as it is.
+                        ELECTROSLAG_LOG_WARN("No levels of detail for geometry %s: %s", geometry->get_name().c_str(), e.what());
+                    }
+                }
+
+                index_range_vector::value_type range(
+                    geometry->get_primitive_stream()->get_index_buffer().get_pointer(),
+                    geometry->get_index_buffer_start_offset()
+                    );
+                if (geometry->get_meshlet_count() == 0 &&
+                    std::find(meshlet_ranges.begin(), meshlet_ranges.end(), range) == meshlet_ranges.end()) {
+                    meshlet_ranges.emplace_back(range);
+                    try {
+                        geometry->generate_meshlets(meshlet_max_triangles);
+                        ELECTROSLAG_LOG_SERIALIZE(
+                            "Geometry %s has %d meshlets.",
+                            geometry->get_name().c_str(),
+                            geometry->get_meshlet_count()
+                            );
+                    }
+                    catch (std::exception const& e) {
+                        ELECTROSLAG_LOG_WARN("No meshlets for geometry %s: %s", geometry->get_name().c_str(), e.what());
+                    }
+                }
+
+                obj = obj->get_next_loaded_object();
+            }
+        }
+#endif
+
         // static
         std::string application::parse_option_value(std::string const& option, int option_offset, int& a, int argc, char** argv)
         {
@@ -164,6 +259,44 @@ namespace electroslag {
                 else if (option.compare(0, 2, "-l") == 0) {
                     m_log_file_path = parse_option_value(option, 2, a, argc, argv);
                 }
+                else if (option.compare(0, 11, "--fixedstep") == 0) {
+                    m_fixed_step_millisec = std::strtod(parse_option_value(option, 11, a, argc, argv).c_str(), 0);
+                }
+                else if (option.compare(0, 2, "-f") == 0) {
+                    m_fixed_step_millisec = std::strtod(parse_option_value(option, 2, a, argc, argv).c_str(), 0);
+                }
+                else if (option.compare(0, 12, "--lowlatency") == 0) {
+                    m_frame_pacing_mode = renderer::frame_pacing_mode_low_latency;
+                }
+                else if (option.compare(0, 15, "--noshadercache") == 0) {
+                    m_shader_cache = false;
+                }
+                else if (option.compare(0, 15, "--texturebudget") == 0) {
+                    // Megabytes per frame; zero uploads on the render thread.
+                    m_texture_upload_megabytes = static_cast<float>(
+                        std::strtod(parse_option_value(option, 15, a, argc, argv).c_str(), 0)
+                        );
+                }
+                else if (option.compare(0, 15, "--texturememory") == 0) {
+                    float texture_memory_megabytes = static_cast<float>(
+                        std::strtod(parse_option_value(option, 15, a, argc, argv).c_str(), 0)
+                        );
+                    if (texture_memory_megabytes > 0.0f) {
+                        m_texture_memory_megabytes = texture_memory_megabytes;
+                    }
+                    else {
+                        std::printf("Ignoring invalid texture memory \"%f\".\n", texture_memory_megabytes);
+                    }
+                }
+                else if (option.compare(0, 16, "--framesinflight") == 0) {
+                    int frames_in_flight = std::atoi(parse_option_value(option, 16, a, argc, argv).c_str());
+                    if (frames_in_flight >= 1 && frames_in_flight <= renderer::max_frames_in_flight) {
+                        m_frames_in_flight = frames_in_flight;
+                    }
+                    else {
+                        std::printf("Ignoring invalid frames in flight \"%d\".\n", frames_in_flight);
+                    }
+                }
 #if !defined(ELECTROSLAG_BUILD_SHIP)
                 else if ((option.compare(0, 6, "--dump") == 0) || (option.compare(0, 2, "-d") == 0)) {
                     m_dump_content = true;
@@ -173,6 +306,27 @@ namespace electroslag {
                     m_optimize_content = true;
                     m_run_content = false;
                 }
+                else if ((option.compare(0, 9, "--gputime") == 0) || (option.compare(0, 2, "-g") == 0)) {
+                    m_gpu_timing = true;
+                }
+                else if (option.compare(0, 13, "--warmshaders") == 0) {
+                    // Load the content, wait for every pipeline to build (filling the
+                    // shader cache) and exit.
+                    m_warm_shaders = true;
+                    m_shader_cache = true;
+                }
+                else if (option.compare(0, 12, "--benchpools") == 0) {
+                    // Time pooled property evaluation against the per-property path,
+                    // log the results and exit.
+                    m_benchmark_property_pools = true;
+                    m_run_content = false;
+                }
+                else if (option.compare(0, 10, "--selftest") == 0) {
+                    // Run the CPU checks against known results, log them and exit;
+                    // the exit code is non-zero if any failed.
+                    m_self_test = true;
+                    m_run_content = false;
+                }
 #endif
                 else {
                     std::printf("Ignoring unknown or invalid option \"%s\".\n", option.c_str());
@@ -248,6 +402,20 @@ namespace electroslag {
                 m_app->m_loading_screen.hide();
                 m_app->m_scene->show();
                 m_app->m_loading_screen.shutdown();
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+                if (m_app->m_warm_shaders) {
+                    // Pipelines step their initialization once a frame on the render
+                    // thread; just wait for the last of them and quit.
+                    renderer::renderer_interface* r = renderer::get_renderer();
+                    while (r->has_pending_pipelines()) {
+                        threading::this_thread::sleep_for(10);
+                    }
+
+                    ELECTROSLAG_LOG_MESSAGE("Shader warm up complete");
+                    ui::get_ui()->get_window()->close();
+                }
+#endif
             }
 
             return (loaded_objects);
@@ -271,6 +439,24 @@ namespace electroslag {
             graphics_params.swap_interval = 0;
             graphics_params.display_attribs.color_format = graphics::frame_buffer_color_format_r8g8b8a8_srgb;
             graphics_params.display_attribs.depth_stencil_format = graphics::frame_buffer_depth_stencil_format_d24s8;
+            if (m_shader_cache) {
+                graphics_params.shader_cache_path = "shader_cache";
+            }
+            graphics_params.texture_upload_megabytes_per_frame = m_texture_upload_megabytes;
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            if (m_gpu_timing) {
+                graphics_params.gpu_timing = true;
+                graphics::get_graphics()->gpu_timer_samples.bind(
+                    graphics::graphics_interface::gpu_timer_samples_delegate::create_from_method<application, &application::on_gpu_timer_samples>(this),
+                    event_bind_mode_own_listener
+                    );
+                graphics::get_graphics()->state_filter_counters_updated.bind(
+                    graphics::graphics_interface::state_filter_counters_delegate::create_from_method<application, &application::on_state_filter_counters>(this),
+                    event_bind_mode_own_listener
+                    );
+            }
+#endif
 
             graphics::get_graphics()->initialize(&graphics_params);
 
@@ -279,6 +465,9 @@ namespace electroslag {
 
             // Initialize the renderer layer.
             renderer::get_renderer()->initialize();
+            renderer::get_renderer()->set_fixed_step_millisec(m_fixed_step_millisec);
+            renderer::get_renderer()->set_frame_pacing(m_frame_pacing_mode, m_frames_in_flight);
+            renderer::get_renderer()->set_texture_memory_megabytes(m_texture_memory_megabytes);
 
             renderer::get_renderer()->destroyed.bind(
                 renderer::renderer_interface::destroyed_delegate::create_from_method<application, &application::on_renderer_destroyed>(this),
@@ -299,5 +488,55 @@ namespace electroslag {
             m_async_content_loader->wait_for_done();
             m_scene.reset();
         }
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+        void application::on_gpu_timer_samples(graphics::gpu_timer_sample const* samples, int sample_count)
+        {
+            // Durations are in microseconds; the CPU column is submission time on
+            // the render thread, the GPU column is execution time on the GPU.
+            for (int s = 0; s < sample_count; ++s) {
+                graphics::gpu_timer_sample const* sample = &samples[s];
+                ELECTROSLAG_LOG_GFX(
+                    "gpu_timer - [frame:%lld] [queue:0x%016llX] [cpu:%8lldus] [gpu:%8lldus] [gpu_start_offset:%8lldus]",
+                    sample->frame_number,
+                    sample->name_hash,
+                    (sample->cpu_end - sample->cpu_begin) / 1000,
+                    (sample->gpu_end - sample->gpu_begin) / 1000,
+                    (sample->gpu_begin - sample->cpu_begin) / 1000
+                    );
+            }
+        }
+
+        void application::on_state_filter_counters(graphics::state_filter_counters const* counters)
+        {
+            // Issued calls reached the driver; filtered ones were redundant and skipped.
+            int issued = 0;
+            int filtered = 0;
+            for (int c = 0; c < graphics::state_filter_category_count; ++c) {
+                issued += counters->issued[c];
+                filtered += counters->filtered[c];
+            }
+
+            ELECTROSLAG_LOG_GFX(
+                "state_filter - [frame:%lld] [issued:%d] [filtered:%d]"
+                " [fbo:%d/%d] [program:%d/%d] [vao:%d/%d] [buffer:%d/%d] [depth:%d/%d] [blend:%d/%d]",
+                counters->frame_number,
+                issued,
+                filtered,
+                counters->issued[graphics::state_filter_category_frame_buffer],
+                counters->filtered[graphics::state_filter_category_frame_buffer],
+                counters->issued[graphics::state_filter_category_program],
+                counters->filtered[graphics::state_filter_category_program],
+                counters->issued[graphics::state_filter_category_vertex_array],
+                counters->filtered[graphics::state_filter_category_vertex_array],
+                counters->issued[graphics::state_filter_category_indexed_buffer],
+                counters->filtered[graphics::state_filter_category_indexed_buffer],
+                counters->issued[graphics::state_filter_category_depth_test],
+                counters->filtered[graphics::state_filter_category_depth_test],
+                counters->issued[graphics::state_filter_category_blending],
+                counters->filtered[graphics::state_filter_category_blending]
+                );
+        }
+#endif
     }
 }
@@ -18,6 +18,7 @@
 #include "electroslag/threading/condition_variable.hpp"
 #include "electroslag/threading/mutex.hpp"
 #include "electroslag/serialize/load_record.hpp"
+#include "electroslag/graphics/graphics_interface.hpp"
 #include "electroslag/renderer/scene.hpp"
 #include "electroslag/application/loading_screen.hpp"
 
@@ -41,6 +42,14 @@ namespace electroslag {
 
             void on_renderer_destroyed();
 
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            // Build what the renderer uses to draw loaded geometry cheaply before it is saved.
+            static void optimize_geometry(serialize::load_record* record);
+
+            void on_gpu_timer_samples(graphics::gpu_timer_sample const* samples, int sample_count);
+            void on_state_filter_counters(graphics::state_filter_counters const* counters);
+#endif
+
             // Initialization sequence
             threading::condition_variable m_renderer_ready_changed;
             threading::mutex m_init_mutex;
@@ -87,7 +96,17 @@ namespace electroslag {
 #if !defined(ELECTROSLAG_BUILD_SHIP)
             bool m_dump_content;
             bool m_optimize_content;
+            bool m_gpu_timing;
+            bool m_warm_shaders;
+            bool m_benchmark_property_pools;
+            bool m_self_test;
 #endif
+            bool m_shader_cache;
+            float m_texture_upload_megabytes;
+            float m_texture_memory_megabytes;
+            double m_fixed_step_millisec;
+            renderer::frame_pacing_mode m_frame_pacing_mode;
+            int m_frames_in_flight;
             bool m_renderer_ready;
         };
     }
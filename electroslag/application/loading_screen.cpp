@@ -135,8 +135,8 @@ namespace electroslag {
             m_draw_queue = g->create_command_queue(ELECTROSLAG_STRING_AND_HASH("cq:loading_screen"));
 
             m_prim_stream = g->create_primitive_stream(prim_stream_desc);
-            m_shader = g->create_shader_program(shader_desc, prim_stream_desc->get_fields());
-            m_texture = g->create_texture(texture_desc);
+            m_shader = g->create_finished_shader_program(shader_desc, prim_stream_desc->get_fields());
+            m_texture = g->create_finished_texture(texture_desc);
 
             // The size parameter for the UBO descriptor is determined by the render thread, so we need to wait
             // for it to be computed.
@@ -174,7 +174,7 @@ namespace electroslag {
             m_visible = false;
         }
 
-        void loading_screen::on_window_frame(int /*millisec_elapsed*/)
+        void loading_screen::on_window_frame(double /*millisec_elapsed*/)
         {
             if (m_visible) {
                 m_draw_queue->enqueue_command<draw_command>(this);
@@ -54,7 +54,7 @@ namespace electroslag {
                 draw_command& operator =(draw_command const&);
             };
 
-            void on_window_frame(int millisec_elapsed);
+            void on_window_frame(double millisec_elapsed);
 
             // Load record.
             serialize::load_record::ref m_loaded_objects;
@@ -14,6 +14,7 @@
 //  limitations under the License.
 
 #pragma once
+#include "electroslag/graphics/sync_interface.hpp"
 
 namespace electroslag {
     namespace graphics {
@@ -25,11 +26,18 @@ namespace electroslag {
             virtual bool is_finished() const = 0;
 
             // bytes < 0 means all bytes from offset to the end of the buffer.
+            // map waits for any fenced GPU work overlapping the span.
             virtual byte* map(int offset = 0, int bytes = -1) = 0;
             virtual void unmap(int offset = 0, int bytes = -1) = 0;
 
+            // On noncoherent buffers, CPU writes are only recorded as dirty here;
+            // all dirty spans are flushed together before the GPU next uses them.
             virtual void flush_cpu_writes(int offset = 0, int bytes = -1) = 0;
             virtual void flush_gpu_writes(int offset = 0, int bytes = -1) = 0;
+
+            // The span is in use by GPU work that sets the sync once done. The sync
+            // must be freshly created, not one that is cleared and re-used.
+            virtual void fence_range(sync_interface::ref const& sync, int offset = 0, int bytes = -1) = 0;
         };
     }
 }
@@ -72,6 +72,9 @@ namespace electroslag {
                 m_mapped_pointer = 0;
                 m_size = 0;
                 m_id = 0;
+
+                m_dirty_pages.reset();
+                m_dirty_page_words = 0;
             }
             else {
                 ELECTROSLAG_LOG_WARN("buffer_opengl destructor before finished");
@@ -84,10 +87,12 @@ namespace electroslag {
             )
         {
             if (id) {
-                gl::BindBuffer(general_buffer_manipulation_target, id);
-                gl::UnmapBuffer(general_buffer_manipulation_target);
+                gl::UnmapNamedBuffer(id);
 
                 gl::DeleteBuffers(1, &id);
+                graphics_opengl* gfx = static_cast<graphics_opengl*>(get_graphics());
+                gfx->get_state_cache()->forget_buffer(id);
+                gfx->get_vertex_format_cache()->forget_buffer(id);
             }
         }
 
@@ -152,23 +157,22 @@ namespace electroslag {
                 }
             }
 
+            // Direct state access throughout; creating a buffer leaves every
+            // binding point alone.
             opengl_object_id buffer_id = 0;
-            gl::GenBuffers(1, &buffer_id);
+            gl::CreateBuffers(1, &buffer_id);
             context_opengl::check_opengl_error();
 
             ELECTROSLAG_CHECK(!m_id);
             m_id = buffer_id;
 
-            gl::BindBuffer(general_buffer_manipulation_target, buffer_id);
-            context_opengl::check_opengl_error();
-
             if (buffer_desc->has_initialized_data()) {
                 ELECTROSLAG_CHECK(!buffer_desc->has_uninitialized_data());
 
                 referenced_buffer_interface::accessor accessor(buffer_desc->get_initialized_data());
                 m_size = accessor.get_sizeof();
 
-                gl::BufferStorage(general_buffer_manipulation_target, accessor.get_sizeof(), accessor.get_pointer(), flags);
+                gl::NamedBufferStorage(buffer_id, accessor.get_sizeof(), accessor.get_pointer(), flags);
                 context_opengl::check_opengl_error();
             }
             else {
@@ -176,13 +180,13 @@ namespace electroslag {
 
                 m_size = buffer_desc->get_uninitialized_data_size();
 
-                gl::BufferStorage(general_buffer_manipulation_target, m_size, 0, flags);
+                gl::NamedBufferStorage(buffer_id, m_size, 0, flags);
                 context_opengl::check_opengl_error();
             }
 
             if (memory_map != buffer_memory_map_static) {
-                m_mapped_pointer = static_cast<byte*>(gl::MapBufferRange(
-                    general_buffer_manipulation_target,
+                m_mapped_pointer = static_cast<byte*>(gl::MapNamedBufferRange(
+                    buffer_id,
                     0,
                     m_size,
                     map_flags
@@ -194,9 +198,18 @@ namespace electroslag {
                 m_mapped_pointer = 0;
             }
 
+            if (m_map_flags.flush_cpu_writes_on_unmap) {
+                int page_count = ((m_size - 1) >> dirty_page_shift) + 1;
+                m_dirty_page_words = ((page_count - 1) / dirty_page_word_bits) + 1;
+                m_dirty_pages.reset(new dirty_page_word[m_dirty_page_words]);
+                for (int w = 0; w < m_dirty_page_words; ++w) {
+                    m_dirty_pages[w].store(0, std::memory_order_relaxed);
+                }
+            }
+
 #if !defined(ELECTROSLAG_BUILD_SHIP)
             if (buffer_desc->has_name_string()) {
-                std::string buffer_name(buffer_desc->get_name());
+                std::string buffer_name(buffer_desc->get_name().str());
                 gl::ObjectLabel(
                     gl::BUFFER,
                     buffer_id,
@@ -216,22 +229,93 @@ namespace electroslag {
 
             gl::MemoryBarrier(gl::CLIENT_MAPPED_BUFFER_BARRIER_BIT);
             context_opengl::check_opengl_error();
-
-            gl::Finish();
-            context_opengl::check_opengl_error();
         }
 
-        void buffer_opengl::opengl_flush_cpu_writes(int offset, int bytes)
+        void buffer_opengl::opengl_flush_cpu_writes()
         {
             ELECTROSLAG_CHECK(is_finished());
 
-            gl::BindBuffer(general_buffer_manipulation_target, m_id);
-            context_opengl::check_opengl_error();
+            // Clear the pending flag before scanning; any page marked after this
+            // point schedules a flush of its own.
+            m_flush_pending.store(false);
+
+            int run_start = -1;
+            for (int w = 0; w < m_dirty_page_words; ++w) {
+                unsigned long long word = m_dirty_pages[w].exchange(0);
+
+                // Skip the common cases a whole word at a time.
+                if ((word == 0 && run_start < 0) || (word == ~0ULL && run_start >= 0)) {
+                    continue;
+                }
+
+                for (int b = 0; b < dirty_page_word_bits; ++b) {
+                    int page = (w * dirty_page_word_bits) + b;
+                    if (word & (1ULL << b)) {
+                        if (run_start < 0) {
+                            run_start = page;
+                        }
+                    }
+                    else if (run_start >= 0) {
+                        opengl_flush_page_run(run_start, page);
+                        run_start = -1;
+                    }
+                }
+            }
 
-            gl::FlushMappedBufferRange(general_buffer_manipulation_target, offset, bytes);
+            if (run_start >= 0) {
+                opengl_flush_page_run(run_start, m_dirty_page_words * dirty_page_word_bits);
+            }
+        }
+
+        void buffer_opengl::opengl_flush_page_run(int first_page, int end_page)
+        {
+            int offset = first_page << dirty_page_shift;
+            int end = min(end_page << dirty_page_shift, m_size);
+            ELECTROSLAG_CHECK(offset < end);
+
+            gl::FlushMappedNamedBufferRange(m_id, offset, end - offset);
             context_opengl::check_opengl_error();
         }
 
+        void buffer_opengl::mark_dirty_pages(int offset, int bytes)
+        {
+            int first_page = offset >> dirty_page_shift;
+            int last_page = (offset + bytes - 1) >> dirty_page_shift;
+
+            int first_word = first_page / dirty_page_word_bits;
+            int last_word = last_page / dirty_page_word_bits;
+            for (int w = first_word; w <= last_word; ++w) {
+                int first_bit = (w == first_word) ? (first_page % dirty_page_word_bits) : 0;
+                int last_bit = (w == last_word) ? (last_page % dirty_page_word_bits) : (dirty_page_word_bits - 1);
+
+                unsigned long long mask = (~0ULL >> (dirty_page_word_bits - 1 - last_bit)) & (~0ULL << first_bit);
+                m_dirty_pages[w].fetch_or(mask);
+            }
+        }
+
+        void buffer_opengl::wait_for_range_fences(int offset, int bytes)
+        {
+            threading::lock_guard fence_lock(&m_fence_mutex);
+
+            range_fence_vector::iterator f(m_range_fences.begin());
+            while (f != m_range_fences.end()) {
+                bool overlaps = (f->offset < offset + bytes) && (offset < f->offset + f->bytes);
+                if (overlaps) {
+                    while (!f->sync->is_signaled()) {
+                        f->sync->wait(&fence_lock);
+                    }
+                }
+
+                // Fences that have passed are dropped whether or not they overlap.
+                if (f->sync->is_signaled()) {
+                    f = m_range_fences.erase(f);
+                }
+                else {
+                    ++f;
+                }
+            }
+        }
+
         void buffer_opengl::create_command::execute(
             context_interface* context
             )
@@ -261,17 +345,14 @@ namespace electroslag {
         }
 
         void buffer_opengl::flush_gpu_writes_command::execute(
-#if !defined(ELECTROSLAG_BUILD_SHIP)
             context_interface* context
-#else
-            context_interface*
-#endif
             )
         {
             ELECTROSLAG_CHECK(context);
             get_graphics()->get_render_thread()->check();
 
             m_buffer->opengl_flush_gpu_writes();
+            context->set_sync_point(m_finish_sync);
         }
 
         void buffer_opengl::flush_cpu_writes_command::execute(
@@ -285,7 +366,7 @@ namespace electroslag {
             ELECTROSLAG_CHECK(context);
             get_graphics()->get_render_thread()->check();
 
-            m_buffer->opengl_flush_cpu_writes(m_offset, m_bytes);
+            m_buffer->opengl_flush_cpu_writes();
         }
 
         byte* buffer_opengl::map(int offset, int bytes)
@@ -302,6 +383,9 @@ namespace electroslag {
                 flush_gpu_writes(offset, bytes);
             }
 
+            // Only GPU work fenced against this span holds up the mapping.
+            wait_for_range_fences(offset, bytes);
+
             return (m_mapped_pointer + offset);
         }
 
@@ -315,39 +399,66 @@ namespace electroslag {
 
         void buffer_opengl::flush_cpu_writes(int offset, int bytes)
         {
+            ELECTROSLAG_CHECK(is_finished());
+            if (!m_map_flags.flush_cpu_writes_on_unmap) {
+                // Coherent writes need no flush.
+                return;
+            }
+
+            ELECTROSLAG_CHECK(offset >= 0 && offset < m_size);
+            if (bytes <= 0) {
+                bytes = m_size - offset;
+            }
+            ELECTROSLAG_CHECK(offset + bytes <= m_size);
+
+            mark_dirty_pages(offset, bytes);
+
             graphics_interface* g = get_graphics();
 
             if (g->get_render_thread()->is_running()) {
-                opengl_flush_cpu_writes(offset, bytes);
+                opengl_flush_cpu_writes();
             }
-            else {
-                g->get_render_policy()->get_system_command_queue()->enqueue_command<flush_cpu_writes_command>(
-                    this,
-                    offset,
-                    bytes
-                    );
+            else if (!m_flush_pending.exchange(true)) {
+                // One flush command covers every span marked before it executes.
+                g->get_render_policy()->get_system_command_queue()->enqueue_command<flush_cpu_writes_command>(this);
             }
         }
 
-        void buffer_opengl::flush_gpu_writes(int, int)
+        void buffer_opengl::flush_gpu_writes(int offset, int bytes)
         {
+            ELECTROSLAG_CHECK(is_finished());
             graphics_interface* g = get_graphics();
 
             if (g->get_render_thread()->is_running()) {
                 opengl_flush_gpu_writes();
+
+                gl::Finish();
+                context_opengl::check_opengl_error();
             }
             else {
-                g->get_render_policy()->get_system_command_queue()->enqueue_command<flush_gpu_writes_command>(this);
+                // The barrier is fenced, so map waits for it without stalling the whole pipeline.
+                sync_interface::ref finish_sync(g->create_sync());
+                g->get_render_policy()->get_system_command_queue()->enqueue_command<flush_gpu_writes_command>(
+                    this,
+                    finish_sync
+                    );
+
+                fence_range(finish_sync, offset, bytes);
             }
         }
 
-        void buffer_opengl::bind(GLenum target) const
+        void buffer_opengl::fence_range(sync_interface::ref const& sync, int offset, int bytes)
         {
-            get_graphics()->get_render_thread()->check();
             ELECTROSLAG_CHECK(is_finished());
+            ELECTROSLAG_CHECK(sync.is_valid());
+            ELECTROSLAG_CHECK(offset >= 0 && offset < m_size);
+            if (bytes <= 0) {
+                bytes = m_size - offset;
+            }
+            ELECTROSLAG_CHECK(offset + bytes <= m_size);
 
-            gl::BindBuffer(target, m_id);
-            context_opengl::check_opengl_error();
+            threading::lock_guard fence_lock(&m_fence_mutex);
+            m_range_fences.emplace_back(sync, offset, bytes);
         }
 
         void buffer_opengl::bind_to_index(GLenum target, int index) const
@@ -355,8 +466,7 @@ namespace electroslag {
             get_graphics()->get_render_thread()->check();
             ELECTROSLAG_CHECK(is_finished());
 
-            gl::BindBufferBase(target, index, m_id);
-            context_opengl::check_opengl_error();
+            static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->bind_buffer_range(target, index, m_id, 0);
         }
 
         void buffer_opengl::bind_range_to_index(GLenum target, int index, int start, int end) const
@@ -376,8 +486,7 @@ namespace electroslag {
                 range_size = m_size - start;
             }
 
-            gl::BindBufferRange(target, index, m_id, start, range_size);
-            context_opengl::check_opengl_error();
+            static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->bind_buffer_range(target, index, m_id, start, range_size);
         }
     }
 }
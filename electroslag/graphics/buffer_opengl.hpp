@@ -15,6 +15,7 @@
 
 #pragma once
 #include "electroslag/ui/ui_interface.hpp"
+#include "electroslag/threading/mutex.hpp"
 #include "electroslag/graphics/graphics_types.hpp"
 #include "electroslag/graphics/buffer_descriptor.hpp"
 #include "electroslag/graphics/buffer_interface.hpp"
@@ -52,18 +53,19 @@ namespace electroslag {
             virtual void flush_cpu_writes(int offset = 0, int bytes = -1);
             virtual void flush_gpu_writes(int offset = 0, int bytes = -1);
 
-            // Called by context_opengl
-            void bind(GLenum target) const;
+            virtual void fence_range(sync_interface::ref const& sync, int offset = 0, int bytes = -1);
+
+            // Called by context_opengl and primitive_stream_opengl
+            opengl_object_id get_id() const
+            {
+                ELECTROSLAG_CHECK(is_finished());
+                return (m_id);
+            }
+
             void bind_to_index(GLenum target, int index) const;
             void bind_range_to_index(GLenum target, int index, int start, int end = -1) const;
 
         private:
-            // This class needs to do manipulations on buffers that require them to be
-            // bound to a target, but aren't really specific to any target. This
-            // target has no special semantics, so we can avoid using targets that actually
-            // mean something.
-            static GLenum const general_buffer_manipulation_target = gl::COPY_READ_BUFFER;
-
             class create_command : public command {
             public:
                 create_command(
@@ -119,15 +121,18 @@ namespace electroslag {
             class flush_gpu_writes_command : public command {
             public:
                 flush_gpu_writes_command(
-                    ref const& buffer
+                    ref const& buffer,
+                    sync_interface::ref const& finish_sync
                     )
                     : m_buffer(buffer)
+                    , m_finish_sync(finish_sync)
                 {}
 
                 virtual void execute(context_interface* context);
 
             private:
                 ref m_buffer;
+                sync_interface::ref m_finish_sync;
 
                 // Disallowed operations:
                 flush_gpu_writes_command();
@@ -137,22 +142,16 @@ namespace electroslag {
 
             class flush_cpu_writes_command : public command {
             public:
-                flush_cpu_writes_command(
-                    ref const& buffer,
-                    int offset,
-                    int bytes
+                explicit flush_cpu_writes_command(
+                    ref const& buffer
                     )
                     : m_buffer(buffer)
-                    , m_offset(offset)
-                    , m_bytes(bytes)
                 {}
 
                 virtual void execute(context_interface* context);
 
             private:
                 ref m_buffer;
-                int m_offset;
-                int m_bytes;
 
                 // Disallowed operations:
                 flush_cpu_writes_command();
@@ -165,6 +164,8 @@ namespace electroslag {
                 , m_mapped_pointer(0)
                 , m_size(0)
                 , m_id(0)
+                , m_dirty_page_words(0)
+                , m_flush_pending(false)
             {}
             virtual ~buffer_opengl();
 
@@ -176,7 +177,11 @@ namespace electroslag {
             static void opengl_destroy(opengl_object_id id);
 
             void opengl_flush_gpu_writes();
-            void opengl_flush_cpu_writes(int offset, int bytes);
+            void opengl_flush_cpu_writes();
+            void opengl_flush_page_run(int first_page, int end_page);
+
+            void mark_dirty_pages(int offset, int bytes);
+            void wait_for_range_fences(int offset, int bytes);
 
             std::atomic<bool> m_is_finished;
 
@@ -195,6 +200,34 @@ namespace electroslag {
                 bool flush_cpu_writes_on_unmap:1;
             } m_map_flags;
 
+            // Noncoherent CPU writes are tracked as one bit per dirty page. Writers on any
+            // thread only set bits; the render thread coalesces runs of set bits and flushes
+            // just those spans.
+            static int const dirty_page_shift = 8;
+            static int const dirty_page_word_bits = 64;
+            typedef std::atomic<unsigned long long> dirty_page_word;
+            std::unique_ptr<dirty_page_word[]> m_dirty_pages;
+            int m_dirty_page_words;
+            std::atomic<bool> m_flush_pending;
+
+            // Spans of the buffer still in use by GPU work, each with the sync that is
+            // set once that work is done.
+            struct range_fence {
+                range_fence(sync_interface::ref const& new_sync, int new_offset, int new_bytes)
+                    : sync(new_sync)
+                    , offset(new_offset)
+                    , bytes(new_bytes)
+                {}
+
+                sync_interface::ref sync;
+                int offset;
+                int bytes;
+            };
+            typedef std::vector<range_fence> range_fence_vector;
+
+            threading::mutex m_fence_mutex;
+            range_fence_vector m_range_fences;
+
             // Disallowed operations:
             explicit buffer_opengl(buffer_opengl const&);
             buffer_opengl& operator =(buffer_opengl const&);
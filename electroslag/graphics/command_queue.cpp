@@ -84,8 +84,9 @@ namespace electroslag {
 
 #if !defined(ELECTROSLAG_BUILD_SHIP)
             if (has_name_string()) {
-                context->push_debug_group(get_name());
+                context->push_debug_group(get_name().str());
             }
+            context->begin_gpu_timer(get_hash());
 #endif
 
             // Iterate over each thread that may have enqueued commands.
@@ -104,8 +105,9 @@ namespace electroslag {
             }
 
 #if !defined(ELECTROSLAG_BUILD_SHIP)
+            context->end_gpu_timer(get_hash());
             if (has_name_string()) {
-                context->pop_debug_group(get_name());
+                context->pop_debug_group(get_name().str());
             }
 #endif
         }
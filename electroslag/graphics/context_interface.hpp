@@ -49,6 +49,14 @@ namespace electroslag {
             virtual primitive_stream_interface::ref& get_primitive_stream() = 0;
             virtual void bind_primitive_stream(primitive_stream_interface::ref const& prim_stream) = 0;
 
+            // Bind a stream whose positions, and any attributes sharing their buffer, are
+            // read from vertex_buffer at vertex_offset, such as vertices deformed on the CPU.
+            virtual void bind_primitive_stream(
+                primitive_stream_interface::ref const& prim_stream,
+                buffer_interface::ref const& vertex_buffer,
+                int vertex_offset
+                ) = 0;
+
             virtual shader_program_interface::ref& get_shader_program() = 0;
             virtual void bind_shader_program(shader_program_interface::ref const& shader) = 0;
 
@@ -56,6 +64,9 @@ namespace electroslag {
             virtual void bind_uniform_buffer(buffer_interface::ref const& ubo, int binding) = 0;
             virtual void bind_uniform_buffer_range(buffer_interface::ref const& ubo, int binding, int start, int end = -1) = 0;
 
+            virtual buffer_interface::ref& get_shader_storage_buffer(int binding) = 0;
+            virtual void bind_shader_storage_buffer(buffer_interface::ref const& ssbo, int binding) = 0;
+
             virtual void set_sync_point(sync_interface::ref& sync) = 0;
 
             // State changes
@@ -68,13 +79,27 @@ namespace electroslag {
             virtual void clear_color(float red, float green, float blue, float alpha) = 0;
             virtual void clear_depth_stencil(float depth, int stencil = 0) = 0;
 
+            // The start offset counts indices, not bytes, in to the bound index buffer.
             virtual void draw(int element_count = 0, int index_buffer_start_offset = 0, int index_value_offset = 0) = 0;
 
+            // Draw several ranges of the bound index buffer in one call. Each range is an
+            // element count and a start offset in indices, as for draw; the arrays hold
+            // draw_count entries.
+            virtual void draw_multiple(
+                int draw_count,
+                int const* element_counts,
+                int const* index_buffer_start_offsets,
+                int index_value_offset = 0
+                ) = 0;
+
             virtual void swap() = 0;
 
 #if !defined(ELECTROSLAG_BUILD_SHIP)
             virtual void push_debug_group(std::string const& name) = 0;
             virtual void pop_debug_group(std::string const& name) = 0;
+
+            virtual void begin_gpu_timer(unsigned long long name_hash) = 0;
+            virtual void end_gpu_timer(unsigned long long name_hash) = 0;
 #endif
         };
     }
@@ -54,14 +54,17 @@ namespace electroslag {
             win32_initialize_context(params);
 #endif
 
-#if !defined(ELECTROSLAG_BUILD_SHIP)
-            // Listen to debug output from OpenGL
-            gl::DebugMessageCallback(debug_msg_callback, this);
-            gl::DebugMessageControl(gl::DONT_CARE, gl::DONT_CARE, gl::DONT_CARE, 0, 0, gl::TRUE_);
-            gl::Disable(gl::DEBUG_OUTPUT_SYNCHRONOUS);
-            context_opengl::check_opengl_error();
+#if ELECTROSLAG_GL_VALIDATION >= ELECTROSLAG_GL_VALIDATION_CALLBACK
+            initialize_debug_output(this);
+#endif
 
+            // Nothing is known about the new context's state.
+            static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->reset();
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
             m_graphics_debugger_attached = initialize_renderdoc();
+
+            m_gpu_timer.initialize(params->gpu_timing);
 #endif
 
             // All contexts have a frame buffer that represents rendering on-screen.
@@ -80,8 +83,14 @@ namespace electroslag {
             gl::GetIntegerv(gl::MAX_FRAGMENT_UNIFORM_BLOCKS, &m_max_stage_uniform_bindings[shader_stage_fragment]);
             gl::GetIntegerv(gl::MAX_COMPUTE_UNIFORM_BLOCKS, &m_max_stage_uniform_bindings[shader_stage_compute]);
             gl::GetIntegerv(gl::UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_min_ubo_offset_alignment);
+            gl::GetIntegerv(gl::MAX_SHADER_STORAGE_BUFFER_BINDINGS, &m_max_total_storage_bindings);
+
+            graphics_opengl* gfx = static_cast<graphics_opengl*>(get_graphics());
+            gfx->get_shader_program_cache()->initialize(params->shader_cache_path);
+            gfx->get_shader_compile_queue()->initialize();
 
             m_bound_uniform_buffers.resize(m_max_total_uniform_bindings);
+            m_bound_storage_buffers.resize(m_max_total_storage_bindings);
 
             // Default to counter-clockwise winding as front facing
             gl::FrontFace(gl::CCW);
@@ -99,6 +108,14 @@ namespace electroslag {
 
         void context_opengl::shutdown()
         {
+            graphics_opengl* gfx = static_cast<graphics_opengl*>(get_graphics());
+            gfx->get_shader_compile_queue()->shutdown();
+            gfx->get_shader_program_cache()->shutdown();
+            gfx->get_vertex_format_cache()->shutdown();
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            m_gpu_timer.shutdown();
+#endif
             m_display_frame_buffer.reset();
 
 #if defined(_WIN32)
@@ -119,6 +136,10 @@ namespace electroslag {
             m_bound_primitive_stream.reset();
             m_bound_shader_program.reset();
             m_bound_uniform_buffers.clear();
+            m_bound_storage_buffers.clear();
+
+            // The objects may now be deleted, so the GL names are no longer meaningful.
+            static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->reset();
         }
 
         void context_opengl::check_render_thread() const
@@ -150,12 +171,12 @@ namespace electroslag {
         void context_opengl::bind_frame_buffer(frame_buffer_interface::ref const& fbi)
         {
             check_render_thread();
-            if (fbi != m_bound_frame_buffer) {
-                if (fbi.is_valid()) {
-                    fbi.cast<frame_buffer_opengl>()->bind();
-                }
-                m_bound_frame_buffer = fbi;
+            // Always bind; objects created since may have changed the GL binding
+            // underneath, and the state cache filters what is really redundant.
+            if (fbi.is_valid()) {
+                fbi.cast<frame_buffer_opengl>()->bind();
             }
+            m_bound_frame_buffer = fbi;
         }
 
         primitive_stream_interface::ref& context_opengl::get_primitive_stream()
@@ -166,12 +187,22 @@ namespace electroslag {
         void context_opengl::bind_primitive_stream(primitive_stream_interface::ref const& prim_stream)
         {
             check_render_thread();
-            if (prim_stream != m_bound_primitive_stream) {
-                if (prim_stream.is_valid()) {
-                    prim_stream.cast<primitive_stream_opengl>()->bind();
-                }
-                m_bound_primitive_stream = prim_stream;
+            if (prim_stream.is_valid()) {
+                prim_stream.cast<primitive_stream_opengl>()->bind();
             }
+            m_bound_primitive_stream = prim_stream;
+        }
+
+        void context_opengl::bind_primitive_stream(
+            primitive_stream_interface::ref const& prim_stream,
+            buffer_interface::ref const& vertex_buffer,
+            int vertex_offset
+            )
+        {
+            check_render_thread();
+            ELECTROSLAG_CHECK(prim_stream.is_valid() && vertex_buffer.is_valid());
+            prim_stream.cast<primitive_stream_opengl>()->bind(vertex_buffer.cast<buffer_opengl>(), vertex_offset);
+            m_bound_primitive_stream = prim_stream;
         }
 
         shader_program_interface::ref& context_opengl::get_shader_program()
@@ -182,12 +213,10 @@ namespace electroslag {
         void context_opengl::bind_shader_program(shader_program_interface::ref const& shader)
         {
             check_render_thread();
-            if (shader != m_bound_shader_program) {
-                if (shader.is_valid()) {
-                    shader.cast<shader_program_opengl>()->bind();
-                }
-                m_bound_shader_program = shader;
+            if (shader.is_valid()) {
+                shader.cast<shader_program_opengl>()->bind();
             }
+            m_bound_shader_program = shader;
         }
 
         buffer_interface::ref& context_opengl::get_uniform_buffer(int binding)
@@ -213,110 +242,30 @@ namespace electroslag {
             m_bound_uniform_buffers[binding] = ubo;
         }
 
-        void context_opengl::set_depth_test(depth_test_params const* depth_test)
+        buffer_interface::ref& context_opengl::get_shader_storage_buffer(int binding)
         {
-            check_render_thread();
-            if (*depth_test != m_depth_test_params) {
-                if (depth_test->test_enable) {
-                    gl::Enable(gl::DEPTH_TEST);
-                    gl::DepthFunc(make_gl_depth_func(depth_test->test_mode));
-                }
-                else {
-                    gl::Disable(gl::DEPTH_TEST);
-                }
+            return (m_bound_storage_buffers[binding]);
+        }
 
-                if (depth_test->write_enable) {
-                    gl::DepthMask(gl::TRUE_);
-                }
-                else {
-                    gl::DepthMask(gl::FALSE_);
-                }
-                check_opengl_error();
-                m_depth_test_params = *depth_test;
+        void context_opengl::bind_shader_storage_buffer(buffer_interface::ref const& ssbo, int binding)
+        {
+            check_render_thread();
+            if (ssbo.is_valid()) {
+                ssbo.cast<buffer_opengl>()->bind_to_index(gl::SHADER_STORAGE_BUFFER, binding);
             }
+            m_bound_storage_buffers[binding] = ssbo;
         }
 
-        GLenum context_opengl::make_gl_depth_func(depth_test_mode test_mode)
+        void context_opengl::set_depth_test(depth_test_params const* depth_test)
         {
-            static GLenum const gl_depth_funcs[depth_test_mode_count] = {
-                gl::NEVER,
-                gl::LESS,
-                gl::EQUAL,
-                gl::LEQUAL,
-                gl::GREATER,
-                gl::NOTEQUAL,
-                gl::GEQUAL,
-                gl::ALWAYS
-            };
-
-            return (gl_depth_funcs[test_mode]);
+            check_render_thread();
+            static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->set_depth_test(depth_test);
         }
 
         void context_opengl::set_blending(blending_params const* blend)
         {
             check_render_thread();
-            if (*blend != m_blend_params) {
-                if (blend->enable) {
-                    gl::Enable(gl::BLEND);
-                    gl::BlendEquationSeparate(
-                        make_gl_blend_equation(blend->color_mode),
-                        make_gl_blend_equation(blend->alpha_mode)
-                        );
-                    gl::BlendFuncSeparate(
-                        make_gl_blend_func(blend->color_op1),
-                        make_gl_blend_func(blend->color_op2),
-                        make_gl_blend_func(blend->alpha_op1),
-                        make_gl_blend_func(blend->alpha_op2)
-                        );
-                }
-                else {
-                    gl::Disable(gl::BLEND);
-                }
-                check_opengl_error();
-                m_blend_params = *blend;
-            }
-        }
-
-        // static
-        GLenum context_opengl::make_gl_blend_equation(blending_mode mode)
-        {
-            static GLenum const gl_blend_equations[blending_mode_count] = {
-                gl::FUNC_ADD,
-                gl::FUNC_SUBTRACT,
-                gl::FUNC_REVERSE_SUBTRACT,
-                gl::MIN,
-                gl::MAX
-            };
-
-            return (gl_blend_equations[mode]);
-        }
-
-        // static
-        GLenum context_opengl::make_gl_blend_func(blending_operand op)
-        {
-            static GLenum const gl_blend_funcs[blending_operand_count] = {
-                gl::ZERO,
-                gl::ONE,
-                gl::SRC_COLOR,
-                gl::ONE_MINUS_SRC_COLOR,
-                gl::DST_COLOR,
-                gl::ONE_MINUS_DST_COLOR,
-                gl::SRC_ALPHA,
-                gl::ONE_MINUS_SRC_ALPHA,
-                gl::DST_ALPHA,
-                gl::ONE_MINUS_DST_ALPHA,
-                gl::CONSTANT_COLOR,
-                gl::ONE_MINUS_CONSTANT_COLOR,
-                gl::CONSTANT_ALPHA,
-                gl::ONE_MINUS_CONSTANT_ALPHA,
-                gl::SRC_ALPHA_SATURATE,
-                gl::SRC1_COLOR,
-                gl::ONE_MINUS_SRC1_COLOR,
-                gl::SRC1_ALPHA,
-                gl::ONE_MINUS_SRC1_ALPHA
-            };
-
-            return (gl_blend_funcs[op]);
+            static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->set_blending(blend);
         }
 
         void context_opengl::clear_color(float red, float green, float blue, float alpha)
@@ -358,7 +307,7 @@ namespace electroslag {
                     );
             }
 
-            intptr_t ibo_start_offset = index_buffer_start_offset;
+            intptr_t ibo_start_offset = static_cast<intptr_t>(index_buffer_start_offset) * sizeof_index;
             gl::DrawElementsBaseVertex(
                 primitive_type_util::get_opengl_primitive_type(prim_type),
                 element_count,
@@ -369,10 +318,67 @@ namespace electroslag {
             check_opengl_error();
         }
 
+        void context_opengl::draw_multiple(
+            int draw_count,
+            int const* element_counts,
+            int const* index_buffer_start_offsets,
+            int index_value_offset
+            )
+        {
+            check_render_thread();
+            ELECTROSLAG_CHECK(m_bound_frame_buffer.is_valid());
+            ELECTROSLAG_CHECK(m_bound_shader_program.is_valid());
+            ELECTROSLAG_CHECK(m_bound_primitive_stream.is_valid());
+            ELECTROSLAG_CHECK(draw_count >= 0);
+
+            if (draw_count == 0) {
+                return;
+            }
+
+            primitive_type prim_type = m_bound_primitive_stream.cast<primitive_stream_opengl>()->get_primitive_type();
+            int sizeof_index = m_bound_primitive_stream.cast<primitive_stream_opengl>()->get_sizeof_index();
+
+            m_multi_draw_counts.resize(draw_count);
+            m_multi_draw_offsets.resize(draw_count);
+            m_multi_draw_base_vertices.resize(draw_count);
+            for (int d = 0; d < draw_count; ++d) {
+                ELECTROSLAG_CHECK(element_counts[d] > 0);
+                ELECTROSLAG_CHECK(index_buffer_start_offsets[d] >= 0);
+
+                intptr_t ibo_start_offset = static_cast<intptr_t>(index_buffer_start_offsets[d]) * sizeof_index;
+                m_multi_draw_counts[d] = element_counts[d];
+                m_multi_draw_offsets[d] = reinterpret_cast<void const*>(ibo_start_offset);
+                m_multi_draw_base_vertices[d] = index_value_offset;
+            }
+
+            gl::MultiDrawElementsBaseVertex(
+                primitive_type_util::get_opengl_primitive_type(prim_type),
+                m_multi_draw_counts.data(),
+                primitive_type_util::get_opengl_index_size(sizeof_index),
+                m_multi_draw_offsets.data(),
+                draw_count,
+                m_multi_draw_base_vertices.data()
+                );
+            check_opengl_error();
+        }
+
         void context_opengl::swap()
         {
             check_render_thread();
 
+            // Finish any programs the driver has compiled, and textures the upload
+            // thread has streamed, since the last frame.
+            graphics_opengl* gfx = static_cast<graphics_opengl*>(get_graphics());
+            gfx->get_shader_compile_queue()->poll();
+            if (gfx->get_texture_upload_thread()->is_started()) {
+                gfx->get_texture_upload_thread()->end_frame();
+            }
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            m_gpu_timer.end_frame(this);
+            gfx->get_state_cache()->end_frame();
+#endif
+
 #if defined(_WIN32)
             if (!SwapBuffers(m_hdc)) {
                 throw win32_api_failure("SwapBuffers");
@@ -394,6 +400,18 @@ namespace electroslag {
             gl::PopDebugGroup();
             check_opengl_error();
         }
+
+        void context_opengl::begin_gpu_timer(unsigned long long name_hash)
+        {
+            check_render_thread();
+            m_gpu_timer.begin(name_hash);
+        }
+
+        void context_opengl::end_gpu_timer(unsigned long long name_hash)
+        {
+            check_render_thread();
+            m_gpu_timer.end(name_hash);
+        }
 #endif
 
 #if defined(_WIN32)
@@ -564,7 +582,7 @@ namespace electroslag {
                 wgl::CONTEXT_MAJOR_VERSION_ARB, 4,
                 wgl::CONTEXT_MINOR_VERSION_ARB, 5,
                 wgl::CONTEXT_PROFILE_MASK_ARB, wgl::CONTEXT_CORE_PROFILE_BIT_ARB,
-#if !defined(ELECTROSLAG_BUILD_SHIP)
+#if ELECTROSLAG_GL_VALIDATION >= ELECTROSLAG_GL_VALIDATION_CALLBACK
                 wgl::CONTEXT_FLAGS_ARB, wgl::CONTEXT_DEBUG_BIT_ARB,
 #endif
                 0 // "NULL" termination
@@ -614,6 +632,25 @@ namespace electroslag {
             }
             return (has_renderdoc);
         }
+#endif
+
+#if ELECTROSLAG_GL_VALIDATION >= ELECTROSLAG_GL_VALIDATION_CALLBACK
+        // static
+        void context_opengl::initialize_debug_output(void const* user_param)
+        {
+            // Listen to debug output from OpenGL
+            gl::DebugMessageCallback(debug_msg_callback, user_param);
+            gl::DebugMessageControl(gl::DONT_CARE, gl::DONT_CARE, gl::DONT_CARE, 0, 0, gl::TRUE_);
+#if ELECTROSLAG_GL_VALIDATION >= ELECTROSLAG_GL_VALIDATION_SYNC
+            // Report on the offending call so a breakpoint in the callback has a useful stack.
+            gl::Enable(gl::DEBUG_OUTPUT_SYNCHRONOUS);
+#else
+            // Notifications are chatty and are the bulk of callback cost when nothing is wrong.
+            gl::DebugMessageControl(gl::DONT_CARE, gl::DONT_CARE, gl::DEBUG_SEVERITY_NOTIFICATION, 0, 0, gl::FALSE_);
+            gl::Disable(gl::DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+            context_opengl::check_opengl_error();
+        }
 
         // static
         void APIENTRY context_opengl::debug_msg_callback(
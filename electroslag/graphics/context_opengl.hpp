@@ -16,16 +16,35 @@
 #pragma once
 #if !defined(ELECTROSLAG_BUILD_SHIP)
 #include "electroslag/dynamic_library.hpp"
+#include "electroslag/graphics/gpu_timer_opengl.hpp"
 #endif
 #include "electroslag/graphics/context_interface.hpp"
 
+// OpenGL validation levels. OFF relies on nothing; CALLBACK creates a debug
+// context and logs through debug_msg_callback asynchronously; SYNC also makes
+// debug output synchronous and polls glGetError after every checked call.
+#define ELECTROSLAG_GL_VALIDATION_OFF 0
+#define ELECTROSLAG_GL_VALIDATION_CALLBACK 1
+#define ELECTROSLAG_GL_VALIDATION_SYNC 2
+
+// May be overridden on the command line to e.g. get SYNC checking in RELEASE.
+#if !defined(ELECTROSLAG_GL_VALIDATION)
+#if defined(ELECTROSLAG_BUILD_DEBUG)
+#define ELECTROSLAG_GL_VALIDATION ELECTROSLAG_GL_VALIDATION_SYNC
+#elif defined(ELECTROSLAG_BUILD_RELEASE)
+#define ELECTROSLAG_GL_VALIDATION ELECTROSLAG_GL_VALIDATION_CALLBACK
+#else
+#define ELECTROSLAG_GL_VALIDATION ELECTROSLAG_GL_VALIDATION_OFF
+#endif
+#endif
+
 namespace electroslag {
     namespace graphics {
         class context_opengl : public context_interface {
         public:
             static void check_opengl_error()
             {
-#if defined(ELECTROSLAG_BUILD_DEBUG)
+#if ELECTROSLAG_GL_VALIDATION >= ELECTROSLAG_GL_VALIDATION_SYNC
                 GLenum error_code = gl::GetError();
                 if (error_code != gl::NO_ERROR_) {
                     throw opengl_api_failure("glGetError", error_code);
@@ -41,6 +60,7 @@ namespace electroslag {
             context_opengl()
                 : m_max_total_uniform_bindings(0)
                 , m_min_ubo_offset_alignment(0)
+                , m_max_total_storage_bindings(0)
 #if !defined(ELECTROSLAG_BUILD_SHIP)
                 , m_graphics_debugger_attached(false)
 #endif
@@ -82,6 +102,13 @@ namespace electroslag {
 #endif
             }
 
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            virtual bool is_gpu_timing_enabled() const
+            {
+                return (m_gpu_timer.is_enabled());
+            }
+#endif
+
             // Implement context_interface
             virtual void initialize(graphics_initialize_params const* params);
             virtual void shutdown();
@@ -94,6 +121,11 @@ namespace electroslag {
 
             virtual primitive_stream_interface::ref& get_primitive_stream();
             virtual void bind_primitive_stream(primitive_stream_interface::ref const& prim_stream);
+            virtual void bind_primitive_stream(
+                primitive_stream_interface::ref const& prim_stream,
+                buffer_interface::ref const& vertex_buffer,
+                int vertex_offset
+                );
 
             virtual shader_program_interface::ref& get_shader_program();
             virtual void bind_shader_program(shader_program_interface::ref const& shader);
@@ -102,6 +134,9 @@ namespace electroslag {
             virtual void bind_uniform_buffer(buffer_interface::ref const& ubo, int binding);
             virtual void bind_uniform_buffer_range(buffer_interface::ref const& ubo, int binding, int start, int end = -1);
 
+            virtual buffer_interface::ref& get_shader_storage_buffer(int binding);
+            virtual void bind_shader_storage_buffer(buffer_interface::ref const& ssbo, int binding);
+
             virtual void set_sync_point(sync_interface::ref& sync);
 
             virtual void set_depth_test(depth_test_params const* depth_test);
@@ -116,18 +151,31 @@ namespace electroslag {
                 int index_value_offset = 0
                 );
 
+            virtual void draw_multiple(
+                int draw_count,
+                int const* element_counts,
+                int const* index_buffer_start_offsets,
+                int index_value_offset = 0
+                );
+
             virtual void swap();
 
 #if !defined(ELECTROSLAG_BUILD_SHIP)
             virtual void push_debug_group(std::string const& name);
             virtual void pop_debug_group(std::string const& name);
+
+            virtual void begin_gpu_timer(unsigned long long name_hash);
+            virtual void end_gpu_timer(unsigned long long name_hash);
 #endif
 
             // These are all methods for use in enqueued commands.
             void check_render_thread() const;
             void check_not_render_thread() const;
 
-#if !defined(ELECTROSLAG_BUILD_SHIP)
+#if ELECTROSLAG_GL_VALIDATION >= ELECTROSLAG_GL_VALIDATION_CALLBACK
+            // Install debug_msg_callback on the current context; shared with sub-contexts.
+            static void initialize_debug_output(void const* user_param);
+
             static void APIENTRY debug_msg_callback(
                 GLenum source,
                 GLenum type,
@@ -161,10 +209,6 @@ namespace electroslag {
                 );
 #endif
 
-            static GLenum make_gl_depth_func(depth_test_mode test_mode);
-            static GLenum make_gl_blend_equation(blending_mode mode);
-            static GLenum make_gl_blend_func(blending_operand op);
-
             // There is always a frame buffer associated with the display.
             frame_buffer_interface::ref m_display_frame_buffer;
 
@@ -172,6 +216,7 @@ namespace electroslag {
             int m_max_total_uniform_bindings;
             int m_max_stage_uniform_bindings[shader_stage_count];
             int m_min_ubo_offset_alignment;
+            int m_max_total_storage_bindings;
 
 #if !defined(ELECTROSLAG_BUILD_SHIP)
             // Set on context create. No support yet for "detaching" a
@@ -180,6 +225,8 @@ namespace electroslag {
 
             bool initialize_renderdoc();
             dynamic_library m_renderdoc_library;
+
+            gpu_timer_opengl m_gpu_timer;
 #endif
 
             // These are the current objects.
@@ -189,10 +236,12 @@ namespace electroslag {
 
             typedef std::vector<buffer_interface::ref> uniform_buffer_binding_vector;
             uniform_buffer_binding_vector m_bound_uniform_buffers;
+            uniform_buffer_binding_vector m_bound_storage_buffers;
 
-            // Cached state copy
-            blending_params m_blend_params;
-            depth_test_params m_depth_test_params;
+            // Scratch arrays for draw_multiple; only touched on the render thread.
+            std::vector<GLsizei> m_multi_draw_counts;
+            std::vector<void const*> m_multi_draw_offsets;
+            std::vector<GLint> m_multi_draw_base_vertices;
 
 #if defined(_WIN32)
             class win32_dummy_context {
@@ -214,16 +214,14 @@ namespace electroslag {
             ELECTROSLAG_CHECK(!is_finished());
             ELECTROSLAG_CHECK(m_type != frame_buffer_type_display);
 
+            // Direct state access throughout; creation leaves the bound frame buffer alone.
             opengl_object_id frame_buffer_id = 0;
-            gl::GenFramebuffers(1, &frame_buffer_id);
+            gl::CreateFramebuffers(1, &frame_buffer_id);
             context_opengl::check_opengl_error();
 
             ELECTROSLAG_CHECK(!m_frame_buffer_id);
             m_frame_buffer_id = frame_buffer_id;
 
-            gl::BindFramebuffer(gl::FRAMEBUFFER, frame_buffer_id);
-            context_opengl::check_opengl_error();
-
             // Create a depth/stencil texture, if needed.
             GLenum depth_stencil_format = 0;
             GLenum depth_stencil_attachment = gl::DEPTH_ATTACHMENT;
@@ -268,17 +266,14 @@ namespace electroslag {
             if (depth_stencil_format) {
                 opengl_object_id depth_texture_id = 0;
 
-                gl::GenTextures(1, &depth_texture_id);
+                gl::CreateTextures(gl::TEXTURE_2D, 1, &depth_texture_id);
                 context_opengl::check_opengl_error();
 
                 ELECTROSLAG_CHECK(!m_depth_texture_id);
                 m_depth_texture_id = depth_texture_id;
 
-                gl::BindTexture(gl::TEXTURE_2D, depth_texture_id);
-                context_opengl::check_opengl_error();
-
-                gl::TexStorage2D(
-                    gl::TEXTURE_2D,
+                gl::TextureStorage2D(
+                    depth_texture_id,
                     1,
                     depth_stencil_format,
                     m_width,
@@ -286,7 +281,7 @@ namespace electroslag {
                     );
                 context_opengl::check_opengl_error();
 
-                gl::FramebufferTexture2D(gl::FRAMEBUFFER, depth_stencil_attachment, gl::TEXTURE_2D, depth_texture_id, 0);
+                gl::NamedFramebufferTexture(frame_buffer_id, depth_stencil_attachment, depth_texture_id, 0);
                 context_opengl::check_opengl_error();
             }
 
@@ -312,17 +307,14 @@ namespace electroslag {
 
             if (color_format) {
                 opengl_object_id color_texture_id = 0;
-                gl::GenTextures(1, &color_texture_id);
+                gl::CreateTextures(gl::TEXTURE_2D, 1, &color_texture_id);
                 context_opengl::check_opengl_error();
 
                 ELECTROSLAG_CHECK(!m_color_texture_id);
                 m_color_texture_id = color_texture_id;
 
-                gl::BindTexture(gl::TEXTURE_2D, color_texture_id);
-                context_opengl::check_opengl_error();
-
-                gl::TexStorage2D(
-                    gl::TEXTURE_2D,
+                gl::TextureStorage2D(
+                    color_texture_id,
                     1,
                     color_format,
                     m_width,
@@ -330,12 +322,12 @@ namespace electroslag {
                     );
                 context_opengl::check_opengl_error();
 
-                gl::FramebufferTexture2D(gl::FRAMEBUFFER, color_attachment, gl::TEXTURE_2D, color_texture_id, 0);
+                gl::NamedFramebufferTexture(frame_buffer_id, color_attachment, color_texture_id, 0);
                 context_opengl::check_opengl_error();
             }
 
             // Extra check to ensure we have a valid frame buffer
-            GLenum frame_buffer_status = gl::CheckFramebufferStatus(gl::FRAMEBUFFER);
+            GLenum frame_buffer_status = gl::CheckNamedFramebufferStatus(frame_buffer_id, gl::FRAMEBUFFER);
             if (frame_buffer_status != gl::FRAMEBUFFER_COMPLETE) {
                 throw opengl_api_failure("Frame buffer is incomplete", frame_buffer_status);
             }
@@ -352,6 +344,7 @@ namespace electroslag {
         {
             if (frame_buffer_id) {
                 gl::DeleteFramebuffers(1, &frame_buffer_id);
+                static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->forget_frame_buffer(frame_buffer_id);
             }
             if (depth_texture_id) {
                 gl::DeleteTextures(1, &depth_texture_id);
@@ -366,30 +359,23 @@ namespace electroslag {
             get_graphics()->get_render_thread()->check();
             ELECTROSLAG_CHECK(is_finished());
 
+            state_cache_opengl* state_cache = static_cast<graphics_opengl*>(get_graphics())->get_state_cache();
             if (m_type == frame_buffer_type_off_screen) {
                 ELECTROSLAG_CHECK(m_frame_buffer_id);
-                gl::BindFramebuffer(gl::FRAMEBUFFER, m_frame_buffer_id);
+                state_cache->bind_frame_buffer(m_frame_buffer_id);
             }
             else {
-                gl::BindFramebuffer(gl::FRAMEBUFFER, 0);
+                state_cache->bind_frame_buffer(0);
             }
-            context_opengl::check_opengl_error();
 
-            if (m_attribs.color_format == frame_buffer_color_format_r8g8b8a8_srgb) {
-                gl::Enable(gl::FRAMEBUFFER_SRGB);
-            }
-            else {
-                gl::Disable(gl::FRAMEBUFFER_SRGB);
-            }
-            context_opengl::check_opengl_error();
+            state_cache->set_frame_buffer_srgb(m_attribs.color_format == frame_buffer_color_format_r8g8b8a8_srgb);
 
             opengl_set_viewport();
         }
 
         void frame_buffer_opengl::opengl_set_viewport() const
         {
-            gl::Viewport(0, 0, m_width, m_height);
-            context_opengl::check_opengl_error();
+            static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->set_viewport(m_width, m_height);
         }
     }
 }
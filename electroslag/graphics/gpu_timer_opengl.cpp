@@ -0,0 +1,180 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/ui/ui_interface.hpp"
+#include "electroslag/graphics/graphics_interface.hpp"
+#include "electroslag/graphics/context_interface.hpp"
+#include "electroslag/graphics/context_opengl.hpp"
+#include "electroslag/graphics/gpu_timer_opengl.hpp"
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+namespace electroslag {
+    namespace graphics {
+        void gpu_timer_opengl::initialize(bool enabled)
+        {
+            m_enabled = enabled;
+            if (!m_enabled) {
+                return;
+            }
+
+            for (int s = 0; s < frame_slot_count; ++s) {
+                m_slots[s].sync = get_graphics()->create_sync();
+            }
+
+            m_current_slot = 0;
+            m_recording = true;
+        }
+
+        void gpu_timer_opengl::shutdown()
+        {
+            for (int s = 0; s < frame_slot_count; ++s) {
+                frame_slot* slot = &m_slots[s];
+                if (!slot->queries.empty()) {
+                    gl::DeleteQueries(static_cast<GLsizei>(slot->queries.size()), &slot->queries.front());
+                    slot->queries.clear();
+                }
+                slot->samples.clear();
+                slot->sync.reset();
+                slot->open_sample = -1;
+                slot->in_flight = false;
+            }
+
+            m_enabled = false;
+            m_recording = false;
+        }
+
+        void gpu_timer_opengl::begin(unsigned long long name_hash)
+        {
+            if (!m_recording) {
+                return;
+            }
+
+            frame_slot* slot = &m_slots[m_current_slot];
+            ELECTROSLAG_CHECK(slot->open_sample == -1);
+
+            if (slot->samples.empty()) {
+                calibrate(slot);
+            }
+
+            // Two queries per sample; the pool only ever grows.
+            int sample_index = static_cast<int>(slot->samples.size());
+            int needed_queries = (sample_index + 1) * 2;
+            if (static_cast<int>(slot->queries.size()) < needed_queries) {
+                slot->queries.resize(needed_queries);
+                gl::GenQueries(2, &slot->queries[needed_queries - 2]);
+                context_opengl::check_opengl_error();
+            }
+
+            gpu_timer_sample sample = { 0 };
+            sample.name_hash = name_hash;
+            sample.frame_number = m_frame_number;
+            sample.cpu_begin = read_cpu_nanoseconds();
+            slot->samples.emplace_back(sample);
+            slot->open_sample = sample_index;
+
+            gl::QueryCounter(slot->queries[sample_index * 2], gl::TIMESTAMP);
+            context_opengl::check_opengl_error();
+        }
+
+        void gpu_timer_opengl::end(unsigned long long name_hash)
+        {
+            if (!m_recording) {
+                return;
+            }
+
+            frame_slot* slot = &m_slots[m_current_slot];
+            int sample_index = slot->open_sample;
+            ELECTROSLAG_CHECK(sample_index >= 0);
+            ELECTROSLAG_CHECK(slot->samples[sample_index].name_hash == name_hash);
+
+            gl::QueryCounter(slot->queries[(sample_index * 2) + 1], gl::TIMESTAMP);
+            context_opengl::check_opengl_error();
+
+            slot->samples[sample_index].cpu_end = read_cpu_nanoseconds();
+            slot->open_sample = -1;
+        }
+
+        void gpu_timer_opengl::end_frame(context_interface* context)
+        {
+            if (!m_enabled) {
+                return;
+            }
+
+            // Fence the queries issued this frame.
+            frame_slot* slot = &m_slots[m_current_slot];
+            ELECTROSLAG_CHECK(slot->open_sample == -1);
+            if (m_recording && !slot->samples.empty()) {
+                context->set_sync_point(slot->sync);
+                slot->in_flight = true;
+            }
+
+            // Read back every slot the sync thread has seen complete.
+            for (int s = 0; s < frame_slot_count; ++s) {
+                frame_slot* resolve_slot = &m_slots[s];
+                if (resolve_slot->in_flight && resolve_slot->sync->is_signaled()) {
+                    resolve(resolve_slot);
+                }
+            }
+
+            ++m_frame_number;
+            m_current_slot = (m_current_slot + 1) % frame_slot_count;
+            m_recording = !m_slots[m_current_slot].in_flight;
+        }
+
+        void gpu_timer_opengl::calibrate(frame_slot* slot)
+        {
+            // Pair the GPU clock with the CPU clock once per frame so the GPU
+            // timestamps can be moved onto the CPU timeline.
+            GLint64 gpu_now = 0;
+            gl::GetInteger64v(gl::TIMESTAMP, &gpu_now);
+            context_opengl::check_opengl_error();
+
+            slot->calibration_offset = read_cpu_nanoseconds() - gpu_now;
+        }
+
+        void gpu_timer_opengl::resolve(frame_slot* slot)
+        {
+            // The fence has passed, so every query result is already available.
+            int sample_count = static_cast<int>(slot->samples.size());
+            for (int i = 0; i < sample_count; ++i) {
+                GLuint64 gpu_begin = 0;
+                GLuint64 gpu_end = 0;
+                gl::GetQueryObjectui64v(slot->queries[i * 2], gl::QUERY_RESULT, &gpu_begin);
+                gl::GetQueryObjectui64v(slot->queries[(i * 2) + 1], gl::QUERY_RESULT, &gpu_end);
+
+                gpu_timer_sample* sample = &slot->samples[i];
+                sample->gpu_begin = static_cast<long long>(gpu_begin) + slot->calibration_offset;
+                sample->gpu_end = static_cast<long long>(gpu_end) + slot->calibration_offset;
+            }
+            context_opengl::check_opengl_error();
+
+            if (sample_count > 0) {
+                get_graphics()->gpu_timer_samples.signal(&slot->samples.front(), sample_count);
+            }
+
+            slot->samples.clear();
+            slot->sync->clear();
+            slot->in_flight = false;
+        }
+
+        long long gpu_timer_opengl::read_cpu_nanoseconds() const
+        {
+            // Same clock as the frame event, so samples line up with frame times.
+            return (ui::get_ui()->get_timer()->read_nanoseconds());
+        }
+    }
+}
+#endif
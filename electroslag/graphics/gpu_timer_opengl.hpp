@@ -0,0 +1,102 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/graphics/graphics_types.hpp"
+#include "electroslag/graphics/graphics_debugger_interface.hpp"
+#include "electroslag/graphics/sync_interface.hpp"
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+namespace electroslag {
+    namespace graphics {
+        class context_interface;
+
+        // Brackets command queue execution with GL_TIMESTAMP queries. Queries are
+        // recycled from a ring of per-frame slots; each slot is fenced with a
+        // sync object at the end of the frame and only read back once the sync
+        // thread has seen the fence pass, so resolving never stalls the render
+        // thread.
+        class gpu_timer_opengl {
+        public:
+            gpu_timer_opengl()
+                : m_enabled(false)
+                , m_recording(false)
+                , m_frame_number(0)
+                , m_current_slot(0)
+            {}
+
+            ~gpu_timer_opengl()
+            {}
+
+            void initialize(bool enabled);
+            void shutdown();
+
+            bool is_enabled() const
+            {
+                return (m_enabled);
+            }
+
+            void begin(unsigned long long name_hash);
+            void end(unsigned long long name_hash);
+
+            // Called once per frame, at swap.
+            void end_frame(context_interface* context);
+
+        private:
+            // Slots stay in flight long enough for the sync thread to catch up
+            // with the GPU without the render thread waiting on it.
+            static int const frame_slot_count = 4;
+
+            typedef std::vector<opengl_object_id> query_vector;
+            typedef std::vector<gpu_timer_sample> sample_vector;
+
+            struct frame_slot {
+                frame_slot()
+                    : calibration_offset(0)
+                    , open_sample(-1)
+                    , in_flight(false)
+                {}
+
+                query_vector queries;
+                sample_vector samples;
+                sync_interface::ref sync;
+                long long calibration_offset;
+                int open_sample;
+                bool in_flight;
+            };
+
+            void calibrate(frame_slot* slot);
+            void resolve(frame_slot* slot);
+
+            long long read_cpu_nanoseconds() const;
+
+            bool m_enabled;
+
+            // False when the GPU is so far behind that the next slot is still
+            // in flight; that frame goes untimed rather than stalling.
+            bool m_recording;
+
+            long long m_frame_number;
+            int m_current_slot;
+
+            frame_slot m_slots[frame_slot_count];
+
+            // Disallowed operations:
+            explicit gpu_timer_opengl(gpu_timer_opengl const&);
+            gpu_timer_opengl& operator =(gpu_timer_opengl const&);
+        };
+    }
+}
+#endif
@@ -17,12 +17,49 @@
 
 namespace electroslag {
     namespace graphics {
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+        // One timed command queue execution. All times are in nanoseconds on the
+        // CPU timeline; GPU timestamps are converted using a per-frame calibration
+        // so both can be displayed together.
+        struct gpu_timer_sample {
+            unsigned long long name_hash;
+            long long frame_number;
+            long long cpu_begin;
+            long long cpu_end;
+            long long gpu_begin;
+            long long gpu_end;
+        };
+
+        // GL state changes requested of state_cache_opengl in one frame, split
+        // by whether the call reached the driver or was a no-op and skipped.
+        enum state_filter_category {
+            state_filter_category_frame_buffer,
+            state_filter_category_program,
+            state_filter_category_vertex_array,
+            state_filter_category_indexed_buffer,
+            state_filter_category_depth_test,
+            state_filter_category_blending,
+
+            state_filter_category_count
+        };
+
+        struct state_filter_counters {
+            long long frame_number;
+            int issued[state_filter_category_count];
+            int filtered[state_filter_category_count];
+        };
+#endif
+
         class graphics_debugger_interface {
         public:
             virtual ~graphics_debugger_interface()
             {}
 
             virtual bool is_graphics_debugger_attached() const = 0;
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            virtual bool is_gpu_timing_enabled() const = 0;
+#endif
         };
     }
 }
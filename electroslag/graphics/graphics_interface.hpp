@@ -14,6 +14,7 @@
 //  limitations under the License.
 
 #pragma once
+#include "electroslag/event.hpp"
 #include "electroslag/graphics/graphics_types.hpp"
 #include "electroslag/graphics/shader_field_map.hpp"
 #include "electroslag/graphics/command_queue_interface.hpp"
@@ -144,6 +145,21 @@ namespace electroslag {
             virtual graphics_debugger_interface* get_graphics_debugger() = 0;
 
             virtual void finish_setting_sync(sync_interface::ref& s) = 0;
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            // Signaled on the render thread a few frames after the timed command
+            // queues executed, once the GPU has passed the frame's sync object.
+            // Bind before graphics is initialized.
+            typedef event<void, gpu_timer_sample const*, int> gpu_timer_samples_event;
+            typedef gpu_timer_samples_event::bound_delegate gpu_timer_samples_delegate;
+            mutable gpu_timer_samples_event gpu_timer_samples;
+
+            // Signaled on the render thread at every swap with the state cache
+            // counters for the frame just submitted.
+            typedef event<void, state_filter_counters const*> state_filter_counters_event;
+            typedef state_filter_counters_event::bound_delegate state_filter_counters_delegate;
+            mutable state_filter_counters_event state_filter_counters_updated;
+#endif
         };
 
         graphics_interface* get_graphics();
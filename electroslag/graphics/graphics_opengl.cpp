@@ -57,6 +57,7 @@ namespace electroslag {
 
             initialize_render_thread(params);
             initialize_sync_thread();
+            initialize_texture_upload_thread(params);
 
             m_initialized = true;
         }
@@ -70,6 +71,7 @@ namespace electroslag {
 
                 m_render_policy.destroy_graphics_objects();
 
+                shutdown_texture_upload_thread();
                 shutdown_sync_thread();
                 shutdown_render_thread();
 
@@ -272,6 +274,26 @@ namespace electroslag {
             m_sync_thread.wait_for_ready();
         }
 
+        void graphics_opengl::initialize_texture_upload_thread(graphics_initialize_params const* params)
+        {
+            ELECTROSLAG_CHECK(!m_texture_upload_thread.is_started());
+
+            int budget_bytes = static_cast<int>(params->texture_upload_megabytes_per_frame * 1024.0f * 1024.0f);
+            if (budget_bytes > 0) {
+                m_texture_upload_thread.spawn(budget_bytes);
+                m_texture_upload_thread.wait_for_ready();
+            }
+        }
+
+        void graphics_opengl::shutdown_texture_upload_thread()
+        {
+            if (m_texture_upload_thread.is_started()) {
+                m_texture_upload_thread.signal_exit();
+                m_texture_upload_thread.wait_for_exit();
+                m_texture_upload_thread.join();
+            }
+        }
+
         void graphics_opengl::shutdown_sync_thread()
         {
             // Process the last batch of commands and destroy the command
@@ -17,6 +17,11 @@
 #include "electroslag/threading/mutex.hpp"
 #include "electroslag/graphics/graphics_interface.hpp"
 #include "electroslag/graphics/sync_thread_opengl.hpp"
+#include "electroslag/graphics/shader_program_cache_opengl.hpp"
+#include "electroslag/graphics/shader_compile_queue_opengl.hpp"
+#include "electroslag/graphics/texture_upload_thread_opengl.hpp"
+#include "electroslag/graphics/state_cache_opengl.hpp"
+#include "electroslag/graphics/vertex_format_cache_opengl.hpp"
 
 namespace electroslag {
     namespace graphics {
@@ -154,6 +159,32 @@ namespace electroslag {
                 m_sync_thread.wait_for_sync(s);
             }
 
+            // Render thread only; these are initialized by context_opengl.
+            shader_program_cache_opengl* get_shader_program_cache()
+            {
+                return (&m_shader_program_cache);
+            }
+
+            shader_compile_queue_opengl* get_shader_compile_queue()
+            {
+                return (&m_shader_compile_queue);
+            }
+
+            texture_upload_thread_opengl* get_texture_upload_thread()
+            {
+                return (&m_texture_upload_thread);
+            }
+
+            state_cache_opengl* get_state_cache()
+            {
+                return (&m_state_cache);
+            }
+
+            vertex_format_cache_opengl* get_vertex_format_cache()
+            {
+                return (&m_vertex_format_cache);
+            }
+
 #if defined(_WIN32)
             // This is signaled by context_opengl when it's now time for sub-contexts
             // to create their own GL context. It has to be here so it is constructed
@@ -176,6 +207,16 @@ namespace electroslag {
             void shutdown_sync_thread();
             sync_thread_opengl m_sync_thread;
 
+            // Streams texture pixels through its own shared context.
+            void initialize_texture_upload_thread(graphics_initialize_params const* params);
+            void shutdown_texture_upload_thread();
+            texture_upload_thread_opengl m_texture_upload_thread;
+
+            shader_program_cache_opengl m_shader_program_cache;
+            shader_compile_queue_opengl m_shader_compile_queue;
+            state_cache_opengl m_state_cache;
+            vertex_format_cache_opengl m_vertex_format_cache;
+
             bool m_initialized;
 
             // Disallowed operations:
@@ -143,6 +143,7 @@ namespace electroslag {
             field_type_texture_handle,
             field_type_mat3,
             field_type_mat4,
+            field_type_texture_index, // Index into the renderer's bindless texture table
             field_type_count // Ensure this is the last enum entry
         };
 
@@ -154,7 +155,8 @@ namespace electroslag {
             "field_type_quat",
             "field_type_texture_handle",
             "field_type_mat3",
-            "field_type_mat4"
+            "field_type_mat4",
+            "field_type_texture_index"
         };
 
         namespace field_type_util {
@@ -162,6 +164,7 @@ namespace electroslag {
             {
                 switch (type) {
                 case field_type_texture_handle:
+                case field_type_texture_index:
                     return (1);
                 case field_type_vec2:
                 case field_type_uvec2:
@@ -192,6 +195,8 @@ namespace electroslag {
                     return (sizeof(uint32_t) * 2);
                 case field_type_texture_handle:
                     return (sizeof(uint64_t));
+                case field_type_texture_index:
+                    return (sizeof(uint32_t));
                 case field_type_mat3:
                     return (sizeof(float) * 9);
                 case field_type_mat4:
@@ -212,6 +217,7 @@ namespace electroslag {
                 case field_type_mat4:
                     return (gl::FLOAT);
                 case field_type_uvec2:
+                case field_type_texture_index:
                     return (gl::UNSIGNED_INT);
                 case field_type_texture_handle:
                     return (gl::TEXTURE); // This is likely not useful for anything. But distinct.
@@ -273,6 +279,73 @@ namespace electroslag {
             struct mat4 : public glm::f32mat4 {
                 static constexpr field_type get_field_type() { return (field_type_mat4); }
             };
+
+            struct texture_index {
+                static constexpr field_type get_field_type() { return (field_type_texture_index); }
+
+                texture_index()
+                    : i(0)
+                {}
+
+                uint32_t i;
+            };
+        }
+
+        // How each component of a vertex attribute is stored in its buffer. Shaders read
+        // floats regardless; integer components are converted, and optionally normalized,
+        // by vertex fetch.
+        enum attribute_component_type {
+            attribute_component_type_unknown = -1,
+            attribute_component_type_float,
+            attribute_component_type_byte,
+            attribute_component_type_unsigned_byte,
+            attribute_component_type_short,
+            attribute_component_type_unsigned_short,
+            attribute_component_type_count // Ensure this is the last enum entry
+        };
+
+        static char const* const attribute_component_type_strings[attribute_component_type_count] = {
+            "attribute_component_type_float",
+            "attribute_component_type_byte",
+            "attribute_component_type_unsigned_byte",
+            "attribute_component_type_short",
+            "attribute_component_type_unsigned_short"
+        };
+
+        namespace attribute_component_type_util {
+            inline int get_bytes(attribute_component_type type)
+            {
+                switch (type) {
+                case attribute_component_type_float:
+                    return (sizeof(float));
+                case attribute_component_type_byte:
+                case attribute_component_type_unsigned_byte:
+                    return (sizeof(uint8_t));
+                case attribute_component_type_short:
+                case attribute_component_type_unsigned_short:
+                    return (sizeof(uint16_t));
+                default:
+                    throw std::logic_error("invalid tag enum value");
+                }
+            }
+
+            inline GLenum get_opengl_type(attribute_component_type type)
+            {
+                switch (type) {
+                case attribute_component_type_float:
+                    return (gl::FLOAT);
+                case attribute_component_type_byte:
+                    return (gl::BYTE);
+                case attribute_component_type_unsigned_byte:
+                    return (gl::UNSIGNED_BYTE);
+                case attribute_component_type_short:
+                    return (gl::SHORT);
+                case attribute_component_type_unsigned_short:
+                    return (gl::UNSIGNED_SHORT);
+                default:
+                    throw std::logic_error("invalid tag enum value");
+                }
+            }
         }
 
         enum buffer_memory_map {
@@ -787,10 +860,24 @@ namespace electroslag {
         struct graphics_initialize_params {
             graphics_initialize_params()
                 : swap_interval(0)
+                , texture_upload_megabytes_per_frame(4.0f)
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+                , gpu_timing(false)
+#endif
             {}
 
             frame_buffer_attribs display_attribs;
             int swap_interval;
+
+            // Directory for linked program binaries; empty disables the cache.
+            std::string shader_cache_path;
+
+            // Budget for the texture upload thread; zero uploads textures on the
+            // render thread instead.
+            float texture_upload_megabytes_per_frame;
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            bool gpu_timing;
+#endif
         };
 
         class context_interface;
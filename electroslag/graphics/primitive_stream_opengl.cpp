@@ -15,7 +15,7 @@
 
 #include "electroslag/precomp.hpp"
 #include "electroslag/graphics/primitive_stream_opengl.hpp"
-#include "electroslag/graphics/graphics_interface.hpp"
+#include "electroslag/graphics/graphics_opengl.hpp"
 #include "electroslag/graphics/context_opengl.hpp"
 #include "electroslag/graphics/buffer_opengl.hpp"
 #include "electroslag/serialize/database.hpp"
@@ -71,37 +71,14 @@ namespace electroslag {
                 }
                 m_vbo_vector.clear();
 
-                if (m_vertex_array_id) {
-                    graphics_interface* g = get_graphics();
-
-                    if (g->get_render_thread()->is_running()) {
-                        opengl_destroy(m_vertex_array_id);
-                    }
-                    else {
-                        // This command can run completely asynchronously to "this" objects destruction.
-                        g->get_render_policy()->get_system_command_queue()->enqueue_command<destroy_command>(
-                            m_vertex_array_id
-                            );
-                    }
-
-                    m_vertex_array_id = 0;
-                }
+                // The vertex array is owned by the vertex format cache.
+                m_vertex_format = 0;
             }
             else {
                 ELECTROSLAG_LOG_WARN("primitive_stream_opengl destructor before finished");
             }
         }
 
-        // static
-        void primitive_stream_opengl::opengl_destroy(
-            opengl_object_id vertex_array_id
-            )
-        {
-            if (vertex_array_id) {
-                gl::DeleteVertexArrays(1, &vertex_array_id);
-            }
-        }
-
         void primitive_stream_opengl::opengl_create(
             primitive_stream_descriptor::ref const& prim_stream_desc
             )
@@ -113,88 +90,72 @@ namespace electroslag {
 
             m_ibo = buffer_opengl::create(prim_stream_desc->get_index_buffer());
 
-            opengl_object_id vertex_array_id = 0;
-            gl::GenVertexArrays(1, &vertex_array_id);
-            context_opengl::check_opengl_error();
-
-            ELECTROSLAG_CHECK(!m_vertex_array_id);
-            m_vertex_array_id = vertex_array_id;
-
-            gl::BindVertexArray(vertex_array_id);
-            context_opengl::check_opengl_error();
-
-            m_vbo_vector.resize(prim_stream_desc->get_attribute_count());
+            // Everything is direct state access; only the layout decides which
+            // vertex array is used, and the buffers are attached at bind time.
+            vertex_format_cache_opengl::format_desc format_desc;
+            buffer_hash_vector binding_buffer_hashes;
             primitive_stream_descriptor::const_attribute_iterator i(prim_stream_desc->begin_attributes());
             while (i != prim_stream_desc->end_attributes()) {
-                opengl_create_vbo(prim_stream_desc, i);
-
                 vertex_attribute const* vert_attrib = (*i);
-                shader_field const* vert_field = vert_attrib->get_field();
+                int binding = opengl_create_vbo(vert_attrib, &format_desc, &binding_buffer_hashes);
 
-                int index = vert_field->get_index();
+                shader_field const* vert_field = vert_attrib->get_field();
                 field_type type = vert_field->get_field_type();
 
-                intptr_t attrib_offset = vert_field->get_offset();
-                gl::VertexAttribPointer(
-                    index,
+                if (vert_field->get_kind() == field_kind_attribute_position) {
+                    m_position_binding = binding;
+                }
+
+                // Quantized attributes stay packed; vertex fetch widens them to the field's floats.
+                GLenum component_type = field_type_util::get_opengl_type(type);
+                if (vert_attrib->get_component_type() != attribute_component_type_float) {
+                    ELECTROSLAG_CHECK(component_type == gl::FLOAT && field_type_util::is_vector(type));
+                    component_type = attribute_component_type_util::get_opengl_type(vert_attrib->get_component_type());
+                }
+
+                format_desc.add_attribute(
+                    vert_field->get_index(),
                     field_type_util::get_order(type),
-                    field_type_util::get_opengl_type(type),
-                    gl::FALSE_,
-                    vert_attrib->get_stride(),
-                    reinterpret_cast<void const*>(attrib_offset)
+                    component_type,
+                    vert_attrib->is_normalized() ? gl::TRUE_ : gl::FALSE_,
+                    vert_attrib->get_offset(),
+                    binding
                     );
-                context_opengl::check_opengl_error();
-
-                gl::EnableVertexAttribArray(index);
-                context_opengl::check_opengl_error();
 
                 ++i;
             }
 
-            m_ibo.cast<buffer_opengl>()->bind(gl::ELEMENT_ARRAY_BUFFER);
-
-#if !defined(ELECTROSLAG_BUILD_SHIP)
-            if (prim_stream_desc->has_name_string()) {
-                std::string prim_stream_name(prim_stream_desc->get_name());
-                gl::ObjectLabel(
-                    gl::VERTEX_ARRAY,
-                    m_vertex_array_id,
-                    static_cast<GLsizei>(prim_stream_name.length()),
-                    prim_stream_name.c_str()
-                    );
-                context_opengl::check_opengl_error();
-            }
-#endif
+            graphics_opengl* gfx = static_cast<graphics_opengl*>(get_graphics());
+            ELECTROSLAG_CHECK(!m_vertex_format);
+            m_vertex_format = gfx->get_vertex_format_cache()->locate_format(&format_desc);
 
             m_is_finished.store(true, std::memory_order_release);
         }
 
-        void primitive_stream_opengl::opengl_create_vbo(
-            primitive_stream_descriptor::ref const& prim_stream_desc,
-            primitive_stream_descriptor::const_attribute_iterator i
+        int primitive_stream_opengl::opengl_create_vbo(
+            vertex_attribute const* vert_attrib,
+            vertex_format_cache_opengl::format_desc* format_desc,
+            buffer_hash_vector* binding_buffer_hashes
             )
         {
-            // A buffer might be referred to by many attributes, but should only be created once.
-            int dupe_index = -1;
-            primitive_stream_descriptor::const_attribute_iterator j(prim_stream_desc->begin_attributes());
-            while (j != i) {
-                if ((*j)->get_buffer()->get_hash() == (*i)->get_buffer()->get_hash()) {
-                    dupe_index = static_cast<int>(j - prim_stream_desc->begin_attributes());
-                    break;
-                }
-                else {
-                    ++j;
+            // A buffer might be referred to by many attributes, but should only be
+            // created and given a binding point once.
+            unsigned long long buffer_hash = vert_attrib->get_buffer()->get_hash();
+            int stride = vert_attrib->get_stride();
+            for (int b = 0; b < format_desc->binding_count; ++b) {
+                if ((*binding_buffer_hashes)[b] == buffer_hash && format_desc->binding_strides[b] == stride) {
+                    return (b);
                 }
             }
 
-            int current_index = static_cast<int>(i - prim_stream_desc->begin_attributes());
-            if (dupe_index != -1) {
-                m_vbo_vector[current_index] = m_vbo_vector[dupe_index];
-            }
-            else {
-                m_vbo_vector[current_index] = buffer_opengl::create((*i)->get_buffer());
-            }
-            m_vbo_vector[current_index].cast<buffer_opengl>()->bind(gl::ARRAY_BUFFER);
+            int binding = format_desc->add_binding(stride);
+            binding_buffer_hashes->emplace_back(buffer_hash);
+
+            buffer_opengl::ref vbo(buffer_opengl::create(vert_attrib->get_buffer()));
+            m_vbo_ids[binding] = vbo->get_id();
+            m_vbo_vector.emplace_back(vbo);
+
+            return (binding);
         }
 
         void primitive_stream_opengl::create_command::execute(
@@ -211,28 +172,41 @@ namespace electroslag {
             }
         }
 
-        void primitive_stream_opengl::destroy_command::execute(
-#if !defined(ELECTROSLAG_BUILD_SHIP)
-            context_interface* context
-#else
-            context_interface*
-#endif
-            )
+        void primitive_stream_opengl::bind() const
         {
-            ELECTROSLAG_CHECK(context);
             get_graphics()->get_render_thread()->check();
+            ELECTROSLAG_CHECK(is_finished());
 
-            primitive_stream_opengl::opengl_destroy(m_vertex_array_id);
+            ELECTROSLAG_CHECK(m_vertex_format);
+            static_cast<graphics_opengl*>(get_graphics())->get_vertex_format_cache()->bind(
+                m_vertex_format,
+                m_vbo_ids,
+                m_vbo_offsets,
+                m_ibo->get_id()
+                );
         }
 
-        void primitive_stream_opengl::bind() const
+        void primitive_stream_opengl::bind(buffer_opengl const* position_buffer, int position_offset) const
         {
             get_graphics()->get_render_thread()->check();
             ELECTROSLAG_CHECK(is_finished());
-
-            ELECTROSLAG_CHECK(m_vertex_array_id);
-            gl::BindVertexArray(m_vertex_array_id);
-            context_opengl::check_opengl_error();
+            ELECTROSLAG_CHECK(m_position_binding >= 0);
+            ELECTROSLAG_CHECK(position_buffer && position_offset >= 0);
+
+            opengl_object_id vbo_ids[vertex_format_cache_opengl::max_bindings];
+            int vbo_offsets[vertex_format_cache_opengl::max_bindings];
+            memcpy(vbo_ids, m_vbo_ids, sizeof(vbo_ids));
+            memcpy(vbo_offsets, m_vbo_offsets, sizeof(vbo_offsets));
+            vbo_ids[m_position_binding] = position_buffer->get_id();
+            vbo_offsets[m_position_binding] = position_offset;
+
+            ELECTROSLAG_CHECK(m_vertex_format);
+            static_cast<graphics_opengl*>(get_graphics())->get_vertex_format_cache()->bind(
+                m_vertex_format,
+                vbo_ids,
+                vbo_offsets,
+                m_ibo->get_id()
+                );
         }
     }
 }
@@ -18,6 +18,7 @@
 #include "electroslag/graphics/primitive_stream_descriptor.hpp"
 #include "electroslag/graphics/primitive_stream_interface.hpp"
 #include "electroslag/graphics/buffer_opengl.hpp"
+#include "electroslag/graphics/vertex_format_cache_opengl.hpp"
 #include "electroslag/graphics/sync_interface.hpp"
 
 namespace electroslag {
@@ -71,6 +72,10 @@ namespace electroslag {
 
             void bind() const;
 
+            // Bind with the binding that holds the stream's positions reading from
+            // position_buffer at position_offset instead of the stream's own buffer.
+            void bind(buffer_opengl const* position_buffer, int position_offset) const;
+
         private:
             class create_command : public command {
             public:
@@ -105,23 +110,6 @@ namespace electroslag {
                 create_command& operator =(create_command const&);
             };
 
-            class destroy_command : public command {
-            public:
-                destroy_command(opengl_object_id vertex_array_id)
-                    : m_vertex_array_id(vertex_array_id)
-                {}
-
-                virtual void execute(context_interface* context);
-
-            private:
-                opengl_object_id m_vertex_array_id;
-
-                // Disallowed operations:
-                destroy_command();
-                explicit destroy_command(destroy_command const&);
-                destroy_command& operator =(destroy_command const&);
-            };
-
             typedef std::vector<buffer_opengl::ref> vbo_vector;
 
             primitive_stream_opengl()
@@ -129,8 +117,12 @@ namespace electroslag {
                 , m_prim_count(0)
                 , m_prim_type(primitive_type_unknown)
                 , m_sizeof_index(0)
-                , m_vertex_array_id(0)
-            {}
+                , m_vertex_format(0)
+                , m_position_binding(-1)
+            {
+                memset(m_vbo_ids, 0, sizeof(m_vbo_ids));
+                memset(m_vbo_offsets, 0, sizeof(m_vbo_offsets));
+            }
             virtual ~primitive_stream_opengl();
 
             void schedule_async_create(primitive_stream_descriptor::ref const& prim_stream_desc);
@@ -138,15 +130,17 @@ namespace electroslag {
 
             void opengl_create(primitive_stream_descriptor::ref const& prim_stream_desc);
 
-            void opengl_create_vbo(
-                primitive_stream_descriptor::ref const& prim_stream_desc,
-                primitive_stream_descriptor::const_attribute_iterator i
-                );
+            typedef std::vector<unsigned long long> buffer_hash_vector;
 
-            static void opengl_destroy(opengl_object_id vertex_array_id);
+            int opengl_create_vbo(
+                vertex_attribute const* vert_attrib,
+                vertex_format_cache_opengl::format_desc* format_desc,
+                buffer_hash_vector* binding_buffer_hashes
+                );
 
             std::atomic<bool> m_is_finished;
 
+            // One per vertex format binding point.
             vbo_vector m_vbo_vector;
             buffer_opengl::ref m_ibo;
 
@@ -155,8 +149,12 @@ namespace electroslag {
             primitive_type m_prim_type;
             int m_sizeof_index;
 
-            // Accessed by the graphics command execution thread only
-            opengl_object_id m_vertex_array_id;
+            // Accessed by the graphics command execution thread only; the vertex
+            // array belongs to the format and is shared with other streams.
+            vertex_format_cache_opengl::vertex_format* m_vertex_format;
+            opengl_object_id m_vbo_ids[vertex_format_cache_opengl::max_bindings];
+            int m_vbo_offsets[vertex_format_cache_opengl::max_bindings];
+            int m_position_binding;
 
             // Disallowed operations:
             explicit primitive_stream_opengl(primitive_stream_opengl const&);
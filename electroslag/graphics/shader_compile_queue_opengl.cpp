@@ -0,0 +1,109 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/logger.hpp"
+#include "electroslag/graphics/shader_compile_queue_opengl.hpp"
+#include "electroslag/graphics/context_opengl.hpp"
+
+namespace electroslag {
+    namespace graphics {
+        void shader_compile_queue_opengl::initialize()
+        {
+            ELECTROSLAG_CHECK(m_pending.empty());
+
+            max_shader_compiler_threads_proc max_threads = 0;
+#if defined(_WIN32)
+            if (has_extension("GL_KHR_parallel_shader_compile")) {
+                max_threads = reinterpret_cast<max_shader_compiler_threads_proc>(
+                    wglGetProcAddress("glMaxShaderCompilerThreadsKHR")
+                    );
+            }
+            else if (has_extension("GL_ARB_parallel_shader_compile")) {
+                max_threads = reinterpret_cast<max_shader_compiler_threads_proc>(
+                    wglGetProcAddress("glMaxShaderCompilerThreadsARB")
+                    );
+            }
+#endif
+
+            if (max_threads) {
+                // Let the driver pick how many compiler threads to use.
+                max_threads(0xFFFFFFFF);
+                context_opengl::check_opengl_error();
+                m_parallel = true;
+            }
+            else {
+                m_parallel = false;
+            }
+
+            ELECTROSLAG_LOG_GFX("Parallel shader compile: %s", (m_parallel ? "enabled" : "unavailable"));
+        }
+
+        void shader_compile_queue_opengl::shutdown()
+        {
+            // Programs still compiling are simply abandoned; the context is going away.
+            m_pending.clear();
+            m_parallel = false;
+        }
+
+        bool shader_compile_queue_opengl::is_program_complete(opengl_object_id program) const
+        {
+            if (!m_parallel) {
+                return (true);
+            }
+
+            int complete = 0;
+            gl::GetProgramiv(program, completion_status, &complete);
+            context_opengl::check_opengl_error();
+            return (complete != 0);
+        }
+
+        void shader_compile_queue_opengl::enqueue(shader_program_opengl::ref const& shader)
+        {
+            ELECTROSLAG_CHECK(m_parallel);
+            m_pending.emplace_back(shader);
+        }
+
+        void shader_compile_queue_opengl::poll()
+        {
+            // Reverse iteration allows us to erase from the vector sanely.
+            int pending_count = static_cast<int>(m_pending.size());
+            for (int i = pending_count - 1; i >= 0; --i) {
+                shader_program_opengl::ref shader(m_pending.at(i));
+                if (is_program_complete(shader->get_program_id())) {
+                    // Remove first; finishing throws on compile or link errors.
+                    m_pending.erase(m_pending.begin() + i);
+                    shader->opengl_finish_link();
+                }
+            }
+        }
+
+        // static
+        bool shader_compile_queue_opengl::has_extension(char const* name)
+        {
+            int extension_count = 0;
+            gl::GetIntegerv(gl::NUM_EXTENSIONS, &extension_count);
+            context_opengl::check_opengl_error();
+
+            for (int i = 0; i < extension_count; ++i) {
+                char const* extension = reinterpret_cast<char const*>(gl::GetStringi(gl::EXTENSIONS, i));
+                if (extension && std::strcmp(extension, name) == 0) {
+                    return (true);
+                }
+            }
+            return (false);
+        }
+    }
+}
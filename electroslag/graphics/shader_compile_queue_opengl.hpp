@@ -0,0 +1,75 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/graphics/graphics_types.hpp"
+#include "electroslag/graphics/shader_program_opengl.hpp"
+
+namespace electroslag {
+    namespace graphics {
+        // Tracks shader programs whose compile and link were issued to the driver
+        // but have not completed. With KHR_parallel_shader_compile (or the ARB
+        // version) the driver compiles on its own threads and completion can be
+        // polled without blocking; each frame the render thread finishes whatever
+        // programs are done. Without the extension every program completes
+        // synchronously, as before.
+        class shader_compile_queue_opengl {
+        public:
+            shader_compile_queue_opengl()
+                : m_parallel(false)
+            {}
+
+            // Called by context_opengl once a context is current.
+            void initialize();
+            void shutdown();
+
+            bool is_parallel() const
+            {
+                return (m_parallel);
+            }
+
+            // Returns true once the compile and link of program have finished,
+            // successfully or not; never blocks when is_parallel().
+            bool is_program_complete(opengl_object_id program) const;
+
+            void enqueue(shader_program_opengl::ref const& shader);
+
+            // Called once a frame on the render thread.
+            void poll();
+
+            int get_pending_count() const
+            {
+                return (static_cast<int>(m_pending.size()));
+            }
+
+        private:
+            // From KHR_parallel_shader_compile; not in the core 4.5 loader.
+            static GLenum const completion_status = 0x91B1;
+
+            typedef void (APIENTRY* max_shader_compiler_threads_proc)(GLuint count);
+
+            static bool has_extension(char const* name);
+
+            typedef std::vector<shader_program_opengl::ref> pending_vector;
+            pending_vector m_pending;
+
+            bool m_parallel;
+
+            // Disallowed operations:
+            explicit shader_compile_queue_opengl(shader_compile_queue_opengl const&);
+            shader_compile_queue_opengl& operator =(shader_compile_queue_opengl const&);
+        };
+    }
+}
@@ -0,0 +1,314 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/logger.hpp"
+#include "electroslag/file_stream.hpp"
+#include "electroslag/referenced_buffer.hpp"
+#include "electroslag/graphics/shader_program_cache_opengl.hpp"
+#include "electroslag/graphics/context_opengl.hpp"
+
+namespace electroslag {
+    namespace graphics {
+        void shader_program_cache_opengl::initialize(std::string const& cache_directory)
+        {
+            ELECTROSLAG_CHECK(!m_enabled);
+
+            if (cache_directory.empty()) {
+                return;
+            }
+
+            int binary_format_count = 0;
+            gl::GetIntegerv(gl::NUM_PROGRAM_BINARY_FORMATS, &binary_format_count);
+            context_opengl::check_opengl_error();
+            if (binary_format_count <= 0) {
+                ELECTROSLAG_LOG_GFX("Shader cache disabled: driver exposes no program binary formats");
+                return;
+            }
+
+            // Binaries are only valid for the exact driver that produced them.
+            static GLenum const identity_strings[] = {
+                gl::VENDOR,
+                gl::RENDERER,
+                gl::VERSION,
+                gl::SHADING_LANGUAGE_VERSION
+            };
+
+            unsigned long long driver_hash = fnv1a::basis;
+            for (int i = 0; i < _countof(identity_strings); ++i) {
+                char const* identity = reinterpret_cast<char const*>(gl::GetString(identity_strings[i]));
+                context_opengl::check_opengl_error();
+                if (identity) {
+                    driver_hash = hash_bytes_runtime(identity, std::strlen(identity) + 1, driver_hash);
+                }
+            }
+
+            try {
+                std::filesystem::path directory(cache_directory);
+                if (!std::filesystem::exists(directory)) {
+                    std::filesystem::create_directories(directory);
+                }
+            }
+            catch (std::exception const& e) {
+                ELECTROSLAG_LOG_WARN("Shader cache disabled: %s", e.what());
+                return;
+            }
+
+            m_cache_directory = cache_directory;
+            m_driver_hash = driver_hash;
+            m_hit_count = 0;
+            m_miss_count = 0;
+            m_enabled = true;
+
+            ELECTROSLAG_LOG_GFX("Shader cache: %s", m_cache_directory.c_str());
+        }
+
+        void shader_program_cache_opengl::shutdown()
+        {
+            if (m_enabled) {
+                ELECTROSLAG_LOG_GFX(
+                    "Shader cache: %d hits, %d misses",
+                    m_hit_count,
+                    m_miss_count
+                    );
+            }
+
+            m_enabled = false;
+            m_cache_directory.clear();
+            m_driver_hash = 0;
+        }
+
+        unsigned long long shader_program_cache_opengl::make_program_key(
+            shader_program_descriptor::ref const& shader_desc,
+            shader_field_map::ref const& vertex_attrib_field_map
+            ) const
+        {
+            ELECTROSLAG_CHECK(m_enabled);
+
+            unsigned int const version = file_version;
+            unsigned long long key = hash_bytes_runtime(&version, sizeof(version), m_driver_hash);
+
+            key = hash_stage(shader_desc->get_vertex_shader(), key);
+            key = hash_stage(shader_desc->get_tessellation_control_shader(), key);
+            key = hash_stage(shader_desc->get_tessellation_evaluation_shader(), key);
+            key = hash_stage(shader_desc->get_geometry_shader(), key);
+            key = hash_stage(shader_desc->get_fragment_shader(), key);
+            key = hash_stage(shader_desc->get_compute_shader(), key);
+
+            if (shader_desc->get_shader_defines().is_valid()) {
+                referenced_buffer_interface::accessor define_accessor(
+                    shader_desc->get_shader_defines().cast<referenced_buffer_interface>()
+                    );
+                key = hash_bytes_runtime(define_accessor.get_pointer(), define_accessor.get_sizeof(), key);
+            }
+            else {
+                key = hash_bytes_runtime("", 1, key);
+            }
+
+            // Attribute locations are baked into the binary at link time.
+            key = hash_field_map(shader_desc->get_vertex_fields(), key);
+            key = hash_field_map(vertex_attrib_field_map, key);
+
+            return (key);
+        }
+
+        bool shader_program_cache_opengl::locate_program_binary(
+            unsigned long long key,
+            opengl_object_id program
+            )
+        {
+            ELECTROSLAG_CHECK(m_enabled);
+            ELECTROSLAG_CHECK(program);
+
+            std::string file_path(make_file_path(key));
+            if (!std::filesystem::exists(std::filesystem::path(file_path))) {
+                ++m_miss_count;
+                return (false);
+            }
+
+            std::vector<byte> binary;
+            file_header header;
+            try {
+                file_stream binary_stream;
+                binary_stream.open(file_path, file_stream_access_mode_read);
+
+                if (binary_stream.get_size() < static_cast<long long>(sizeof(header))) {
+                    throw load_object_failure("truncated shader cache header");
+                }
+                binary_stream.read(&header, sizeof(header));
+
+                if ((header.magic != file_magic) ||
+                    (header.version != file_version) ||
+                    (header.key != key) ||
+                    (header.driver_hash != m_driver_hash) ||
+                    (binary_stream.get_size() != static_cast<long long>(sizeof(header) + header.binary_length))) {
+                    throw load_object_failure("stale shader cache entry");
+                }
+
+                binary.resize(header.binary_length);
+                binary_stream.read(binary.data(), header.binary_length);
+            }
+            catch (std::exception const& e) {
+                ELECTROSLAG_LOG_GFX("Shader cache miss %016llx: %s", key, e.what());
+                discard_file(file_path);
+                ++m_miss_count;
+                return (false);
+            }
+
+            gl::ProgramBinary(
+                program,
+                header.binary_format,
+                binary.data(),
+                static_cast<GLsizei>(header.binary_length)
+                );
+
+            // A driver is free to reject a binary it produced earlier, which shows
+            // up either as an error from ProgramBinary or a failed link status.
+            GLenum binary_error = gl::GetError();
+            int link_status = 0;
+            if (binary_error == gl::NO_ERROR_) {
+                gl::GetProgramiv(program, gl::LINK_STATUS, &link_status);
+                context_opengl::check_opengl_error();
+            }
+
+            if (!link_status) {
+                ELECTROSLAG_LOG_GFX("Shader cache miss %016llx: binary rejected by driver", key);
+                discard_file(file_path);
+                ++m_miss_count;
+                return (false);
+            }
+
+            ++m_hit_count;
+            return (true);
+        }
+
+        void shader_program_cache_opengl::store_program_binary(
+            unsigned long long key,
+            opengl_object_id program
+            )
+        {
+            ELECTROSLAG_CHECK(m_enabled);
+            ELECTROSLAG_CHECK(program);
+
+            int binary_length = 0;
+            gl::GetProgramiv(program, gl::PROGRAM_BINARY_LENGTH, &binary_length);
+            context_opengl::check_opengl_error();
+            if (binary_length <= 0) {
+                return;
+            }
+
+            std::vector<byte> binary(binary_length);
+            GLenum binary_format = 0;
+            GLsizei returned_length = 0;
+            gl::GetProgramBinary(program, binary_length, &returned_length, &binary_format, binary.data());
+            context_opengl::check_opengl_error();
+
+            file_header header;
+            header.magic = file_magic;
+            header.version = file_version;
+            header.key = key;
+            header.driver_hash = m_driver_hash;
+            header.binary_format = binary_format;
+            header.binary_length = static_cast<unsigned int>(returned_length);
+
+            // Write to a temporary first so a crash never leaves a torn entry
+            // behind under the real name.
+            std::string file_path(make_file_path(key));
+            std::string temp_path(file_path + ".tmp");
+            try {
+                {
+                    file_stream binary_stream;
+                    binary_stream.create_new(temp_path, file_stream_access_mode_write);
+                    binary_stream.write(&header, sizeof(header));
+                    binary_stream.write(binary.data(), returned_length);
+                }
+
+                discard_file(file_path);
+                std::filesystem::rename(std::filesystem::path(temp_path), std::filesystem::path(file_path));
+            }
+            catch (std::exception const& e) {
+                ELECTROSLAG_LOG_WARN("Could not write shader cache entry %016llx: %s", key, e.what());
+                discard_file(temp_path);
+            }
+        }
+
+        // static
+        unsigned long long shader_program_cache_opengl::hash_stage(
+            shader_stage_descriptor::ref const& stage_desc,
+            unsigned long long hash
+            )
+        {
+            if (stage_desc.is_valid() && stage_desc->has_source()) {
+                referenced_buffer_interface::accessor source_accessor(stage_desc->get_source());
+                return (hash_bytes_runtime(source_accessor.get_pointer(), source_accessor.get_sizeof(), hash));
+            }
+            else {
+                // Keep an absent stage distinct from an empty one.
+                return (hash_bytes_runtime("-", 1, hash));
+            }
+        }
+
+        // static
+        unsigned long long shader_program_cache_opengl::hash_field_map(
+            shader_field_map::ref const& field_map,
+            unsigned long long hash
+            )
+        {
+            // Field maps are unordered, so combine the per-field hashes with an order
+            // independent sum before folding them in.
+            unsigned long long field_sum = 0;
+            int field_count = 0;
+            if (field_map.is_valid()) {
+                shader_field_map::const_iterator f(field_map->begin());
+                while (f != field_map->end()) {
+                    shader_field const* field = f->second;
+
+                    int field_values[3] = {
+                        field->get_kind(),
+                        field->get_field_type(),
+                        field->get_index()
+                    };
+                    field_sum += hash_bytes_runtime(field_values, sizeof(field_values), f->first);
+
+                    ++field_count;
+                    ++f;
+                }
+            }
+
+            hash = hash_bytes_runtime(&field_count, sizeof(field_count), hash);
+            return (hash_bytes_runtime(&field_sum, sizeof(field_sum), hash));
+        }
+
+        std::string shader_program_cache_opengl::make_file_path(unsigned long long key) const
+        {
+            std::string file_path(m_cache_directory);
+            formatted_string_append(file_path, "\\%016llx.bin", key);
+            return (file_path);
+        }
+
+        void shader_program_cache_opengl::discard_file(std::string const& file_path)
+        {
+            try {
+                std::filesystem::path path(file_path);
+                if (std::filesystem::exists(path)) {
+                    std::filesystem::remove(path);
+                }
+            }
+            catch (std::exception const&) {
+                // A stale entry that can't be removed is simply overwritten later.
+            }
+        }
+    }
+}
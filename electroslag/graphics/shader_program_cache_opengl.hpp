@@ -0,0 +1,104 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/graphics/graphics_types.hpp"
+#include "electroslag/graphics/shader_program_descriptor.hpp"
+#include "electroslag/graphics/shader_field_map.hpp"
+
+namespace electroslag {
+    namespace graphics {
+        // Persists linked program binaries on disk so later runs can skip compiling
+        // and linking GLSL. Entries are keyed by the program sources, defines, the
+        // vertex attribute layout they were linked against, and the identity of the
+        // driver that produced them; anything that does not match is discarded and
+        // the program is rebuilt from source. Only used from the render thread.
+        class shader_program_cache_opengl {
+        public:
+            shader_program_cache_opengl()
+                : m_driver_hash(0)
+                , m_enabled(false)
+                , m_hit_count(0)
+                , m_miss_count(0)
+            {}
+
+            // Called by context_opengl once a context is current.
+            void initialize(std::string const& cache_directory);
+            void shutdown();
+
+            bool is_enabled() const
+            {
+                return (m_enabled);
+            }
+
+            unsigned long long make_program_key(
+                shader_program_descriptor::ref const& shader_desc,
+                shader_field_map::ref const& vertex_attrib_field_map
+                ) const;
+
+            // Returns false if there is no usable binary for key; program is then
+            // left without a binary and should be built from source.
+            bool locate_program_binary(unsigned long long key, opengl_object_id program);
+
+            void store_program_binary(unsigned long long key, opengl_object_id program);
+
+            int get_hit_count() const
+            {
+                return (m_hit_count);
+            }
+
+            int get_miss_count() const
+            {
+                return (m_miss_count);
+            }
+
+        private:
+            static unsigned int const file_magic = 0x43505345; // "ESPC"
+            static unsigned int const file_version = 1;
+
+            struct file_header {
+                unsigned int magic;
+                unsigned int version;
+                unsigned long long key;
+                unsigned long long driver_hash;
+                unsigned int binary_format;
+                unsigned int binary_length;
+            };
+
+            static unsigned long long hash_stage(
+                shader_stage_descriptor::ref const& stage_desc,
+                unsigned long long hash
+                );
+
+            static unsigned long long hash_field_map(
+                shader_field_map::ref const& field_map,
+                unsigned long long hash
+                );
+
+            std::string make_file_path(unsigned long long key) const;
+            void discard_file(std::string const& file_path);
+
+            std::string m_cache_directory;
+            unsigned long long m_driver_hash;
+            bool m_enabled;
+            int m_hit_count;
+            int m_miss_count;
+
+            // Disallowed operations:
+            explicit shader_program_cache_opengl(shader_program_cache_opengl const&);
+            shader_program_cache_opengl& operator =(shader_program_cache_opengl const&);
+        };
+    }
+}
@@ -16,7 +16,7 @@
 #include "electroslag/precomp.hpp"
 #include "electroslag/logger.hpp"
 #include "electroslag/graphics/shader_program_opengl.hpp"
-#include "electroslag/graphics/graphics_interface.hpp"
+#include "electroslag/graphics/graphics_opengl.hpp"
 #include "electroslag/graphics/context_opengl.hpp"
 
 namespace electroslag {
@@ -29,7 +29,7 @@ namespace electroslag {
             graphics_interface* g = get_graphics();
 
             if (g->get_render_thread()->is_running()) {
-                opengl_create(shader_desc, vertex_attrib_field_map);
+                opengl_create(shader_desc, vertex_attrib_field_map, false);
             }
             else {
                 g->get_render_policy()->get_system_command_queue()->enqueue_command<create_command>(
@@ -117,6 +117,7 @@ namespace electroslag {
         {
             if (program) {
                 gl::DeleteProgram(program);
+                static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->forget_program(program);
             }
             if (vertex_part) {
                 gl::DeleteShader(vertex_part);
@@ -140,20 +141,106 @@ namespace electroslag {
 
         void shader_program_opengl::opengl_create(
             shader_program_descriptor::ref const& shader_desc,
-            shader_field_map::ref const& vertex_attrib_field_map
+            shader_field_map::ref const& vertex_attrib_field_map,
+            bool wait_for_link
             )
         {
             ELECTROSLAG_CHECK(!is_finished());
 
             m_descriptor = shader_program_descriptor::clone(shader_desc);
 
+            graphics_opengl* gfx = static_cast<graphics_opengl*>(get_graphics());
+            shader_program_cache_opengl* cache = gfx->get_shader_program_cache();
+
+            // The key must be computed before attrib metadata rewrites field indices.
+            if (cache->is_enabled()) {
+                m_cache_key = cache->make_program_key(m_descriptor, vertex_attrib_field_map);
+                if (opengl_load_cached_program(cache, m_cache_key, vertex_attrib_field_map)) {
+                    opengl_complete_create();
+                    return;
+                }
+                m_store_to_cache = true;
+            }
+
             opengl_compile_shader_program(m_descriptor);
-            opengl_set_attrib_metadata(m_descriptor, vertex_attrib_field_map);
+            opengl_set_attrib_metadata(m_descriptor, vertex_attrib_field_map, true);
+
+            if (m_store_to_cache) {
+                gl::ProgramParameteri(m_program, gl::PROGRAM_BINARY_RETRIEVABLE_HINT, gl::TRUE_);
+                context_opengl::check_opengl_error();
+            }
+
             opengl_link_shader_program();
+
+            // Querying compile or link status blocks until the driver is done, so
+            // when it compiles in parallel leave the program to be finished by a
+            // later frame's poll.
+            shader_compile_queue_opengl* compile_queue = gfx->get_shader_compile_queue();
+            if (!wait_for_link && compile_queue->is_parallel()) {
+                compile_queue->enqueue(ref(this));
+            }
+            else {
+                opengl_finish_link();
+            }
+        }
+
+        void shader_program_opengl::opengl_finish_link()
+        {
+            ELECTROSLAG_CHECK(!is_finished());
+
+            // Report compile errors first; they make for a more useful message than
+            // the link failure that follows from them.
+            opengl_check_shader_stage(m_vertex_part);
+            opengl_check_shader_stage(m_tessellation_control_part);
+            opengl_check_shader_stage(m_tessellation_evaluation_part);
+            opengl_check_shader_stage(m_geometry_part);
+            opengl_check_shader_stage(m_fragment_part);
+            opengl_check_shader_stage(m_compute_part);
+
+            opengl_check_link_status();
+
+            if (m_store_to_cache) {
+                static_cast<graphics_opengl*>(get_graphics())->get_shader_program_cache()->store_program_binary(
+                    m_cache_key,
+                    m_program
+                    );
+                m_store_to_cache = false;
+            }
+
+            opengl_complete_create();
+        }
+
+        void shader_program_opengl::opengl_complete_create()
+        {
+            opengl_validate_shader_program();
             opengl_gather_ubo_metadata(m_descriptor);
             opengl_finish_create(m_descriptor);
         }
 
+        bool shader_program_opengl::opengl_load_cached_program(
+            shader_program_cache_opengl* cache,
+            unsigned long long cache_key,
+            shader_field_map::ref const& vertex_attrib_field_map
+            )
+        {
+            opengl_object_id program = gl::CreateProgram();
+            context_opengl::check_opengl_error();
+
+            if (!cache->locate_program_binary(cache_key, program)) {
+                gl::DeleteProgram(program);
+                context_opengl::check_opengl_error();
+                return (false);
+            }
+
+            ELECTROSLAG_CHECK(!m_program);
+            m_program = program;
+
+            // Attribute locations were bound when the binary was linked; the field
+            // indices still need to be resolved for the descriptor.
+            opengl_set_attrib_metadata(m_descriptor, vertex_attrib_field_map, false);
+            return (true);
+        }
+
         void shader_program_opengl::opengl_compile_shader_program(
             shader_program_descriptor::ref& shader_desc
             )
@@ -279,6 +366,27 @@ namespace electroslag {
             gl::CompileShader(shader_part);
             context_opengl::check_opengl_error();
 
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            if (stage_descriptor->has_name_string()) {
+                std::string stage_name(stage_descriptor->get_name().str());
+                gl::ObjectLabel(
+                    gl::SHADER,
+                    shader_part,
+                    static_cast<GLsizei>(stage_name.length()),
+                    stage_name.c_str()
+                    );
+                context_opengl::check_opengl_error();
+            }
+#endif
+        }
+
+        // static
+        void shader_program_opengl::opengl_check_shader_stage(opengl_object_id shader_part)
+        {
+            if (!shader_part) {
+                return;
+            }
+
             int compile_status = 0;
             gl::GetShaderiv(shader_part, gl::COMPILE_STATUS, &compile_status);
             if (!compile_status) {
@@ -293,24 +401,12 @@ namespace electroslag {
 
                 throw opengl_api_failure(compile_log, 0);
             }
-
-#if !defined(ELECTROSLAG_BUILD_SHIP)
-            if (stage_descriptor->has_name_string()) {
-                std::string stage_name(stage_descriptor->get_name());
-                gl::ObjectLabel(
-                    gl::SHADER,
-                    shader_part,
-                    static_cast<GLsizei>(stage_name.length()),
-                    stage_name.c_str()
-                    );
-                context_opengl::check_opengl_error();
-            }
-#endif
         }
 
         void shader_program_opengl::opengl_set_attrib_metadata(
             shader_program_descriptor::ref& shader_desc,
-            shader_field_map::ref const& vertex_attrib_field_map
+            shader_field_map::ref const& vertex_attrib_field_map,
+            bool bind_locations
             )
         {
             // Each vertex attribute has a metadata entry including either an explicit
@@ -358,8 +454,10 @@ namespace electroslag {
                 }
 
                 // Assign the attrib.
-                gl::BindAttribLocation(m_program, attrib_location, field->get_name().c_str());
-                context_opengl::check_opengl_error();
+                if (bind_locations) {
+                    gl::BindAttribLocation(m_program, attrib_location, field->get_name().c_str());
+                    context_opengl::check_opengl_error();
+                }
                 field->set_index(attrib_location);
 
                 ++sf;
@@ -370,7 +468,10 @@ namespace electroslag {
         {
             gl::LinkProgram(m_program);
             context_opengl::check_opengl_error();
+        }
 
+        void shader_program_opengl::opengl_check_link_status()
+        {
             int link_status = 0;
             gl::GetProgramiv(m_program, gl::LINK_STATUS, &link_status);
             if (!link_status) {
@@ -385,7 +486,10 @@ namespace electroslag {
 
                 throw opengl_api_failure(link_log, 0);
             }
+        }
 
+        void shader_program_opengl::opengl_validate_shader_program()
+        {
             gl::ValidateProgram(m_program);
             context_opengl::check_opengl_error();
 
@@ -395,35 +499,36 @@ namespace electroslag {
                 throw opengl_api_failure("shader failed validation", 0);
             }
 
-            gl::UseProgram(m_program);
-            context_opengl::check_opengl_error();
+            static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->use_program(m_program);
         }
 
         void shader_program_opengl::opengl_gather_ubo_metadata(
             shader_program_descriptor::ref& shader_desc
             )
         {
-            if (m_vertex_part) {
+            // Test the descriptor rather than the compiled parts; programs loaded
+            // from the binary cache never compile any.
+            if (has_stage_source(shader_desc->get_vertex_shader())) {
                 opengl_gather_stage_ubo_metadata(shader_desc->get_vertex_shader());
             }
 
-            if (m_tessellation_control_part) {
+            if (has_stage_source(shader_desc->get_tessellation_control_shader())) {
                 opengl_gather_stage_ubo_metadata(shader_desc->get_tessellation_control_shader());
             }
 
-            if (m_tessellation_evaluation_part) {
+            if (has_stage_source(shader_desc->get_tessellation_evaluation_shader())) {
                 opengl_gather_stage_ubo_metadata(shader_desc->get_tessellation_evaluation_shader());
             }
 
-            if (m_geometry_part) {
+            if (has_stage_source(shader_desc->get_geometry_shader())) {
                 opengl_gather_stage_ubo_metadata(shader_desc->get_geometry_shader());
             }
 
-            if (m_fragment_part) {
+            if (has_stage_source(shader_desc->get_fragment_shader())) {
                 opengl_gather_stage_ubo_metadata(shader_desc->get_fragment_shader());
             }
 
-            if (m_compute_part) {
+            if (has_stage_source(shader_desc->get_compute_shader())) {
                 opengl_gather_stage_ubo_metadata(shader_desc->get_compute_shader());
             }
         }
@@ -486,9 +591,9 @@ namespace electroslag {
                 while (f != ubo_field_map->end()) {
                     shader_field* field = f->second;
 
-                    std::string resource_name(ubo->get_name());
+                    std::string resource_name(ubo->get_name().str());
                     resource_name.append(".");
-                    resource_name.append(field->get_name());
+                    resource_name.append(field->get_name().c_str());
 
                     GLuint resource_index = gl::GetProgramResourceIndex(m_program, gl::UNIFORM, resource_name.c_str());
                     ELECTROSLAG_CHECK((resource_index != gl::INVALID_INDEX) && (resource_index != gl::INVALID_ENUM));
@@ -530,7 +635,7 @@ namespace electroslag {
         {
 #if !defined(ELECTROSLAG_BUILD_SHIP)
             if (shader_desc->has_name_string()) {
-                std::string shader_name(shader_desc->get_name());
+                std::string shader_name(shader_desc->get_name().str());
                 gl::ObjectLabel(
                     gl::PROGRAM,
                     m_program,
@@ -552,7 +657,8 @@ namespace electroslag {
             ELECTROSLAG_CHECK(context);
             get_graphics()->get_render_thread()->check();
 
-            m_shader->opengl_create(m_shader_desc, m_vertex_attrib_field_map);
+            // A caller waiting on the finish sync needs the program complete by then.
+            m_shader->opengl_create(m_shader_desc, m_vertex_attrib_field_map, m_finish_sync.is_valid());
 
             if (m_finish_sync.is_valid()) {
                 context->set_sync_point(m_finish_sync);
@@ -586,8 +692,7 @@ namespace electroslag {
             get_graphics()->get_render_thread()->check();
             ELECTROSLAG_CHECK(is_finished());
 
-            gl::UseProgram(m_program);
-            context_opengl::check_opengl_error();
+            static_cast<graphics_opengl*>(get_graphics())->get_state_cache()->use_program(m_program);
         }
 
 #if !defined(ELECTROSLAG_BUILD_SHIP)
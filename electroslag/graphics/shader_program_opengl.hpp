@@ -18,6 +18,7 @@
 #include "electroslag/graphics/primitive_stream_descriptor.hpp"
 #include "electroslag/graphics/shader_program_interface.hpp"
 #include "electroslag/graphics/sync_interface.hpp"
+#include "electroslag/graphics/shader_program_cache_opengl.hpp"
 
 namespace electroslag {
     namespace graphics {
@@ -60,6 +61,14 @@ namespace electroslag {
             // Called by context_opengl
             void bind() const;
 
+            // Called by shader_compile_queue_opengl
+            opengl_object_id get_program_id() const
+            {
+                return (m_program);
+            }
+
+            void opengl_finish_link();
+
         private:
             class create_command : public command {
             public:
@@ -145,6 +154,8 @@ namespace electroslag {
                 , m_fragment_part(0)
                 , m_compute_part(0)
                 , m_program(0)
+                , m_cache_key(0)
+                , m_store_to_cache(false)
             {}
             virtual ~shader_program_opengl();
 
@@ -160,6 +171,13 @@ namespace electroslag {
             // Operations performed on the graphics command execution thread
             void opengl_create(
                 shader_program_descriptor::ref const& shader_desc,
+                shader_field_map::ref const& vertex_attrib_field_map,
+                bool wait_for_link
+                );
+
+            bool opengl_load_cached_program(
+                shader_program_cache_opengl* cache,
+                unsigned long long cache_key,
                 shader_field_map::ref const& vertex_attrib_field_map
                 );
 
@@ -171,12 +189,23 @@ namespace electroslag {
                 std::string const& shader_defines
                 );
 
+            static void opengl_check_shader_stage(opengl_object_id part);
+
             void opengl_set_attrib_metadata(
                 shader_program_descriptor::ref& shader_desc,
-                shader_field_map::ref const& vertex_attrib_field_map
+                shader_field_map::ref const& vertex_attrib_field_map,
+                bool bind_locations
                 );
 
             void opengl_link_shader_program();
+            void opengl_check_link_status();
+            void opengl_complete_create();
+            void opengl_validate_shader_program();
+
+            static bool has_stage_source(shader_stage_descriptor::ref const& stage_descriptor)
+            {
+                return (stage_descriptor.is_valid() && stage_descriptor->has_source());
+            }
 
             void opengl_gather_ubo_metadata(
                 shader_program_descriptor::ref& shader_desc
@@ -213,6 +242,11 @@ namespace electroslag {
             opengl_object_id m_compute_part;
             opengl_object_id m_program;
 
+            // Carried from issuing the link to finishing it, which may be frames
+            // later when the driver compiles in parallel.
+            unsigned long long m_cache_key;
+            bool m_store_to_cache;
+
             // Disallowed operations:
             explicit shader_program_opengl(shader_program_opengl const&);
             shader_program_opengl& operator =(shader_program_opengl const&);
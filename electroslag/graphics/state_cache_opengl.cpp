@@ -0,0 +1,375 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/graphics/graphics_interface.hpp"
+#include "electroslag/graphics/state_cache_opengl.hpp"
+#include "electroslag/graphics/context_opengl.hpp"
+
+namespace electroslag {
+    namespace graphics {
+        state_cache_opengl::state_cache_opengl()
+        {
+            reset();
+        }
+
+        void state_cache_opengl::reset()
+        {
+            m_frame_buffer_id = unknown_id;
+            m_program = unknown_id;
+            m_vertex_array_id = unknown_id;
+            for (int t = 0; t < indexed_target_count; ++t) {
+                m_indexed_buffers[t].clear();
+            }
+
+            m_depth_test = depth_test_params();
+            m_blending = blending_params();
+            m_viewport_width = -1;
+            m_viewport_height = -1;
+            m_depth_test_known = false;
+            m_depth_func_known = false;
+            m_blending_known = false;
+            m_blend_equations_known = false;
+            m_frame_buffer_srgb_known = false;
+            m_frame_buffer_srgb = false;
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            memset(&m_counters, 0, sizeof(m_counters));
+#endif
+        }
+
+        void state_cache_opengl::bind_frame_buffer(opengl_object_id frame_buffer_id)
+        {
+            bool issue = (frame_buffer_id != m_frame_buffer_id);
+            if (issue) {
+                gl::BindFramebuffer(gl::FRAMEBUFFER, frame_buffer_id);
+                context_opengl::check_opengl_error();
+                m_frame_buffer_id = frame_buffer_id;
+            }
+            count(state_filter_category_frame_buffer, issue);
+        }
+
+        void state_cache_opengl::set_frame_buffer_srgb(bool enable)
+        {
+            bool issue = (!m_frame_buffer_srgb_known || enable != m_frame_buffer_srgb);
+            if (issue) {
+                if (enable) {
+                    gl::Enable(gl::FRAMEBUFFER_SRGB);
+                }
+                else {
+                    gl::Disable(gl::FRAMEBUFFER_SRGB);
+                }
+                context_opengl::check_opengl_error();
+                m_frame_buffer_srgb = enable;
+                m_frame_buffer_srgb_known = true;
+            }
+            count(state_filter_category_frame_buffer, issue);
+        }
+
+        void state_cache_opengl::set_viewport(int width, int height)
+        {
+            bool issue = (width != m_viewport_width || height != m_viewport_height);
+            if (issue) {
+                gl::Viewport(0, 0, width, height);
+                context_opengl::check_opengl_error();
+                m_viewport_width = width;
+                m_viewport_height = height;
+            }
+            count(state_filter_category_frame_buffer, issue);
+        }
+
+        void state_cache_opengl::use_program(opengl_object_id program)
+        {
+            bool issue = (program != m_program);
+            if (issue) {
+                gl::UseProgram(program);
+                context_opengl::check_opengl_error();
+                m_program = program;
+            }
+            count(state_filter_category_program, issue);
+        }
+
+        void state_cache_opengl::bind_vertex_array(opengl_object_id vertex_array_id)
+        {
+            bool issue = (vertex_array_id != m_vertex_array_id);
+            if (issue) {
+                gl::BindVertexArray(vertex_array_id);
+                context_opengl::check_opengl_error();
+                m_vertex_array_id = vertex_array_id;
+            }
+            count(state_filter_category_vertex_array, issue);
+        }
+
+        void state_cache_opengl::bind_buffer_range(
+            GLenum target,
+            int index,
+            opengl_object_id buffer_id,
+            int offset,
+            int size
+            )
+        {
+            ELECTROSLAG_CHECK(index >= 0);
+
+            bool issue = true;
+            int t = get_indexed_target(target);
+            if (t >= 0) {
+                indexed_buffer_binding_vector& bindings = m_indexed_buffers[t];
+                if (index >= static_cast<int>(bindings.size())) {
+                    bindings.resize(index + 1);
+                }
+
+                indexed_buffer_binding* binding = &bindings[index];
+                issue = (
+                    binding->buffer_id != buffer_id ||
+                    binding->offset != offset ||
+                    binding->size != size
+                    );
+
+                binding->buffer_id = buffer_id;
+                binding->offset = offset;
+                binding->size = size;
+            }
+
+            if (issue) {
+                if (size < 0) {
+                    ELECTROSLAG_CHECK(offset == 0);
+                    gl::BindBufferBase(target, index, buffer_id);
+                }
+                else {
+                    gl::BindBufferRange(target, index, buffer_id, offset, size);
+                }
+                context_opengl::check_opengl_error();
+            }
+            count(state_filter_category_indexed_buffer, issue);
+        }
+
+        void state_cache_opengl::set_depth_test(depth_test_params const* depth_test)
+        {
+            bool issue_enable = (!m_depth_test_known || depth_test->test_enable != m_depth_test.test_enable);
+            if (issue_enable) {
+                if (depth_test->test_enable) {
+                    gl::Enable(gl::DEPTH_TEST);
+                }
+                else {
+                    gl::Disable(gl::DEPTH_TEST);
+                }
+            }
+            count(state_filter_category_depth_test, issue_enable);
+
+            // The compare function is irrelevant while testing is off; leave it be.
+            bool issue_func = false;
+            if (depth_test->test_enable) {
+                issue_func = (!m_depth_func_known || depth_test->test_mode != m_depth_test.test_mode);
+                if (issue_func) {
+                    gl::DepthFunc(make_gl_depth_func(depth_test->test_mode));
+                    m_depth_test.test_mode = depth_test->test_mode;
+                    m_depth_func_known = true;
+                }
+                count(state_filter_category_depth_test, issue_func);
+            }
+
+            bool issue_mask = (!m_depth_test_known || depth_test->write_enable != m_depth_test.write_enable);
+            if (issue_mask) {
+                gl::DepthMask(depth_test->write_enable ? gl::TRUE_ : gl::FALSE_);
+            }
+            count(state_filter_category_depth_test, issue_mask);
+
+            if (issue_enable || issue_func || issue_mask) {
+                context_opengl::check_opengl_error();
+            }
+
+            m_depth_test.test_enable = depth_test->test_enable;
+            m_depth_test.write_enable = depth_test->write_enable;
+            m_depth_test_known = true;
+        }
+
+        void state_cache_opengl::set_blending(blending_params const* blend)
+        {
+            bool issue_enable = (!m_blending_known || blend->enable != m_blending.enable);
+            if (issue_enable) {
+                if (blend->enable) {
+                    gl::Enable(gl::BLEND);
+                }
+                else {
+                    gl::Disable(gl::BLEND);
+                }
+                context_opengl::check_opengl_error();
+                m_blending.enable = blend->enable;
+                m_blending_known = true;
+            }
+            count(state_filter_category_blending, issue_enable);
+
+            // As with depth, equations and factors only matter while blending.
+            if (blend->enable) {
+                bool issue_equation = (
+                    !m_blend_equations_known ||
+                    blend->color_mode != m_blending.color_mode ||
+                    blend->alpha_mode != m_blending.alpha_mode
+                    );
+                if (issue_equation) {
+                    gl::BlendEquationSeparate(
+                        make_gl_blend_equation(blend->color_mode),
+                        make_gl_blend_equation(blend->alpha_mode)
+                        );
+                }
+                count(state_filter_category_blending, issue_equation);
+
+                bool issue_func = (
+                    !m_blend_equations_known ||
+                    blend->color_op1 != m_blending.color_op1 ||
+                    blend->color_op2 != m_blending.color_op2 ||
+                    blend->alpha_op1 != m_blending.alpha_op1 ||
+                    blend->alpha_op2 != m_blending.alpha_op2
+                    );
+                if (issue_func) {
+                    gl::BlendFuncSeparate(
+                        make_gl_blend_func(blend->color_op1),
+                        make_gl_blend_func(blend->color_op2),
+                        make_gl_blend_func(blend->alpha_op1),
+                        make_gl_blend_func(blend->alpha_op2)
+                        );
+                }
+                count(state_filter_category_blending, issue_func);
+
+                if (issue_equation || issue_func) {
+                    context_opengl::check_opengl_error();
+                    m_blending = *blend;
+                    m_blend_equations_known = true;
+                }
+            }
+        }
+
+        void state_cache_opengl::forget_frame_buffer(opengl_object_id frame_buffer_id)
+        {
+            if (frame_buffer_id == m_frame_buffer_id) {
+                m_frame_buffer_id = unknown_id;
+            }
+        }
+
+        void state_cache_opengl::forget_program(opengl_object_id program)
+        {
+            // Deleting the current program is deferred by the driver until it is
+            // no longer current, but its name is freed immediately.
+            if (program == m_program) {
+                m_program = unknown_id;
+            }
+        }
+
+        void state_cache_opengl::forget_vertex_array(opengl_object_id vertex_array_id)
+        {
+            if (vertex_array_id == m_vertex_array_id) {
+                m_vertex_array_id = unknown_id;
+            }
+        }
+
+        void state_cache_opengl::forget_buffer(opengl_object_id buffer_id)
+        {
+            for (int t = 0; t < indexed_target_count; ++t) {
+                indexed_buffer_binding_vector::iterator b(m_indexed_buffers[t].begin());
+                while (b != m_indexed_buffers[t].end()) {
+                    if (b->buffer_id == buffer_id) {
+                        *b = indexed_buffer_binding();
+                    }
+                    ++b;
+                }
+            }
+        }
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+        void state_cache_opengl::end_frame()
+        {
+            get_graphics()->state_filter_counters_updated.signal(&m_counters);
+
+            long long frame_number = m_counters.frame_number + 1;
+            memset(&m_counters, 0, sizeof(m_counters));
+            m_counters.frame_number = frame_number;
+        }
+#endif
+
+        // static
+        int state_cache_opengl::get_indexed_target(GLenum target)
+        {
+            switch (target) {
+            case gl::UNIFORM_BUFFER:
+                return (indexed_target_uniform_buffer);
+
+            case gl::SHADER_STORAGE_BUFFER:
+                return (indexed_target_shader_storage_buffer);
+
+            default:
+                return (-1);
+            }
+        }
+
+        // static
+        GLenum state_cache_opengl::make_gl_depth_func(depth_test_mode test_mode)
+        {
+            static GLenum const gl_depth_funcs[depth_test_mode_count] = {
+                gl::NEVER,
+                gl::LESS,
+                gl::EQUAL,
+                gl::LEQUAL,
+                gl::GREATER,
+                gl::NOTEQUAL,
+                gl::GEQUAL,
+                gl::ALWAYS
+            };
+
+            return (gl_depth_funcs[test_mode]);
+        }
+
+        // static
+        GLenum state_cache_opengl::make_gl_blend_equation(blending_mode mode)
+        {
+            static GLenum const gl_blend_equations[blending_mode_count] = {
+                gl::FUNC_ADD,
+                gl::FUNC_SUBTRACT,
+                gl::FUNC_REVERSE_SUBTRACT,
+                gl::MIN,
+                gl::MAX
+            };
+
+            return (gl_blend_equations[mode]);
+        }
+
+        // static
+        GLenum state_cache_opengl::make_gl_blend_func(blending_operand op)
+        {
+            static GLenum const gl_blend_funcs[blending_operand_count] = {
+                gl::ZERO,
+                gl::ONE,
+                gl::SRC_COLOR,
+                gl::ONE_MINUS_SRC_COLOR,
+                gl::DST_COLOR,
+                gl::ONE_MINUS_DST_COLOR,
+                gl::SRC_ALPHA,
+                gl::ONE_MINUS_SRC_ALPHA,
+                gl::DST_ALPHA,
+                gl::ONE_MINUS_DST_ALPHA,
+                gl::CONSTANT_COLOR,
+                gl::ONE_MINUS_CONSTANT_COLOR,
+                gl::CONSTANT_ALPHA,
+                gl::ONE_MINUS_CONSTANT_ALPHA,
+                gl::SRC_ALPHA_SATURATE,
+                gl::SRC1_COLOR,
+                gl::ONE_MINUS_SRC1_COLOR,
+                gl::SRC1_ALPHA,
+                gl::ONE_MINUS_SRC1_ALPHA
+            };
+
+            return (gl_blend_funcs[op]);
+        }
+    }
+}
@@ -0,0 +1,138 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/graphics/graphics_types.hpp"
+#include "electroslag/graphics/graphics_debugger_interface.hpp"
+
+namespace electroslag {
+    namespace graphics {
+        // Shadow copy of the binding and fixed function state of the main context.
+        // Every change is compared against the last value sent to the driver and
+        // dropped if it would not change anything. Anything that binds these on
+        // the render thread must come through here, or the shadow goes stale.
+        // Only used from the render thread.
+        class state_cache_opengl {
+        public:
+            state_cache_opengl();
+
+            // Forget all shadowed state; the next change of each kind is issued.
+            void reset();
+
+            void bind_frame_buffer(opengl_object_id frame_buffer_id);
+            void set_frame_buffer_srgb(bool enable);
+            void set_viewport(int width, int height);
+
+            void use_program(opengl_object_id program);
+            void bind_vertex_array(opengl_object_id vertex_array_id);
+
+            // Size -1 binds the whole buffer, the same as glBindBufferBase.
+            void bind_buffer_range(GLenum target, int index, opengl_object_id buffer_id, int offset, int size = -1);
+
+            void set_depth_test(depth_test_params const* depth_test);
+            void set_blending(blending_params const* blend);
+
+            // Called as objects are deleted; the driver resets any bindings of
+            // a deleted name, and the name may be handed out again.
+            void forget_frame_buffer(opengl_object_id frame_buffer_id);
+            void forget_program(opengl_object_id program);
+            void forget_vertex_array(opengl_object_id vertex_array_id);
+            void forget_buffer(opengl_object_id buffer_id);
+
+            // Also used for state shadowed elsewhere, such as shared vertex array buffers.
+            void count(state_filter_category category, bool issued)
+            {
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+                if (issued) {
+                    ++m_counters.issued[category];
+                }
+                else {
+                    ++m_counters.filtered[category];
+                }
+#else
+                UNREFERENCED_PARAMETER(category);
+                UNREFERENCED_PARAMETER(issued);
+#endif
+            }
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            // Called once per frame, at swap.
+            void end_frame();
+
+            state_filter_counters const* get_counters() const
+            {
+                return (&m_counters);
+            }
+#endif
+
+        private:
+            // Never a valid object name, so the first bind of anything is issued.
+            static opengl_object_id const unknown_id = ~0U;
+
+            // Indexed binding points shadowed; others are passed straight through.
+            enum indexed_target {
+                indexed_target_uniform_buffer,
+                indexed_target_shader_storage_buffer,
+
+                indexed_target_count
+            };
+
+            struct indexed_buffer_binding {
+                indexed_buffer_binding()
+                    : buffer_id(unknown_id)
+                    , offset(0)
+                    , size(0)
+                {}
+
+                opengl_object_id buffer_id;
+                int offset;
+                int size;
+            };
+
+            typedef std::vector<indexed_buffer_binding> indexed_buffer_binding_vector;
+
+            static int get_indexed_target(GLenum target);
+
+            static GLenum make_gl_depth_func(depth_test_mode test_mode);
+            static GLenum make_gl_blend_equation(blending_mode mode);
+            static GLenum make_gl_blend_func(blending_operand op);
+
+            opengl_object_id m_frame_buffer_id;
+            opengl_object_id m_program;
+            opengl_object_id m_vertex_array_id;
+            indexed_buffer_binding_vector m_indexed_buffers[indexed_target_count];
+
+            // The state structs can't represent "unknown", so track that separately.
+            depth_test_params m_depth_test;
+            blending_params m_blending;
+            int m_viewport_width;
+            int m_viewport_height;
+            bool m_depth_test_known;
+            bool m_depth_func_known;
+            bool m_blending_known;
+            bool m_blend_equations_known;
+            bool m_frame_buffer_srgb_known;
+            bool m_frame_buffer_srgb;
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            state_filter_counters m_counters;
+#endif
+
+            // Disallowed operations:
+            explicit state_cache_opengl(state_cache_opengl const&);
+            state_cache_opengl& operator =(state_cache_opengl const&);
+        };
+    }
+}
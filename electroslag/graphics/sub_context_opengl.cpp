@@ -50,12 +50,8 @@ namespace electroslag {
             win32_initialize_context();
 #endif
 
-#if !defined(ELECTROSLAG_BUILD_SHIP)
-            // Listen to debug output from OpenGL
-            gl::DebugMessageCallback(context_opengl::debug_msg_callback, this);
-            gl::DebugMessageControl(gl::DONT_CARE, gl::DONT_CARE, gl::DONT_CARE, 0, 0, gl::TRUE_);
-            gl::Disable(gl::DEBUG_OUTPUT_SYNCHRONOUS);
-            context_opengl::check_opengl_error();
+#if ELECTROSLAG_GL_VALIDATION >= ELECTROSLAG_GL_VALIDATION_CALLBACK
+            context_opengl::initialize_debug_output(this);
 #endif
         }
 
@@ -89,7 +85,7 @@ namespace electroslag {
                 wgl::CONTEXT_MAJOR_VERSION_ARB, 4,
                 wgl::CONTEXT_MINOR_VERSION_ARB, 5,
                 wgl::CONTEXT_PROFILE_MASK_ARB, wgl::CONTEXT_CORE_PROFILE_BIT_ARB,
-#if !defined(ELECTROSLAG_BUILD_SHIP)
+#if ELECTROSLAG_GL_VALIDATION >= ELECTROSLAG_GL_VALIDATION_CALLBACK
                 wgl::CONTEXT_FLAGS_ARB, wgl::CONTEXT_DEBUG_BIT_ARB,
 #endif
                 0 // "NULL" termination
@@ -26,6 +26,11 @@ namespace electroslag {
             virtual bool is_finished() const = 0;
 
             virtual field_structs::texture_handle get_handle() = 0;
+
+            // Orders pending uploads across textures; lower values are uploaded
+            // first, e.g. the distance to the nearest viewer.
+            virtual float get_stream_priority() const = 0;
+            virtual void set_stream_priority(float priority) = 0;
         };
     }
 }
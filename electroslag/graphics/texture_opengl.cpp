@@ -15,7 +15,7 @@
 
 #include "electroslag/precomp.hpp"
 #include "electroslag/graphics/texture_opengl.hpp"
-#include "electroslag/graphics/graphics_interface.hpp"
+#include "electroslag/graphics/graphics_opengl.hpp"
 #include "electroslag/graphics/context_opengl.hpp"
 
 
@@ -28,7 +28,7 @@ namespace electroslag {
             graphics_interface* g = get_graphics();
 
             if (g->get_render_thread()->is_running()) {
-                opengl_create(texture_desc);
+                opengl_create(texture_desc, false);
             }
             else {
                 g->get_render_policy()->get_system_command_queue()->enqueue_command<create_command>(
@@ -90,15 +90,29 @@ namespace electroslag {
             }
         }
 
-        void texture_opengl::opengl_create(texture_descriptor::ref& texture_desc)
+        void texture_opengl::opengl_create(
+            texture_descriptor::ref& texture_desc,
+            bool wait_for_upload
+            )
         {
             ELECTROSLAG_CHECK(!is_finished());
             ELECTROSLAG_CHECK(texture_descriptor::is_texture_complete(texture_desc.get_pointer()));
 
-            switch (texture_desc->get_type()) {
+            // Pixels go through the upload thread unless the caller is blocked on
+            // this texture; only the storage is allocated here.
+            texture_upload_thread_opengl* upload_thread = static_cast<graphics_opengl*>(
+                get_graphics()
+                )->get_texture_upload_thread();
+            // The upload thread writes whole 2D images, which only fits 2D and cube
+            // textures; 3D and array textures always load here.
+            texture_type_flags type = texture_desc->get_type();
+            bool stream_levels = !wait_for_upload && upload_thread->is_started() &&
+                (type == texture_type_flags_normal || type == texture_type_flags_mipmap || type == texture_type_flags_cube);
+
+            switch (type) {
             case texture_type_flags_normal:
             case texture_type_flags_mipmap:
-                opengl_create_map(texture_desc);
+                opengl_create_map(texture_desc, !stream_levels);
                 break;
 
             case texture_type_flags_3d:
@@ -110,7 +124,7 @@ namespace electroslag {
                 break;
 
             case texture_type_flags_cube:
-                opengl_create_cube(texture_desc);
+                opengl_create_cube(texture_desc, !stream_levels);
                 break;
 
             // TODO: support the creation of the rest of the texture types
@@ -121,9 +135,28 @@ namespace electroslag {
                 throw parameter_failure("OpenGL does not support the given texture flag feature combination");
             }
 
-            opengl_create_generate_levels(texture_desc);
             opengl_create_set_parameters(texture_desc);
 
+            if (stream_levels && texture_desc->begin_images() != texture_desc->end_images()) {
+                // The upload context only sees the new storage once this context has flushed.
+                gl::Flush();
+                upload_thread->enqueue_texture(ref(this), texture_desc);
+            }
+            else {
+                opengl_finish_create(texture_desc);
+            }
+        }
+
+        void texture_opengl::opengl_finish_create(texture_descriptor::ref& texture_desc)
+        {
+            ELECTROSLAG_CHECK(!is_finished());
+
+            // Levels are generated from the uploaded base level, so this waits for
+            // any streaming to complete.
+            opengl_create_generate_levels(texture_desc);
+
+            // The bindless handle freezes the texture's parameters, so it is only
+            // made once everything else is in place.
             m_handle.h = gl::GetTextureHandleARB(m_texture_id);
             gl::MakeTextureHandleResidentARB(m_handle.h);
 
@@ -131,7 +164,7 @@ namespace electroslag {
 
 #if !defined(ELECTROSLAG_BUILD_SHIP)
             if (texture_desc->has_name_string()) {
-                std::string texture_name(texture_desc->get_name());
+                std::string texture_name(texture_desc->get_name().str());
                 gl::ObjectLabel(
                     gl::TEXTURE,
                     m_texture_id,
@@ -146,18 +179,22 @@ namespace electroslag {
         }
 
         void texture_opengl::opengl_create_map(
-            texture_descriptor::ref& texture_desc
+            texture_descriptor::ref& texture_desc,
+            bool load_levels
             )
         {
             opengl_create_common(gl::TEXTURE_2D);
 
             int levels = texture_desc->compute_mip_levels();
             opengl_create_immutable_allocate(texture_desc, levels, 0);
+            if (!load_levels) {
+                return;
+            }
 
             texture_descriptor::const_image_iterator i(texture_desc->begin_images());
             ELECTROSLAG_CHECK(i != texture_desc->end_images());
 
-            opengl_create_load_level(gl::TEXTURE_2D, *i);
+            opengl_create_load_level(*i);
             ++i;
             --levels;
 
@@ -165,7 +202,7 @@ namespace electroslag {
                 ELECTROSLAG_CHECK(texture_desc->get_type() & texture_type_flags_mipmap);
                 if (texture_desc->get_mip_level_generation_mode() == texture_level_generate_off) {
                     do {
-                        opengl_create_load_level(gl::TEXTURE_2D, *i);
+                        opengl_create_load_level(*i);
                         ++i;
                         --levels;
                     } while (i != texture_desc->end_images());
@@ -195,37 +232,26 @@ namespace electroslag {
         }
 
         void texture_opengl::opengl_create_cube(
-            texture_descriptor::ref& texture_desc
+            texture_descriptor::ref& texture_desc,
+            bool load_levels
             )
         {
             opengl_create_common(gl::TEXTURE_CUBE_MAP);
 
             int levels_per_face = texture_desc->compute_mip_levels();
             opengl_create_immutable_allocate(texture_desc, levels_per_face, 0);
-
-            // Same order as the texture_cube_face
-            static GLenum const cube_targets[] = {
-                0,                               // texture_cube_face_normal
-                gl::TEXTURE_CUBE_MAP_POSITIVE_Z, // texture_cube_face_front
-                gl::TEXTURE_CUBE_MAP_NEGATIVE_Z, // texture_cube_face_back
-                gl::TEXTURE_CUBE_MAP_POSITIVE_X, // texture_cube_face_left
-                gl::TEXTURE_CUBE_MAP_NEGATIVE_X, // texture_cube_face_right
-                gl::TEXTURE_CUBE_MAP_POSITIVE_Y, // texture_cube_face_top
-                gl::TEXTURE_CUBE_MAP_NEGATIVE_Y  // texture_cube_face_bottom
-            };
-            ELECTROSLAG_STATIC_CHECK(
-                _countof(cube_targets) == texture_cube_face_count,
-                "cube_targets mismatch"
-                );
+            if (!load_levels) {
+                return;
+            }
 
             texture_descriptor::const_image_iterator i(texture_desc->begin_images());
             ELECTROSLAG_CHECK(i != texture_desc->end_images());
 
             for (unsigned int face = 1; face < texture_cube_face_count; ++face) {
                 int levels = levels_per_face;
-                GLenum target = cube_targets[(*i)->get_cube_face()];
+                ELECTROSLAG_CHECK((*i)->get_cube_face() != texture_cube_face_normal);
 
-                opengl_create_load_level(target, *i);
+                opengl_create_load_level(*i);
                 ++i;
                 --levels;
 
@@ -233,8 +259,8 @@ namespace electroslag {
                     ELECTROSLAG_CHECK(texture_desc->get_type() & texture_type_flags_mipmap);
                     if (texture_desc->get_mip_level_generation_mode() == texture_level_generate_off) {
                         do {
-                            ELECTROSLAG_CHECK(target == cube_targets[(*i)->get_cube_face()]);
-                            opengl_create_load_level(target, *i);
+                            ELECTROSLAG_CHECK((*i)->get_cube_face() == (*(i - 1))->get_cube_face());
+                            opengl_create_load_level(*i);
                             ++i;
                             --levels;
                         } while (i != texture_desc->end_images());
@@ -278,7 +304,7 @@ namespace electroslag {
                 texture_level_generate generate_mode = texture_desc->get_mip_level_generation_mode();
                 if (generate_mode != texture_level_generate_off) {
                     // TODO: Mipmap generation quality flags?
-                    gl::GenerateMipmap(m_texture_target);
+                    gl::GenerateTextureMipmap(m_texture_id);
                     context_opengl::check_opengl_error();
                 }
             }
@@ -326,18 +352,14 @@ namespace electroslag {
         {
             m_texture_target = texture_target;
 
+            // Everything after this is direct state access, so creating a
+            // texture never touches the texture unit bindings.
             opengl_object_id texture_id = 0;
-            gl::GenTextures(1, &texture_id);
+            gl::CreateTextures(texture_target, 1, &texture_id);
             context_opengl::check_opengl_error();
 
             ELECTROSLAG_CHECK(!m_texture_id);
             m_texture_id = texture_id;
-
-            gl::ActiveTexture(gl::TEXTURE0);
-            context_opengl::check_opengl_error();
-
-            gl::BindTexture(texture_target, texture_id);
-            context_opengl::check_opengl_error();
         }
 
         void texture_opengl::opengl_create_immutable_allocate(
@@ -378,8 +400,8 @@ namespace electroslag {
             };
 
             if (!depth) {
-                gl::TexStorage2D(
-                    m_texture_target,
+                gl::TextureStorage2D(
+                    m_texture_id,
                     levels,
                     sized_formats[texture_desc->get_color_format()],
                     texture_desc->get_width(),
@@ -388,8 +410,8 @@ namespace electroslag {
                 context_opengl::check_opengl_error();
             }
             else {
-                gl::TexStorage3D(
-                    m_texture_target,
+                gl::TextureStorage3D(
+                    m_texture_id,
                     levels,
                     sized_formats[texture_desc->get_color_format()],
                     texture_desc->get_width(),
@@ -400,16 +422,18 @@ namespace electroslag {
             }
         }
 
-        void texture_opengl::opengl_create_load_level(
-            GLenum map_target,
-            image_descriptor::ref const& image
-            ) const
+        // static
+        bool texture_opengl::get_upload_format(
+            texture_color_format color_format,
+            GLenum* out_format,
+            GLenum* out_type
+            )
         {
             GLenum format = 0;
             GLenum type = 0;
             bool compressed = false;
 
-            switch (image->get_color_format()) {
+            switch (color_format) {
             case texture_color_format_r8:
                 format = gl::RED;
                 type = gl::UNSIGNED_BYTE;
@@ -516,24 +540,69 @@ namespace electroslag {
                 throw std::logic_error("unknown texture color format");
             }
 
-            {
-                referenced_buffer_interface::accessor pixel_accessor(image->get_pixels());
+            *out_format = format;
+            *out_type = type;
+            return (compressed);
+        }
+
+        void texture_opengl::opengl_create_load_level(
+            image_descriptor::ref const& image
+            ) const
+        {
+            referenced_buffer_interface::accessor pixel_accessor(image->get_pixels());
+            opengl_upload_image(
+                m_texture_id,
+                image,
+                pixel_accessor.get_pointer(),
+                pixel_accessor.get_sizeof()
+                );
+        }
+
+        // static
+        void texture_opengl::opengl_upload_image(
+            opengl_object_id texture_id,
+            image_descriptor::ref const& image,
+            void const* pixels,
+            int pixels_sizeof
+            )
+        {
+            // Direct state access treats a cube map as six layers, in this order.
+            static int const cube_face_layers[] = {
+                0, // texture_cube_face_normal
+                4, // texture_cube_face_front
+                5, // texture_cube_face_back
+                0, // texture_cube_face_left
+                1, // texture_cube_face_right
+                2, // texture_cube_face_top
+                3  // texture_cube_face_bottom
+            };
+            ELECTROSLAG_STATIC_CHECK(
+                _countof(cube_face_layers) == texture_cube_face_count,
+                "cube_face_layers mismatch"
+                );
+
+            GLenum format = 0;
+            GLenum type = 0;
+            bool compressed = get_upload_format(image->get_color_format(), &format, &type);
+
+            texture_cube_face face = image->get_cube_face();
+            if (face == texture_cube_face_normal) {
                 if (compressed) {
-                    gl::CompressedTexSubImage2D(
-                        map_target,
+                    gl::CompressedTextureSubImage2D(
+                        texture_id,
                         image->get_mip_level(),
                         0,
                         0,
                         image->get_width(),
                         image->get_height(),
                         type,
-                        pixel_accessor.get_sizeof(),
-                        pixel_accessor.get_pointer()
+                        pixels_sizeof,
+                        pixels
                         );
                 }
                 else {
-                    gl::TexSubImage2D(
-                        map_target,
+                    gl::TextureSubImage2D(
+                        texture_id,
                         image->get_mip_level(),
                         0,
                         0,
@@ -541,11 +610,43 @@ namespace electroslag {
                         image->get_height(),
                         format,
                         type,
-                        pixel_accessor.get_pointer()
+                        pixels
+                        );
+                }
+            }
+            else {
+                if (compressed) {
+                    gl::CompressedTextureSubImage3D(
+                        texture_id,
+                        image->get_mip_level(),
+                        0,
+                        0,
+                        cube_face_layers[face],
+                        image->get_width(),
+                        image->get_height(),
+                        1,
+                        type,
+                        pixels_sizeof,
+                        pixels
+                        );
+                }
+                else {
+                    gl::TextureSubImage3D(
+                        texture_id,
+                        image->get_mip_level(),
+                        0,
+                        0,
+                        cube_face_layers[face],
+                        image->get_width(),
+                        image->get_height(),
+                        1,
+                        format,
+                        type,
+                        pixels
                         );
                 }
-                context_opengl::check_opengl_error();
             }
+            context_opengl::check_opengl_error();
         }
 
         void texture_opengl::opengl_create_set_magnification_filter(
@@ -567,7 +668,7 @@ namespace electroslag {
                 throw std::logic_error("unknown texture filter");
             }
 
-            gl::TexParameteri(m_texture_target, gl::TEXTURE_MAG_FILTER, gl_filter);
+            gl::TextureParameteri(m_texture_id, gl::TEXTURE_MAG_FILTER, gl_filter);
             context_opengl::check_opengl_error();
         }
 
@@ -623,7 +724,7 @@ namespace electroslag {
                 throw std::logic_error("unknown texture filter");
             }
 
-            gl::TexParameteri(m_texture_target, gl::TEXTURE_MIN_FILTER, gl_filter);
+            gl::TextureParameteri(m_texture_id, gl::TEXTURE_MIN_FILTER, gl_filter);
             context_opengl::check_opengl_error();
         }
 
@@ -651,7 +752,7 @@ namespace electroslag {
                 throw std::logic_error("unknown texture coordinate wrap mode");
             }
 
-            gl::TexParameteri(m_texture_target, pname, gl_wrap_mode);
+            gl::TextureParameteri(m_texture_id, pname, gl_wrap_mode);
             context_opengl::check_opengl_error();
         }
 
@@ -662,7 +763,8 @@ namespace electroslag {
             ELECTROSLAG_CHECK(context);
             get_graphics()->get_render_thread()->check();
 
-            m_texture->opengl_create(m_texture_desc);
+            // A caller waiting on the finish sync needs the pixels in place by then.
+            m_texture->opengl_create(m_texture_desc, m_finish_sync.is_valid());
 
             if (m_finish_sync.is_valid()) {
                 context->set_sync_point(m_finish_sync);
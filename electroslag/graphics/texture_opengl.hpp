@@ -56,6 +56,38 @@ namespace electroslag {
                 return (m_handle);
             }
 
+            virtual float get_stream_priority() const
+            {
+                return (m_stream_priority.load(std::memory_order_relaxed));
+            }
+
+            virtual void set_stream_priority(float priority)
+            {
+                m_stream_priority.store(priority, std::memory_order_relaxed);
+            }
+
+            // Called by texture_upload_thread_opengl
+            opengl_object_id get_texture_id() const
+            {
+                return (m_texture_id);
+            }
+
+            static bool get_upload_format(
+                texture_color_format color_format,
+                GLenum* out_format,
+                GLenum* out_type
+                );
+
+            // pixels is an offset when a pixel unpack buffer is bound.
+            static void opengl_upload_image(
+                opengl_object_id texture_id,
+                image_descriptor::ref const& image,
+                void const* pixels,
+                int pixels_sizeof
+                );
+
+            void opengl_finish_create(texture_descriptor::ref& texture_desc);
+
         private:
             class create_command : public command {
             public:
@@ -109,6 +141,7 @@ namespace electroslag {
 
             texture_opengl()
                 : m_is_finished(false)
+                , m_stream_priority(0.0f)
                 , m_texture_target(0)
                 , m_texture_id(0)
                 , m_complete(false)
@@ -118,13 +151,13 @@ namespace electroslag {
             void schedule_async_create(texture_descriptor::ref& texture_desc);
             void schedule_async_create_finished(texture_descriptor::ref& texture_desc);
 
-            void opengl_create(texture_descriptor::ref& texture_desc);
+            void opengl_create(texture_descriptor::ref& texture_desc, bool wait_for_upload);
             static void opengl_destroy(opengl_object_id texture_id);
 
-            void opengl_create_map(texture_descriptor::ref& texture_desc);
+            void opengl_create_map(texture_descriptor::ref& texture_desc, bool load_levels);
             void opengl_create_3d(texture_descriptor::ref& texture_desc);
             void opengl_create_array(texture_descriptor::ref& texture_desc);
-            void opengl_create_cube(texture_descriptor::ref& texture_desc);
+            void opengl_create_cube(texture_descriptor::ref& texture_desc, bool load_levels);
             void opengl_create_cube_array(texture_descriptor::ref& texture_desc);
 
             void opengl_create_generate_levels(texture_descriptor::ref& texture_desc) const;
@@ -140,7 +173,6 @@ namespace electroslag {
                 ) const;
 
             void opengl_create_load_level(
-                GLenum map_target,
                 image_descriptor::ref const& image
                 ) const;
 
@@ -160,6 +192,9 @@ namespace electroslag {
 
             std::atomic<bool> m_is_finished;
 
+            // Lower values stream sooner; any thread may update it.
+            std::atomic<float> m_stream_priority;
+
             // Initialized on construction and read-only after
             GLenum m_texture_target;
 
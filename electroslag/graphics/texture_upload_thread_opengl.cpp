@@ -0,0 +1,455 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/logger.hpp"
+#include "electroslag/graphics/texture_upload_thread_opengl.hpp"
+#include "electroslag/graphics/context_opengl.hpp"
+
+namespace electroslag {
+    namespace graphics {
+        bool texture_upload_thread_opengl::is_started() const
+        {
+            bool thread_is_started = false;
+            if (m_thread.is_a_thread()) {
+                threading::lock_guard thread_lock(&m_mutex);
+                if (m_exception) {
+                    std::rethrow_exception(m_exception);
+                }
+                thread_is_started = m_from_state.ready;
+            }
+            return (thread_is_started);
+        }
+
+        void texture_upload_thread_opengl::spawn(int frame_budget_bytes)
+        {
+            ELECTROSLAG_CHECK(frame_budget_bytes > 0);
+            if (!m_thread.is_a_thread()) {
+                m_frame_budget_bytes = frame_budget_bytes;
+                m_budget_remaining_bytes = frame_budget_bytes;
+                m_ring_size = max(frame_budget_bytes * ring_frames, min_ring_size);
+                m_thread.spawn(&thread_stub, this);
+            }
+        }
+
+        void texture_upload_thread_opengl::wait_for_ready()
+        {
+            if (!m_thread.is_a_thread()) {
+                throw std::logic_error("thread not spawned yet; will never be ready");
+            }
+
+            {
+                threading::lock_guard thread_lock(&m_mutex);
+                while (!m_from_state.ready) {
+                    if (m_exception) {
+                        std::rethrow_exception(m_exception);
+                    }
+
+                    m_from_condition_var.wait(&thread_lock);
+                }
+            }
+        }
+
+        void texture_upload_thread_opengl::signal_exit()
+        {
+            threading::lock_guard thread_lock(&m_mutex);
+            if (m_exception) {
+                std::rethrow_exception(m_exception);
+            }
+
+            m_to_state.exit_thread = true;
+            m_to_condition_var.notify_all();
+        }
+
+        void texture_upload_thread_opengl::wait_for_exit()
+        {
+            if (!m_thread.is_a_thread()) {
+                throw std::logic_error("thread not spawned yet; will never exit");
+            }
+
+            {
+                threading::lock_guard thread_lock(&m_mutex);
+                while (m_from_state.ready) {
+                    if (m_exception) {
+                        std::rethrow_exception(m_exception);
+                    }
+
+                    m_from_condition_var.wait(&thread_lock);
+                }
+            }
+        }
+
+        void texture_upload_thread_opengl::join()
+        {
+            threading::lock_guard thread_lock(&m_mutex);
+            m_thread.join();
+            m_thread_id = threading::thread_id();
+        }
+
+        void texture_upload_thread_opengl::enqueue_texture(
+            texture_opengl::ref const& texture,
+            texture_descriptor::ref const& texture_desc
+            )
+        {
+            upload_job job;
+            job.texture = texture;
+            job.texture_desc = texture_desc;
+
+            // Levels the driver generates itself need no upload.
+            bool generate_levels = (texture_desc->get_type() & texture_type_flags_mipmap) &&
+                (texture_desc->get_mip_level_generation_mode() != texture_level_generate_off);
+
+            texture_descriptor::const_image_iterator i(texture_desc->begin_images());
+            while (i != texture_desc->end_images()) {
+                if ((*i)->get_mip_level() == 0 || !generate_levels) {
+                    job.images.emplace_back(*i);
+                }
+                ++i;
+            }
+
+            // Smallest (highest numbered) levels first; stable so cube faces stay in order.
+            std::stable_sort(
+                job.images.begin(),
+                job.images.end(),
+                [](image_descriptor::ref const& a, image_descriptor::ref const& b) -> bool {
+                    return (a->get_mip_level() > b->get_mip_level());
+                });
+
+            threading::lock_guard thread_lock(&m_mutex);
+            if (m_exception) {
+                std::rethrow_exception(m_exception);
+            }
+
+            m_jobs.emplace_back(job);
+            m_to_condition_var.notify_all();
+        }
+
+        void texture_upload_thread_opengl::end_frame()
+        {
+            get_graphics()->get_render_thread()->check();
+
+            completed_vector finished;
+            {
+                threading::lock_guard thread_lock(&m_mutex);
+                if (m_exception) {
+                    std::rethrow_exception(m_exception);
+                }
+
+                m_budget_remaining_bytes = m_frame_budget_bytes;
+                if (!m_jobs.empty()) {
+                    m_to_condition_var.notify_all();
+                }
+
+                // Reverse iteration allows us to erase from the vector sanely.
+                int completed_count = static_cast<int>(m_completed.size());
+                for (int c = completed_count - 1; c >= 0; --c) {
+                    GLenum status = gl::ClientWaitSync(m_completed[c].fence, 0, 0);
+                    if (status == gl::ALREADY_SIGNALED || status == gl::CONDITION_SATISFIED) {
+                        finished.emplace_back(m_completed[c]);
+                        m_completed.erase(m_completed.begin() + c);
+                    }
+                    else if (status == gl::WAIT_FAILED_) {
+                        context_opengl::check_opengl_error();
+                    }
+                }
+            }
+
+            completed_vector::iterator f(finished.begin());
+            while (f != finished.end()) {
+                gl::DeleteSync(f->fence);
+                context_opengl::check_opengl_error();
+
+                f->texture->opengl_finish_create(f->texture_desc);
+                ++f;
+            }
+        }
+
+        long long texture_upload_thread_opengl::get_bytes_uploaded() const
+        {
+            threading::lock_guard thread_lock(&m_mutex);
+            return (m_bytes_uploaded);
+        }
+
+        void texture_upload_thread_opengl::thread_method()
+        {
+            ELECTROSLAG_LOG_MESSAGE("texture_upload_thread_opengl::thread_method");
+            try {
+                {
+                    threading::lock_guard thread_lock(&m_mutex);
+                    m_thread.set_thread_name(ELECTROSLAG_STRING_AND_HASH("t:graphics-upload"));
+
+                    m_thread_id = threading::this_thread::get_id();
+
+                    m_sub_context.initialize();
+                    create_ring();
+
+                    m_to_state.exit_thread = false;
+
+                    m_from_state.ready = true;
+                    m_from_condition_var.notify_all();
+                }
+
+                for (;;) {
+                    texture_opengl::ref texture;
+                    texture_descriptor::ref texture_desc;
+                    image_descriptor::ref image;
+                    bool last_image = false;
+                    {
+                        threading::lock_guard thread_lock(&m_mutex);
+
+                        // Wait for work, and for budget to do it with.
+                        while (!m_to_state.exit_thread && (m_jobs.empty() || m_budget_remaining_bytes <= 0)) {
+                            m_to_condition_var.wait(&thread_lock);
+                        }
+
+                        if (m_to_state.exit_thread) {
+                            break;
+                        }
+
+                        int j = select_job();
+                        upload_job& job = m_jobs[j];
+
+                        texture = job.texture;
+                        image = job.images[job.next_image];
+                        ++job.next_image;
+
+                        // A level larger than the whole budget still goes through,
+                        // it just uses up this frame.
+                        int image_bytes = image->get_pixels()->get_sizeof();
+                        m_budget_remaining_bytes -= image_bytes;
+                        m_bytes_uploaded += image_bytes;
+
+                        if (job.next_image >= static_cast<int>(job.images.size())) {
+                            last_image = true;
+                            texture_desc = job.texture_desc;
+                            m_jobs.erase(m_jobs.begin() + j);
+                        }
+                    }
+
+                    upload_image(texture->get_texture_id(), image);
+
+                    if (last_image) {
+                        GLsync fence = gl::FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+                        context_opengl::check_opengl_error();
+
+                        // Make sure the fence reaches the GPU; the render thread only polls it.
+                        gl::Flush();
+
+                        completed_upload completed;
+                        completed.texture = texture;
+                        completed.texture_desc = texture_desc;
+                        completed.fence = fence;
+
+                        threading::lock_guard thread_lock(&m_mutex);
+                        m_completed.emplace_back(completed);
+                    }
+                }
+            }
+            catch (...) {
+                threading::lock_guard thread_lock(&m_mutex);
+                m_exception = std::current_exception();
+            }
+
+            {
+                threading::lock_guard thread_lock(&m_mutex);
+                m_from_state.ready = false;
+                m_from_condition_var.notify_all();
+
+                // Anything not yet uploaded is abandoned along with the context.
+                m_jobs.clear();
+                completed_vector::iterator c(m_completed.begin());
+                while (c != m_completed.end()) {
+                    gl::DeleteSync(c->fence);
+                    ++c;
+                }
+                m_completed.clear();
+
+                destroy_ring();
+                m_sub_context.shutdown();
+            }
+        }
+
+        int texture_upload_thread_opengl::select_job() const
+        {
+            // Assume the m_mutex is being held.
+            ELECTROSLAG_CHECK(!m_jobs.empty());
+
+            int best_job = 0;
+            float best_priority = m_jobs[0].texture->get_stream_priority();
+            int best_bytes = m_jobs[0].images[m_jobs[0].next_image]->get_pixels()->get_sizeof();
+
+            int job_count = static_cast<int>(m_jobs.size());
+            for (int j = 1; j < job_count; ++j) {
+                upload_job const& job = m_jobs[j];
+                float priority = job.texture->get_stream_priority();
+                int bytes = job.images[job.next_image]->get_pixels()->get_sizeof();
+
+                // Among equally important textures, prefer the smallest next level
+                // so as many textures as possible get something on screen.
+                if ((priority < best_priority) || (priority == best_priority && bytes < best_bytes)) {
+                    best_job = j;
+                    best_priority = priority;
+                    best_bytes = bytes;
+                }
+            }
+
+            return (best_job);
+        }
+
+        void texture_upload_thread_opengl::upload_image(
+            opengl_object_id texture_id,
+            image_descriptor::ref const& image
+            )
+        {
+            referenced_buffer_interface::accessor pixel_accessor(image->get_pixels());
+            int pixels_sizeof = pixel_accessor.get_sizeof();
+
+            if (pixels_sizeof > m_ring_size) {
+                // Too big to stage; let the driver copy it from client memory.
+                texture_opengl::opengl_upload_image(
+                    texture_id,
+                    image,
+                    pixel_accessor.get_pointer(),
+                    pixels_sizeof
+                    );
+                return;
+            }
+
+            int ring_offset = 0;
+            byte* staging = allocate_ring(pixels_sizeof, &ring_offset);
+            std::memcpy(staging, pixel_accessor.get_pointer(), pixels_sizeof);
+
+            gl::BindBuffer(gl::PIXEL_UNPACK_BUFFER, m_ring_buffer);
+            context_opengl::check_opengl_error();
+
+            texture_opengl::opengl_upload_image(
+                texture_id,
+                image,
+                reinterpret_cast<void const*>(static_cast<intptr_t>(ring_offset)),
+                pixels_sizeof
+                );
+
+            gl::BindBuffer(gl::PIXEL_UNPACK_BUFFER, 0);
+            context_opengl::check_opengl_error();
+
+            ring_region region;
+            region.begin = ring_offset;
+            region.end = ring_offset + pixels_sizeof;
+            region.fence = gl::FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+            context_opengl::check_opengl_error();
+            m_ring_regions.emplace_back(region);
+
+            m_ring_head = region.end;
+        }
+
+        byte* texture_upload_thread_opengl::allocate_ring(int size, int* out_offset)
+        {
+            ELECTROSLAG_CHECK(size <= m_ring_size);
+
+            // Keep staged images aligned for any pixel unpack alignment.
+            static int const staging_alignment = 16;
+            int offset = (m_ring_head + (staging_alignment - 1)) & ~(staging_alignment - 1);
+            if (offset + size > m_ring_size) {
+                offset = 0;
+            }
+
+            // Regions are retired oldest first; wait until none of the ones still in
+            // flight overlap [offset, offset + size).
+            for (;;) {
+                bool overlap = false;
+                ring_region_deque::const_iterator r(m_ring_regions.begin());
+                while (r != m_ring_regions.end()) {
+                    if (r->begin < offset + size && offset < r->end) {
+                        overlap = true;
+                        break;
+                    }
+                    ++r;
+                }
+
+                if (!overlap) {
+                    break;
+                }
+                wait_for_ring_region();
+            }
+
+            *out_offset = offset;
+            return (m_ring_memory + offset);
+        }
+
+        void texture_upload_thread_opengl::wait_for_ring_region()
+        {
+            ELECTROSLAG_CHECK(!m_ring_regions.empty());
+            ring_region region(m_ring_regions.front());
+            m_ring_regions.pop_front();
+
+            // One second; anything beyond that is a hang.
+            GLuint64 const wait_nanoseconds = 1000ULL * 1000ULL * 1000ULL;
+            GLenum status = gl::ClientWaitSync(region.fence, gl::SYNC_FLUSH_COMMANDS_BIT, wait_nanoseconds);
+            gl::DeleteSync(region.fence);
+
+            if (status == gl::TIMEOUT_EXPIRED) {
+                throw std::runtime_error("Timeout waiting on texture upload staging");
+            }
+            else if (status == gl::WAIT_FAILED_) {
+                context_opengl::check_opengl_error();
+            }
+        }
+
+        void texture_upload_thread_opengl::create_ring()
+        {
+            ELECTROSLAG_CHECK(!m_ring_buffer);
+            ELECTROSLAG_CHECK(m_ring_size > 0);
+
+            opengl_object_id ring_buffer = 0;
+            gl::CreateBuffers(1, &ring_buffer);
+            context_opengl::check_opengl_error();
+            m_ring_buffer = ring_buffer;
+
+            GLbitfield const flags = gl::MAP_WRITE_BIT | gl::MAP_PERSISTENT_BIT | gl::MAP_COHERENT_BIT;
+            gl::NamedBufferStorage(m_ring_buffer, m_ring_size, 0, flags);
+            context_opengl::check_opengl_error();
+
+            m_ring_memory = static_cast<byte*>(gl::MapNamedBufferRange(m_ring_buffer, 0, m_ring_size, flags));
+            context_opengl::check_opengl_error();
+            if (!m_ring_memory) {
+                throw opengl_api_failure("MapNamedBufferRange", 0);
+            }
+
+            m_ring_head = 0;
+
+            ELECTROSLAG_LOG_GFX(
+                "Texture streaming: %d KB staging, %d KB per frame",
+                m_ring_size / 1024,
+                m_frame_budget_bytes / 1024
+                );
+        }
+
+        void texture_upload_thread_opengl::destroy_ring()
+        {
+            while (!m_ring_regions.empty()) {
+                gl::DeleteSync(m_ring_regions.front().fence);
+                m_ring_regions.pop_front();
+            }
+
+            if (m_ring_buffer) {
+                gl::UnmapNamedBuffer(m_ring_buffer);
+                gl::DeleteBuffers(1, &m_ring_buffer);
+                m_ring_buffer = 0;
+            }
+            m_ring_memory = 0;
+            m_ring_head = 0;
+        }
+    }
+}
@@ -0,0 +1,205 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/threading/this_thread.hpp"
+#include "electroslag/threading/thread.hpp"
+#include "electroslag/threading/mutex.hpp"
+#include "electroslag/threading/condition_variable.hpp"
+#include "electroslag/graphics/graphics_types.hpp"
+#include "electroslag/graphics/texture_descriptor.hpp"
+#include "electroslag/graphics/texture_opengl.hpp"
+#include "electroslag/graphics/sub_context_opengl.hpp"
+
+namespace electroslag {
+    namespace graphics {
+        // Streams texture pixels to the GPU from its own thread and shared context,
+        // so texture creation never stalls the render thread on uploads.
+        //
+        // Pixels are copied into a persistently mapped pixel unpack buffer used as
+        // a ring; each region is fenced and only reused once the GPU has consumed
+        // it. Levels are uploaded smallest first, textures in order of their
+        // stream priority, and no more than the per-frame byte budget is
+        // started each frame. Once the last level of a texture has been
+        // submitted, its fence is handed back to the render thread, which
+        // finishes the texture (mip generation, bindless handle) when the fence
+        // passes.
+        class texture_upload_thread_opengl {
+        public:
+            texture_upload_thread_opengl()
+                : m_mutex(ELECTROSLAG_STRING_AND_HASH("m:texture_upload_thread"))
+                , m_to_condition_var(ELECTROSLAG_STRING_AND_HASH("cv:to_texture_upload_thread"))
+                , m_from_condition_var(ELECTROSLAG_STRING_AND_HASH("cv:from_texture_upload_thread"))
+                , m_frame_budget_bytes(0)
+                , m_budget_remaining_bytes(0)
+                , m_bytes_uploaded(0)
+                , m_ring_buffer(0)
+                , m_ring_memory(0)
+                , m_ring_size(0)
+                , m_ring_head(0)
+            {}
+
+            ~texture_upload_thread_opengl()
+            {
+                join();
+            }
+
+            bool is_running() const
+            {
+                return (threading::this_thread::get_id() == m_thread_id);
+            }
+
+            void check() const
+            {
+                ELECTROSLAG_CHECK(threading::this_thread::get_id() == m_thread_id);
+            }
+
+            void check_not() const
+            {
+                ELECTROSLAG_CHECK(threading::this_thread::get_id() != m_thread_id);
+            }
+
+            bool is_started() const;
+            void spawn(int frame_budget_bytes);
+            void wait_for_ready();
+
+            void signal_exit();
+            void wait_for_exit();
+            void join();
+
+            // Any thread; queues every level the texture needs uploaded.
+            void enqueue_texture(
+                texture_opengl::ref const& texture,
+                texture_descriptor::ref const& texture_desc
+                );
+
+            // Render thread, once per frame: refills the upload budget and finishes
+            // textures whose uploads the GPU has completed.
+            void end_frame();
+
+            long long get_bytes_uploaded() const;
+
+        private:
+            // The ring holds a few frames worth of budget so the upload thread
+            // rarely waits on the GPU to release a region.
+            static int const ring_frames = 4;
+            static int const min_ring_size = 4 * 1024 * 1024;
+
+            struct upload_job {
+                upload_job()
+                    : next_image(0)
+                {}
+
+                texture_opengl::ref texture;
+                texture_descriptor::ref texture_desc;
+
+                typedef std::vector<image_descriptor::ref> image_vector;
+                image_vector images; // Smallest first
+                int next_image;
+            };
+            typedef std::vector<upload_job> job_vector;
+
+            struct completed_upload {
+                completed_upload()
+                    : fence(0)
+                {}
+
+                texture_opengl::ref texture;
+                texture_descriptor::ref texture_desc;
+                GLsync fence;
+            };
+            typedef std::vector<completed_upload> completed_vector;
+
+            struct ring_region {
+                ring_region()
+                    : begin(0)
+                    , end(0)
+                    , fence(0)
+                {}
+
+                int begin;
+                int end;
+                GLsync fence;
+            };
+            typedef std::deque<ring_region> ring_region_deque;
+
+            static void thread_stub(void* argument)
+            {
+                reinterpret_cast<texture_upload_thread_opengl*>(argument)->thread_method();
+            }
+
+            void thread_method();
+
+            // Called with m_mutex held; returns the index of the job to upload from.
+            int select_job() const;
+
+            void upload_image(opengl_object_id texture_id, image_descriptor::ref const& image);
+            byte* allocate_ring(int size, int* out_offset);
+            void wait_for_ring_region();
+
+            void create_ring();
+            void destroy_ring();
+
+            threading::thread m_thread;
+            threading::thread_id m_thread_id;
+
+            mutable threading::mutex m_mutex;
+
+            job_vector m_jobs;
+            completed_vector m_completed;
+
+            int m_frame_budget_bytes;
+            int m_budget_remaining_bytes;
+            long long m_bytes_uploaded;
+
+            // State changes the upload thread listens to.
+            threading::condition_variable m_to_condition_var;
+            struct to_thread_state {
+                to_thread_state()
+                    : exit_thread(false)
+                {}
+
+                bool exit_thread:1;
+            } m_to_state;
+            ELECTROSLAG_STATIC_CHECK(sizeof(to_thread_state) == 1, "Bit packing check");
+
+            // State changes precipitated by the upload thread
+            threading::condition_variable m_from_condition_var;
+            std::exception_ptr m_exception;
+
+            struct from_thread_state {
+                from_thread_state()
+                    : ready(false)
+                {}
+
+                bool ready:1;
+            } m_from_state;
+            ELECTROSLAG_STATIC_CHECK(sizeof(from_thread_state) == 1, "Bit packing check");
+
+            // Private state to the upload thread.
+            sub_context_opengl m_sub_context;
+
+            opengl_object_id m_ring_buffer;
+            byte* m_ring_memory;
+            int m_ring_size;
+            int m_ring_head;
+            ring_region_deque m_ring_regions;
+
+            // Disallowed operations:
+            explicit texture_upload_thread_opengl(texture_upload_thread_opengl const&);
+            texture_upload_thread_opengl& operator =(texture_upload_thread_opengl const&);
+        };
+    }
+}
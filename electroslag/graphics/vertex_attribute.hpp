@@ -27,6 +27,9 @@ namespace electroslag {
             vertex_attribute()
                 : m_stride(0)
                 , m_field(0)
+                , m_component_type(attribute_component_type_float)
+                , m_normalized(false)
+                , m_offset(-1)
             {}
 
             vertex_attribute(
@@ -39,6 +42,9 @@ namespace electroslag {
                 , m_field(field)
                 , m_buffer(buffer)
                 , m_stride(stride)
+                , m_component_type(attribute_component_type_float)
+                , m_normalized(false)
+                , m_offset(-1)
             {
                 ELECTROSLAG_CHECK(field->is_attribute());
             }
@@ -54,6 +60,9 @@ namespace electroslag {
                 , m_field(field)
                 , m_buffer(buffer)
                 , m_stride(stride)
+                , m_component_type(attribute_component_type_float)
+                , m_normalized(false)
+                , m_offset(-1)
             {
                 ELECTROSLAG_CHECK(field->is_attribute());
             }
@@ -68,6 +77,9 @@ namespace electroslag {
                 , m_field(copy_object.m_field)
                 , m_buffer(copy_object.m_buffer)
                 , m_stride(copy_object.m_stride)
+                , m_component_type(copy_object.m_component_type)
+                , m_normalized(copy_object.m_normalized)
+                , m_offset(copy_object.m_offset)
             {}
 
             vertex_attribute& operator =(vertex_attribute const& copy_object)
@@ -77,12 +89,18 @@ namespace electroslag {
                     m_field = copy_object.m_field;
                     m_buffer = copy_object.m_buffer;
                     m_stride = copy_object.m_stride;
+                    m_component_type = copy_object.m_component_type;
+                    m_normalized = copy_object.m_normalized;
+                    m_offset = copy_object.m_offset;
                 }
                 return (*this);
             }
 
             // Implement serializable_object
             explicit vertex_attribute(serialize::archive_reader_interface* ar)
+                : m_component_type(attribute_component_type_float)
+                , m_normalized(false)
+                , m_offset(-1)
             {
                 if (!ar->read_int32("stride", &m_stride)) {
                     throw load_object_failure("stride");
@@ -101,6 +119,17 @@ namespace electroslag {
                 m_field = dynamic_cast<shader_field*>(serialize::get_database()->find_object(field_name_hash));
 
                 ELECTROSLAG_CHECK(m_field->is_attribute());
+
+                // Older archives only hold float attributes.
+                if (ar->read_enumeration("component_type", &m_component_type, attribute_component_type_strings)) {
+                    if (!ar->read_boolean("normalized", &m_normalized)) {
+                        throw load_object_failure("normalized");
+                    }
+
+                    if (!ar->read_int32("offset", &m_offset)) {
+                        throw load_object_failure("offset");
+                    }
+                }
             }
 
             virtual void save_to_archive(serialize::archive_writer_interface* ar)
@@ -112,6 +141,9 @@ namespace electroslag {
                 ar->write_int32("stride", m_stride);
                 ar->write_name_hash("vbo", m_buffer->get_hash());
                 ar->write_name_hash("field", m_field->get_hash());
+                ar->write_int32("component_type", m_component_type);
+                ar->write_boolean("normalized", m_normalized);
+                ar->write_int32("offset", m_offset);
             }
 
             int get_stride() const
@@ -129,10 +161,43 @@ namespace electroslag {
                 return (m_field);
             }
 
+            attribute_component_type get_component_type() const
+            {
+                return (m_component_type);
+            }
+
+            bool is_normalized() const
+            {
+                return (m_normalized);
+            }
+
+            // Byte offset of the attribute within each element of the buffer. Float
+            // attributes are laid out like the field; packed ones give their own.
+            int get_offset() const
+            {
+                return ((m_offset >= 0) ? m_offset : m_field->get_offset());
+            }
+
+            // Keep quantized data packed in the buffer; the field must be a float vector.
+            // The field's offset assumes float components, so the packed layout's byte
+            // offset is given here.
+            void set_component_type(attribute_component_type component_type, bool normalized, int offset)
+            {
+                ELECTROSLAG_CHECK(component_type > attribute_component_type_unknown && component_type < attribute_component_type_count);
+                ELECTROSLAG_CHECK(component_type != attribute_component_type_float || !normalized);
+                ELECTROSLAG_CHECK(offset >= 0 && (m_stride == 0 || offset < m_stride));
+                m_component_type = component_type;
+                m_normalized = normalized;
+                m_offset = offset;
+            }
+
         private:
             buffer_descriptor::ref m_buffer;
             int m_stride;
             shader_field* m_field;
+            attribute_component_type m_component_type;
+            bool m_normalized;
+            int m_offset; // -1 to use the field's offset
         };
     }
 }
@@ -0,0 +1,152 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/graphics/graphics_opengl.hpp"
+#include "electroslag/graphics/context_opengl.hpp"
+#include "electroslag/graphics/vertex_format_cache_opengl.hpp"
+
+namespace electroslag {
+    namespace graphics {
+        void vertex_format_cache_opengl::shutdown()
+        {
+            state_cache_opengl* state_cache = static_cast<graphics_opengl*>(get_graphics())->get_state_cache();
+
+            vertex_format_table::iterator f(m_vertex_format_table.begin());
+            while (f != m_vertex_format_table.end()) {
+                opengl_object_id vertex_array_id = f->second.vertex_array_id;
+                gl::DeleteVertexArrays(1, &vertex_array_id);
+                state_cache->forget_vertex_array(vertex_array_id);
+                ++f;
+            }
+            m_vertex_format_table.clear();
+        }
+
+        vertex_format_cache_opengl::vertex_format* vertex_format_cache_opengl::locate_format(
+            format_desc const* desc
+            )
+        {
+            unsigned long long format_hash = hash_bytes_runtime(desc, sizeof(*desc));
+
+            vertex_format_table::iterator existing(m_vertex_format_table.find(format_hash));
+            if (existing != m_vertex_format_table.end()) {
+                ELECTROSLAG_CHECK(memcmp(&existing->second.desc, desc, sizeof(*desc)) == 0);
+                return (&existing->second);
+            }
+
+            vertex_format* format = &m_vertex_format_table[format_hash];
+            format->desc = *desc;
+            memset(format->bound_vertex_buffers, 0, sizeof(format->bound_vertex_buffers));
+            memset(format->bound_vertex_offsets, 0, sizeof(format->bound_vertex_offsets));
+            format->bound_element_buffer = 0;
+
+            opengl_object_id vertex_array_id = 0;
+            gl::CreateVertexArrays(1, &vertex_array_id);
+            context_opengl::check_opengl_error();
+            format->vertex_array_id = vertex_array_id;
+
+            for (int a = 0; a < desc->attribute_count; ++a) {
+                format_attribute const* attrib = &desc->attributes[a];
+                gl::VertexArrayAttribFormat(
+                    vertex_array_id,
+                    attrib->index,
+                    attrib->order,
+                    attrib->type,
+                    attrib->normalized,
+                    attrib->relative_offset
+                    );
+                gl::VertexArrayAttribBinding(vertex_array_id, attrib->index, attrib->binding);
+                gl::EnableVertexArrayAttrib(vertex_array_id, attrib->index);
+            }
+            context_opengl::check_opengl_error();
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            std::string format_name;
+            formatted_string_append(format_name, "vertex_format::%016llX", format_hash);
+            gl::ObjectLabel(
+                gl::VERTEX_ARRAY,
+                vertex_array_id,
+                static_cast<GLsizei>(format_name.length()),
+                format_name.c_str()
+                );
+            context_opengl::check_opengl_error();
+#endif
+
+            return (format);
+        }
+
+        void vertex_format_cache_opengl::bind(
+            vertex_format* format,
+            opengl_object_id const* vertex_buffers,
+            int const* vertex_offsets,
+            opengl_object_id element_buffer
+            )
+        {
+            state_cache_opengl* state_cache = static_cast<graphics_opengl*>(get_graphics())->get_state_cache();
+            state_cache->bind_vertex_array(format->vertex_array_id);
+
+            // Only this class changes the shared vertex array's buffers, so the
+            // shadow in the format is authoritative.
+            bool issued_any = false;
+
+            for (int b = 0; b < format->desc.binding_count; ++b) {
+                bool issue = (format->bound_vertex_buffers[b] != vertex_buffers[b] ||
+                    format->bound_vertex_offsets[b] != vertex_offsets[b]);
+                if (issue) {
+                    gl::VertexArrayVertexBuffer(
+                        format->vertex_array_id,
+                        b,
+                        vertex_buffers[b],
+                        vertex_offsets[b],
+                        format->desc.binding_strides[b]
+                        );
+                    format->bound_vertex_buffers[b] = vertex_buffers[b];
+                    format->bound_vertex_offsets[b] = vertex_offsets[b];
+                    issued_any = true;
+                }
+                state_cache->count(state_filter_category_vertex_array, issue);
+            }
+
+            bool issue = (format->bound_element_buffer != element_buffer);
+            if (issue) {
+                gl::VertexArrayElementBuffer(format->vertex_array_id, element_buffer);
+                format->bound_element_buffer = element_buffer;
+                issued_any = true;
+            }
+            state_cache->count(state_filter_category_vertex_array, issue);
+
+            if (issued_any) {
+                context_opengl::check_opengl_error();
+            }
+        }
+
+        void vertex_format_cache_opengl::forget_buffer(opengl_object_id buffer_id)
+        {
+            vertex_format_table::iterator f(m_vertex_format_table.begin());
+            while (f != m_vertex_format_table.end()) {
+                vertex_format* format = &f->second;
+                for (int b = 0; b < format->desc.binding_count; ++b) {
+                    if (format->bound_vertex_buffers[b] == buffer_id) {
+                        format->bound_vertex_buffers[b] = 0;
+                    }
+                }
+                if (format->bound_element_buffer == buffer_id) {
+                    format->bound_element_buffer = 0;
+                }
+                ++f;
+            }
+        }
+    }
+}
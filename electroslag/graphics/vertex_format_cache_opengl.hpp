@@ -0,0 +1,121 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/graphics/graphics_types.hpp"
+
+namespace electroslag {
+    namespace graphics {
+        // Vertex arrays keyed by vertex layout alone. The layout (attribute formats
+        // and which binding point each reads from) is set up once with direct
+        // state access; primitive streams with the same layout share the vertex
+        // array and only point its binding points at their own buffers when they
+        // are bound. Layouts are few, so the vertex arrays live until shutdown.
+        // Only used from the render thread.
+        class vertex_format_cache_opengl {
+        public:
+            // GL guarantees at least this many of each.
+            static int const max_attributes = 16;
+            static int const max_bindings = 16;
+
+            struct format_attribute {
+                int index;
+                int order;
+                GLenum type;
+                GLboolean normalized;
+                int relative_offset;
+                int binding;
+            };
+
+            // Zero filled on construction so the whole struct can be hashed and compared.
+            struct format_desc {
+                format_desc()
+                {
+                    memset(this, 0, sizeof(*this));
+                }
+
+                void add_attribute(int index, int order, GLenum type, GLboolean normalized, int relative_offset, int binding)
+                {
+                    ELECTROSLAG_CHECK(attribute_count < max_attributes);
+                    ELECTROSLAG_CHECK(binding >= 0 && binding < binding_count);
+                    format_attribute* a = &attributes[attribute_count++];
+                    a->index = index;
+                    a->order = order;
+                    a->type = type;
+                    a->normalized = normalized;
+                    a->relative_offset = relative_offset;
+                    a->binding = binding;
+                }
+
+                int add_binding(int stride)
+                {
+                    ELECTROSLAG_CHECK(binding_count < max_bindings);
+                    binding_strides[binding_count] = stride;
+                    return (binding_count++);
+                }
+
+                int attribute_count;
+                int binding_count;
+                format_attribute attributes[max_attributes];
+                int binding_strides[max_bindings];
+            };
+
+            struct vertex_format {
+                format_desc desc;
+                opengl_object_id vertex_array_id;
+
+                // What the shared vertex array's binding points hold right now.
+                opengl_object_id bound_vertex_buffers[max_bindings];
+                int bound_vertex_offsets[max_bindings];
+                opengl_object_id bound_element_buffer;
+            };
+
+            vertex_format_cache_opengl()
+            {}
+
+            // Called by context_opengl while its context is still current.
+            void shutdown();
+
+            // The returned pointer stays valid until shutdown.
+            vertex_format* locate_format(format_desc const* desc);
+
+            // Bind the shared vertex array and point it at one stream's buffers;
+            // vertex_buffers and vertex_offsets have one entry per binding in the format.
+            void bind(
+                vertex_format* format,
+                opengl_object_id const* vertex_buffers,
+                int const* vertex_offsets,
+                opengl_object_id element_buffer
+                );
+
+            // Called as buffers are deleted; a vertex array that is not bound keeps
+            // its reference to a deleted buffer, and the name may be handed out again.
+            void forget_buffer(opengl_object_id buffer_id);
+
+        private:
+            typedef std::unordered_map<
+                unsigned long long,
+                vertex_format,
+                prehashed_key<unsigned long long>,
+                std::equal_to<unsigned long long>
+            > vertex_format_table;
+            vertex_format_table m_vertex_format_table;
+
+            // Disallowed operations:
+            explicit vertex_format_cache_opengl(vertex_format_cache_opengl const&);
+            vertex_format_cache_opengl& operator =(vertex_format_cache_opengl const&);
+        };
+    }
+}
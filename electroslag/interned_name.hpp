@@ -0,0 +1,62 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+
+namespace electroslag {
+    // A string owned by the name_table. Interned strings live as long as the
+    // table does, so a handle can be kept and read without copying or locking.
+    class interned_name {
+    public:
+        interned_name()
+            : m_str(0)
+            , m_length(0)
+        {}
+
+        interned_name(char const* str, int length)
+            : m_str(str)
+            , m_length(length)
+        {}
+
+        bool is_valid() const
+        {
+            return (m_str != 0);
+        }
+
+        char const* c_str() const
+        {
+            return (m_str ? m_str : "");
+        }
+
+        int length() const
+        {
+            return (m_length);
+        }
+
+        bool empty() const
+        {
+            return (m_length == 0);
+        }
+
+        std::string str() const
+        {
+            return (std::string(c_str(), m_length));
+        }
+
+    private:
+        char const* m_str;
+        int m_length;
+    };
+}
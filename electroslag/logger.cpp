@@ -23,29 +23,162 @@ namespace electroslag {
         return (get_systems()->get_logger());
     }
 
+    class logger::log_ring {
+    public:
+        static unsigned int const capacity = 64 * 1024;
+
+        // Anything larger bypasses the ring and is written synchronously.
+        static int const max_record_bytes = capacity / 4;
+
+        log_ring()
+            : m_write(0)
+            , m_read(0)
+            , m_reserved_write(0)
+        {}
+
+        // Producer side.
+        log_record* reserve(int record_bytes)
+        {
+            unsigned int write = m_write.load(std::memory_order_relaxed);
+            unsigned int read = m_read.load(std::memory_order_acquire);
+            unsigned int offset = write & (capacity - 1);
+            unsigned int contiguous = capacity - offset;
+            unsigned int padding = (contiguous < static_cast<unsigned int>(record_bytes)) ? contiguous : 0;
+
+            if ((write + padding + record_bytes) - read > capacity) {
+                return (0);
+            }
+
+            // Records never wrap; skip the tail of the buffer with a padding record.
+            if (padding) {
+                log_record* padding_record = reinterpret_cast<log_record*>(m_buffer + offset);
+                padding_record->format = 0;
+                padding_record->record_bytes = static_cast<int>(padding);
+                write += padding;
+                offset = 0;
+            }
+
+            m_reserved_write = write + record_bytes;
+            return (reinterpret_cast<log_record*>(m_buffer + offset));
+        }
+
+        log_record* reserve_overflow(int record_bytes)
+        {
+            m_overflow.resize(record_bytes);
+            return (reinterpret_cast<log_record*>(&m_overflow.front()));
+        }
+
+        bool is_overflow(log_record const* record) const
+        {
+            return (!m_overflow.empty() && reinterpret_cast<byte const*>(record) == &m_overflow.front());
+        }
+
+        void publish()
+        {
+            m_write.store(m_reserved_write, std::memory_order_release);
+        }
+
+        // Consumer side; the logger's m_mutex serializes consumers.
+        void drain(logger* l)
+        {
+            unsigned int read = m_read.load(std::memory_order_relaxed);
+            unsigned int write = m_write.load(std::memory_order_acquire);
+            while (read != write) {
+                log_record const* record = reinterpret_cast<log_record const*>(m_buffer + (read & (capacity - 1)));
+                if (record->format) {
+                    l->format_record(record);
+                }
+                read += record->record_bytes;
+            }
+            m_read.store(read, std::memory_order_release);
+        }
+
+    private:
+        // Rings come from the ordinary heap, so rather than over-align the members,
+        // pad them far enough apart that the producer and consumer indices never
+        // share a cache line with each other or with the records.
+        static unsigned int const cache_line_bytes = 64;
+
+        std::atomic<unsigned int> m_write;
+        byte m_write_padding[cache_line_bytes - sizeof(std::atomic<unsigned int>)];
+        std::atomic<unsigned int> m_read;
+        byte m_read_padding[cache_line_bytes - sizeof(std::atomic<unsigned int>)];
+        byte m_buffer[capacity];
+
+        // Producer private.
+        unsigned int m_reserved_write;
+        std::vector<byte> m_overflow;
+
+        // Disallowed operations:
+        explicit log_ring(log_ring const&);
+        log_ring& operator =(log_ring const&);
+    };
+
     logger::logger()
         : m_mutex(ELECTROSLAG_STRING_AND_HASH("m:logger"))
+        , m_wake_mutex(ELECTROSLAG_STRING_AND_HASH("m:logger_wake"))
+        , m_wake(ELECTROSLAG_STRING_AND_HASH("cv:logger_wake"))
         , m_log_enable_bits(default_log_enable_bits)
         , m_log_output_bits(default_log_output_bits)
+        , m_next_sequence(0)
+        , m_records_pending(false)
+        , m_async(false)
+        , m_exit_thread(false)
 #if defined(ELECTROSLAG_COMPILER_MSVC) && defined(ELECTROSLAG_BUILD_DEBUG)
         , m_report_hook_set(false)
 #endif 
     {}
 
+    logger::~logger()
+    {
+        flush();
+
+        threading::lock_guard logger_lock(&m_mutex);
+        ring_vector::iterator r(m_rings.begin());
+        while (r != m_rings.end()) {
+            delete *r;
+            ++r;
+        }
+        m_rings.clear();
+    }
+
     void logger::initialize()
     {
+        {
+            threading::lock_guard logger_lock(&m_mutex);
 #if defined(ELECTROSLAG_COMPILER_MSVC) && defined(ELECTROSLAG_BUILD_DEBUG)
-        threading::lock_guard logger_lock(&m_mutex);
-        if (!m_report_hook_set) {
-            if (_CrtSetReportHook2(_CRT_RPTHOOK_INSTALL, &crt_dbg_report_logger) >= 0) {
-                m_report_hook_set = true;
+            if (!m_report_hook_set) {
+                if (_CrtSetReportHook2(_CRT_RPTHOOK_INSTALL, &crt_dbg_report_logger) >= 0) {
+                    m_report_hook_set = true;
+                }
             }
-        }
 #endif
+        }
+
+        if (!m_async.load(std::memory_order_acquire)) {
+            {
+                threading::lock_guard wake_lock(&m_wake_mutex);
+                m_exit_thread = false;
+            }
+            m_thread.spawn(&thread_stub, this);
+            m_async.store(true, std::memory_order_release);
+        }
     }
 
     void logger::shutdown()
     {
+        if (m_async.exchange(false)) {
+            {
+                threading::lock_guard wake_lock(&m_wake_mutex);
+                m_exit_thread = true;
+                m_wake.notify_all();
+            }
+            m_thread.join();
+        }
+
+        // Pick up anything enqueued while the logger thread was exiting.
+        flush();
+
 #if defined(ELECTROSLAG_COMPILER_MSVC) && defined(ELECTROSLAG_BUILD_DEBUG)
         threading::lock_guard logger_lock(&m_mutex);
         if (m_report_hook_set) {
@@ -56,17 +189,22 @@ namespace electroslag {
         fflush(stdout);
     }
 
-    int logger::get_log_enable() const
+    void logger::flush()
     {
         threading::lock_guard logger_lock(&m_mutex);
-        return (m_log_enable_bits);
+        drain_rings();
+        write_lines();
+    }
+
+    int logger::get_log_enable() const
+    {
+        return (m_log_enable_bits.load(std::memory_order_relaxed));
     }
 
     void logger::set_log_enable(int enable_bits)
     {
-        threading::lock_guard logger_lock(&m_mutex);
         if ((enable_bits & ~log_enable_bit_valid) == 0) {
-            m_log_enable_bits = enable_bits;
+            m_log_enable_bits.store(enable_bits, std::memory_order_relaxed);
         }
         else {
             throw parameter_failure("enable_bits");
@@ -93,6 +231,11 @@ namespace electroslag {
     void logger::set_log_output_file(std::string const& output_file)
     {
         threading::lock_guard logger_lock(&m_mutex);
+
+        // Records already enqueued belong to the old file.
+        drain_rings();
+        write_lines();
+
         if (m_output_file.is_open()) {
             m_output_file.close();
         }
@@ -105,107 +248,237 @@ namespace electroslag {
         }
     }
 
-    void logger::log_print(
-        char level_code,
-        char const* format_string,
-        va_list arg_list
-        )
+    logger::log_ring* logger::get_this_thread_ring()
+    {
+        log_ring* ring = m_this_thread_ring.get();
+        if (!ring) {
+            // Rings are owned by the logger; on_thread_exit hands them back.
+            ring = new log_ring();
+            m_this_thread_ring.reset(ring);
+
+            threading::lock_guard logger_lock(&m_mutex);
+            m_rings.emplace_back(ring);
+        }
+        return (ring);
+    }
+
+    void logger::on_thread_exit()
     {
+        log_ring* ring = m_this_thread_ring.get();
+        if (ring) {
+            m_this_thread_ring.reset(0);
+
+            // Write out whatever the thread left behind before the ring goes away.
+            threading::lock_guard logger_lock(&m_mutex);
+            ring->drain(this);
+            write_lines();
+
+            m_rings.erase(std::remove(m_rings.begin(), m_rings.end(), ring), m_rings.end());
+            delete ring;
+        }
+    }
+
+    logger::log_record* logger::begin_record(int record_bytes)
+    {
+        log_ring* ring = get_this_thread_ring();
+        threading::thread* this_thread = threading::this_thread::get();
+
+        log_record* record = 0;
+        if (record_bytes > log_ring::max_record_bytes) {
+            record = ring->reserve_overflow(record_bytes);
+        }
+        else {
+            record = ring->reserve(record_bytes);
+            while (!record) {
+                // The ring is full. Let the logger thread catch up, or drain it here
+                // when there is no logger thread to do it (or this is that thread).
+                if (m_async.load(std::memory_order_acquire) && this_thread != &m_thread) {
+                    wake_logger_thread();
+                    SwitchToThread();
+                }
+                else {
+                    flush();
+                }
+                record = ring->reserve(record_bytes);
+            }
+        }
+
+        record->sequence = m_next_sequence.fetch_add(1, std::memory_order_relaxed);
+        record->thread_name_hash = this_thread->get_thread_name_hash();
+        record->timestamp = ui::get_ui()->get_timer()->read_milliseconds();
+        record->record_bytes = record_bytes;
+        return (record);
+    }
+
+    void logger::end_record(log_record* record)
+    {
+        log_ring* ring = m_this_thread_ring.get();
+        if (ring->is_overflow(record)) {
+            // Written synchronously, after everything already queued.
+            threading::lock_guard logger_lock(&m_mutex);
+            drain_rings();
+            format_record(record);
+            write_lines();
+        }
+        else {
+            ring->publish();
+            if (m_async.load(std::memory_order_acquire)) {
+                wake_logger_thread();
+            }
+            else {
+                flush();
+            }
+        }
+    }
+
+    void logger::wake_logger_thread()
+    {
+        // Only the first record of a batch pays for the notify.
+        if (!m_records_pending.exchange(true, std::memory_order_acq_rel)) {
+            threading::lock_guard wake_lock(&m_wake_mutex);
+            m_wake.notify_one();
+        }
+    }
+
+    void logger::thread_method()
+    {
+        m_thread.set_thread_name(ELECTROSLAG_STRING_AND_HASH("t:logger"));
+
+        bool exit_thread = false;
+        do {
+            {
+                threading::lock_guard wake_lock(&m_wake_mutex);
+                while (!m_records_pending.exchange(false, std::memory_order_acq_rel) && !m_exit_thread) {
+                    m_wake.wait(&wake_lock);
+                }
+                exit_thread = m_exit_thread;
+            }
+
+            try {
+                flush();
+            }
+            catch (...) {
+                // Nowhere left to report a failure to write the log.
+            }
+        } while (!exit_thread);
+    }
+
+    void logger::drain_rings()
+    {
+        // Assume the m_mutex is being held.
+        ring_vector::iterator r(m_rings.begin());
+        while (r != m_rings.end()) {
+            (*r)->drain(this);
+            ++r;
+        }
+    }
+
+    void logger::format_record(log_record const* record)
+    {
+        // Assume the m_mutex is being held.
+
         // Don't bother to format if there will be no output.
         if (!m_log_output_bits) {
             return;
         }
 
-        // Timestamp
-        unsigned int timestamp = ui::get_ui()->get_timer()->read_milliseconds();
+        byte const* arguments = reinterpret_cast<byte const*>(record + 1);
 
-        // Figure out how long the message is.
-        int formatted_length = std::vsnprintf(0, 0, format_string, arg_list);
-        if (formatted_length == -1) {
-            throw std::runtime_error("failed to format log parameters.");
+        // Most messages fit on the stack; only long ones format twice.
+        char message[512];
+        std::string message_string;
+        int formatted_length = record->format(record->format_string, arguments, message, sizeof(message));
+        if (formatted_length < 0) {
+            message_string = "failed to format log parameters.";
         }
         else if (!formatted_length) {
             return;
         }
-
-        threading::thread* this_thread = threading::this_thread::get();
-        std::string this_thread_name;
-        if (this_thread->has_thread_name()) {
-            this_thread_name = this_thread->get_thread_name();
+        else if (formatted_length < static_cast<int>(sizeof(message))) {
+            message_string.assign(message, formatted_length);
         }
         else {
-            this_thread_name = "n/a";
-        }
-        int thread_name_length = static_cast<int>(this_thread_name.length());
-
-        // Allocate stack space for the output string
-        int expected_prefix_length =
-            2 + 1 +  // '[' + level_code + ']'
-            2 + 10 + // '[' + timestamp + ']'
-            2 + thread_name_length + // '[' + thread name + ']'
-            1;       // space
-        int output_length = 
-            formatted_length +
-            expected_prefix_length +
-            2;      // +1 for the NUL and might need newline, so +1 again
-        char* output_string = static_cast<char*>(alloca(output_length));
-        output_string[0] = '\0';
-
-        // Write in the prefix.
-        int prefix_length = std::snprintf(output_string, output_length, "[%c][%10u][%-*s] ",
-            level_code,
-            timestamp,
-            thread_name_length,
-            this_thread_name.c_str()
-            );
-        if (prefix_length != expected_prefix_length) {
-            throw std::runtime_error("failed to format log parameters.");
+            message_string.resize(formatted_length + 1);
+            record->format(record->format_string, arguments, &message_string[0], formatted_length + 1);
+            message_string.resize(formatted_length);
         }
 
-        // Write the message.
-        int return_length = std::vsnprintf(
-            output_string + prefix_length,
-            output_length - prefix_length,
-            format_string,
-            arg_list
-            );
-        if (return_length == -1) {
-            throw std::runtime_error("failed to format log parameters.");
+        // Append a newline if one isn't there already.
+        if (message_string.back() != '\n') {
+            message_string.push_back('\n');
         }
 
-        // Append a newline if one isn't there already, and always NUL terminate.
-        int write_length = 0;
-        if (output_string[output_length - 3] != '\n') {
-            output_string[output_length - 2] = '\n';
-            output_string[output_length - 1] = '\0';
-            write_length = output_length - 1;
+        log_line line;
+        line.sequence = record->sequence;
+        line.level_code = record->level_code;
+        line.timestamp = record->timestamp;
+
+        interned_name thread_name;
+        if (get_name_table()->locate(record->thread_name_hash, &thread_name)) {
+            line.thread_name.assign(thread_name.c_str(), thread_name.length());
         }
         else {
-            output_string[output_length - 2] = '\0';
-            write_length = output_length - 2;
+            line.thread_name = "n/a";
+        }
+
+        formatted_string_append(line.text, "[%c][%10u][%-*s] ",
+            line.level_code,
+            line.timestamp,
+            static_cast<int>(line.thread_name.length()),
+            line.thread_name.c_str()
+            );
+        line.prefix_length = static_cast<int>(line.text.length());
+        line.text += message_string;
+
+        m_lines.emplace_back(std::move(line));
+    }
+
+    void logger::write_lines()
+    {
+        // Assume the m_mutex is being held.
+        if (m_lines.empty()) {
+            return;
+        }
+
+        // Rings are drained one thread at a time; restore the global order.
+        std::stable_sort(m_lines.begin(), m_lines.end(), [](log_line const& a, log_line const& b) {
+            return (a.sequence < b.sequence);
+        });
+
+        m_batch.clear();
+        line_vector::const_iterator l(m_lines.begin());
+        while (l != m_lines.end()) {
+            m_batch += l->text;
+            ++l;
         }
 
         // Output
         if (m_log_output_bits & log_output_bit_console) {
-            std::fputs(output_string, stdout);
+            std::fputs(m_batch.c_str(), stdout);
         }
 
 #if defined(_WIN32)
         if ((m_log_output_bits & log_output_bit_debugger) && being_debugged()) {
-            OutputDebugString(output_string);
+            OutputDebugString(m_batch.c_str());
         }
 #endif
 
         if (m_log_output_bits & log_output_bit_file) {
-            m_output_file.write(output_string, write_length);
+            m_output_file.write(m_batch.data(), static_cast<long long>(m_batch.length()));
         }
 
-        log_output.signal(
-            level_code,
-            timestamp,
-            this_thread_name.c_str(),
-            output_string + prefix_length
-            );
+        l = m_lines.begin();
+        while (l != m_lines.end()) {
+            log_output.signal(
+                l->level_code,
+                l->timestamp,
+                l->thread_name.c_str(),
+                l->text.c_str() + l->prefix_length
+                );
+            ++l;
+        }
+
+        m_lines.clear();
     }
 
 #if defined(ELECTROSLAG_COMPILER_MSVC) && defined(ELECTROSLAG_BUILD_DEBUG)
@@ -17,6 +17,9 @@
 #include "electroslag/event.hpp"
 #include "electroslag/file_stream.hpp"
 #include "electroslag/threading/mutex.hpp"
+#include "electroslag/threading/condition_variable.hpp"
+#include "electroslag/threading/thread.hpp"
+#include "electroslag/threading/thread_local_ptr.hpp"
 
 #if defined(ELECTROSLAG_BUILD_SHIP) | defined(RC_INVOKED)
 #define ELECTROSLAG_LOG_ERROR(...)
@@ -60,13 +63,94 @@ namespace electroslag {
         log_output_bit_end // Keep at the end of the enum
     };
 
+    // Log arguments are copied raw into a per-thread ring and formatted later on
+    // the logger thread. Values are stored as-is; strings are copied because the
+    // caller's buffer is usually a temporary.
+    template<class T>
+    struct log_argument {
+        ELECTROSLAG_STATIC_CHECK(std::is_trivially_copyable<T>::value, "Log arguments must be trivially copyable");
+        typedef T value_type;
+
+        static int size(T)
+        {
+            return (static_cast<int>(sizeof(T)));
+        }
+
+        static void store(byte*& cursor, T value)
+        {
+            memcpy(cursor, &value, sizeof(T));
+            cursor += sizeof(T);
+        }
+
+        static value_type load(byte const*& cursor)
+        {
+            T value;
+            memcpy(&value, cursor, sizeof(T));
+            cursor += sizeof(T);
+            return (value);
+        }
+    };
+
+    struct log_string_argument {
+        typedef char const* value_type;
+
+        static int size(void const* value)
+        {
+            return (static_cast<int>(sizeof(int) + (value ? strlen(static_cast<char const*>(value)) + 1 : 0)));
+        }
+
+        static void store(byte*& cursor, void const* value)
+        {
+            int length = (value ? static_cast<int>(strlen(static_cast<char const*>(value)) + 1) : 0);
+            memcpy(cursor, &length, sizeof(int));
+            cursor += sizeof(int);
+            if (length) {
+                memcpy(cursor, value, length);
+                cursor += length;
+            }
+        }
+
+        static value_type load(byte const*& cursor)
+        {
+            int length = 0;
+            memcpy(&length, cursor, sizeof(int));
+            cursor += sizeof(int);
+            if (length) {
+                char const* value = reinterpret_cast<char const*>(cursor);
+                cursor += length;
+                return (value);
+            }
+            else {
+                return ("(null)");
+            }
+        }
+    };
+
+    template<>
+    struct log_argument<char const*> : public log_string_argument {};
+    template<>
+    struct log_argument<char*> : public log_string_argument {};
+    template<>
+    struct log_argument<unsigned char const*> : public log_string_argument {};
+    template<>
+    struct log_argument<unsigned char*> : public log_string_argument {};
+
     class logger {
     public:
         logger();
+        ~logger();
 
+        // Starts and stops the thread that formats and writes log records. Outside
+        // of initialize/shutdown, records are written synchronously by the caller.
         void initialize();
         void shutdown();
 
+        // Blocks until every record enqueued so far has been written.
+        void flush();
+
+        // Called by each exiting thread to write and free its record ring.
+        void on_thread_exit();
+
         virtual int get_log_enable() const;
         virtual void set_log_enable(int enable_bits);
 
@@ -74,58 +158,43 @@ namespace electroslag {
         virtual void set_log_output(int output_bits);
         virtual void set_log_output_file(std::string const& output_file);
 
-        virtual void log_error(char const* format_string, ...)
+        template<class... Args>
+        void log_error(char const* format_string, Args... args)
         {
-            threading::lock_guard logger_lock(&m_mutex);
-            if (m_log_enable_bits & log_enable_bit_error) {
-                va_list arg_list;
-                va_start(arg_list, format_string);
-                log_print('E', format_string, arg_list);
-                va_end(arg_list);
+            if (m_log_enable_bits.load(std::memory_order_relaxed) & log_enable_bit_error) {
+                log_enqueue('E', format_string, args...);
             }
         }
 
-        virtual void log_warning(char const* format_string, ...)
+        template<class... Args>
+        void log_warning(char const* format_string, Args... args)
         {
-            threading::lock_guard logger_lock(&m_mutex);
-            if (m_log_enable_bits & log_enable_bit_warn) {
-                va_list arg_list;
-                va_start(arg_list, format_string);
-                log_print('W', format_string, arg_list);
-                va_end(arg_list);
+            if (m_log_enable_bits.load(std::memory_order_relaxed) & log_enable_bit_warn) {
+                log_enqueue('W', format_string, args...);
             }
         }
 
-        virtual void log_message(char const* format_string, ...)
+        template<class... Args>
+        void log_message(char const* format_string, Args... args)
         {
-            threading::lock_guard logger_lock(&m_mutex);
-            if (m_log_enable_bits & log_enable_bit_message) {
-                va_list arg_list;
-                va_start(arg_list, format_string);
-                log_print('M', format_string, arg_list);
-                va_end(arg_list);
+            if (m_log_enable_bits.load(std::memory_order_relaxed) & log_enable_bit_message) {
+                log_enqueue('M', format_string, args...);
             }
         }
 
-        virtual void log_gfx(char const* format_string, ...)
+        template<class... Args>
+        void log_gfx(char const* format_string, Args... args)
         {
-            threading::lock_guard logger_lock(&m_mutex);
-            if (m_log_enable_bits & log_enable_bit_graphics) {
-                va_list arg_list;
-                va_start(arg_list, format_string);
-                log_print('G', format_string, arg_list);
-                va_end(arg_list);
+            if (m_log_enable_bits.load(std::memory_order_relaxed) & log_enable_bit_graphics) {
+                log_enqueue('G', format_string, args...);
             }
         }
 
-        virtual void log_serialize(char const* format_string, ...)
+        template<class... Args>
+        void log_serialize(char const* format_string, Args... args)
         {
-            threading::lock_guard logger_lock(&m_mutex);
-            if (m_log_enable_bits & log_enable_bit_serialize) {
-                va_list arg_list;
-                va_start(arg_list, format_string);
-                log_print('S', format_string, arg_list);
-                va_end(arg_list);
+            if (m_log_enable_bits.load(std::memory_order_relaxed) & log_enable_bit_serialize) {
+                log_enqueue('S', format_string, args...);
             }
         }
 
@@ -143,14 +212,129 @@ namespace electroslag {
             log_output_bit_console | log_output_bit_debugger;
 #endif
 
-        virtual void log_print(char level_code, char const* format_string, va_list arg_list);
+        // Every record starts with this header; the packed arguments follow it.
+        // A record with no format function is padding at the end of the ring.
+        typedef int (*format_function)(char const* format_string, byte const* arguments, char* output, int output_length);
+
+        struct log_record {
+            format_function format;
+            char const* format_string;
+            unsigned long long sequence;
+            unsigned long long thread_name_hash;
+            unsigned int timestamp;
+            int record_bytes;
+            char level_code;
+        };
+
+        static unsigned int const log_record_alignment = 64;
+        ELECTROSLAG_STATIC_CHECK(sizeof(log_record) <= log_record_alignment, "Log record header must fit in a padding record");
+
+        // Unpack arguments in order and hand them to snprintf.
+        template<class... Remaining>
+        struct log_unpack;
+
+        template<class... Args>
+        struct log_formatter {
+            static int format(char const* format_string, byte const* arguments, char* output, int output_length)
+            {
+                return (log_unpack<Args...>::format(format_string, arguments, output, output_length));
+            }
+        };
+
+        static int log_argument_bytes()
+        {
+            return (0);
+        }
+
+        template<class First, class... Rest>
+        static int log_argument_bytes(First first, Rest... rest)
+        {
+            return (log_argument<First>::size(first) + log_argument_bytes(rest...));
+        }
+
+        static void log_store_arguments(byte*&)
+        {}
+
+        template<class First, class... Rest>
+        static void log_store_arguments(byte*& cursor, First first, Rest... rest)
+        {
+            log_argument<First>::store(cursor, first);
+            log_store_arguments(cursor, rest...);
+        }
+
+        template<class... Args>
+        void log_enqueue(char level_code, char const* format_string, Args... args)
+        {
+            int record_bytes = static_cast<int>(align_up(
+                static_cast<unsigned int>(sizeof(log_record) + log_argument_bytes(args...)),
+                log_record_alignment
+                ));
+
+            log_record* record = begin_record(record_bytes);
+            record->format = &log_formatter<Args...>::format;
+            record->format_string = format_string;
+            record->level_code = level_code;
+
+            byte* cursor = reinterpret_cast<byte*>(record + 1);
+            log_store_arguments(cursor, args...);
+
+            end_record(record);
+        }
+
+        // Single producer, single consumer byte ring; one per logging thread.
+        class log_ring;
+
+        log_ring* get_this_thread_ring();
+        log_record* begin_record(int record_bytes);
+        void end_record(log_record* record);
+        void wake_logger_thread();
+
+        // Consumer side; m_mutex must be held.
+        void drain_rings();
+        void format_record(log_record const* record);
+        void write_lines();
+
+        static void thread_stub(void* argument)
+        {
+            reinterpret_cast<logger*>(argument)->thread_method();
+        }
+
+        void thread_method();
 
         mutable threading::mutex m_mutex;
+        threading::mutex m_wake_mutex;
+        threading::condition_variable m_wake;
+        threading::thread m_thread;
         file_stream m_output_file;
 
-        int m_log_enable_bits;
+        std::atomic<int> m_log_enable_bits;
         int m_log_output_bits;
 
+        // Producer side state.
+        threading::thread_local_ptr<log_ring> m_this_thread_ring;
+        std::atomic<unsigned long long> m_next_sequence;
+        std::atomic<bool> m_records_pending;
+        std::atomic<bool> m_async;
+
+        // Consumer side state, protected by m_mutex.
+        typedef std::vector<log_ring*> ring_vector;
+        ring_vector m_rings;
+
+        struct log_line {
+            unsigned long long sequence;
+            char level_code;
+            unsigned int timestamp;
+            std::string thread_name;
+            std::string text;
+            int prefix_length;
+        };
+        typedef std::vector<log_line> line_vector;
+        line_vector m_lines;
+        std::string m_batch;
+
+        // Protected by m_wake_mutex.
+        bool m_exit_thread;
+
 #if defined(ELECTROSLAG_COMPILER_MSVC) && defined(ELECTROSLAG_BUILD_DEBUG)
         bool m_report_hook_set;
 
@@ -163,10 +347,30 @@ namespace electroslag {
 
     public:
         // Ensure the event is constructed after the mutex by declaring it below in the class.
+        // Signaled from the logger thread; listeners must not log.
         typedef event<void, char, unsigned int, char const*, char const*> log_output_event;
         typedef log_output_event::bound_delegate log_output_delegate;
         mutable log_output_event log_output;
     };
 
+    template<>
+    struct logger::log_unpack<> {
+        template<class... Loaded>
+        static int format(char const* format_string, byte const*, char* output, int output_length, Loaded... loaded)
+        {
+            return (std::snprintf(output, output_length, format_string, loaded...));
+        }
+    };
+
+    template<class First, class... Rest>
+    struct logger::log_unpack<First, Rest...> {
+        template<class... Loaded>
+        static int format(char const* format_string, byte const* cursor, char* output, int output_length, Loaded... loaded)
+        {
+            typename log_argument<First>::value_type value(log_argument<First>::load(cursor));
+            return (log_unpack<Rest...>::format(format_string, cursor, output, output_length, loaded..., value));
+        }
+    };
+
     logger* get_logger();
 }
@@ -0,0 +1,86 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/mapped_file.hpp"
+
+namespace electroslag {
+    // static
+    referenced_buffer_interface::ref mapped_file::create(std::string const& path, mapped_file_mode mode)
+    {
+        DWORD page_protection = 0;
+        DWORD view_access = 0;
+        switch (mode) {
+        case mapped_file_mode_read:
+            page_protection = PAGE_READONLY;
+            view_access = FILE_MAP_READ;
+            break;
+
+        case mapped_file_mode_copy_on_write:
+            page_protection = PAGE_WRITECOPY;
+            view_access = FILE_MAP_COPY;
+            break;
+
+        default:
+            throw parameter_failure("mode");
+        }
+
+        HANDLE file = CreateFileA(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            0,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            0
+            );
+        if (file == INVALID_HANDLE_VALUE) {
+            throw win32_api_failure("CreateFile");
+        }
+
+        // Buffers are sized with an int, and an empty file cannot be mapped.
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size)) {
+            CloseHandle(file);
+            throw win32_api_failure("GetFileSizeEx");
+        }
+        if (file_size.QuadPart <= 0 || file_size.QuadPart > std::numeric_limits<int>::max()) {
+            CloseHandle(file);
+            throw load_object_failure("mapped file size");
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, 0, page_protection, 0, 0, 0);
+        if (!mapping) {
+            CloseHandle(file);
+            throw win32_api_failure("CreateFileMapping");
+        }
+
+        void* view = MapViewOfFile(mapping, view_access, 0, 0, 0);
+        if (!view) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw win32_api_failure("MapViewOfFile");
+        }
+
+        return (ref(new mapped_file(file, mapping, view, static_cast<int>(file_size.QuadPart))));
+    }
+
+    mapped_file::~mapped_file()
+    {
+        UnmapViewOfFile(m_view);
+        CloseHandle(m_mapping);
+        CloseHandle(m_file);
+    }
+}
@@ -0,0 +1,72 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/referenced_buffer.hpp"
+
+namespace electroslag {
+    enum mapped_file_mode {
+        mapped_file_mode_invalid = -1,
+        mapped_file_mode_read, // Pages are shared and read only.
+        mapped_file_mode_copy_on_write // Written pages become private copies; the file is never changed.
+    };
+
+    // A whole file mapped in to the address space. The view never moves, so unlike
+    // referenced_buffer, lock() does not exclude other users; derived_referenced_buffer
+    // slices of the same mapping can be accessed at the same time.
+    class mapped_file : public referenced_buffer_interface {
+    public:
+        static ref create(std::string const& path, mapped_file_mode mode = mapped_file_mode_read);
+
+        // Implement referenced_buffer_interface
+        virtual void* lock()
+        {
+            return (m_view);
+        }
+
+        virtual void unlock()
+        {}
+
+        virtual int get_sizeof() const
+        {
+            return (m_sizeof);
+        }
+
+    protected:
+#if defined(_WIN32)
+        mapped_file(HANDLE file, HANDLE mapping, void* view, int view_sizeof)
+            : m_file(file)
+            , m_mapping(mapping)
+            , m_view(view)
+            , m_sizeof(view_sizeof)
+        {}
+#endif
+
+        virtual ~mapped_file();
+
+    private:
+#if defined(_WIN32)
+        HANDLE m_file;
+        HANDLE m_mapping;
+#endif
+        void* m_view;
+        int m_sizeof;
+
+        // Disallowed operations:
+        mapped_file();
+        explicit mapped_file(mapped_file const&);
+        mapped_file& operator =(mapped_file const&);
+    };
+}
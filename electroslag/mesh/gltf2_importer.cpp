@@ -16,7 +16,7 @@
 #include "electroslag/precomp.hpp"
 #include "electroslag/mesh/gltf2_importer.hpp"
 #include "electroslag/threading/thread_pool.hpp"
-#include "electroslag/file_stream.hpp"
+#include "electroslag/mapped_file.hpp"
 #include "electroslag/graphics/buffer_descriptor.hpp"
 #include "electroslag/serialize/base64.hpp"
 
@@ -108,28 +108,42 @@ namespace electroslag {
 
         gltf2_importer::import_future::value_type gltf2_importer::async_mesh_loader::execute_for_value()
         {
-            file_stream gltf2_stream;
-            gltf2_stream.open(m_file_name, file_stream_access_mode_read);
-
-            long long stream_size = gltf2_stream.get_size();
-            if (stream_size <= 0) {
-                throw load_object_failure("gltf2 0 byte stream");
+            // Copy on write lets the JSON be parsed in place without touching the file.
+            referenced_buffer_interface::ref file_data(mapped_file::create(m_file_name, mapped_file_mode_copy_on_write));
+            referenced_buffer_interface::accessor file_accessor(file_data);
+            byte* file_bytes = static_cast<byte*>(file_accessor.get_pointer());
+            int file_sizeof = file_accessor.get_sizeof();
+
+            // GLB containers are parsed where they lie; text gltf2 needs a terminated copy.
+            std::unique_ptr<char[]> json_copy;
+            char* json = 0;
+            bool is_glb = false;
+            if (file_sizeof >= static_cast<int>(sizeof(glb_header))) {
+                glb_header header;
+                memcpy(&header, file_bytes, sizeof(header));
+                is_glb = (header.magic == glb_magic);
             }
 
-            // Read the gltf2 json into a buffer and set up to parse it.
-            std::unique_ptr<char[]> stream_buffer(new char[stream_size + 1]);
-
-            gltf2_stream.read(stream_buffer.get(), stream_size);
-            stream_buffer[stream_size] = '\0';
+            if (is_glb) {
+                json = parse_glb_container(file_data, file_bytes, file_sizeof, &json_copy);
+            }
+            else {
+                json_copy.reset(new char[file_sizeof + 1]);
+                memcpy(json_copy.get(), file_bytes, file_sizeof);
+                json_copy[file_sizeof] = '\0';
+                json = json_copy.get();
+            }
 
+            // The document's strings point in to the mapping or the copy, both of which outlive it.
             rapidjson::Document doc;
-            doc.ParseInsitu<rapidjson::kParseInsituFlag | rapidjson::kParseCommentsFlag>(stream_buffer.get());
+            doc.ParseInsitu<rapidjson::kParseInsituFlag | rapidjson::kParseCommentsFlag>(json);
 
             // TODO: Deal with parse errors better
             ELECTROSLAG_CHECK(!doc.HasParseError());
             ELECTROSLAG_CHECK(doc.IsObject());
 
-            // Parse all of the gltf2 objects.
+            // Parse all of the gltf2 objects. Buffers are mapped rather than read, and
+            // texture importers start on the IO pool as soon as their texture is parsed.
             parse_asset(doc);
             parse_extensions(doc);
             parse_buffers(doc);
@@ -141,11 +155,22 @@ namespace electroslag {
             parse_materials(doc);
             parse_meshes(doc);
             parse_nodes(doc);
+            parse_skins(doc);
             parse_scenes(doc);
+            parse_animations(doc);
+
+            // Convert accessor data in parallel.
+            decode_accessors();
 
             // Create electroslag objects from the parsed gltf2.
             renderer::instance_descriptor::ref scene_desc(create_descriptors());
 
+            // Release the file mappings; descriptors keep any slices they still need.
+            m_decoded_accessors.clear();
+            m_buffer_views.clear();
+            m_buffers.clear();
+            m_glb_binary.reset();
+
             // Resolve circular object dependencies.
             m_this_importer.reset();
             m_load_record.reset();
@@ -180,6 +205,72 @@ namespace electroslag {
             return (base64_start);
         }
 
+        char* gltf2_importer::async_mesh_loader::parse_glb_container(
+            referenced_buffer_interface::ref const& file_data,
+            byte* file_bytes,
+            int file_sizeof,
+            std::unique_ptr<char[]>* out_json_copy
+            )
+        {
+            glb_header header;
+            memcpy(&header, file_bytes, sizeof(header));
+            if (header.version != 2) {
+                throw load_object_failure("gltf2 glb version is not supported");
+            }
+            if (header.length > static_cast<uint32_t>(file_sizeof)) {
+                throw load_object_failure("gltf2 glb is truncated");
+            }
+            int container_sizeof = static_cast<int>(header.length);
+
+            // The JSON chunk is always first.
+            int offset = sizeof(glb_header);
+            glb_chunk_header json_chunk;
+            if (offset + static_cast<int>(sizeof(json_chunk)) > container_sizeof) {
+                throw load_object_failure("gltf2 glb missing JSON chunk");
+            }
+            memcpy(&json_chunk, file_bytes + offset, sizeof(json_chunk));
+            offset += sizeof(json_chunk);
+
+            if (json_chunk.type != glb_chunk_type_json || json_chunk.length > static_cast<uint32_t>(container_sizeof - offset)) {
+                throw load_object_failure("gltf2 glb invalid JSON chunk");
+            }
+            char* json = reinterpret_cast<char*>(file_bytes + offset);
+            offset += json_chunk.length;
+            int json_end = offset;
+
+            // An optional BIN chunk follows; it backs the buffer without a uri.
+            glb_chunk_header bin_chunk;
+            if (offset + static_cast<int>(sizeof(bin_chunk)) <= container_sizeof) {
+                memcpy(&bin_chunk, file_bytes + offset, sizeof(bin_chunk));
+                offset += sizeof(bin_chunk);
+
+                if (bin_chunk.type == glb_chunk_type_bin && bin_chunk.length > 0) {
+                    if (bin_chunk.length > static_cast<uint32_t>(container_sizeof - offset)) {
+                        throw load_object_failure("gltf2 glb invalid BIN chunk");
+                    }
+                    m_glb_binary = derived_referenced_buffer::create(file_data, offset, bin_chunk.length);
+                }
+            }
+
+            // In place parsing needs a terminator. The byte after the JSON is either the
+            // already read BIN chunk header or a padding space; the mapping is copy on
+            // write, so only that page becomes private. Otherwise fall back on a copy.
+            if (json_end < file_sizeof) {
+                file_bytes[json_end] = '\0';
+            }
+            else if (json_chunk.length > 0 && json[json_chunk.length - 1] == ' ') {
+                json[json_chunk.length - 1] = '\0';
+            }
+            else {
+                out_json_copy->reset(new char[json_chunk.length + 1]);
+                memcpy(out_json_copy->get(), json, json_chunk.length);
+                (*out_json_copy)[json_chunk.length] = '\0';
+                json = out_json_copy->get();
+            }
+
+            return (json);
+        }
+
         void gltf2_importer::async_mesh_loader::parse_asset(rapidjson::Document const& doc)
         {
             rapidjson::Value::ConstMemberIterator asset(doc.FindMember("asset"));
@@ -223,8 +314,38 @@ namespace electroslag {
             }
         }
 
-        void gltf2_importer::async_mesh_loader::parse_extensions(rapidjson::Document const& /*doc*/)
-        {}
+        void gltf2_importer::async_mesh_loader::parse_extensions(rapidjson::Document const& doc)
+        {
+            static char const* const mesh_quantization_name = "KHR_mesh_quantization";
+
+            rapidjson::Value::ConstMemberIterator used_member(doc.FindMember("extensionsUsed"));
+            if (used_member != doc.MemberEnd()) {
+                ELECTROSLAG_CHECK(used_member->value.IsArray());
+
+                for (rapidjson::Value::ConstValueIterator e(used_member->value.Begin());
+                     e != used_member->value.End();
+                     ++e) {
+                    if (std::strcmp(e->GetString(), mesh_quantization_name) == 0) {
+                        m_mesh_quantization = true;
+                    }
+                }
+            }
+
+            // Files that require an extension cannot be loaded correctly without it.
+            rapidjson::Value::ConstMemberIterator required_member(doc.FindMember("extensionsRequired"));
+            if (required_member != doc.MemberEnd()) {
+                ELECTROSLAG_CHECK(required_member->value.IsArray());
+
+                for (rapidjson::Value::ConstValueIterator e(required_member->value.Begin());
+                     e != required_member->value.End();
+                     ++e) {
+                    if (std::strcmp(e->GetString(), mesh_quantization_name) != 0) {
+                        throw load_object_failure("gltf2 requires an unsupported extension");
+                    }
+                    m_mesh_quantization = true;
+                }
+            }
+        }
 
         void gltf2_importer::async_mesh_loader::parse_buffers(rapidjson::Document const& doc)
         {
@@ -246,53 +367,53 @@ namespace electroslag {
                     throw load_object_failure("gltf2 buffer missing byteLength");
                 }
 
-                int bytes = bytes_member->value.GetInt();;
-
-                // Get the data.
-                this_buffer.data = referenced_buffer_from_sizeof::create(bytes);
-                {
-                    referenced_buffer_interface::accessor buffer_acessor(this_buffer.data);
+                int bytes = bytes_member->value.GetInt();
+                if (bytes <= 0) {
+                    throw load_object_failure("gltf2 buffer byteLength is not valid");
+                }
 
-                    rapidjson::Value::ConstMemberIterator uri_member(b->FindMember("uri"));
-                    if (uri_member != b->MemberEnd()) {
-                        char const* uri = uri_member->value.GetString();
-                        int uri_length = uri_member->value.GetStringLength();
+                // Get the data. Files and the GLB binary chunk are used where they are mapped.
+                rapidjson::Value::ConstMemberIterator uri_member(b->FindMember("uri"));
+                if (uri_member != b->MemberEnd()) {
+                    char const* uri = uri_member->value.GetString();
+                    int uri_length = uri_member->value.GetStringLength();
 
-                        // Figure out if the uri is a supported data-uri.
-                        int base64_start = locate_base64_start(uri_length, uri);
+                    // Figure out if the uri is a supported data-uri.
+                    int base64_start = locate_base64_start(uri_length, uri);
 
-                        // Decode the data-uri or load the file.
-                        if (base64_start != -1) {
-                            serialize::base64::decode(
-                                uri + base64_start,
-                                uri_length - base64_start,
-                                buffer_acessor.get_pointer(),
-                                buffer_acessor.get_sizeof()
-                                );
-                        }
-                        else {
-                            // All file URIs are relative to the gltf2 file path.
-                            std::filesystem::path buffer_path(m_file_name);
-                            buffer_path = buffer_path.remove_filename();
-                            buffer_path /= uri;
-                            buffer_path = std::filesystem::canonical(buffer_path);
-
-                            file_stream buffer_stream;
-                            buffer_stream.open(buffer_path.string(), file_stream_access_mode_read);
-
-                            long long stream_size = buffer_stream.get_size();
-                            if (stream_size > 0) {
-                                buffer_stream.read(buffer_acessor.get_pointer(), buffer_acessor.get_sizeof());
-                            }
-                            else {
-                                throw load_object_failure("gltf2 bin file is 0 bytes");
-                            }
-                        }
+                    // Decode the data-uri or map the file.
+                    if (base64_start != -1) {
+                        this_buffer.data = referenced_buffer_from_sizeof::create(bytes);
+                        referenced_buffer_interface::accessor buffer_acessor(this_buffer.data);
+
+                        serialize::base64::decode(
+                            uri + base64_start,
+                            uri_length - base64_start,
+                            buffer_acessor.get_pointer(),
+                            buffer_acessor.get_sizeof()
+                            );
                     }
                     else {
-                        // TODO: support GDB
+                        // All file URIs are relative to the gltf2 file path.
+                        std::filesystem::path buffer_path(m_file_name);
+                        buffer_path = buffer_path.remove_filename();
+                        buffer_path /= uri;
+                        buffer_path = std::filesystem::canonical(buffer_path);
+
+                        this_buffer.data = mapped_file::create(buffer_path.string());
                     }
                 }
+                else if (m_glb_binary.is_valid()) {
+                    this_buffer.data = m_glb_binary;
+                }
+                else {
+                    throw load_object_failure("gltf2 buffer has no uri and no GLB binary chunk");
+                }
+
+                // Files and GLB chunks may be padded past byteLength.
+                if (this_buffer.data->get_sizeof() < bytes) {
+                    throw load_object_failure("gltf2 buffer is smaller than byteLength");
+                }
 
                 m_buffers.push_back(this_buffer);
             }
@@ -349,6 +470,12 @@ namespace electroslag {
                     this_view.target = static_cast<buffer_view_target>(target_member->value.GetInt());
                 }
 
+                // Accessors are read straight out of the pinned buffer, so the view must lie within it.
+                if (this_view.byte_offset < 0 || this_view.byte_length < 0 ||
+                    this_view.byte_offset + this_view.byte_length > m_buffers[this_view.buffer].data->get_sizeof()) {
+                    throw load_object_failure("gltf2 buffer view exceeds buffer");
+                }
+
                 m_buffer_views.emplace_back(this_view);
             }
         }
@@ -366,7 +493,8 @@ namespace electroslag {
                  ++a) {
                 accessor this_accessor;
 
-                // Buffer view is referenced by array index.
+                // Buffer view is referenced by array index. Without one the accessor is all
+                // zeros, usually with sparse elements.
                 rapidjson::Value::ConstMemberIterator buffer_view_member(a->FindMember("bufferView"));
                 if (buffer_view_member != a->MemberEnd()) {
                     this_accessor.buffer_view = buffer_view_member->value.GetInt();
@@ -374,9 +502,6 @@ namespace electroslag {
                         throw load_object_failure("gltf2 accessor invalid buffer_view");
                     }
                 }
-                else {
-                    throw load_object_failure("gltf2 accessor buffer view is not found");
-                }
 
                 // Offset in the buffer view in bytes
                 rapidjson::Value::ConstMemberIterator byte_offset_member(a->FindMember("byteOffset"));
@@ -474,6 +599,61 @@ namespace electroslag {
                     }
                 }
 
+                // Sparse elements come from their own index and value buffer views.
+                rapidjson::Value::ConstMemberIterator sparse_member(a->FindMember("sparse"));
+                if (sparse_member != a->MemberEnd()) {
+                    rapidjson::Value::ConstMemberIterator sparse_count_member(sparse_member->value.FindMember("count"));
+                    rapidjson::Value::ConstMemberIterator indices_member(sparse_member->value.FindMember("indices"));
+                    rapidjson::Value::ConstMemberIterator values_member(sparse_member->value.FindMember("values"));
+                    if (sparse_count_member == sparse_member->value.MemberEnd() ||
+                        indices_member == sparse_member->value.MemberEnd() ||
+                        values_member == sparse_member->value.MemberEnd()) {
+                        throw load_object_failure("gltf2 accessor sparse is incomplete");
+                    }
+
+                    this_accessor.sparse_count = sparse_count_member->value.GetInt();
+                    if (this_accessor.sparse_count <= 0 || this_accessor.sparse_count > this_accessor.count) {
+                        throw load_object_failure("gltf2 accessor sparse count is not valid");
+                    }
+
+                    rapidjson::Value::ConstMemberIterator indices_view_member(indices_member->value.FindMember("bufferView"));
+                    rapidjson::Value::ConstMemberIterator indices_type_member(indices_member->value.FindMember("componentType"));
+                    if (indices_view_member == indices_member->value.MemberEnd() ||
+                        indices_type_member == indices_member->value.MemberEnd()) {
+                        throw load_object_failure("gltf2 accessor sparse indices are incomplete");
+                    }
+
+                    this_accessor.sparse_indices_buffer_view = indices_view_member->value.GetInt();
+                    this_accessor.sparse_indices_component_type = static_cast<accessor_component_type>(indices_type_member->value.GetInt());
+                    if ((this_accessor.sparse_indices_component_type != accessor_component_type_unsigned_byte) &&
+                        (this_accessor.sparse_indices_component_type != accessor_component_type_unsigned_short) &&
+                        (this_accessor.sparse_indices_component_type != accessor_component_type_unsigned_int)) {
+                        throw load_object_failure("gltf2 accessor sparse indices component_type is not valid");
+                    }
+
+                    rapidjson::Value::ConstMemberIterator indices_offset_member(indices_member->value.FindMember("byteOffset"));
+                    if (indices_offset_member != indices_member->value.MemberEnd()) {
+                        this_accessor.sparse_indices_byte_offset = indices_offset_member->value.GetInt();
+                    }
+
+                    rapidjson::Value::ConstMemberIterator values_view_member(values_member->value.FindMember("bufferView"));
+                    if (values_view_member == values_member->value.MemberEnd()) {
+                        throw load_object_failure("gltf2 accessor sparse values are incomplete");
+                    }
+
+                    this_accessor.sparse_values_buffer_view = values_view_member->value.GetInt();
+
+                    rapidjson::Value::ConstMemberIterator values_offset_member(values_member->value.FindMember("byteOffset"));
+                    if (values_offset_member != values_member->value.MemberEnd()) {
+                        this_accessor.sparse_values_byte_offset = values_offset_member->value.GetInt();
+                    }
+
+                    if (this_accessor.sparse_indices_buffer_view < 0 || this_accessor.sparse_indices_buffer_view >= m_buffer_views.size() ||
+                        this_accessor.sparse_values_buffer_view < 0 || this_accessor.sparse_values_buffer_view >= m_buffer_views.size()) {
+                        throw load_object_failure("gltf2 accessor sparse invalid buffer_view");
+                    }
+                }
+
                 m_accessors.emplace_back(this_accessor);
             }
         }
@@ -716,6 +896,7 @@ namespace electroslag {
 
                         accessor& a = m_accessors.at(this_primitive.index_accessor);
                         if ((a.type != accessor_type_scalar) ||
+                            (a.buffer_view < 0) || (a.sparse_count > 0) ||
                             ((a.component_type != accessor_component_type_unsigned_byte) &&
                              (a.component_type != accessor_component_type_unsigned_short) &&
                              (a.component_type != accessor_component_type_unsigned_int))) {
@@ -763,7 +944,7 @@ namespace electroslag {
 
                         accessor& a = m_accessors.at(this_primitive.position_attrib_accessor);
                         if ((a.type != accessor_type_vec3) ||
-                            (a.component_type != accessor_component_type_float)) {
+                            ((a.component_type != accessor_component_type_float) && !is_quantized_component(a, false))) {
                             throw load_object_failure("gltf2 invalid position accessor");
                         }
                     }
@@ -779,7 +960,7 @@ namespace electroslag {
 
                         accessor& a = m_accessors.at(this_primitive.normal_attrib_accessor);
                         if ((a.type != accessor_type_vec3) ||
-                            (a.component_type != accessor_component_type_float)) {
+                            ((a.component_type != accessor_component_type_float) && !is_quantized_component(a, true))) {
                             throw load_object_failure("gltf2 invalid normal accessor");
                         }
                     }
@@ -795,7 +976,7 @@ namespace electroslag {
 
                         accessor& a = m_accessors.at(this_primitive.tangent_attrib_accessor);
                         if ((a.type != accessor_type_vec4) ||
-                            (a.component_type != accessor_component_type_float)) {
+                            ((a.component_type != accessor_component_type_float) && !is_quantized_component(a, true))) {
                             throw load_object_failure("gltf2 invalid tangent accessor");
                         }
                     }
@@ -813,7 +994,8 @@ namespace electroslag {
                         if ((a.type != accessor_type_vec2) ||
                             ((a.component_type != accessor_component_type_float) &&
                              (a.component_type != accessor_component_type_unsigned_byte) &&
-                             (a.component_type != accessor_component_type_unsigned_short))) {
+                             (a.component_type != accessor_component_type_unsigned_short) &&
+                             !is_quantized_component(a, false))) {
                             throw load_object_failure("gltf2 invalid texcoord_0 accessor");
                         }
                     }
@@ -831,7 +1013,8 @@ namespace electroslag {
                         if ((a.type != accessor_type_vec2) ||
                             ((a.component_type != accessor_component_type_float) &&
                              (a.component_type != accessor_component_type_unsigned_byte) &&
-                             (a.component_type != accessor_component_type_unsigned_short))) {
+                             (a.component_type != accessor_component_type_unsigned_short) &&
+                             !is_quantized_component(a, false))) {
                             throw load_object_failure("gltf2 invalid texcoord_1 accessor");
                         }
                     }
@@ -855,9 +1038,118 @@ namespace electroslag {
                         }
                     }
 
+                    // Up to four skin joints per vertex, with their weights.
+                    rapidjson::Value::ConstMemberIterator joints_0_member(attributes_member->value.FindMember("JOINTS_0"));
+                    if (joints_0_member != attributes_member->value.MemberEnd()) {
+                        this_primitive.joints_0_attrib_accessor = joints_0_member->value.GetInt();
+
+                        if (this_primitive.joints_0_attrib_accessor < 0 || this_primitive.joints_0_attrib_accessor >= m_accessors.size()) {
+                            throw load_object_failure("gltf2 invalid accessor index");
+                        }
+
+                        accessor& a = m_accessors.at(this_primitive.joints_0_attrib_accessor);
+                        if ((a.type != accessor_type_vec4) ||
+                            ((a.component_type != accessor_component_type_unsigned_byte) &&
+                             (a.component_type != accessor_component_type_unsigned_short)) ||
+                            a.normalized) {
+                            throw load_object_failure("gltf2 invalid joints_0 accessor");
+                        }
+                    }
+
+                    rapidjson::Value::ConstMemberIterator weights_0_member(attributes_member->value.FindMember("WEIGHTS_0"));
+                    if (weights_0_member != attributes_member->value.MemberEnd()) {
+                        this_primitive.weights_0_attrib_accessor = weights_0_member->value.GetInt();
+
+                        if (this_primitive.weights_0_attrib_accessor < 0 || this_primitive.weights_0_attrib_accessor >= m_accessors.size()) {
+                            throw load_object_failure("gltf2 invalid accessor index");
+                        }
+
+                        accessor& a = m_accessors.at(this_primitive.weights_0_attrib_accessor);
+                        if ((a.type != accessor_type_vec4) ||
+                            ((a.component_type != accessor_component_type_float) &&
+                             (a.component_type != accessor_component_type_unsigned_byte || !a.normalized) &&
+                             (a.component_type != accessor_component_type_unsigned_short || !a.normalized))) {
+                            throw load_object_failure("gltf2 invalid weights_0 accessor");
+                        }
+                    }
+
+                    if ((this_primitive.joints_0_attrib_accessor < 0) != (this_primitive.weights_0_attrib_accessor < 0)) {
+                        throw load_object_failure("gltf2 joints_0 and weights_0 must be used together");
+                    }
+
+                    // Morph targets hold position and normal deltas; tangent deltas are ignored.
+                    rapidjson::Value::ConstMemberIterator targets_member(p->FindMember("targets"));
+                    if (targets_member != p->MemberEnd()) {
+                        ELECTROSLAG_CHECK(targets_member->value.IsArray());
+
+                        for (rapidjson::Value::ConstValueIterator t(targets_member->value.Begin());
+                             t != targets_member->value.End();
+                             ++t) {
+
+                            morph_target this_target;
+
+                            rapidjson::Value::ConstMemberIterator target_position_member(t->FindMember("POSITION"));
+                            if (target_position_member != t->MemberEnd()) {
+                                this_target.position_attrib_accessor = target_position_member->value.GetInt();
+                            }
+
+                            rapidjson::Value::ConstMemberIterator target_normal_member(t->FindMember("NORMAL"));
+                            if (target_normal_member != t->MemberEnd()) {
+                                this_target.normal_attrib_accessor = target_normal_member->value.GetInt();
+                            }
+
+                            int target_accessors[] = {
+                                this_target.position_attrib_accessor,
+                                this_target.normal_attrib_accessor
+                            };
+                            for (int i = 0; i < _countof(target_accessors); ++i) {
+                                if (target_accessors[i] < 0) {
+                                    continue;
+                                }
+
+                                if (target_accessors[i] >= m_accessors.size()) {
+                                    throw load_object_failure("gltf2 invalid accessor index");
+                                }
+
+                                accessor& a = m_accessors.at(target_accessors[i]);
+                                if (a.type != accessor_type_vec3) {
+                                    throw load_object_failure("gltf2 invalid morph target accessor");
+                                }
+                            }
+
+                            this_primitive.targets.emplace_back(this_target);
+                        }
+                    }
+
+                    // Every primitive in a mesh has the same number of morph targets.
+                    if (!this_mesh.primitives.empty() &&
+                        this_mesh.primitives.front().targets.size() != this_primitive.targets.size()) {
+                        throw load_object_failure("gltf2 primitives have different morph target counts");
+                    }
+
                     this_mesh.primitives.emplace_back(this_primitive);
                 }
 
+                // Default morph target weights.
+                rapidjson::Value::ConstMemberIterator weights_member(m->FindMember("weights"));
+                if (weights_member != m->MemberEnd()) {
+                    ELECTROSLAG_CHECK(weights_member->value.IsArray());
+
+                    for (rapidjson::Value::ConstValueIterator w(weights_member->value.Begin());
+                         w != weights_member->value.End();
+                         ++w) {
+                        this_mesh.weights.emplace_back(w->GetFloat());
+                    }
+                }
+
+                int target_count = this_mesh.primitives.empty() ? 0 : static_cast<int>(this_mesh.primitives.front().targets.size());
+                if (this_mesh.weights.empty()) {
+                    this_mesh.weights.resize(target_count, 0.0f);
+                }
+                else if (this_mesh.weights.size() != target_count) {
+                    throw load_object_failure("gltf2 mesh weights do not match morph targets");
+                }
+
                 m_meshes.emplace_back(this_mesh);
             }
         }
@@ -1033,6 +1325,12 @@ namespace electroslag {
                     }
                 }
 
+                // Skinned nodes name a skin; skins are checked once they are parsed.
+                rapidjson::Value::ConstMemberIterator skin_member(n->FindMember("skin"));
+                if (skin_member != n->MemberEnd()) {
+                    this_node.skin = skin_member->value.GetInt();
+                }
+
                 // Node transform is either by matrix or scale-rotate-translate.
                 rapidjson::Value::ConstMemberIterator matrix_member(n->FindMember("matrix"));
                 if (matrix_member != n->MemberEnd()) {
@@ -1069,7 +1367,7 @@ namespace electroslag {
                             }
                         }
                         else {
-                            this_node.rotate = glm::f32quat(0.0f, 0.0f, 0.0f, 1.0f);
+                            this_node.rotate = glm::f32quat(1.0f, 0.0f, 0.0f, 0.0f);
                         }
 
                         if (translation_member != n->MemberEnd()) {
@@ -1083,8 +1381,105 @@ namespace electroslag {
                     }
                 }
 
+                // Child node indexes form the transform hierarchy.
+                rapidjson::Value::ConstMemberIterator children_member(n->FindMember("children"));
+                if (children_member != n->MemberEnd()) {
+                    ELECTROSLAG_CHECK(children_member->value.IsArray());
+
+                    for (rapidjson::Value::ConstValueIterator c(children_member->value.Begin());
+                         c != children_member->value.End();
+                         ++c) {
+                        this_node.children.emplace_back(c->GetInt());
+                    }
+                }
+
                 m_nodes.emplace_back(this_node);
             }
+
+            // Children can only be validated once every node is known.
+            std::vector<node>::const_iterator n(m_nodes.begin());
+            while (n != m_nodes.end()) {
+                std::vector<int>::const_iterator c(n->children.begin());
+                while (c != n->children.end()) {
+                    if (*c < 0 || *c >= m_nodes.size()) {
+                        throw load_object_failure("gltf2 invalid child node index");
+                    }
+                    ++c;
+                }
+                ++n;
+            }
+        }
+
+        void gltf2_importer::async_mesh_loader::parse_skins(rapidjson::Document const& doc)
+        {
+            rapidjson::Value::ConstMemberIterator skins(doc.FindMember("skins"));
+            if (skins != doc.MemberEnd()) {
+                ELECTROSLAG_CHECK(skins->value.IsArray());
+
+                for (rapidjson::Value::ConstValueIterator s(skins->value.Begin());
+                     s != skins->value.End();
+                     ++s) {
+
+                    skin this_skin;
+
+                    // Joints are node indexes.
+                    rapidjson::Value::ConstMemberIterator joints_member(s->FindMember("joints"));
+                    if (joints_member == s->MemberEnd() || !joints_member->value.IsArray()) {
+                        throw load_object_failure("gltf2 skin joints member not present");
+                    }
+
+                    for (rapidjson::Value::ConstValueIterator j(joints_member->value.Begin());
+                         j != joints_member->value.End();
+                         ++j) {
+                        int joint = j->GetInt();
+                        if (joint < 0 || joint >= m_nodes.size()) {
+                            throw load_object_failure("gltf2 invalid skin joint node index");
+                        }
+                        this_skin.joints.emplace_back(joint);
+                    }
+
+                    if (this_skin.joints.empty()) {
+                        throw load_object_failure("gltf2 skin has no joints");
+                    }
+
+                    // Inverse bind matrices default to identity when not given.
+                    rapidjson::Value::ConstMemberIterator inverse_bind_member(s->FindMember("inverseBindMatrices"));
+                    if (inverse_bind_member != s->MemberEnd()) {
+                        this_skin.inverse_bind_accessor = inverse_bind_member->value.GetInt();
+
+                        if (this_skin.inverse_bind_accessor < 0 || this_skin.inverse_bind_accessor >= m_accessors.size()) {
+                            throw load_object_failure("gltf2 invalid accessor index");
+                        }
+
+                        accessor& a = m_accessors.at(this_skin.inverse_bind_accessor);
+                        if ((a.type != accessor_type_mat4) ||
+                            (a.component_type != accessor_component_type_float) ||
+                            (a.count != this_skin.joints.size())) {
+                            throw load_object_failure("gltf2 invalid inverse bind matrix accessor");
+                        }
+                    }
+
+                    m_skins.emplace_back(this_skin);
+                }
+            }
+
+            // Node skin indexes can only be checked now.
+            std::vector<node>::const_iterator n(m_nodes.begin());
+            while (n != m_nodes.end()) {
+                if (n->skin >= 0) {
+                    if (n->skin >= m_skins.size()) {
+                        throw load_object_failure("gltf2 invalid skin index");
+                    }
+
+                    if (n->mesh < 0) {
+                        throw load_object_failure("gltf2 skinned node has no mesh");
+                    }
+                }
+                else if (n->skin != -1) {
+                    throw load_object_failure("gltf2 invalid skin index");
+                }
+                ++n;
+            }
         }
 
         void gltf2_importer::async_mesh_loader::parse_scenes(rapidjson::Document const& doc)
@@ -1132,8 +1527,804 @@ namespace electroslag {
             }
         }
 
+        void gltf2_importer::async_mesh_loader::parse_animations(rapidjson::Document const& doc)
+        {
+            rapidjson::Value::ConstMemberIterator animations(doc.FindMember("animations"));
+            if (animations == doc.MemberEnd()) {
+                return;
+            }
+            ELECTROSLAG_CHECK(animations->value.IsArray());
+
+            for (rapidjson::Value::ConstValueIterator a(animations->value.Begin());
+                 a != animations->value.End();
+                 ++a) {
+
+                clip this_clip;
+
+                // Samplers pair key times with key values.
+                rapidjson::Value::ConstMemberIterator samplers_member(a->FindMember("samplers"));
+                if (samplers_member == a->MemberEnd()) {
+                    throw load_object_failure("gltf2 animation missing samplers");
+                }
+                ELECTROSLAG_CHECK(samplers_member->value.IsArray());
+
+                for (rapidjson::Value::ConstValueIterator s(samplers_member->value.Begin());
+                     s != samplers_member->value.End();
+                     ++s) {
+
+                    clip_sampler this_sampler;
+
+                    rapidjson::Value::ConstMemberIterator input_member(s->FindMember("input"));
+                    rapidjson::Value::ConstMemberIterator output_member(s->FindMember("output"));
+                    if (input_member == s->MemberEnd() || output_member == s->MemberEnd()) {
+                        throw load_object_failure("gltf2 animation sampler missing input or output");
+                    }
+
+                    this_sampler.input_accessor = input_member->value.GetInt();
+                    this_sampler.output_accessor = output_member->value.GetInt();
+                    if (this_sampler.input_accessor < 0 || this_sampler.input_accessor >= m_accessors.size() ||
+                        this_sampler.output_accessor < 0 || this_sampler.output_accessor >= m_accessors.size()) {
+                        throw load_object_failure("gltf2 invalid accessor index");
+                    }
+
+                    accessor const& input = m_accessors.at(this_sampler.input_accessor);
+                    if (input.type != accessor_type_scalar || input.component_type != accessor_component_type_float) {
+                        throw load_object_failure("gltf2 invalid animation input accessor");
+                    }
+
+                    rapidjson::Value::ConstMemberIterator interpolation_member(s->FindMember("interpolation"));
+                    if (interpolation_member != s->MemberEnd()) {
+                        char const* interpolation = interpolation_member->value.GetString();
+                        if (std::strcmp(interpolation, "STEP") == 0) {
+                            this_sampler.interpolation = animation::keyframe_interpolation_step;
+                        }
+                        else if (std::strcmp(interpolation, "LINEAR") == 0) {
+                            this_sampler.interpolation = animation::keyframe_interpolation_linear;
+                        }
+                        else if (std::strcmp(interpolation, "CUBICSPLINE") == 0) {
+                            this_sampler.interpolation = animation::keyframe_interpolation_cubic;
+                        }
+                        else {
+                            throw load_object_failure("gltf2 animation sampler interpolation is not valid");
+                        }
+                    }
+
+                    this_clip.samplers.emplace_back(this_sampler);
+                }
+
+                // Channels point a sampler at a node's transform or morph target weights.
+                rapidjson::Value::ConstMemberIterator channels_member(a->FindMember("channels"));
+                if (channels_member == a->MemberEnd()) {
+                    throw load_object_failure("gltf2 animation missing channels");
+                }
+                ELECTROSLAG_CHECK(channels_member->value.IsArray());
+
+                for (rapidjson::Value::ConstValueIterator c(channels_member->value.Begin());
+                     c != channels_member->value.End();
+                     ++c) {
+
+                    clip_channel this_channel;
+
+                    rapidjson::Value::ConstMemberIterator sampler_member(c->FindMember("sampler"));
+                    if (sampler_member == c->MemberEnd()) {
+                        throw load_object_failure("gltf2 animation channel missing sampler");
+                    }
+
+                    this_channel.sampler = sampler_member->value.GetInt();
+                    if (this_channel.sampler < 0 || this_channel.sampler >= this_clip.samplers.size()) {
+                        throw load_object_failure("gltf2 invalid animation sampler index");
+                    }
+
+                    rapidjson::Value::ConstMemberIterator target_member(c->FindMember("target"));
+                    if (target_member == c->MemberEnd()) {
+                        throw load_object_failure("gltf2 animation channel missing target");
+                    }
+
+                    // Channels without a node are for extensions; skip them.
+                    rapidjson::Value::ConstMemberIterator node_member(target_member->value.FindMember("node"));
+                    if (node_member == target_member->value.MemberEnd()) {
+                        continue;
+                    }
+
+                    this_channel.node = node_member->value.GetInt();
+                    if (this_channel.node < 0 || this_channel.node >= m_nodes.size()) {
+                        throw load_object_failure("gltf2 invalid node index");
+                    }
+
+                    rapidjson::Value::ConstMemberIterator path_member(target_member->value.FindMember("path"));
+                    if (path_member == target_member->value.MemberEnd()) {
+                        throw load_object_failure("gltf2 animation target missing path");
+                    }
+
+                    char const* path = path_member->value.GetString();
+                    if (std::strcmp(path, "translation") == 0) {
+                        this_channel.value_type = animation::keyframe_value_type_vec3;
+                        this_channel.property_hash = hash_string("translate");
+                    }
+                    else if (std::strcmp(path, "rotation") == 0) {
+                        this_channel.value_type = animation::keyframe_value_type_quat;
+                        this_channel.property_hash = hash_string("rotation");
+                    }
+                    else if (std::strcmp(path, "scale") == 0) {
+                        this_channel.value_type = animation::keyframe_value_type_vec3;
+                        this_channel.property_hash = hash_string("scale");
+                    }
+                    else if (std::strcmp(path, "weights") == 0) {
+                        // Split in to one float channel per morph target when the tracks are made.
+                        this_channel.value_type = animation::keyframe_value_type_float;
+                        this_channel.property_hash = hash_string("weights");
+                    }
+                    else {
+                        throw load_object_failure("gltf2 animation target path is not valid");
+                    }
+
+                    this_clip.channels.emplace_back(this_channel);
+                }
+
+                m_clips.emplace_back(this_clip);
+            }
+        }
+
+        void gltf2_importer::async_mesh_loader::require_accessor(int accessor_index)
+        {
+            if (accessor_index < 0) {
+                return;
+            }
+
+            decoded_accessor& decoded = m_decoded_accessors.at(accessor_index);
+            decoded.needed = true;
+        }
+
+        void gltf2_importer::async_mesh_loader::decode_accessors()
+        {
+            m_decoded_accessors.clear();
+            m_decoded_accessors.resize(m_accessors.size());
+
+            // Deformed meshes decode every attribute they blend.
+            std::vector<node>::const_iterator n(m_nodes.begin());
+            while (n != m_nodes.end()) {
+                bool skinned = (n->skin >= 0);
+                if (n->mesh >= 0 && (skinned || !m_meshes[n->mesh].weights.empty())) {
+                    std::vector<primitive>::const_iterator p(m_meshes[n->mesh].primitives.begin());
+                    while (p != m_meshes[n->mesh].primitives.end()) {
+                        require_accessor(p->position_attrib_accessor);
+                        require_accessor(p->normal_attrib_accessor);
+                        if (skinned) {
+                            require_accessor(p->joints_0_attrib_accessor);
+                            require_accessor(p->weights_0_attrib_accessor);
+                        }
+
+                        std::vector<morph_target>::const_iterator t(p->targets.begin());
+                        while (t != p->targets.end()) {
+                            require_accessor(t->position_attrib_accessor);
+                            require_accessor(t->normal_attrib_accessor);
+                            ++t;
+                        }
+                        ++p;
+                    }
+                }
+                ++n;
+            }
+
+            std::vector<skin>::const_iterator sk(m_skins.begin());
+            while (sk != m_skins.end()) {
+                require_accessor(sk->inverse_bind_accessor);
+                ++sk;
+            }
+
+            std::vector<clip>::const_iterator c(m_clips.begin());
+            while (c != m_clips.end()) {
+                std::vector<clip_sampler>::const_iterator cs(c->samplers.begin());
+                while (cs != c->samplers.end()) {
+                    require_accessor(cs->input_accessor);
+                    require_accessor(cs->output_accessor);
+                    ++cs;
+                }
+                ++c;
+            }
+
+            // Pin every buffer for the whole stage. Owned buffers lock exclusively, so the
+            // work items read through these pointers rather than taking their own accessors.
+            std::deque<referenced_buffer_interface::accessor> pinned_buffers;
+            m_buffer_bytes.resize(m_buffers.size());
+            for (int b = 0; b < static_cast<int>(m_buffers.size()); ++b) {
+                pinned_buffers.emplace_back(m_buffers[b].data);
+                m_buffer_bytes[b] = static_cast<byte const*>(pinned_buffers.back().get_pointer());
+                ELECTROSLAG_CHECK(m_buffer_bytes[b]);
+            }
+
+            // Large accessors are converted on the decode pool. This loader is itself an IO pool
+            // item, and each worker owns its queue, so waiting on IO pool items could deadlock;
+            // the frame pool would make frames wait behind the conversion.
+            threading::thread_pool* pool = threading::get_decode_thread_pool();
+            std::vector<accessor_decode_work_item::ref> items;
+            int accessor_count = static_cast<int>(m_accessors.size());
+            for (int a = 0; a < accessor_count; ++a) {
+                if (!m_decoded_accessors[a].needed) {
+                    continue;
+                }
+
+                if (m_accessors[a].count >= inline_decode_count) {
+                    items.emplace_back(pool->enqueue_work_item<accessor_decode_work_item>(this, a));
+                }
+            }
+
+            std::exception_ptr first_exception;
+            try {
+                for (int a = 0; a < accessor_count; ++a) {
+                    if (m_decoded_accessors[a].needed && m_accessors[a].count < inline_decode_count) {
+                        decode_accessor(a);
+                    }
+                }
+            }
+            catch (...) {
+                first_exception = std::current_exception();
+            }
+
+            // Every item must finish before the buffers are unpinned.
+            std::vector<accessor_decode_work_item::ref>::const_iterator i(items.begin());
+            while (i != items.end()) {
+                (*i)->wait_for_done();
+                if (!first_exception && (*i)->get_exception()) {
+                    first_exception = (*i)->get_exception();
+                }
+                ++i;
+            }
+
+            m_buffer_bytes.clear();
+            pinned_buffers.clear();
+
+            if (first_exception) {
+                std::rethrow_exception(first_exception);
+            }
+        }
+
+        void gltf2_importer::async_mesh_loader::decode_accessor(int accessor_index)
+        {
+            // Each item owns its entry; the vector itself does not change during the stage.
+            decoded_accessor& decoded = m_decoded_accessors[accessor_index];
+            read_accessor_floats(accessor_index, &decoded.values);
+        }
+
+        std::vector<float> const& gltf2_importer::async_mesh_loader::get_accessor_values(int accessor_index) const
+        {
+            decoded_accessor const& decoded = m_decoded_accessors.at(accessor_index);
+            ELECTROSLAG_CHECK(decoded.needed);
+            return (decoded.values);
+        }
+
+        void gltf2_importer::async_mesh_loader::read_accessor_floats(int accessor_index, std::vector<float>* out_values) const
+        {
+            accessor const& a = m_accessors.at(accessor_index);
+            if (a.count <= 0) {
+                throw load_object_failure("gltf2 accessor count is not valid");
+            }
+
+            int component_count = accessor_type_value_count[a.type];
+            int element_bytes = component_count * get_component_bytes(a.component_type);
+            out_values->resize(a.count * component_count);
+            float* out = out_values->data();
+
+            if (a.buffer_view >= 0) {
+                // Tightly packed unless the view says otherwise.
+                int stride = max(m_buffer_views.at(a.buffer_view).byte_stride, element_bytes);
+                byte const* element = locate_view_bytes(
+                    a.buffer_view,
+                    a.byte_offset,
+                    ((a.count - 1) * stride) + element_bytes
+                    );
+
+                convert_components(a.component_type, a.normalized, element, stride, component_count, a.count, out);
+            }
+            else {
+                std::fill(out_values->begin(), out_values->end(), 0.0f);
+            }
+
+            if (a.sparse_count <= 0) {
+                return;
+            }
+
+            // Sparse values are always tightly packed.
+            std::vector<float> sparse_values(a.sparse_count * component_count);
+            byte const* sparse_value_bytes = locate_view_bytes(
+                a.sparse_values_buffer_view,
+                a.sparse_values_byte_offset,
+                a.sparse_count * element_bytes
+                );
+            convert_components(
+                a.component_type,
+                a.normalized,
+                sparse_value_bytes,
+                element_bytes,
+                component_count,
+                a.sparse_count,
+                sparse_values.data()
+                );
+
+            int index_bytes = get_component_bytes(a.sparse_indices_component_type);
+            byte const* sparse_index_bytes = locate_view_bytes(
+                a.sparse_indices_buffer_view,
+                a.sparse_indices_byte_offset,
+                a.sparse_count * index_bytes
+                );
+
+            float const* sparse_value = sparse_values.data();
+            for (int s = 0; s < a.sparse_count; ++s) {
+                uint32_t index = 0;
+                switch (a.sparse_indices_component_type) {
+                case accessor_component_type_unsigned_byte:
+                    index = sparse_index_bytes[s];
+                    break;
+
+                case accessor_component_type_unsigned_short: {
+                    uint16_t v = 0;
+                    memcpy(&v, sparse_index_bytes + (s * sizeof(v)), sizeof(v));
+                    index = v;
+                    break;
+                }
+
+                default:
+                    memcpy(&index, sparse_index_bytes + (s * sizeof(index)), sizeof(index));
+                    break;
+                }
+
+                if (index >= static_cast<uint32_t>(a.count)) {
+                    throw load_object_failure("gltf2 accessor sparse index exceeds count");
+                }
+
+                // Rotations, tangents and colors are the common 4 wide case.
+                float* target = out + (index * component_count);
+                if (component_count == 4) {
+                    _mm_storeu_ps(target, _mm_loadu_ps(sparse_value));
+                }
+                else {
+                    memcpy(target, sparse_value, component_count * sizeof(float));
+                }
+                sparse_value += component_count;
+            }
+        }
+
+        byte const* gltf2_importer::async_mesh_loader::locate_view_bytes(
+            int buffer_view_index,
+            int byte_offset,
+            int bytes
+            ) const
+        {
+            // Buffers are pinned by decode_accessors.
+            ELECTROSLAG_CHECK(m_buffer_bytes.size() == m_buffers.size());
+
+            buffer_view const& bv = m_buffer_views.at(buffer_view_index);
+            if (byte_offset < 0 || bytes < 0 || byte_offset + bytes > bv.byte_length) {
+                throw load_object_failure("gltf2 accessor exceeds buffer view");
+            }
+
+            return (m_buffer_bytes[bv.buffer] + bv.byte_offset + byte_offset);
+        }
+
+        // static
+        int gltf2_importer::async_mesh_loader::get_component_bytes(accessor_component_type component_type)
+        {
+            switch (component_type) {
+            case accessor_component_type_byte:
+            case accessor_component_type_unsigned_byte:
+                return (1);
+
+            case accessor_component_type_short:
+            case accessor_component_type_unsigned_short:
+                return (2);
+
+            case accessor_component_type_unsigned_int:
+            case accessor_component_type_float:
+                return (4);
+
+            default:
+                throw load_object_failure("gltf2 accessor component_type is not valid");
+            }
+        }
+
+        // static
+        void gltf2_importer::async_mesh_loader::convert_components(
+            accessor_component_type component_type,
+            bool normalized,
+            byte const* element,
+            int stride,
+            int component_count,
+            int element_count,
+            float* out_values
+            )
+        {
+            int component_bytes = get_component_bytes(component_type);
+
+            for (int e = 0; e < element_count; ++e) {
+                for (int c = 0; c < component_count; ++c) {
+                    byte const* component = element + (c * component_bytes);
+                    float value = 0.0f;
+
+                    // Normalized integers map to [0, 1] or [-1, 1].
+                    switch (component_type) {
+                    case accessor_component_type_byte: {
+                        int8_t v = *reinterpret_cast<int8_t const*>(component);
+                        value = normalized ? max(v / 127.0f, -1.0f) : v;
+                        break;
+                    }
+
+                    case accessor_component_type_unsigned_byte: {
+                        uint8_t v = *component;
+                        value = normalized ? (v / 255.0f) : v;
+                        break;
+                    }
+
+                    case accessor_component_type_short: {
+                        int16_t v = 0;
+                        memcpy(&v, component, sizeof(v));
+                        value = normalized ? max(v / 32767.0f, -1.0f) : v;
+                        break;
+                    }
+
+                    case accessor_component_type_unsigned_short: {
+                        uint16_t v = 0;
+                        memcpy(&v, component, sizeof(v));
+                        value = normalized ? (v / 65535.0f) : v;
+                        break;
+                    }
+
+                    case accessor_component_type_unsigned_int: {
+                        uint32_t v = 0;
+                        memcpy(&v, component, sizeof(v));
+                        value = static_cast<float>(v);
+                        break;
+                    }
+
+                    default:
+                        memcpy(&value, component, sizeof(value));
+                        break;
+                    }
+
+                    *out_values++ = value;
+                }
+                element += stride;
+            }
+        }
+
+        bool gltf2_importer::async_mesh_loader::is_quantized_component(accessor const& a, bool signed_normalized_only) const
+        {
+            if (!m_mesh_quantization) {
+                return (false);
+            }
+
+            switch (a.component_type) {
+            case accessor_component_type_byte:
+            case accessor_component_type_short:
+                return (a.normalized || !signed_normalized_only);
+
+            case accessor_component_type_unsigned_byte:
+            case accessor_component_type_unsigned_short:
+                return (!signed_normalized_only);
+
+            default:
+                return (false);
+            }
+        }
+
+        void gltf2_importer::async_mesh_loader::create_clip_descriptors()
+        {
+            // Samplers frequently share their input accessor; share the key times too.
+            std::vector<animation::keyframe_times::ref> accessor_times(m_accessors.size());
+
+            std::vector<clip>::const_iterator c(m_clips.begin());
+            int clip_id = 0;
+            while (c != m_clips.end()) {
+                std::string clip_name;
+                formatted_string_append(clip_name, "%s::animation::%d", m_object_prefix.c_str(), clip_id);
+
+                animation::animation_clip::ref clip_desc(animation::animation_clip::create());
+                clip_desc->set_name(clip_name);
+
+                std::vector<clip_channel>::const_iterator ch(c->channels.begin());
+                int channel_id = 0;
+                while (ch != c->channels.end()) {
+                    clip_sampler const& sampler = c->samplers[ch->sampler];
+
+                    animation::keyframe_times::ref& times = accessor_times[sampler.input_accessor];
+                    if (!times.is_valid()) {
+                        std::vector<float> const& values = get_accessor_values(sampler.input_accessor);
+
+                        std::string times_name;
+                        formatted_string_append(times_name, "%s::key_times::%d", m_object_prefix.c_str(), sampler.input_accessor);
+
+                        times = animation::keyframe_times::create(values.data(), static_cast<int>(values.size()));
+                        times->set_name(times_name);
+                        m_load_record->insert_object(times);
+                    }
+
+                    // Outputs must hold one value (three for cubic) of the right size per key.
+                    std::vector<float> const& values = get_accessor_values(sampler.output_accessor);
+                    int values_per_key = (sampler.interpolation == animation::keyframe_interpolation_cubic) ? 3 : 1;
+                    int key_values = times->get_key_count() * values_per_key;
+                    unsigned long long target_hash = m_nodes[ch->node].desc->get_hash();
+
+                    if (ch->property_hash == hash_string("weights")) {
+                        // Every key holds one weight per morph target; each target gets its own track.
+                        int value_count = static_cast<int>(values.size());
+                        if (key_values == 0 || value_count == 0 || (value_count % key_values) != 0) {
+                            throw load_object_failure("gltf2 animation output accessor does not match input");
+                        }
+                        int morph_target_count = value_count / key_values;
+
+                        std::vector<float> target_values(key_values);
+                        for (int t = 0; t < morph_target_count; ++t) {
+                            for (int k = 0; k < key_values; ++k) {
+                                target_values[k] = values[(k * morph_target_count) + t];
+                            }
+
+                            std::string track_name;
+                            formatted_string_append(track_name, "%s::track::%d::%d", clip_name.c_str(), channel_id, t);
+
+                            animation::keyframe_track::ref track(animation::keyframe_track::create(
+                                times,
+                                ch->value_type,
+                                sampler.interpolation,
+                                target_values.data()
+                                ));
+                            track->set_name(track_name);
+                            m_load_record->insert_object(track);
+
+                            clip_desc->insert_channel(
+                                target_hash,
+                                renderer::deformation_descriptor::get_morph_weight_hash(t),
+                                track
+                                );
+                        }
+                    }
+                    else {
+                        int components = (ch->value_type == animation::keyframe_value_type_quat) ? 4 : 3;
+                        if (values.size() != key_values * components) {
+                            throw load_object_failure("gltf2 animation output accessor does not match input");
+                        }
+
+                        std::string track_name;
+                        formatted_string_append(track_name, "%s::track::%d", clip_name.c_str(), channel_id);
+
+                        animation::keyframe_track::ref track(animation::keyframe_track::create(
+                            times,
+                            ch->value_type,
+                            sampler.interpolation,
+                            values.data()
+                            ));
+                        track->set_name(track_name);
+                        m_load_record->insert_object(track);
+
+                        clip_desc->insert_channel(target_hash, ch->property_hash, track);
+                    }
+
+                    ++ch; ++channel_id;
+                }
+
+                m_load_record->insert_object(clip_desc);
+                ++c; ++clip_id;
+            }
+        }
+
+        void gltf2_importer::async_mesh_loader::create_deformation_descriptors()
+        {
+            std::vector<renderer::skin_descriptor::ref> skin_descs;
+            skin_descs.reserve(m_skins.size());
+
+            std::vector<skin>::const_iterator s(m_skins.begin());
+            int skin_id = 0;
+            while (s != m_skins.end()) {
+                std::string skin_name;
+                formatted_string_append(skin_name, "%s::skin::%d", m_object_prefix.c_str(), skin_id);
+
+                renderer::skin_descriptor::ref skin_desc(renderer::skin_descriptor::create());
+                skin_desc->set_name(skin_name);
+
+                int joint_count = static_cast<int>(s->joints.size());
+                for (int j = 0; j < joint_count; ++j) {
+                    glm::f32mat4x4 inverse_bind_matrix(1.0f);
+                    if (s->inverse_bind_accessor >= 0) {
+                        std::vector<float> const& values = get_accessor_values(s->inverse_bind_accessor);
+
+                        // Column major, as glm stores them.
+                        for (int i = 0; i < 16; ++i) {
+                            inverse_bind_matrix[i / 4][i % 4] = values[(j * 16) + i];
+                        }
+                    }
+
+                    skin_desc->insert_joint(m_nodes[s->joints[j]].desc->get_hash(), inverse_bind_matrix);
+                }
+
+                m_load_record->insert_object(skin_desc);
+                skin_descs.emplace_back(skin_desc);
+                ++s; ++skin_id;
+            }
+
+            // A mesh used both with and without a skin needs two deformations.
+            std::vector<renderer::deformation_descriptor::ref> mesh_deformations(m_meshes.size() * 2);
+
+            std::vector<node>::const_iterator n(m_nodes.begin());
+            while (n != m_nodes.end()) {
+                bool skinned = (n->skin >= 0);
+                if (n->mesh >= 0 && (skinned || !m_meshes[n->mesh].weights.empty())) {
+                    renderer::deformation_descriptor::ref& deformation = mesh_deformations[(n->mesh * 2) + (skinned ? 1 : 0)];
+                    if (!deformation.is_valid()) {
+                        deformation = create_mesh_deformation(n->mesh, skinned);
+                    }
+
+                    n->desc->set_deformation(deformation);
+                    if (skinned) {
+                        n->desc->set_skin(skin_descs[n->skin]);
+                    }
+                }
+                ++n;
+            }
+        }
+
+        renderer::deformation_descriptor::ref gltf2_importer::async_mesh_loader::create_mesh_deformation(
+            int mesh_index,
+            bool skinned
+            )
+        {
+            mesh const& this_mesh = m_meshes[mesh_index];
+            int target_count = static_cast<int>(this_mesh.weights.size());
+
+            // Normals are only deformed if every primitive has them.
+            bool normals = true;
+            std::vector<primitive>::const_iterator p(this_mesh.primitives.begin());
+            while (p != this_mesh.primitives.end()) {
+                if (p->position_attrib_accessor < 0) {
+                    throw load_object_failure("gltf2 deformed primitive has no positions");
+                }
+                normals &= (p->normal_attrib_accessor >= 0);
+                ++p;
+            }
+
+            // Each vertex deforms on its own, so primitives are simply concatenated.
+            std::vector<float> positions;
+            std::vector<float> normal_values;
+            std::vector<uint16_t> joints;
+            std::vector<float> weights;
+            std::vector<std::vector<float> > target_positions(target_count);
+            std::vector<std::vector<float> > target_normals(target_count);
+
+            p = this_mesh.primitives.begin();
+            while (p != this_mesh.primitives.end()) {
+                std::vector<float> const& position_values = get_accessor_values(p->position_attrib_accessor);
+                positions.insert(positions.end(), position_values.begin(), position_values.end());
+                int attribute_floats = static_cast<int>(position_values.size());
+                int vertex_count = attribute_floats / 3;
+
+                if (normals) {
+                    std::vector<float> const& values = get_accessor_values(p->normal_attrib_accessor);
+                    if (values.size() != attribute_floats) {
+                        throw load_object_failure("gltf2 normal count does not match positions");
+                    }
+                    normal_values.insert(normal_values.end(), values.begin(), values.end());
+                }
+
+                if (skinned) {
+                    int joint_values = vertex_count * renderer::deformation_descriptor::joints_per_vertex;
+                    if (p->joints_0_attrib_accessor >= 0) {
+                        std::vector<float> const& joint_indices = get_accessor_values(p->joints_0_attrib_accessor);
+                        if (joint_indices.size() != joint_values) {
+                            throw load_object_failure("gltf2 joints_0 count does not match positions");
+                        }
+
+                        std::vector<float>::const_iterator j(joint_indices.begin());
+                        while (j != joint_indices.end()) {
+                            joints.emplace_back(static_cast<uint16_t>(*j));
+                            ++j;
+                        }
+
+                        std::vector<float> const& joint_weights = get_accessor_values(p->weights_0_attrib_accessor);
+                        if (joint_weights.size() != joint_values) {
+                            throw load_object_failure("gltf2 weights_0 count does not match positions");
+                        }
+                        weights.insert(weights.end(), joint_weights.begin(), joint_weights.end());
+                    }
+                    else {
+                        // Unweighted vertices end up following the first joint.
+                        joints.resize(joints.size() + joint_values, 0);
+                        weights.resize(weights.size() + joint_values, 0.0f);
+                    }
+                }
+
+                for (int t = 0; t < target_count; ++t) {
+                    morph_target const& target = p->targets[t];
+
+                    if (target.position_attrib_accessor >= 0) {
+                        std::vector<float> const& values = get_accessor_values(target.position_attrib_accessor);
+                        if (values.size() != attribute_floats) {
+                            throw load_object_failure("gltf2 morph target count does not match positions");
+                        }
+                        target_positions[t].insert(target_positions[t].end(), values.begin(), values.end());
+                    }
+                    else {
+                        target_positions[t].resize(target_positions[t].size() + attribute_floats, 0.0f);
+                    }
+
+                    if (normals) {
+                        if (target.normal_attrib_accessor >= 0) {
+                            std::vector<float> const& values = get_accessor_values(target.normal_attrib_accessor);
+                            if (values.size() != attribute_floats) {
+                                throw load_object_failure("gltf2 morph target count does not match positions");
+                            }
+                            target_normals[t].insert(target_normals[t].end(), values.begin(), values.end());
+                        }
+                        else {
+                            target_normals[t].resize(target_normals[t].size() + attribute_floats, 0.0f);
+                        }
+                    }
+                }
+
+                ++p;
+            }
+
+            std::string deformation_name;
+            formatted_string_append(
+                deformation_name,
+                skinned ? "%s::skinned_deformation::%d" : "%s::deformation::%d",
+                m_object_prefix.c_str(),
+                mesh_index
+                );
+
+            renderer::deformation_descriptor::ref deformation(renderer::deformation_descriptor::create(
+                static_cast<int>(positions.size() / 3),
+                positions.data(),
+                normals ? normal_values.data() : 0
+                ));
+            deformation->set_name(deformation_name);
+
+            if (skinned) {
+                deformation->set_skin_weights(joints.data(), weights.data());
+            }
+
+            for (int t = 0; t < target_count; ++t) {
+                deformation->insert_morph_target(
+                    target_positions[t].data(),
+                    normals ? target_normals[t].data() : 0,
+                    this_mesh.weights[t]
+                    );
+            }
+
+            m_load_record->insert_object(deformation);
+            return (deformation);
+        }
+
         renderer::instance_descriptor::ref gltf2_importer::async_mesh_loader::create_descriptors()
         {
+            // Every node gets an instance; glTF2 requires the node graph to be a forest,
+            // so nodes can be linked to their children once they all exist.
+            std::vector<node>::iterator n(m_nodes.begin());
+            int node_id = 0;
+            while (n != m_nodes.end()) {
+                std::string node_name;
+                formatted_string_append(node_name, "%s::node::%d", m_object_prefix.c_str(), node_id);
+
+                n->desc = renderer::instance_descriptor::create();
+                n->desc->set_name(node_name);
+                n->desc->set_transform(create_node_transform(*n, node_name));
+
+                m_load_record->insert_object(n->desc);
+                ++n; ++node_id;
+            }
+
+            n = m_nodes.begin();
+            while (n != m_nodes.end()) {
+                std::vector<int>::const_iterator c(n->children.begin());
+                while (c != n->children.end()) {
+                    n->desc->insert_child_instance(m_nodes[*c].desc);
+                    ++c;
+                }
+                ++n;
+            }
+
+            // Skins name their joints by instance, so they follow the node instances.
+            create_deformation_descriptors();
+
+            // Animations target node instances by name; they are played through the scene.
+            create_clip_descriptors();
+
             std::vector<scene>::iterator s(m_scenes.begin());
             int scene_id = 0;
             while (s != m_scenes.end()) {
@@ -1145,10 +2336,8 @@ namespace electroslag {
 
                 std::vector<int>::const_iterator node_index_iter(s->nodes.begin());
                 while (node_index_iter != s->nodes.end()) {
-                    std::string node_name;
-                    formatted_string_append(node_name, "%s::node::%d", m_object_prefix.c_str(), *node_index_iter);
-
-                    //s->desc->insert_child_instance()
+                    s->desc->insert_child_instance(m_nodes[*node_index_iter].desc);
+                    ++node_index_iter;
                 }
 
                 m_load_record->insert_object(s->desc);
@@ -1157,7 +2346,7 @@ namespace electroslag {
 
             // The top level instance has a single child pointing at the default scene.
             renderer::instance_descriptor::ref scene_desc;
-            if (m_scene >= 0) {
+            if (m_scene < 0) {
                 m_scene = 0;
             }
 
@@ -1167,7 +2356,7 @@ namespace electroslag {
             scene_desc->set_transform(m_base_transform);
             m_load_record->insert_object(scene_desc);
 
-            return  (scene_desc);
+            return (scene_desc);
 
             /*
             // Name the buffer descriptor.
@@ -1195,5 +2384,42 @@ namespace electroslag {
             }
             */
         }
+
+        renderer::transform_descriptor::ref gltf2_importer::async_mesh_loader::create_node_transform(
+            node const& this_node,
+            std::string const& node_name
+            )
+        {
+            if (this_node.transform_type == node_transform_type_none) {
+                return (renderer::transform_descriptor::ref::null_ref);
+            }
+
+            renderer::transform_descriptor::ref transform_desc(renderer::transform_descriptor::create());
+            transform_desc->set_name(node_name + "::transform");
+
+            if (this_node.transform_type == node_transform_type_srt) {
+                transform_desc->set_rotation(this_node.rotate);
+                transform_desc->set_scale(this_node.scale);
+                transform_desc->set_translate(this_node.translate);
+            }
+            else {
+                // Matrices are decomposed in to T * R * S; glTF2 forbids skew and projection here.
+                glm::f32mat3 basis(this_node.matrix);
+                glm::f32vec3 scale(glm::length(basis[0]), glm::length(basis[1]), glm::length(basis[2]));
+                if (glm::determinant(basis) < 0.0f) {
+                    scale.x = -scale.x;
+                }
+                basis[0] /= scale.x;
+                basis[1] /= scale.y;
+                basis[2] /= scale.z;
+
+                transform_desc->set_rotation(glm::normalize(glm::quat_cast(basis)));
+                transform_desc->set_scale(scale);
+                transform_desc->set_translate(glm::f32vec3(this_node.matrix[3]));
+            }
+
+            m_load_record->insert_object(transform_desc);
+            return (transform_desc);
+        }
     }
 }
@@ -28,7 +28,12 @@
 #include "electroslag/graphics/graphics_types.hpp"
 #include "electroslag/renderer/instance_descriptor.hpp"
 #include "electroslag/renderer/transform_descriptor.hpp"
+#include "electroslag/renderer/deformation_descriptor.hpp"
+#include "electroslag/renderer/skin_descriptor.hpp"
 #include "electroslag/texture/gli_importer.hpp"
+#include "electroslag/animation/keyframe_times.hpp"
+#include "electroslag/animation/keyframe_track.hpp"
+#include "electroslag/animation/animation_clip.hpp"
 
 namespace electroslag {
     namespace mesh {
@@ -87,6 +92,7 @@ namespace electroslag {
                     , m_bake_in_scale(bake_in_scale)
                     , m_base_transform(base_transform)
                     , m_scene(-1)
+                    , m_mesh_quantization(false)
                 {}
                 virtual ~async_mesh_loader()
                 {}
@@ -152,6 +158,12 @@ namespace electroslag {
                         , normalized(false)
                         , count(0)
                         , type(accessor_type_unknown)
+                        , sparse_count(0)
+                        , sparse_indices_buffer_view(-1)
+                        , sparse_indices_byte_offset(0)
+                        , sparse_indices_component_type(accessor_component_type_unknown)
+                        , sparse_values_buffer_view(-1)
+                        , sparse_values_byte_offset(0)
                     {
                         memset(max, 0, sizeof(max));
                         memset(min, 0, sizeof(min));
@@ -165,7 +177,15 @@ namespace electroslag {
                     accessor_type type;
                     float max[16];
                     float min[16];
-                    // TODO sparse
+
+                    // Sparse elements replace elements of the base data, or of zeros when
+                    // there is no buffer view.
+                    int sparse_count;
+                    int sparse_indices_buffer_view;
+                    int sparse_indices_byte_offset;
+                    accessor_component_type sparse_indices_component_type;
+                    int sparse_values_buffer_view;
+                    int sparse_values_byte_offset;
                 };
 
                 enum alpha_mode_type {
@@ -230,6 +250,17 @@ namespace electroslag {
                     primitive_mode_type_triangle_fan = gl::TRIANGLE_FAN
                 };
 
+                // Morph target attributes are deltas from the base attributes.
+                struct morph_target {
+                    morph_target()
+                        : position_attrib_accessor(-1)
+                        , normal_attrib_accessor(-1)
+                    {}
+
+                    int position_attrib_accessor;
+                    int normal_attrib_accessor;
+                };
+
                 struct primitive {
                     primitive()
                         : index_accessor(-1)
@@ -241,6 +272,8 @@ namespace electroslag {
                         , texcoord_0_attrib_accessor(-1)
                         , texcoord_1_attrib_accessor(-1)
                         , color_0_attrib_accessor(-1)
+                        , joints_0_attrib_accessor(-1)
+                        , weights_0_attrib_accessor(-1)
                     {}
 
                     int index_accessor;
@@ -253,10 +286,15 @@ namespace electroslag {
                     int texcoord_0_attrib_accessor;
                     int texcoord_1_attrib_accessor;
                     int color_0_attrib_accessor;
+                    int joints_0_attrib_accessor;
+                    int weights_0_attrib_accessor;
+
+                    std::vector<morph_target> targets;
                 };
 
                 struct mesh {
                     std::vector<primitive> primitives;
+                    std::vector<float> weights;
                 };
 
                 enum node_transform_type {
@@ -269,15 +307,28 @@ namespace electroslag {
                 struct node {
                     node()
                         : mesh(-1)
+                        , skin(-1)
                         , transform_type(node_transform_type_none)
                     {}
 
                     int mesh;
+                    int skin;
                     node_transform_type transform_type;
                     glm::f32vec3 translate;
                     glm::f32vec3 scale;
                     glm::f32quat rotate;
                     glm::f32mat4 matrix;
+                    std::vector<int> children;
+                    renderer::instance_descriptor::ref desc;
+                };
+
+                struct skin {
+                    skin()
+                        : inverse_bind_accessor(-1)
+                    {}
+
+                    std::vector<int> joints;
+                    int inverse_bind_accessor;
                 };
 
                 struct scene {
@@ -285,8 +336,65 @@ namespace electroslag {
                     renderer::instance_descriptor::ref desc;
                 };
 
+                struct clip_sampler {
+                    clip_sampler()
+                        : input_accessor(-1)
+                        , output_accessor(-1)
+                        , interpolation(animation::keyframe_interpolation_linear)
+                    {}
+
+                    int input_accessor;
+                    int output_accessor;
+                    animation::keyframe_interpolation interpolation;
+                };
+
+                struct clip_channel {
+                    clip_channel()
+                        : sampler(-1)
+                        , node(-1)
+                        , value_type(animation::keyframe_value_type_unknown)
+                        , property_hash(0)
+                    {}
+
+                    int sampler;
+                    int node;
+                    animation::keyframe_value_type value_type;
+                    unsigned long long property_hash;
+                };
+
+                // A gltf2 "animation."
+                struct clip {
+                    std::vector<clip_sampler> samplers;
+                    std::vector<clip_channel> channels;
+                };
+
+                // GLB binary container layout; all fields are little endian.
+                struct glb_header {
+                    uint32_t magic;
+                    uint32_t version;
+                    uint32_t length;
+                };
+
+                struct glb_chunk_header {
+                    uint32_t length;
+                    uint32_t type;
+                };
+
+                static uint32_t const glb_magic = 0x46546C67; // "glTF"
+                static uint32_t const glb_chunk_type_json = 0x4E4F534A; // "JSON"
+                static uint32_t const glb_chunk_type_bin = 0x004E4942; // "BIN\0"
+
                 static int locate_base64_start(int uri_length, char const* uri);
 
+                // Find the chunks in a mapped GLB file; returns the JSON chunk, terminated for
+                // in place parsing, and keeps a slice of the BIN chunk for buffer 0.
+                char* parse_glb_container(
+                    referenced_buffer_interface::ref const& file_data,
+                    byte* file_bytes,
+                    int file_sizeof,
+                    std::unique_ptr<char[]>* out_json_copy
+                    );
+
                 void parse_asset(rapidjson::Document const& doc);
                 void parse_extensions(rapidjson::Document const& doc);
                 void parse_buffers(rapidjson::Document const& doc);
@@ -298,11 +406,94 @@ namespace electroslag {
                 void parse_meshes(rapidjson::Document const& doc);
                 void parse_materials(rapidjson::Document const& doc);
                 void parse_nodes(rapidjson::Document const& doc);
+                void parse_skins(rapidjson::Document const& doc);
                 void parse_scenes(rapidjson::Document const& doc);
+                void parse_animations(rapidjson::Document const& doc);
 
                 void parse_material_map(rapidjson::Value::ConstMemberIterator const& map_member, material_map* out_map);
 
                 renderer::instance_descriptor::ref create_descriptors();
+                renderer::transform_descriptor::ref create_node_transform(node const& this_node, std::string const& node_name);
+                void create_clip_descriptors();
+                void create_deformation_descriptors();
+                renderer::deformation_descriptor::ref create_mesh_deformation(int mesh_index, bool skinned);
+
+                // Accessors converted by decode_accessors for descriptor assembly to read.
+                struct decoded_accessor {
+                    decoded_accessor()
+                        : needed(false)
+                    {}
+
+                    bool needed;
+                    std::vector<float> values;
+                };
+
+                // Converts one accessor on the decode thread pool. Worker threads do not survive
+                // exceptions, so failures are kept for the loader to rethrow.
+                class accessor_decode_work_item : public threading::work_item_interface {
+                public:
+                    typedef reference<accessor_decode_work_item> ref;
+
+                    accessor_decode_work_item(async_mesh_loader* loader, int accessor_index)
+                        : m_loader(loader)
+                        , m_accessor_index(accessor_index)
+                    {}
+
+                    virtual void execute()
+                    {
+                        try {
+                            m_loader->decode_accessor(m_accessor_index);
+                        }
+                        catch (...) {
+                            m_exception = std::current_exception();
+                        }
+                    }
+
+                    std::exception_ptr const& get_exception() const
+                    {
+                        return (m_exception);
+                    }
+
+                private:
+                    async_mesh_loader* m_loader;
+                    int m_accessor_index;
+                    std::exception_ptr m_exception;
+
+                    // Disallowed operations:
+                    accessor_decode_work_item();
+                    explicit accessor_decode_work_item(accessor_decode_work_item const&);
+                    accessor_decode_work_item& operator =(accessor_decode_work_item const&);
+                };
+
+                // Accessors with fewer elements are converted on the loader thread.
+                static int const inline_decode_count = 4096;
+
+                void require_accessor(int accessor_index);
+                void decode_accessors();
+                void decode_accessor(int accessor_index);
+                std::vector<float> const& get_accessor_values(int accessor_index) const;
+
+                // Expand an accessor to floats, applying normalization and sparse substitution.
+                void read_accessor_floats(int accessor_index, std::vector<float>* out_values) const;
+
+                // Bounds checked pointer in to a pinned buffer view.
+                byte const* locate_view_bytes(int buffer_view_index, int byte_offset, int bytes) const;
+
+                static int get_component_bytes(accessor_component_type component_type);
+
+                static void convert_components(
+                    accessor_component_type component_type,
+                    bool normalized,
+                    byte const* element,
+                    int stride,
+                    int component_count,
+                    int element_count,
+                    float* out_values
+                    );
+
+                // KHR_mesh_quantization allows 8 and 16 bit components where floats are otherwise
+                // required; normals and tangents must be signed and normalized.
+                bool is_quantized_component(accessor const& a, bool signed_normalized_only) const;
 
                 // Input parameters.
                 gltf2_importer::ref m_this_importer;
@@ -313,17 +504,23 @@ namespace electroslag {
                 renderer::transform_descriptor::ref m_base_transform;
 
                 // Parse state.
+                referenced_buffer_interface::ref m_glb_binary;
                 std::vector<buffer> m_buffers;
                 std::vector<buffer_view> m_buffer_views;
                 std::vector<accessor> m_accessors;
+                std::vector<decoded_accessor> m_decoded_accessors;
+                std::vector<byte const*> m_buffer_bytes;
                 std::vector<std::string> m_image_paths;
                 std::vector<graphics::sampler_params> m_samplers;
                 std::vector<texture::gli_importer::ref> m_texture_importers;
                 std::vector<material> m_materials;
                 std::vector<mesh> m_meshes;
                 std::vector<node> m_nodes;
+                std::vector<skin> m_skins;
                 std::vector<scene> m_scenes;
+                std::vector<clip> m_clips;
                 int m_scene;
+                bool m_mesh_quantization;
             };
 
             gltf2_importer(
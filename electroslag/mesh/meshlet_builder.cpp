@@ -0,0 +1,240 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/mesh/meshlet_builder.hpp"
+
+namespace electroslag {
+    namespace mesh {
+        // Interleave the low 10 bits of v with two zero bits between each.
+        static uint32_t spread_morton_bits(uint32_t v)
+        {
+            v &= 0x3ff;
+            v = (v | (v << 16)) & 0x030000ff;
+            v = (v | (v << 8)) & 0x0300f00f;
+            v = (v | (v << 4)) & 0x030c30c3;
+            v = (v | (v << 2)) & 0x09249249;
+            return (v);
+        }
+
+        static void compute_meshlet_bounds(
+            glm::f32vec3 const* positions,
+            glm::f32vec3 const* triangle_normals,
+            uint32_t const* indices,
+            meshlet* m
+            )
+        {
+            // Sphere around the center of the box; loose, but cheap and stable.
+            glm::f32vec3 min_corner(positions[indices[m->first_index]]);
+            glm::f32vec3 max_corner(min_corner);
+            for (int i = 1; i < m->index_count; ++i) {
+                glm::f32vec3 const& p = positions[indices[m->first_index + i]];
+                min_corner = glm::min(min_corner, p);
+                max_corner = glm::max(max_corner, p);
+            }
+
+            m->center = (min_corner + max_corner) * 0.5f;
+            m->radius = 0.0f;
+            for (int i = 0; i < m->index_count; ++i) {
+                m->radius = max(m->radius, glm::length(positions[indices[m->first_index + i]] - m->center));
+            }
+
+            // The axis is the average facing; the cutoff widens it by a right angle on
+            // every side and inverts it, giving the eye directions that see only backs.
+            int first_triangle = m->first_index / 3;
+            int triangle_count = m->index_count / 3;
+            glm::f32vec3 normal_sum(0.0f);
+            for (int t = 0; t < triangle_count; ++t) {
+                normal_sum += triangle_normals[first_triangle + t];
+            }
+
+            m->cone_axis = glm::f32vec3(0.0f);
+            m->cone_cutoff = 1.0f;
+
+            float normal_sum_length = glm::length(normal_sum);
+            if (normal_sum_length <= 0.0f) {
+                return;
+            }
+
+            glm::f32vec3 axis(normal_sum / normal_sum_length);
+            float min_dot = 1.0f;
+            for (int t = 0; t < triangle_count; ++t) {
+                glm::f32vec3 const& n = triangle_normals[first_triangle + t];
+                if (n != glm::f32vec3(0.0f)) {
+                    min_dot = min(min_dot, glm::dot(axis, n));
+                }
+            }
+
+            if (min_dot > 0.0f) {
+                m->cone_axis = axis;
+                m->cone_cutoff = std::sqrt(1.0f - (min_dot * min_dot));
+            }
+        }
+
+        void build_meshlets(
+            float const* positions,
+            int vertex_count,
+            uint32_t const* indices,
+            int index_count,
+            int max_triangles,
+            std::vector<uint32_t>* out_indices,
+            std::vector<meshlet>* out_meshlets
+            )
+        {
+            if (!positions || vertex_count <= 0) {
+                throw parameter_failure("positions");
+            }
+
+            if (!indices || index_count <= 0 || index_count % 3) {
+                throw parameter_failure("indices");
+            }
+
+            if (max_triangles <= 0) {
+                throw parameter_failure("max_triangles");
+            }
+
+            glm::f32vec3 const* vertices = reinterpret_cast<glm::f32vec3 const*>(positions);
+            int triangle_count = index_count / 3;
+
+            // Centroids and unit normals; degenerate triangles keep a zero normal.
+            std::vector<glm::f32vec3> centroids(triangle_count);
+            std::vector<glm::f32vec3> normals(triangle_count);
+            glm::f32vec3 min_corner(std::numeric_limits<float>::max());
+            glm::f32vec3 max_corner(-std::numeric_limits<float>::max());
+            uint32_t vertex_limit = static_cast<uint32_t>(vertex_count);
+            for (int t = 0; t < triangle_count; ++t) {
+                uint32_t const* tri = indices + (t * 3);
+                if (tri[0] >= vertex_limit || tri[1] >= vertex_limit || tri[2] >= vertex_limit) {
+                    throw parameter_failure("index out of range");
+                }
+
+                glm::f32vec3 const& a = vertices[tri[0]];
+                glm::f32vec3 const& b = vertices[tri[1]];
+                glm::f32vec3 const& c = vertices[tri[2]];
+                centroids[t] = (a + b + c) / 3.0f;
+                min_corner = glm::min(min_corner, centroids[t]);
+                max_corner = glm::max(max_corner, centroids[t]);
+
+                glm::f32vec3 normal(glm::cross(b - a, c - a));
+                float length = glm::length(normal);
+                normals[t] = (length > 0.0f) ? (normal / length) : glm::f32vec3(0.0f);
+            }
+
+            // Seed order.
+            glm::f32vec3 extent(max_corner - min_corner);
+            float longest = max(extent.x, max(extent.y, extent.z));
+            float to_grid = (longest > 0.0f) ? (1023.0f / longest) : 0.0f;
+
+            std::vector<std::pair<uint32_t, int> > seeds(triangle_count);
+            for (int t = 0; t < triangle_count; ++t) {
+                glm::f32vec3 grid((centroids[t] - min_corner) * to_grid);
+                seeds[t].first =
+                    spread_morton_bits(static_cast<uint32_t>(grid.x)) |
+                    (spread_morton_bits(static_cast<uint32_t>(grid.y)) << 1) |
+                    (spread_morton_bits(static_cast<uint32_t>(grid.z)) << 2);
+                seeds[t].second = t;
+            }
+            std::sort(seeds.begin(), seeds.end());
+
+            // Triangles using each vertex, packed; vertex v owns [offsets[v], offsets[v + 1]).
+            std::vector<int> vertex_triangle_offsets(vertex_count + 1, 0);
+            for (int i = 0; i < index_count; ++i) {
+                ++vertex_triangle_offsets[indices[i] + 1];
+            }
+            for (int v = 0; v < vertex_count; ++v) {
+                vertex_triangle_offsets[v + 1] += vertex_triangle_offsets[v];
+            }
+
+            std::vector<int> vertex_triangles(index_count);
+            {
+                std::vector<int> fill(vertex_triangle_offsets.begin(), vertex_triangle_offsets.end() - 1);
+                for (int i = 0; i < index_count; ++i) {
+                    vertex_triangles[fill[indices[i]]++] = i / 3;
+                }
+            }
+
+            // Breadth first growth from each seed. queued_by holds the meshlet that last
+            // queued a triangle, so a triangle is looked at once per meshlet at most.
+            std::vector<byte> assigned(triangle_count, 0);
+            std::vector<int> queued_by(triangle_count, -1);
+            std::vector<int> queue;
+            std::vector<int> ordered_triangles;
+            ordered_triangles.reserve(triangle_count);
+
+            out_indices->clear();
+            out_indices->reserve(index_count);
+            out_meshlets->clear();
+
+            std::vector<std::pair<uint32_t, int> >::const_iterator s(seeds.begin());
+            while (s != seeds.end()) {
+                int seed = s->second;
+                ++s;
+                if (assigned[seed]) {
+                    continue;
+                }
+
+                int meshlet_index = static_cast<int>(out_meshlets->size());
+                glm::f32vec3 const& seed_normal = normals[seed];
+
+                queue.clear();
+                queue.emplace_back(seed);
+                queued_by[seed] = meshlet_index;
+
+                meshlet m;
+                m.first_index = static_cast<int>(out_indices->size());
+                m.index_count = 0;
+
+                for (int head = 0; head < static_cast<int>(queue.size()) && m.index_count < max_triangles * 3; ++head) {
+                    int t = queue[head];
+                    assigned[t] = 1;
+                    ordered_triangles.emplace_back(t);
+                    out_indices->insert(out_indices->end(), indices + (t * 3), indices + (t * 3) + 3);
+                    m.index_count += 3;
+
+                    for (int i = 0; i < 3; ++i) {
+                        uint32_t v = indices[(t * 3) + i];
+                        for (int n = vertex_triangle_offsets[v]; n < vertex_triangle_offsets[v + 1]; ++n) {
+                            int neighbor = vertex_triangles[n];
+                            if (assigned[neighbor] || queued_by[neighbor] == meshlet_index) {
+                                continue;
+                            }
+
+                            if (glm::dot(normals[neighbor], seed_normal) < 0.0f) {
+                                continue;
+                            }
+
+                            queued_by[neighbor] = meshlet_index;
+                            queue.emplace_back(neighbor);
+                        }
+                    }
+                }
+
+                out_meshlets->emplace_back(m);
+            }
+
+            // Normals follow the output order so each meshlet's are contiguous.
+            std::vector<glm::f32vec3> ordered_normals(triangle_count);
+            for (int t = 0; t < triangle_count; ++t) {
+                ordered_normals[t] = normals[ordered_triangles[t]];
+            }
+
+            std::vector<meshlet>::iterator m(out_meshlets->begin());
+            while (m != out_meshlets->end()) {
+                compute_meshlet_bounds(vertices, ordered_normals.data(), out_indices->data(), &(*m));
+                ++m;
+            }
+        }
+    }
+}
@@ -0,0 +1,55 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+
+#if defined(ELECTROSLAG_BUILD_SHIP)
+#error meshlet building not to be included in SHIP build!
+#endif
+
+namespace electroslag {
+    namespace mesh {
+        // A run of triangles that is culled as one unit, in the reordered index list.
+        struct meshlet {
+            int first_index;
+            int index_count;
+
+            // Bounding sphere, in the same units as the positions.
+            glm::f32vec3 center;
+            float radius;
+
+            // Every triangle faces away from an eye for which
+            // dot(center - eye, cone_axis) >= cone_cutoff * length(center - eye) + radius.
+            // Meshlets too curved to ever be back facing have a zero axis and a cutoff of 1.
+            glm::f32vec3 cone_axis;
+            float cone_cutoff;
+        };
+
+        // Split a triangle list in to meshlets of at most max_triangles. Meshlets grow
+        // outward from a seed over shared vertices, stopping at creases steeper than a right
+        // angle so the normal cones stay useful. Seeds are taken in Morton order of their
+        // centroids, so meshlets that are near in the index list are near in space too.
+        // The output indices hold every input triangle exactly once.
+        void build_meshlets(
+            float const* positions,
+            int vertex_count,
+            uint32_t const* indices,
+            int index_count,
+            int max_triangles,
+            std::vector<uint32_t>* out_indices,
+            std::vector<meshlet>* out_meshlets
+            );
+    }
+}
@@ -0,0 +1,252 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/logger.hpp"
+#include "electroslag/mesh/meshlet_builder.hpp"
+#include "electroslag/mesh/meshlet_builder_check.hpp"
+#include "electroslag/renderer/mesh_data_per_pass.hpp"
+
+namespace electroslag {
+    namespace mesh {
+        static glm::f32vec3 get_position(std::vector<float> const& positions, uint32_t vertex)
+        {
+            return (glm::f32vec3(positions[vertex * 3], positions[(vertex * 3) + 1], positions[(vertex * 3) + 2]));
+        }
+
+        // Pack a triangle with its smallest index first, keeping the winding, so the same
+        // triangle compares equal however the builder rotated it.
+        static uint64_t get_triangle_key(uint32_t const* triangle)
+        {
+            int first = 0;
+            if (triangle[1] < triangle[first]) {
+                first = 1;
+            }
+            if (triangle[2] < triangle[first]) {
+                first = 2;
+            }
+
+            uint64_t key = 0;
+            for (int i = 0; i < 3; ++i) {
+                key = (key << 21) | triangle[(first + i) % 3];
+            }
+            return (key);
+        }
+
+        static bool check_meshlet_ranges()
+        {
+            renderer::mesh_data_per_pass::cluster_draw_list cluster_draws;
+            cluster_draws.append_range(6, 0);
+            cluster_draws.append_range(6, 6);
+            cluster_draws.append_range(3, 20);
+            cluster_draws.append_range(3, 23);
+            cluster_draws.append_range(3, 30);
+
+            static int const expected_counts[] = { 12, 6, 3 };
+            static int const expected_offsets[] = { 0, 20, 30 };
+            static int const expected_range_count = 3;
+
+            if (static_cast<int>(cluster_draws.element_counts.size()) != expected_range_count ||
+                static_cast<int>(cluster_draws.index_buffer_start_offsets.size()) != expected_range_count) {
+                ELECTROSLAG_LOG_ERROR("meshlet check - %d draw ranges, expected %d",
+                    static_cast<int>(cluster_draws.element_counts.size()), expected_range_count);
+                return (false);
+            }
+
+            bool passed = true;
+            for (int r = 0; r < expected_range_count; ++r) {
+                if (cluster_draws.element_counts[r] != expected_counts[r] ||
+                    cluster_draws.index_buffer_start_offsets[r] != expected_offsets[r]) {
+                    ELECTROSLAG_LOG_ERROR("meshlet check - draw range %d is %d at %d, expected %d at %d",
+                        r,
+                        cluster_draws.element_counts[r],
+                        cluster_draws.index_buffer_start_offsets[r],
+                        expected_counts[r],
+                        expected_offsets[r]);
+                    passed = false;
+                }
+            }
+            return (passed);
+        }
+
+        bool check_meshlets()
+        {
+            static int const stacks = 12;
+            static int const slices = 24;
+            static int const max_triangles = 32;
+            static int const eye_steps = 9;
+            static float const eye_extent = 3.0f;
+            static float const tolerance = 1e-4f;
+
+            // A unit sphere with a fan at each pole.
+            std::vector<float> positions;
+            positions.reserve((((stacks - 1) * slices) + 2) * 3);
+            positions.emplace_back(0.0f);
+            positions.emplace_back(1.0f);
+            positions.emplace_back(0.0f);
+            for (int r = 1; r < stacks; ++r) {
+                float phi = (glm::pi<float>() * r) / stacks;
+                for (int s = 0; s < slices; ++s) {
+                    float theta = (glm::two_pi<float>() * s) / slices;
+                    positions.emplace_back(std::sin(phi) * std::cos(theta));
+                    positions.emplace_back(std::cos(phi));
+                    positions.emplace_back(std::sin(phi) * std::sin(theta));
+                }
+            }
+            positions.emplace_back(0.0f);
+            positions.emplace_back(-1.0f);
+            positions.emplace_back(0.0f);
+
+            int vertex_count = static_cast<int>(positions.size() / 3);
+            uint32_t north = 0;
+            uint32_t south = static_cast<uint32_t>(vertex_count - 1);
+
+            std::vector<uint32_t> indices;
+            for (int r = 0; r < stacks; ++r) {
+                for (int s = 0; s < slices; ++s) {
+                    int next_s = (s + 1) % slices;
+                    uint32_t upper = static_cast<uint32_t>(1 + ((r - 1) * slices) + s);
+                    uint32_t upper_next = static_cast<uint32_t>(1 + ((r - 1) * slices) + next_s);
+                    uint32_t lower = static_cast<uint32_t>(1 + (r * slices) + s);
+                    uint32_t lower_next = static_cast<uint32_t>(1 + (r * slices) + next_s);
+
+                    if (r == 0) {
+                        indices.insert(indices.end(), { north, lower, lower_next });
+                    }
+                    else if (r == stacks - 1) {
+                        indices.insert(indices.end(), { upper, south, upper_next });
+                    }
+                    else {
+                        indices.insert(indices.end(), { upper, lower, lower_next });
+                        indices.insert(indices.end(), { upper, lower_next, upper_next });
+                    }
+                }
+            }
+
+            // Wind every triangle outward, so back facing means facing the center.
+            int index_count = static_cast<int>(indices.size());
+            for (int i = 0; i < index_count; i += 3) {
+                glm::f32vec3 a(get_position(positions, indices[i]));
+                glm::f32vec3 b(get_position(positions, indices[i + 1]));
+                glm::f32vec3 c(get_position(positions, indices[i + 2]));
+                if (glm::dot(glm::cross(b - a, c - a), a + b + c) < 0.0f) {
+                    std::swap(indices[i + 1], indices[i + 2]);
+                }
+            }
+
+            std::vector<uint32_t> meshlet_indices;
+            std::vector<meshlet> meshlets;
+            build_meshlets(positions.data(), vertex_count, indices.data(), index_count, max_triangles, &meshlet_indices, &meshlets);
+
+            bool passed = true;
+
+            // Every triangle once, with its winding.
+            if (static_cast<int>(meshlet_indices.size()) != index_count) {
+                ELECTROSLAG_LOG_ERROR("meshlet check - %d indices out, expected %d", static_cast<int>(meshlet_indices.size()), index_count);
+                passed = false;
+            }
+            else {
+                std::vector<uint64_t> triangles_in;
+                std::vector<uint64_t> triangles_out;
+                for (int i = 0; i < index_count; i += 3) {
+                    triangles_in.emplace_back(get_triangle_key(&indices[i]));
+                    triangles_out.emplace_back(get_triangle_key(&meshlet_indices[i]));
+                }
+                std::sort(triangles_in.begin(), triangles_in.end());
+                std::sort(triangles_out.begin(), triangles_out.end());
+                if (triangles_in != triangles_out) {
+                    ELECTROSLAG_LOG_ERROR("meshlet check - triangles were lost, repeated or flipped");
+                    passed = false;
+                }
+            }
+
+            // Meshlets tile the output in order and stay under the limit.
+            int next_index = 0;
+            for (meshlet const& m : meshlets) {
+                if (m.first_index != next_index || m.index_count <= 0 || (m.index_count % 3) != 0 ||
+                    m.index_count > max_triangles * 3 || m.first_index + m.index_count > static_cast<int>(meshlet_indices.size())) {
+                    ELECTROSLAG_LOG_ERROR("meshlet check - meshlet has %d indices at %d, expected at most %d at %d",
+                        m.index_count, m.first_index, max_triangles * 3, next_index);
+                    return (false);
+                }
+                next_index += m.index_count;
+            }
+            if (next_index != static_cast<int>(meshlet_indices.size())) {
+                ELECTROSLAG_LOG_ERROR("meshlet check - meshlets cover %d indices, expected %d",
+                    next_index, static_cast<int>(meshlet_indices.size()));
+                return (false);
+            }
+
+            // Bounding spheres hold their vertices.
+            for (meshlet const& m : meshlets) {
+                for (int i = m.first_index; i < m.first_index + m.index_count; ++i) {
+                    glm::f32vec3 p(get_position(positions, meshlet_indices[i]));
+                    if (glm::length(p - m.center) > (m.radius * (1.0f + tolerance)) + tolerance) {
+                        ELECTROSLAG_LOG_ERROR("meshlet check - vertex %u is outside its meshlet's bounds", meshlet_indices[i]);
+                        passed = false;
+                        break;
+                    }
+                }
+            }
+
+            // A meshlet culled from an eye may have no triangle facing that eye. Eyes are
+            // spread through a box around the sphere, inside it too.
+            int culled_count = 0;
+            for (int x = 0; x < eye_steps; ++x) {
+                for (int y = 0; y < eye_steps; ++y) {
+                    for (int z = 0; z < eye_steps; ++z) {
+                        glm::f32vec3 eye(
+                            -eye_extent + ((2.0f * eye_extent * x) / (eye_steps - 1)),
+                            -eye_extent + ((2.0f * eye_extent * y) / (eye_steps - 1)),
+                            -eye_extent + ((2.0f * eye_extent * z) / (eye_steps - 1))
+                            );
+
+                        for (meshlet const& m : meshlets) {
+                            glm::f32vec3 eye_to_center(m.center - eye);
+                            if (glm::dot(eye_to_center, m.cone_axis) < (m.cone_cutoff * glm::length(eye_to_center)) + m.radius) {
+                                continue;
+                            }
+                            ++culled_count;
+
+                            for (int i = m.first_index; i < m.first_index + m.index_count; i += 3) {
+                                glm::f32vec3 a(get_position(positions, meshlet_indices[i]));
+                                glm::f32vec3 b(get_position(positions, meshlet_indices[i + 1]));
+                                glm::f32vec3 c(get_position(positions, meshlet_indices[i + 2]));
+                                glm::f32vec3 normal(glm::cross(b - a, c - a));
+                                glm::f32vec3 eye_to_a(a - eye);
+                                if (glm::dot(normal, eye_to_a) < -tolerance * glm::length(normal) * glm::length(eye_to_a)) {
+                                    ELECTROSLAG_LOG_ERROR("meshlet check - meshlet at %d culled with a triangle facing the eye", m.first_index);
+                                    passed = false;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Cones that never cull would pass the above without testing anything.
+            if (culled_count == 0) {
+                ELECTROSLAG_LOG_ERROR("meshlet check - no meshlet was ever culled");
+                passed = false;
+            }
+
+            passed = check_meshlet_ranges() && passed;
+
+            ELECTROSLAG_LOG_MESSAGE("meshlet check - %s", passed ? "passed" : "FAILED");
+            return (passed);
+        }
+    }
+}
@@ -0,0 +1,31 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+
+#if defined(ELECTROSLAG_BUILD_SHIP)
+#error meshlet building checks not to be included in SHIP build!
+#endif
+
+namespace electroslag {
+    namespace mesh {
+        // Splits a sphere in to meshlets and checks that every triangle is kept once,
+        // no meshlet is over its limit, bounds hold every vertex and no eye position
+        // culls a meshlet that has a triangle facing it. Also checks that the ranges
+        // of surviving meshlets merge when they touch. Logs each failure; returns false
+        // if there were any.
+        bool check_meshlets();
+    }
+}
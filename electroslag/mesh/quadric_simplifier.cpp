@@ -0,0 +1,348 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/mesh/quadric_simplifier.hpp"
+
+namespace electroslag {
+    namespace mesh {
+        void quadric_simplifier::quadric::add_plane(glm::f64vec3 const& normal, double d)
+        {
+            q[0] += normal.x * normal.x;
+            q[1] += normal.x * normal.y;
+            q[2] += normal.x * normal.z;
+            q[3] += normal.x * d;
+            q[4] += normal.y * normal.y;
+            q[5] += normal.y * normal.z;
+            q[6] += normal.y * d;
+            q[7] += normal.z * normal.z;
+            q[8] += normal.z * d;
+            q[9] += d * d;
+        }
+
+        void quadric_simplifier::quadric::add(quadric const& other)
+        {
+            for (int i = 0; i < _countof(q); ++i) {
+                q[i] += other.q[i];
+            }
+        }
+
+        double quadric_simplifier::quadric::evaluate(glm::f64vec3 const& p) const
+        {
+            // p' * Q * p, with p = (x, y, z, 1)
+            double e =
+                (q[0] * p.x * p.x) + (2.0 * q[1] * p.x * p.y) + (2.0 * q[2] * p.x * p.z) + (2.0 * q[3] * p.x) +
+                (q[4] * p.y * p.y) + (2.0 * q[5] * p.y * p.z) + (2.0 * q[6] * p.y) +
+                (q[7] * p.z * p.z) + (2.0 * q[8] * p.z) +
+                q[9];
+            return (max(e, 0.0));
+        }
+
+        quadric_simplifier::quadric_simplifier(
+            float const* positions,
+            int vertex_count,
+            uint32_t const* indices,
+            int index_count
+            )
+            : m_live_triangles(0)
+            , m_max_cost(0.0)
+        {
+            if (!positions || vertex_count <= 0) {
+                throw parameter_failure("positions");
+            }
+
+            if (!indices || index_count % 3) {
+                throw parameter_failure("indices");
+            }
+
+            m_positions.reserve(vertex_count);
+            for (int v = 0; v < vertex_count; ++v) {
+                m_positions.emplace_back(positions[v * 3], positions[(v * 3) + 1], positions[(v * 3) + 2]);
+            }
+            m_quadrics.resize(vertex_count);
+            m_vertex_version.resize(vertex_count, 0);
+            m_vertex_triangles.resize(vertex_count);
+
+            m_triangles.assign(indices, indices + index_count);
+            int triangle_count = index_count / 3;
+            m_triangle_live.resize(triangle_count, 0);
+
+            // Edges used by only one triangle are on a boundary; key is (low << 32) | high.
+            typedef std::unordered_map<unsigned long long, int, prehashed_key<unsigned long long> > edge_count_map;
+            edge_count_map edge_counts;
+
+            for (int t = 0; t < triangle_count; ++t) {
+                uint32_t const* tri = &m_triangles[t * 3];
+                uint32_t vertex_limit = static_cast<uint32_t>(vertex_count);
+                if (tri[0] >= vertex_limit || tri[1] >= vertex_limit || tri[2] >= vertex_limit) {
+                    throw parameter_failure("index out of range");
+                }
+
+                // Degenerate triangles are dropped up front.
+                glm::f64vec3 normal(glm::cross(m_positions[tri[1]] - m_positions[tri[0]], m_positions[tri[2]] - m_positions[tri[0]]));
+                double length = glm::length(normal);
+                if (length <= 0.0) {
+                    continue;
+                }
+                normal /= length;
+
+                quadric plane;
+                plane.add_plane(normal, -glm::dot(normal, m_positions[tri[0]]));
+                for (int i = 0; i < 3; ++i) {
+                    m_quadrics[tri[i]].add(plane);
+                    m_vertex_triangles[tri[i]].emplace_back(t);
+
+                    unsigned long long a = tri[i];
+                    unsigned long long b = tri[(i + 1) % 3];
+                    edge_counts[(min(a, b) << 32) | max(a, b)]++;
+                }
+
+                m_triangle_live[t] = 1;
+                ++m_live_triangles;
+            }
+
+            // Boundary edges get a plane through the edge, perpendicular to the surface, so
+            // open borders and material seams keep their shape.
+            for (int t = 0; t < triangle_count; ++t) {
+                if (!m_triangle_live[t]) {
+                    continue;
+                }
+
+                uint32_t const* tri = &m_triangles[t * 3];
+                glm::f64vec3 normal(glm::normalize(glm::cross(
+                    m_positions[tri[1]] - m_positions[tri[0]],
+                    m_positions[tri[2]] - m_positions[tri[0]]
+                    )));
+
+                for (int i = 0; i < 3; ++i) {
+                    unsigned long long a = tri[i];
+                    unsigned long long b = tri[(i + 1) % 3];
+                    if (edge_counts[(min(a, b) << 32) | max(a, b)] != 1) {
+                        continue;
+                    }
+
+                    glm::f64vec3 edge(m_positions[b] - m_positions[a]);
+                    glm::f64vec3 border_normal(glm::cross(edge, normal));
+                    double length = glm::length(border_normal);
+                    if (length <= 0.0) {
+                        continue;
+                    }
+                    border_normal /= length;
+
+                    quadric border;
+                    border.add_plane(border_normal, -glm::dot(border_normal, m_positions[a]));
+                    m_quadrics[a].add(border);
+                    m_quadrics[b].add(border);
+                }
+            }
+
+            for (int t = 0; t < triangle_count; ++t) {
+                if (m_triangle_live[t]) {
+                    uint32_t const* tri = &m_triangles[t * 3];
+                    for (int i = 0; i < 3; ++i) {
+                        push_collapse(tri[i], tri[(i + 1) % 3]);
+                        push_collapse(tri[(i + 1) % 3], tri[i]);
+                    }
+                }
+            }
+        }
+
+        float quadric_simplifier::simplify(int target_index_count, float max_error)
+        {
+            double max_cost = static_cast<double>(max_error) * max_error;
+
+            while (get_index_count() > target_index_count && !m_collapses.empty()) {
+                collapse const& c = m_collapses.top();
+                if (c.cost > max_cost) {
+                    // Leave it queued; a later call may allow more error.
+                    break;
+                }
+
+                collapse this_collapse(c);
+                m_collapses.pop();
+
+                // Entries go stale whenever either end has changed since they were queued.
+                if (this_collapse.from_version != m_vertex_version[this_collapse.from] ||
+                    this_collapse.to_version != m_vertex_version[this_collapse.to]) {
+                    continue;
+                }
+
+                if (collapse_flips_triangles(this_collapse.from, this_collapse.to)) {
+                    continue;
+                }
+
+                apply_collapse(this_collapse);
+            }
+
+            return (static_cast<float>(std::sqrt(m_max_cost)));
+        }
+
+        void quadric_simplifier::get_indices(std::vector<uint32_t>* out_indices) const
+        {
+            out_indices->clear();
+            out_indices->reserve(get_index_count());
+
+            int triangle_count = static_cast<int>(m_triangle_live.size());
+            for (int t = 0; t < triangle_count; ++t) {
+                if (m_triangle_live[t]) {
+                    out_indices->insert(out_indices->end(), &m_triangles[t * 3], &m_triangles[t * 3] + 3);
+                }
+            }
+        }
+
+        void quadric_simplifier::push_collapse(int from, int to)
+        {
+            quadric combined(m_quadrics[from]);
+            combined.add(m_quadrics[to]);
+
+            collapse c;
+            c.cost = combined.evaluate(m_positions[to]);
+            c.from = from;
+            c.to = to;
+            c.from_version = m_vertex_version[from];
+            c.to_version = m_vertex_version[to];
+            m_collapses.push(c);
+        }
+
+        bool quadric_simplifier::collapse_flips_triangles(int from, int to) const
+        {
+            uint32_t from_index = static_cast<uint32_t>(from);
+            uint32_t to_index = static_cast<uint32_t>(to);
+            bool shares_edge = false;
+
+            std::vector<int>::const_iterator t(m_vertex_triangles[from].begin());
+            while (t != m_vertex_triangles[from].end()) {
+                if (m_triangle_live[*t]) {
+                    uint32_t const* tri = &m_triangles[*t * 3];
+                    if (tri[0] == to_index || tri[1] == to_index || tri[2] == to_index) {
+                        // This triangle disappears with the collapse.
+                        shares_edge = true;
+                    }
+                    else {
+                        glm::f64vec3 p[3];
+                        glm::f64vec3 moved[3];
+                        for (int i = 0; i < 3; ++i) {
+                            p[i] = m_positions[tri[i]];
+                            moved[i] = (tri[i] == from_index) ? m_positions[to] : p[i];
+                        }
+
+                        glm::f64vec3 before(glm::cross(p[1] - p[0], p[2] - p[0]));
+                        glm::f64vec3 after(glm::cross(moved[1] - moved[0], moved[2] - moved[0]));
+                        if (glm::dot(before, after) <= 0.0) {
+                            return (true);
+                        }
+                    }
+                }
+                ++t;
+            }
+
+            // Vertices that no longer share a triangle can't be collapsed together.
+            return (!shares_edge);
+        }
+
+        void quadric_simplifier::apply_collapse(collapse const& c)
+        {
+            uint32_t from_index = static_cast<uint32_t>(c.from);
+            uint32_t to_index = static_cast<uint32_t>(c.to);
+            std::vector<int>& from_triangles = m_vertex_triangles[c.from];
+            std::vector<int>& to_triangles = m_vertex_triangles[c.to];
+
+            std::vector<int>::const_iterator t(from_triangles.begin());
+            while (t != from_triangles.end()) {
+                if (m_triangle_live[*t]) {
+                    uint32_t* tri = &m_triangles[*t * 3];
+                    if (tri[0] == to_index || tri[1] == to_index || tri[2] == to_index) {
+                        m_triangle_live[*t] = 0;
+                        --m_live_triangles;
+                    }
+                    else {
+                        for (int i = 0; i < 3; ++i) {
+                            if (tri[i] == from_index) {
+                                tri[i] = to_index;
+                            }
+                        }
+                        to_triangles.emplace_back(*t);
+                    }
+                }
+                ++t;
+            }
+            from_triangles.clear();
+
+            m_quadrics[c.to].add(m_quadrics[c.from]);
+            m_max_cost = max(m_max_cost, c.cost);
+
+            // Invalidate every queued collapse touching either vertex.
+            ++m_vertex_version[c.from];
+            ++m_vertex_version[c.to];
+
+            // Reverse iteration allows us to erase from the vector sanely.
+            for (int i = static_cast<int>(to_triangles.size()) - 1; i >= 0; --i) {
+                if (!m_triangle_live[to_triangles[i]]) {
+                    to_triangles.erase(to_triangles.begin() + i);
+                }
+            }
+
+            t = to_triangles.begin();
+            while (t != to_triangles.end()) {
+                uint32_t const* tri = &m_triangles[*t * 3];
+                for (int i = 0; i < 3; ++i) {
+                    if (tri[i] != to_index) {
+                        push_collapse(c.to, tri[i]);
+                        push_collapse(tri[i], c.to);
+                    }
+                }
+                ++t;
+            }
+        }
+
+        void build_lod_chain(
+            float const* positions,
+            int vertex_count,
+            uint32_t const* indices,
+            int index_count,
+            int max_levels,
+            std::vector<simplified_lod>* out_lods
+            )
+        {
+            out_lods->clear();
+
+            // Each level continues simplifying where the previous one stopped.
+            quadric_simplifier simplifier(positions, vertex_count, indices, index_count);
+            int previous_index_count = index_count;
+
+            for (int l = 0; l < max_levels; ++l) {
+                int target_index_count = ((previous_index_count / 3) / 2) * 3;
+                if (target_index_count <= 0) {
+                    break;
+                }
+
+                float error = simplifier.simplify(target_index_count, std::numeric_limits<float>::max());
+
+                // Stop when a level would save less than a quarter of the triangles.
+                int level_index_count = simplifier.get_index_count();
+                if (level_index_count <= 0 || level_index_count > (previous_index_count * 3) / 4) {
+                    break;
+                }
+
+                out_lods->emplace_back();
+                simplified_lod& lod = out_lods->back();
+                simplifier.get_indices(&lod.indices);
+                lod.geometric_error = error;
+
+                previous_index_count = level_index_count;
+            }
+        }
+    }
+}
@@ -0,0 +1,117 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+
+#if defined(ELECTROSLAG_BUILD_SHIP)
+#error mesh simplification not to be included in SHIP build!
+#endif
+
+namespace electroslag {
+    namespace mesh {
+        // Quadric error metric simplification by half edge collapse. A vertex is only ever
+        // merged in to one of its neighbors, so every level of detail produced indexes the
+        // original vertices and can share their vertex buffer. Errors are in the same units
+        // as the positions.
+        class quadric_simplifier {
+        public:
+            // Positions are three floats per vertex; indices form a triangle list.
+            quadric_simplifier(
+                float const* positions,
+                int vertex_count,
+                uint32_t const* indices,
+                int index_count
+                );
+
+            // Collapse edges until no more than target_index_count indices remain, or until
+            // the cheapest collapse would introduce more than max_error. Each call carries on
+            // from the last. Returns the largest error introduced so far.
+            float simplify(int target_index_count, float max_error);
+
+            int get_index_count() const
+            {
+                return (m_live_triangles * 3);
+            }
+
+            void get_indices(std::vector<uint32_t>* out_indices) const;
+
+        private:
+            // Symmetric 4x4 matrix measuring summed squared distance to a set of planes.
+            struct quadric {
+                quadric()
+                {
+                    memset(q, 0, sizeof(q));
+                }
+
+                void add_plane(glm::f64vec3 const& normal, double d);
+                void add(quadric const& other);
+                double evaluate(glm::f64vec3 const& p) const;
+
+                // a2, ab, ac, ad, b2, bc, bd, c2, cd, d2
+                double q[10];
+            };
+
+            struct collapse {
+                bool operator >(collapse const& compare_with) const
+                {
+                    return (cost > compare_with.cost);
+                }
+
+                double cost;
+                int from;
+                int to;
+                int from_version;
+                int to_version;
+            };
+
+            void push_collapse(int from, int to);
+            bool collapse_flips_triangles(int from, int to) const;
+            void apply_collapse(collapse const& c);
+
+            std::vector<glm::f64vec3> m_positions;
+            std::vector<quadric> m_quadrics;
+            std::vector<int> m_vertex_version;
+            std::vector<std::vector<int> > m_vertex_triangles;
+
+            std::vector<uint32_t> m_triangles;
+            std::vector<byte> m_triangle_live;
+            int m_live_triangles;
+
+            std::priority_queue<collapse, std::vector<collapse>, std::greater<collapse> > m_collapses;
+            double m_max_cost;
+
+            // Disallowed operations:
+            quadric_simplifier();
+            explicit quadric_simplifier(quadric_simplifier const&);
+            quadric_simplifier& operator =(quadric_simplifier const&);
+        };
+
+        struct simplified_lod {
+            std::vector<uint32_t> indices;
+            float geometric_error;
+        };
+
+        // Build up to max_levels coarser levels, each aiming for half the triangles of the
+        // one before. The chain ends early once simplification stops making progress.
+        void build_lod_chain(
+            float const* positions,
+            int vertex_count,
+            uint32_t const* indices,
+            int index_count,
+            int max_levels,
+            std::vector<simplified_lod>* out_lods
+            );
+    }
+}
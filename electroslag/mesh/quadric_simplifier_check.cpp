@@ -0,0 +1,128 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/logger.hpp"
+#include "electroslag/mesh/quadric_simplifier.hpp"
+#include "electroslag/mesh/quadric_simplifier_check.hpp"
+
+namespace electroslag {
+    namespace mesh {
+        bool check_lod_chain()
+        {
+            static int const grid_size = 33;
+            static int const max_levels = 6;
+            static int const min_levels = 4;
+
+            // A single bump over a unit square; flat regions would simplify for free and
+            // never show the error growing.
+            std::vector<float> positions;
+            positions.reserve(grid_size * grid_size * 3);
+            for (int y = 0; y < grid_size; ++y) {
+                for (int x = 0; x < grid_size; ++x) {
+                    float u = static_cast<float>(x) / (grid_size - 1);
+                    float v = static_cast<float>(y) / (grid_size - 1);
+                    positions.emplace_back(u);
+                    positions.emplace_back(v);
+                    positions.emplace_back(0.25f * std::sin(u * glm::pi<float>()) * std::sin(v * glm::pi<float>()));
+                }
+            }
+
+            std::vector<uint32_t> indices;
+            indices.reserve((grid_size - 1) * (grid_size - 1) * 6);
+            for (int y = 0; y < grid_size - 1; ++y) {
+                for (int x = 0; x < grid_size - 1; ++x) {
+                    uint32_t corner = static_cast<uint32_t>((y * grid_size) + x);
+                    indices.emplace_back(corner);
+                    indices.emplace_back(corner + 1);
+                    indices.emplace_back(corner + grid_size + 1);
+                    indices.emplace_back(corner);
+                    indices.emplace_back(corner + grid_size + 1);
+                    indices.emplace_back(corner + grid_size);
+                }
+            }
+
+            int vertex_count = grid_size * grid_size;
+            int index_count = static_cast<int>(indices.size());
+
+            std::vector<simplified_lod> lods;
+            build_lod_chain(positions.data(), vertex_count, indices.data(), index_count, max_levels, &lods);
+
+            bool passed = true;
+            int level_count = static_cast<int>(lods.size());
+            if (level_count < min_levels || level_count > max_levels) {
+                ELECTROSLAG_LOG_ERROR("lod chain check - %d levels, expected %d to %d", level_count, min_levels, max_levels);
+                passed = false;
+            }
+
+            int previous_triangles = index_count / 3;
+            float previous_error = 0.0f;
+            for (int l = 0; l < level_count; ++l) {
+                simplified_lod const& lod = lods[l];
+                int level_index_count = static_cast<int>(lod.indices.size());
+                int triangles = level_index_count / 3;
+
+                // Each level aims for half the triangles; one collapse removes at most two
+                // triangles, so it may undershoot by a little but never overshoot.
+                int target_triangles = previous_triangles / 2;
+                if ((level_index_count % 3) != 0 || triangles > target_triangles || triangles < target_triangles - 2) {
+                    ELECTROSLAG_LOG_ERROR(
+                        "lod chain check - level %d has %d triangles, expected half of %d",
+                        l + 1,
+                        triangles,
+                        previous_triangles
+                        );
+                    passed = false;
+                }
+
+                if (!(lod.geometric_error >= previous_error)) {
+                    ELECTROSLAG_LOG_ERROR(
+                        "lod chain check - level %d error %g is less than the level before's %g",
+                        l + 1,
+                        static_cast<double>(lod.geometric_error),
+                        static_cast<double>(previous_error)
+                        );
+                    passed = false;
+                }
+
+                for (int t = 0; t + 2 < level_index_count; t += 3) {
+                    uint32_t a = lod.indices[t];
+                    uint32_t b = lod.indices[t + 1];
+                    uint32_t c = lod.indices[t + 2];
+                    if (a >= static_cast<uint32_t>(vertex_count) ||
+                        b >= static_cast<uint32_t>(vertex_count) ||
+                        c >= static_cast<uint32_t>(vertex_count) ||
+                        a == b || b == c || a == c) {
+                        ELECTROSLAG_LOG_ERROR("lod chain check - level %d triangle %d is not valid", l + 1, t / 3);
+                        passed = false;
+                        break;
+                    }
+                }
+
+                previous_triangles = triangles;
+                previous_error = lod.geometric_error;
+            }
+
+            // The bump can't be flattened for free.
+            if (level_count > 0 && !(previous_error > 0.0f)) {
+                ELECTROSLAG_LOG_ERROR("lod chain check - coarsest level reports no error");
+                passed = false;
+            }
+
+            ELECTROSLAG_LOG_MESSAGE("lod chain check - %s", passed ? "passed" : "FAILED");
+            return (passed);
+        }
+    }
+}
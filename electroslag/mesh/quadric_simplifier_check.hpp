@@ -0,0 +1,29 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+
+#if defined(ELECTROSLAG_BUILD_SHIP)
+#error mesh simplification checks not to be included in SHIP build!
+#endif
+
+namespace electroslag {
+    namespace mesh {
+        // Builds a level of detail chain for a curved grid and checks that every level
+        // indexes valid vertices, halves the triangles of the level before it and reports
+        // no less error. Logs each failure; returns false if there were any.
+        bool check_lod_chain();
+    }
+}
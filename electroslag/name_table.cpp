@@ -25,22 +25,215 @@ namespace electroslag {
         return (get_systems()->get_name_table());
     }
 
+    name_table::name_table()
+        : m_index(0)
+        , m_arena_cursor(0)
+        , m_arena_remaining(0)
+        , m_insert_mutex()
+    {
+        m_index.store(create_index(initial_index_capacity, 0), std::memory_order_release);
+    }
+
+    name_table::~name_table()
+    {
+        name_index* index = m_index.load(std::memory_order_acquire);
+        while (index) {
+            name_index* previous = index->previous;
+            delete[] index->slots;
+            delete index;
+            index = previous;
+        }
+        m_index.store(0, std::memory_order_relaxed);
+
+        arena_block_vector::iterator b(m_arena_blocks.begin());
+        while (b != m_arena_blocks.end()) {
+            delete[] *b;
+            ++b;
+        }
+        m_arena_blocks.clear();
+    }
+
+    void name_table::insert(std::string const& name, unsigned long long name_hash)
+    {
+        if (!name_hash) {
+            return;
+        }
+
+        // Usually the name is already interned and only its count changes.
+        name_entry* entry = locate_entry(name_hash);
+        if (!entry) {
+            threading::lock_guard insert_lock(&m_insert_mutex);
+
+            // Another thread may have interned it while this one waited.
+            entry = locate_entry(name_hash);
+            if (!entry) {
+                entry = allocate_entry(name, name_hash);
+
+                name_index* index = m_index.load(std::memory_order_relaxed);
+                if ((index->used + 1) * 4 > index->capacity * 3) {
+                    grow_index();
+                    index = m_index.load(std::memory_order_relaxed);
+                }
+                add_to_index(index, entry);
+                return;
+            }
+        }
+
+        entry->count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void name_table::remove(unsigned long long name_hash)
+    {
+        name_entry* entry = locate_entry(name_hash);
+        if (entry) {
+            int count = entry->count.load(std::memory_order_relaxed);
+            while (count > 0 && !entry->count.compare_exchange_weak(count, count - 1, std::memory_order_relaxed)) {}
+        }
+    }
+
+    interned_name name_table::lookup(unsigned long long name_hash) const
+    {
+        interned_name name;
+        if (!locate(name_hash, &name)) {
+            throw std::out_of_range("name_table::lookup");
+        }
+        return (name);
+    }
+
+    bool name_table::locate(unsigned long long name_hash, interned_name* out_name) const
+    {
+        name_entry const* entry = locate_entry(name_hash);
+        if (entry && entry->count.load(std::memory_order_relaxed) > 0) {
+            if (out_name) {
+                *out_name = interned_name(entry->get_string(), entry->length);
+            }
+            return (true);
+        }
+        else {
+            return (false);
+        }
+    }
+
+    void name_table::duplicate(unsigned long long name_hash)
+    {
+        // Only names that are still present can be duplicated.
+        name_entry* entry = locate_entry(name_hash);
+        if (entry) {
+            int count = entry->count.load(std::memory_order_relaxed);
+            while (count > 0 && !entry->count.compare_exchange_weak(count, count + 1, std::memory_order_relaxed)) {}
+        }
+    }
+
+    name_table::name_entry* name_table::locate_entry(unsigned long long name_hash) const
+    {
+        if (!name_hash) {
+            return (0);
+        }
+
+        name_index const* index = m_index.load(std::memory_order_acquire);
+        unsigned int mask = index->capacity - 1;
+        unsigned int s = static_cast<unsigned int>(name_hash) & mask;
+        for (;;) {
+            index_slot const* slot = &index->slots[s];
+            unsigned long long slot_hash = slot->hash.load(std::memory_order_acquire);
+            if (slot_hash == name_hash) {
+                return (slot->entry.load(std::memory_order_relaxed));
+            }
+            else if (!slot_hash) {
+                return (0);
+            }
+            s = (s + 1) & mask;
+        }
+    }
+
+    name_table::name_entry* name_table::allocate_entry(std::string const& name, unsigned long long name_hash)
+    {
+        // Assume the m_insert_mutex is being held.
+        unsigned int entry_size = align_up(
+            static_cast<unsigned int>(sizeof(name_entry) + name.length() + 1),
+            static_cast<unsigned int>(alignof(name_entry))
+            );
+
+        if (entry_size > m_arena_remaining) {
+            unsigned int block_size = (entry_size > arena_block_size) ? entry_size : arena_block_size;
+            m_arena_cursor = new byte[block_size];
+            m_arena_remaining = block_size;
+            m_arena_blocks.emplace_back(m_arena_cursor);
+        }
+
+        name_entry* entry = new (m_arena_cursor) name_entry();
+        entry->hash = name_hash;
+        entry->count.store(1, std::memory_order_relaxed);
+        entry->length = static_cast<int>(name.length());
+        memcpy(const_cast<char*>(entry->get_string()), name.c_str(), name.length() + 1);
+
+        m_arena_cursor += entry_size;
+        m_arena_remaining -= entry_size;
+        return (entry);
+    }
+
+    void name_table::add_to_index(name_index* index, name_entry* entry)
+    {
+        // Assume the m_insert_mutex is being held.
+        unsigned int mask = index->capacity - 1;
+        unsigned int s = static_cast<unsigned int>(entry->hash) & mask;
+        while (index->slots[s].hash.load(std::memory_order_relaxed)) {
+            s = (s + 1) & mask;
+        }
+
+        index->slots[s].entry.store(entry, std::memory_order_relaxed);
+        index->slots[s].hash.store(entry->hash, std::memory_order_release);
+        index->used++;
+    }
+
+    name_table::name_index* name_table::create_index(unsigned int capacity, name_index* previous)
+    {
+        name_index* index = new name_index();
+        index->previous = previous;
+        index->capacity = capacity;
+        index->used = 0;
+        index->slots = new index_slot[capacity];
+        for (unsigned int s = 0; s < capacity; ++s) {
+            index->slots[s].hash.store(0, std::memory_order_relaxed);
+            index->slots[s].entry.store(0, std::memory_order_relaxed);
+        }
+        return (index);
+    }
+
+    void name_table::grow_index()
+    {
+        // Assume the m_insert_mutex is being held.
+        name_index* old_index = m_index.load(std::memory_order_relaxed);
+        name_index* new_index = create_index(old_index->capacity * 2, old_index);
+
+        for (unsigned int s = 0; s < old_index->capacity; ++s) {
+            name_entry* entry = old_index->slots[s].entry.load(std::memory_order_relaxed);
+            if (entry) {
+                add_to_index(new_index, entry);
+            }
+        }
+
+        m_index.store(new_index, std::memory_order_release);
+    }
+
 #if !defined(ELECTROSLAG_BUILD_SHIP)
     void name_table::dump()
     {
-        threading::lock_guard name_table_lock(&m_mutex);
+        threading::lock_guard insert_lock(&m_insert_mutex);
         ELECTROSLAG_LOG_MESSAGE("Name Table Dump");
         ELECTROSLAG_LOG_MESSAGE("Hash               | Count  | String");
         ELECTROSLAG_LOG_MESSAGE("-------------------|--------|-----------------------------------------------");
-        const_name_iterator i(m_string_map.begin());
-        while (i != m_string_map.end()) {
-            ELECTROSLAG_LOG_MESSAGE(
-                "0x%016llX |%8d| %s",
-                i->first,
-                i->second.count,
-                i->second.str.c_str()
-                );
-            ++i;
+        name_index const* index = m_index.load(std::memory_order_acquire);
+        for (unsigned int s = 0; s < index->capacity; ++s) {
+            name_entry const* entry = index->slots[s].entry.load(std::memory_order_relaxed);
+            if (entry && entry->count.load(std::memory_order_relaxed) > 0) {
+                ELECTROSLAG_LOG_MESSAGE(
+                    "0x%016llX |%8d| %s",
+                    entry->hash,
+                    entry->count.load(std::memory_order_relaxed),
+                    entry->get_string()
+                    );
+            }
         }
     }
 #endif
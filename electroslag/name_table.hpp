@@ -14,106 +14,101 @@
 //  limitations under the License.
 
 #pragma once
+#include "electroslag/interned_name.hpp"
 #include "electroslag/threading/mutex.hpp"
 
 namespace electroslag {
+    // Maps name hashes back to strings. Lookups, reference counting and inserts
+    // of names already present never lock; only interning a new string takes the
+    // insert mutex. Entries are never freed before the table is, and a name whose
+    // count drops to zero is simply reported as absent until it is inserted again.
     class name_table {
     public:
-        // An ugly call sequence: this constructor results in the mutex being
-        // locked before it's fully constructed and the string map inserted
-        // before the name_table is fully constructed. It works, but might be
-        // brittle due to reliance on member initialization order.
-        name_table()
-            : m_string_map()
-            , m_mutex(ELECTROSLAG_STRING_AND_HASH("m:name_table"))
-        {}
-
-        ~name_table()
-        {
-            // The same ugly call sequence above means that the mutex might
-            // be entered after it's destroyed. Clear the name to make sure that
-            // doesn't happen.
-            m_mutex.clear_name();
-        }
+        name_table();
+        ~name_table();
 
         void insert(std::string const& name)
         {
             insert(name, hash_string_runtime(name.c_str()));
         }
 
-        void insert(std::string const& name, unsigned long long name_hash)
-        {
-            threading::lock_guard name_table_lock(&m_mutex);
-
-            name_iterator in_map(m_string_map.find(name_hash));
-            if (in_map == m_string_map.end()) {
-                name_entry n;
-                n.str = name;
-                n.count = 1;
-                m_string_map.insert(std::make_pair(name_hash, n));
-            }
-            else {
-                in_map->second.count += 1;
-            }
-        }
+        void insert(std::string const& name, unsigned long long name_hash);
 
-        void remove(unsigned long long name_hash)
-        {
-            threading::lock_guard name_table_lock(&m_mutex);
-            name_iterator in_map(m_string_map.find(name_hash));
-            if (in_map != m_string_map.end()) {
-                if (in_map->second.count == 1) {
-                    m_string_map.erase(in_map);
-                }
-                else {
-                    in_map->second.count -= 1;
-                }
-            }
-        }
+        void remove(unsigned long long name_hash);
 
-        bool contains(unsigned long long name_hash)
+        bool contains(unsigned long long name_hash) const
         {
-            threading::lock_guard name_table_lock(&m_mutex);
-            return (m_string_map.count(name_hash) == 1);
+            return (locate(name_hash, 0));
         }
 
-        std::string lookup(unsigned long long name_hash)
-        {
-            threading::lock_guard name_table_lock(&m_mutex);
-            return (m_string_map.at(name_hash).str);
-        }
+        // Throws if the name is not present.
+        interned_name lookup(unsigned long long name_hash) const;
 
-        void duplicate(unsigned long long name_hash)
-        {
-            threading::lock_guard name_table_lock(&m_mutex);
-            name_iterator in_map(m_string_map.find(name_hash));
-            if (in_map != m_string_map.end()) {
-                in_map->second.count += 1;
-            }
-        }
+        // Returns false if the name is not present.
+        bool locate(unsigned long long name_hash, interned_name* out_name) const;
+
+        void duplicate(unsigned long long name_hash);
 
 #if !defined(ELECTROSLAG_BUILD_SHIP)
         void dump();
 #endif
 
     private:
+        // Entries are carved from the arena; the NUL terminated string follows.
         struct name_entry {
-            std::string str;
-            int count;
+            char const* get_string() const
+            {
+                return (reinterpret_cast<char const*>(this + 1));
+            }
+
+            unsigned long long hash;
+            std::atomic<int> count;
+            int length;
+        };
+
+        // Open addressed with linear probing, keyed by the (already FNV) hash.
+        // A hash of zero marks an empty slot; named_object uses it to mean "no name".
+        // A slot's entry is written before its hash is published.
+        struct index_slot {
+            std::atomic<unsigned long long> hash;
+            std::atomic<name_entry*> entry;
         };
 
-        typedef std::unordered_map<
-            unsigned long long,
-            name_entry,
-            prehashed_key<unsigned long long>,
-            std::equal_to<unsigned long long>
-        > string_map;
-        typedef string_map::const_iterator const_name_iterator;
-        typedef string_map::iterator name_iterator;
+        // Growing publishes a new index; older ones stay alive for readers still
+        // probing them and are freed with the table.
+        struct name_index {
+            name_index* previous;
+            unsigned int capacity;
+            unsigned int used;
+            index_slot* slots;
+        };
+
+        static unsigned int const initial_index_capacity = 1024;
+        static unsigned int const arena_block_size = 64 * 1024;
+
+        name_entry* locate_entry(unsigned long long name_hash) const;
+
+        // These require the m_insert_mutex to be held.
+        name_entry* allocate_entry(std::string const& name, unsigned long long name_hash);
+        void add_to_index(name_index* index, name_entry* entry);
+        name_index* create_index(unsigned int capacity, name_index* previous);
+        void grow_index();
+
+        std::atomic<name_index*> m_index;
+
+        // Protected by m_insert_mutex.
+        typedef std::vector<byte*> arena_block_vector;
+        arena_block_vector m_arena_blocks;
+        byte* m_arena_cursor;
+        unsigned int m_arena_remaining;
 
-        string_map m_string_map;
+        // Left unnamed: naming it would insert into this table while it is
+        // still being constructed.
+        threading::mutex m_insert_mutex;
 
-        mutable threading::mutex m_mutex;
+        // Disallowed operations:
+        explicit name_table(name_table const&);
+        name_table& operator =(name_table const&);
     };
 
     name_table* get_name_table();
@@ -41,7 +41,7 @@ namespace electroslag {
         clear_name();
     }
 
-    std::string named_object::get_name() const
+    interned_name named_object::get_name() const
     {
         return (get_name_table()->lookup(m_hash));
     }
@@ -14,13 +14,15 @@
 //  limitations under the License.
 
 #pragma once
+#include "electroslag/interned_name.hpp"
 
 namespace electroslag {
     class named_object {
     public:
         virtual ~named_object();
 
-        std::string get_name() const;
+        // The string stays in the name table, so this doesn't allocate.
+        interned_name get_name() const;
 
         void set_name(std::string const& name);
 
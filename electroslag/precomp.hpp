@@ -93,6 +93,8 @@
 #include <forward_list>
 #include <unordered_map>
 #include <deque>
+#include <queue>
+#include <functional>
 #include <filesystem>
 #include <algorithm>
 
@@ -46,6 +46,7 @@ namespace electroslag {
             , m_near_distance(0.0f) // TODO: Sensible defaults for camera parameters.
             , m_far_distance(0.0f)
             , m_field_of_view(0.0f)
+            , m_pixels_per_unit(0.0f)
             , m_size_change_delegate(0)
             , m_world_to_eye_dirty(true)
             , m_fbo_tracks_window_dimensions(false)
@@ -214,6 +215,32 @@ namespace electroslag {
             return (false);
         }
 
+        float camera::compute_screen_size(mesh_interface::ref& mesh, float camera_distance) const
+        {
+            math::f32aabb const& world_aabb = mesh->get_world_aabb();
+            float diameter = glm::length(world_aabb.get_max_corner() - world_aabb.get_min_corner());
+            return (diameter * compute_pixels_per_unit(camera_distance));
+        }
+
+        float camera::compute_pixels_per_unit(float camera_distance) const
+        {
+            if (m_camera_mode == camera_mode_perspective) {
+                return (m_pixels_per_unit / max(camera_distance, m_near_distance));
+            }
+            else {
+                return (m_pixels_per_unit);
+            }
+        }
+
+        void camera::get_cluster_cull_view(cluster_cull_view* out_view) const
+        {
+            ELECTROSLAG_CHECK(!m_world_to_eye_dirty);
+            out_view->frustum_planes = m_world_frustum_planes;
+            out_view->frustum_plane_count = view_frustum_plane_index_count;
+            out_view->eye_position = m_translate.get_value();
+            out_view->perspective = (m_camera_mode == camera_mode_perspective);
+        }
+
         camera::camera_transform_work_item::ref camera::make_transform_work_item(
             frame_details* this_frame_details
             )
@@ -227,8 +254,8 @@ namespace electroslag {
         void camera::transform_camera(frame_details* this_frame_details)
         {
             // Animate properties
-            m_world_to_eye_dirty |= (m_translate.update(this_frame_details->millisec_elapsed) == animation::property_value_state_changed);
-            m_world_to_eye_dirty |= (m_rotation.update(this_frame_details->millisec_elapsed) == animation::property_value_state_changed);
+            m_world_to_eye_dirty |= (m_translate.update(this_frame_details->time) == animation::property_value_state_changed);
+            m_world_to_eye_dirty |= (m_rotation.update(this_frame_details->time) == animation::property_value_state_changed);
 
             if (m_world_to_eye_dirty) {
                 // These transforms are specified in the same way as meshes; but we want
@@ -301,6 +328,8 @@ namespace electroslag {
                 frustum_points[frustum_points_left_bottom_far]   = glm::f32vec3(-1.0f, -1.0f, -m_far_distance);
                 frustum_points[frustum_points_right_top_far]     = glm::f32vec3( 1.0f,  1.0f, -m_far_distance);
                 frustum_points[frustum_points_right_bottom_far]  = glm::f32vec3( 1.0f, -1.0f, -m_far_distance);
+
+                m_pixels_per_unit = target_height / 2.0f;
             }
             else if (m_camera_mode == camera_mode_perspective) {
                 // Set up projection matrix.
@@ -319,6 +348,8 @@ namespace electroslag {
                 float nx = ny * aspect_ratio;
                 float fx = fy * aspect_ratio;
 
+                m_pixels_per_unit = target_height / (2.0f * tan_half_fov);
+
                 frustum_points[frustum_points_left_top_near]     = glm::f32vec3(-nx,  ny, -m_near_distance);
                 frustum_points[frustum_points_left_bottom_near]  = glm::f32vec3(-nx, -ny, -m_near_distance);
                 frustum_points[frustum_points_right_top_near]    = glm::f32vec3( nx,  ny, -m_near_distance);
@@ -58,6 +58,15 @@ namespace electroslag {
 
             bool view_frustum_cull(mesh_interface::ref& mesh, float* out_camera_distance) const;
 
+            // Approximate size of the mesh on screen, in pixels across, given the camera
+            // distance returned by view_frustum_cull.
+            float compute_screen_size(mesh_interface::ref& mesh, float camera_distance) const;
+
+            // Pixels on screen covered by one world unit at the given camera distance.
+            float compute_pixels_per_unit(float camera_distance) const;
+
+            void get_cluster_cull_view(cluster_cull_view* out_view) const;
+
             class camera_transform_work_item : public frame_work_item {
             public:
                 typedef reference<camera_transform_work_item> ref;
@@ -134,6 +143,10 @@ namespace electroslag {
             float m_far_distance;
             float m_field_of_view;
 
+            // Pixels covered by one world unit at unit distance (perspective) or at any
+            // distance (orthographic.)
+            float m_pixels_per_unit;
+
             // Position the camera in world space; used to create the view transform matrix.
             animation::quat_property<hash_string("rotation")> m_rotation;
             animation::vec3_property<hash_string("translate")> m_translate;
@@ -0,0 +1,201 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/renderer/deformation_descriptor.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        deformation_descriptor::deformation_descriptor(serialize::archive_reader_interface* ar)
+            : m_vertex_count(0)
+        {
+            int32_t vertex_count = 0;
+            if (!ar->read_int32("vertex_count", &vertex_count) || vertex_count <= 0) {
+                throw load_object_failure("vertex_count");
+            }
+            m_vertex_count = vertex_count;
+
+            int attribute_floats = m_vertex_count * 3;
+            m_positions.resize(attribute_floats);
+            if (!ar->read_buffer("positions", m_positions.data(), attribute_floats * sizeof(float))) {
+                throw load_object_failure("positions");
+            }
+
+            bool normals = false;
+            if (!ar->read_boolean("has_normals", &normals)) {
+                throw load_object_failure("has_normals");
+            }
+
+            if (normals) {
+                m_normals.resize(attribute_floats);
+                if (!ar->read_buffer("normals", m_normals.data(), attribute_floats * sizeof(float))) {
+                    throw load_object_failure("normals");
+                }
+            }
+
+            bool skinned = false;
+            if (!ar->read_boolean("skinned", &skinned)) {
+                throw load_object_failure("skinned");
+            }
+
+            if (skinned) {
+                int joint_values = m_vertex_count * joints_per_vertex;
+                m_joints.resize(joint_values);
+                if (!ar->read_buffer("joints", m_joints.data(), joint_values * sizeof(uint16_t))) {
+                    throw load_object_failure("joints");
+                }
+
+                m_weights.resize(joint_values);
+                if (!ar->read_buffer("weights", m_weights.data(), joint_values * sizeof(float))) {
+                    throw load_object_failure("weights");
+                }
+            }
+
+            int32_t morph_target_count = 0;
+            if (!ar->read_int32("morph_target_count", &morph_target_count) || morph_target_count < 0) {
+                throw load_object_failure("morph_target_count");
+            }
+
+            if (morph_target_count > 0) {
+                m_morph_default_weights.resize(morph_target_count);
+                if (!ar->read_buffer("morph_weights", m_morph_default_weights.data(), morph_target_count * sizeof(float))) {
+                    throw load_object_failure("morph_weights");
+                }
+
+                int morph_floats = morph_target_count * attribute_floats;
+                m_morph_positions.resize(morph_floats);
+                if (!ar->read_buffer("morph_positions", m_morph_positions.data(), morph_floats * sizeof(float))) {
+                    throw load_object_failure("morph_positions");
+                }
+
+                if (normals) {
+                    m_morph_normals.resize(morph_floats);
+                    if (!ar->read_buffer("morph_normals", m_morph_normals.data(), morph_floats * sizeof(float))) {
+                        throw load_object_failure("morph_normals");
+                    }
+                }
+            }
+        }
+
+        deformation_descriptor::deformation_descriptor(int vertex_count, float const* positions, float const* normals)
+            : m_vertex_count(vertex_count)
+        {
+            if (vertex_count <= 0) {
+                throw parameter_failure("vertex_count");
+            }
+
+            if (!positions) {
+                throw parameter_failure("positions");
+            }
+
+            int attribute_floats = m_vertex_count * 3;
+            m_positions.assign(positions, positions + attribute_floats);
+            if (normals) {
+                m_normals.assign(normals, normals + attribute_floats);
+            }
+        }
+
+        void deformation_descriptor::save_to_archive(serialize::archive_writer_interface* ar)
+        {
+            serializable_object::save_to_archive(ar);
+
+            int attribute_bytes = m_vertex_count * 3 * sizeof(float);
+            ar->write_int32("vertex_count", m_vertex_count);
+            ar->write_buffer("positions", m_positions.data(), attribute_bytes);
+
+            ar->write_boolean("has_normals", has_normals());
+            if (has_normals()) {
+                ar->write_buffer("normals", m_normals.data(), attribute_bytes);
+            }
+
+            ar->write_boolean("skinned", is_skinned());
+            if (is_skinned()) {
+                int joint_values = m_vertex_count * joints_per_vertex;
+                ar->write_buffer("joints", m_joints.data(), joint_values * sizeof(uint16_t));
+                ar->write_buffer("weights", m_weights.data(), joint_values * sizeof(float));
+            }
+
+            int morph_target_count = get_morph_target_count();
+            ar->write_int32("morph_target_count", morph_target_count);
+            if (morph_target_count > 0) {
+                ar->write_buffer("morph_weights", m_morph_default_weights.data(), morph_target_count * sizeof(float));
+                ar->write_buffer("morph_positions", m_morph_positions.data(), morph_target_count * attribute_bytes);
+                if (has_normals()) {
+                    ar->write_buffer("morph_normals", m_morph_normals.data(), morph_target_count * attribute_bytes);
+                }
+            }
+        }
+
+        void deformation_descriptor::set_skin_weights(uint16_t const* joints, float const* weights)
+        {
+            if (!joints) {
+                throw parameter_failure("joints");
+            }
+
+            if (!weights) {
+                throw parameter_failure("weights");
+            }
+
+            int joint_values = m_vertex_count * joints_per_vertex;
+            m_joints.assign(joints, joints + joint_values);
+            m_weights.assign(weights, weights + joint_values);
+
+            for (int v = 0; v < joint_values; v += joints_per_vertex) {
+                float* w = &m_weights[v];
+                float sum = w[0] + w[1] + w[2] + w[3];
+                if (sum > 0.0f) {
+                    float scale = 1.0f / sum;
+                    for (int j = 0; j < joints_per_vertex; ++j) {
+                        w[j] *= scale;
+                    }
+                }
+                else {
+                    // Unweighted vertices follow the first joint.
+                    w[0] = 1.0f;
+                    m_joints[v] = 0;
+                }
+            }
+        }
+
+        // static
+        unsigned long long deformation_descriptor::get_morph_weight_hash(int target)
+        {
+            std::string property_name;
+            formatted_string_append(property_name, "morph_weight::%d", target);
+            return (hash_string_runtime(property_name.c_str()));
+        }
+
+        void deformation_descriptor::insert_morph_target(float const* position_deltas, float const* normal_deltas, float default_weight)
+        {
+            if (!position_deltas) {
+                throw parameter_failure("position_deltas");
+            }
+
+            int attribute_floats = m_vertex_count * 3;
+            m_morph_positions.insert(m_morph_positions.end(), position_deltas, position_deltas + attribute_floats);
+
+            if (has_normals()) {
+                if (normal_deltas) {
+                    m_morph_normals.insert(m_morph_normals.end(), normal_deltas, normal_deltas + attribute_floats);
+                }
+                else {
+                    m_morph_normals.resize(m_morph_normals.size() + attribute_floats, 0.0f);
+                }
+            }
+
+            m_morph_default_weights.emplace_back(default_weight);
+        }
+    }
+}
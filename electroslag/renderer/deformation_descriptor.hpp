@@ -0,0 +1,130 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/serialize/serializable_object.hpp"
+#include "electroslag/serialize/archive_interface.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        // Source vertices for a mesh whose positions and normals are recomputed on the CPU
+        // every frame: morph target deltas are blended first, then the result is skinned
+        // by up to four weighted joints. Values are packed three floats per position or
+        // normal and four joints or weights per vertex.
+        class deformation_descriptor
+            : public referenced_object
+            , public serialize::serializable_object<deformation_descriptor> {
+        public:
+            typedef reference<deformation_descriptor> ref;
+
+            static int const joints_per_vertex = 4;
+
+            // Normals are optional.
+            static ref create(int vertex_count, float const* positions, float const* normals)
+            {
+                return (ref(new deformation_descriptor(vertex_count, positions, normals)));
+            }
+
+            // Implement serializable_object
+            explicit deformation_descriptor(serialize::archive_reader_interface* ar);
+            virtual void save_to_archive(serialize::archive_writer_interface* ar);
+
+            // deformation_descriptor methods
+            int get_vertex_count() const
+            {
+                return (m_vertex_count);
+            }
+
+            bool has_normals() const
+            {
+                return (!m_normals.empty());
+            }
+
+            float const* get_positions() const
+            {
+                return (m_positions.data());
+            }
+
+            float const* get_normals() const
+            {
+                return (m_normals.data());
+            }
+
+            // Weights are renormalized so each vertex's weights add up to one.
+            void set_skin_weights(uint16_t const* joints, float const* weights);
+
+            bool is_skinned() const
+            {
+                return (!m_joints.empty());
+            }
+
+            uint16_t const* get_joints() const
+            {
+                return (m_joints.data());
+            }
+
+            float const* get_weights() const
+            {
+                return (m_weights.data());
+            }
+
+            // Normal deltas are ignored if the mesh itself has no normals.
+            void insert_morph_target(float const* position_deltas, float const* normal_deltas, float default_weight);
+
+            int get_morph_target_count() const
+            {
+                return (static_cast<int>(m_morph_default_weights.size()));
+            }
+
+            // Animation clip channels name a morph target's weight by this property hash.
+            static unsigned long long get_morph_weight_hash(int target);
+
+            float get_morph_default_weight(int target) const
+            {
+                return (m_morph_default_weights[target]);
+            }
+
+            float const* get_morph_position_deltas(int target) const
+            {
+                return (m_morph_positions.data() + (target * m_vertex_count * 3));
+            }
+
+            float const* get_morph_normal_deltas(int target) const
+            {
+                return (m_morph_normals.data() + (target * m_vertex_count * 3));
+            }
+
+        private:
+            deformation_descriptor(int vertex_count, float const* positions, float const* normals);
+
+            int m_vertex_count;
+
+            std::vector<float> m_positions;
+            std::vector<float> m_normals;
+
+            std::vector<uint16_t> m_joints;
+            std::vector<float> m_weights;
+
+            std::vector<float> m_morph_positions;
+            std::vector<float> m_morph_normals;
+            std::vector<float> m_morph_default_weights;
+
+            // Disallowed operations:
+            deformation_descriptor();
+            explicit deformation_descriptor(deformation_descriptor const&);
+            deformation_descriptor& operator =(deformation_descriptor const&);
+        };
+    }
+}
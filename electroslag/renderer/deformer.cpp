@@ -0,0 +1,305 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/threading/thread_pool.hpp"
+#include "electroslag/renderer/deformer.hpp"
+#include "electroslag/renderer/renderer.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        void compute_joint_palette(
+            transform_hierarchy const* hierarchy,
+            int mesh_node,
+            int const* joint_nodes,
+            skin_descriptor const* skin,
+            glm::f32mat4x4* out_palette
+            )
+        {
+            glm::f32mat4x4 world_to_mesh(glm::inverse(hierarchy->get_local_to_world(mesh_node)));
+
+            int joint_count = skin->get_joint_count();
+            for (int j = 0; j < joint_count; ++j) {
+                out_palette[j] = world_to_mesh *
+                    hierarchy->get_local_to_world(joint_nodes[j]) *
+                    skin->get_inverse_bind_matrix(j);
+            }
+        }
+
+        void deform_vertices(
+            deformation_descriptor const* desc,
+            int morph_count,
+            int const* morph_targets,
+            float const* morph_weights,
+            glm::f32mat4x4 const* palette,
+            int begin,
+            int end,
+            deformed_vertex* out_vertices
+            )
+        {
+            float const* positions = desc->get_positions();
+            float const* normals = desc->get_normals();
+            bool has_normals = desc->has_normals();
+            uint16_t const* joints = desc->get_joints();
+            float const* weights = desc->get_weights();
+
+            for (int v = begin; v < end; ++v) {
+                int a = v * 3;
+
+                // Position w is one and normal w is zero, so the palette's translation
+                // column only moves positions.
+                __m128 position = _mm_setr_ps(positions[a], positions[a + 1], positions[a + 2], 1.0f);
+                __m128 normal = _mm_setzero_ps();
+                if (has_normals) {
+                    normal = _mm_setr_ps(normals[a], normals[a + 1], normals[a + 2], 0.0f);
+                }
+
+                // Morph targets are offsets from the bind pose.
+                for (int t = 0; t < morph_count; ++t) {
+                    __m128 w = _mm_set1_ps(morph_weights[t]);
+
+                    float const* dp = desc->get_morph_position_deltas(morph_targets[t]) + a;
+                    position = _mm_add_ps(position, _mm_mul_ps(w, _mm_setr_ps(dp[0], dp[1], dp[2], 0.0f)));
+
+                    if (has_normals) {
+                        float const* dn = desc->get_morph_normal_deltas(morph_targets[t]) + a;
+                        normal = _mm_add_ps(normal, _mm_mul_ps(w, _mm_setr_ps(dn[0], dn[1], dn[2], 0.0f)));
+                    }
+                }
+
+                if (palette) {
+                    // Blend the four joint matrices a column at a time, then transform once.
+                    int j = v * deformation_descriptor::joints_per_vertex;
+                    __m128 c0 = _mm_setzero_ps();
+                    __m128 c1 = _mm_setzero_ps();
+                    __m128 c2 = _mm_setzero_ps();
+                    __m128 c3 = _mm_setzero_ps();
+                    for (int k = 0; k < deformation_descriptor::joints_per_vertex; ++k) {
+                        float const* m = &palette[joints[j + k]][0][0];
+                        __m128 w = _mm_set1_ps(weights[j + k]);
+                        c0 = _mm_add_ps(c0, _mm_mul_ps(w, _mm_loadu_ps(m)));
+                        c1 = _mm_add_ps(c1, _mm_mul_ps(w, _mm_loadu_ps(m + 4)));
+                        c2 = _mm_add_ps(c2, _mm_mul_ps(w, _mm_loadu_ps(m + 8)));
+                        c3 = _mm_add_ps(c3, _mm_mul_ps(w, _mm_loadu_ps(m + 12)));
+                    }
+
+                    __m128 skinned = _mm_mul_ps(c0, _mm_shuffle_ps(position, position, _MM_SHUFFLE(0, 0, 0, 0)));
+                    skinned = _mm_add_ps(skinned, _mm_mul_ps(c1, _mm_shuffle_ps(position, position, _MM_SHUFFLE(1, 1, 1, 1))));
+                    skinned = _mm_add_ps(skinned, _mm_mul_ps(c2, _mm_shuffle_ps(position, position, _MM_SHUFFLE(2, 2, 2, 2))));
+                    position = _mm_add_ps(skinned, c3);
+
+                    // Joints are expected to scale uniformly, so the blended matrix also
+                    // works for normals once they are renormalized.
+                    skinned = _mm_mul_ps(c0, _mm_shuffle_ps(normal, normal, _MM_SHUFFLE(0, 0, 0, 0)));
+                    skinned = _mm_add_ps(skinned, _mm_mul_ps(c1, _mm_shuffle_ps(normal, normal, _MM_SHUFFLE(1, 1, 1, 1))));
+                    normal = _mm_add_ps(skinned, _mm_mul_ps(c2, _mm_shuffle_ps(normal, normal, _MM_SHUFFLE(2, 2, 2, 2))));
+                }
+
+                float p[4];
+                float n[4];
+                _mm_storeu_ps(p, position);
+                _mm_storeu_ps(n, normal);
+
+                deformed_vertex* out = &out_vertices[v - begin];
+                out->position = glm::f32vec3(p[0], p[1], p[2]);
+
+                float length_squared = (n[0] * n[0]) + (n[1] * n[1]) + (n[2] * n[2]);
+                if (length_squared > 0.0f) {
+                    float scale = 1.0f / std::sqrt(length_squared);
+                    out->normal = glm::f32vec3(n[0] * scale, n[1] * scale, n[2] * scale);
+                }
+                else {
+                    out->normal = glm::f32vec3(0.0f, 0.0f, 0.0f);
+                }
+            }
+        }
+
+        deformer::deformer(
+            deformation_descriptor::ref const& desc,
+            skin_descriptor::ref const& skin,
+            transform_hierarchy const* hierarchy,
+            int mesh_node,
+            int const* joint_nodes
+            )
+            : m_desc(desc)
+            , m_skin(skin)
+            , m_hierarchy(hierarchy)
+            , m_mesh_node(mesh_node)
+            , m_dynamic_size(0)
+            , m_dynamic_offset(-1)
+        {
+            for (int f = 0; f < max_frames_in_flight; ++f) {
+                m_frame_deformed[f] = false;
+            }
+
+            if (!m_desc.is_valid()) {
+                throw parameter_failure("desc");
+            }
+
+            if (m_skin.is_valid()) {
+                if (!m_desc->is_skinned()) {
+                    throw parameter_failure("skin without joint weights");
+                }
+
+                int joint_count = m_skin->get_joint_count();
+                m_joint_nodes.assign(joint_nodes, joint_nodes + joint_count);
+                m_palette.resize(joint_count, glm::f32mat4x4(1.0f));
+
+                // Check joint indexes once here, rather than for every vertex every frame.
+                int joint_values = m_desc->get_vertex_count() * deformation_descriptor::joints_per_vertex;
+                uint16_t const* joints = m_desc->get_joints();
+                for (int j = 0; j < joint_values; ++j) {
+                    if (joints[j] >= joint_count) {
+                        throw parameter_failure("joint index");
+                    }
+                }
+            }
+
+            int morph_target_count = m_desc->get_morph_target_count();
+            m_morph_weights.reserve(morph_target_count);
+            for (int t = 0; t < morph_target_count; ++t) {
+                m_morph_weights.emplace_back(m_desc->get_morph_default_weight(t));
+            }
+
+            // Round up so the allocations after this one keep their UBO offset alignment.
+            m_dynamic_size = next_multiple_of_2(m_desc->get_vertex_count() * static_cast<int>(sizeof(deformed_vertex)), 256);
+        }
+
+        // static
+        void deformer::check_vertex_layout(
+            deformation_descriptor const* desc,
+            graphics::primitive_stream_descriptor const* stream
+            )
+        {
+            graphics::vertex_attribute const* position_attrib = 0;
+            graphics::primitive_stream_descriptor::const_attribute_iterator a(stream->begin_attributes());
+            while (a != stream->end_attributes()) {
+                if ((*a)->get_field()->get_kind() == graphics::field_kind_attribute_position) {
+                    position_attrib = *a;
+                    break;
+                }
+                ++a;
+            }
+            if (!position_attrib) {
+                throw load_object_failure("deformed geometry has no vertex positions");
+            }
+
+            graphics::buffer_descriptor::ref const& vbo_desc = position_attrib->get_buffer();
+            if (position_attrib->get_stride() != static_cast<int>(sizeof(deformed_vertex))) {
+                throw load_object_failure("deformed vertex stride");
+            }
+
+            // Everything read from the positions' buffer is replaced by the deformed vertices.
+            a = stream->begin_attributes();
+            while (a != stream->end_attributes()) {
+                graphics::vertex_attribute const* attrib = *a;
+                if (attrib->get_buffer()->get_hash() == vbo_desc->get_hash()) {
+                    int expected_offset = -1;
+                    switch (attrib->get_field()->get_kind()) {
+                    case graphics::field_kind_attribute_position:
+                        expected_offset = static_cast<int>(offsetof(deformed_vertex, position));
+                        break;
+
+                    case graphics::field_kind_attribute_normal:
+                        expected_offset = static_cast<int>(offsetof(deformed_vertex, normal));
+                        break;
+
+                    default:
+                        break;
+                    }
+
+                    if (expected_offset < 0 ||
+                        attrib->get_offset() != expected_offset ||
+                        attrib->get_component_type() != graphics::attribute_component_type_float) {
+                        throw load_object_failure("deformed vertex layout");
+                    }
+                }
+                ++a;
+            }
+
+            int vbo_sizeof = vbo_desc->get_uninitialized_data_size();
+            if (vbo_desc->has_initialized_data()) {
+                referenced_buffer_interface::accessor vbo_accessor(vbo_desc->get_initialized_data());
+                vbo_sizeof = vbo_accessor.get_sizeof();
+            }
+            if (vbo_sizeof != desc->get_vertex_count() * static_cast<int>(sizeof(deformed_vertex))) {
+                throw load_object_failure("deformed vertex count");
+            }
+        }
+
+        void deformer::make_work_items(frame_details* this_frame_details, frame_work_item_vector* items)
+        {
+            bool* frame_deformed = &m_frame_deformed[this_frame_details->frame_index];
+            *frame_deformed = false;
+
+            if (m_dynamic_offset < 0) {
+                m_dynamic_offset = this_frame_details->r->get_ubo_manager()->request_dynamic_ubo_space(m_dynamic_size);
+            }
+
+            // The frame's buffer may not have grown to cover this deformer yet.
+            if (!this_frame_details->mapped_dynamic_ubo ||
+                m_dynamic_offset + m_dynamic_size > this_frame_details->dynamic_ubo_size) {
+                return;
+            }
+
+            if (m_skin.is_valid()) {
+                compute_joint_palette(m_hierarchy, m_mesh_node, m_joint_nodes.data(), m_skin.get_pointer(), m_palette.data());
+            }
+
+            // Targets with no weight are dropped before any vertex is touched.
+            m_active_targets.clear();
+            m_active_weights.clear();
+            int morph_target_count = static_cast<int>(m_morph_weights.size());
+            for (int t = 0; t < morph_target_count; ++t) {
+                if (m_morph_weights[t] != 0.0f) {
+                    m_active_targets.emplace_back(t);
+                    m_active_weights.emplace_back(m_morph_weights[t]);
+                }
+            }
+
+            deformed_vertex* out_vertices = reinterpret_cast<deformed_vertex*>(
+                this_frame_details->mapped_dynamic_ubo + m_dynamic_offset
+                );
+
+            int vertex_count = m_desc->get_vertex_count();
+            if (vertex_count <= chunk_vertices) {
+                deform_range(out_vertices, 0, vertex_count);
+            }
+            else {
+                threading::thread_pool* pool = threading::get_frame_thread_pool();
+                for (int c = 0; c < vertex_count; c += chunk_vertices) {
+                    items->emplace_back(pool->enqueue_work_item<deform_work_item>(
+                        this,
+                        out_vertices + c,
+                        c,
+                        min(c + chunk_vertices, vertex_count)
+                        ).cast<frame_work_item>());
+                }
+            }
+
+            *frame_deformed = true;
+        }
+
+        void deformer::finish_work_items(frame_details* this_frame_details)
+        {
+            if (m_frame_deformed[this_frame_details->frame_index]) {
+                this_frame_details->dynamic_ubo->flush_cpu_writes(
+                    m_dynamic_offset,
+                    m_desc->get_vertex_count() * sizeof(deformed_vertex)
+                    );
+            }
+        }
+    }
+}
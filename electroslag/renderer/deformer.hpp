@@ -0,0 +1,203 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/threading/work_item_interface.hpp"
+#include "electroslag/graphics/primitive_stream_descriptor.hpp"
+#include "electroslag/renderer/renderer_types.hpp"
+#include "electroslag/renderer/transform_hierarchy.hpp"
+#include "electroslag/renderer/deformation_descriptor.hpp"
+#include "electroslag/renderer/skin_descriptor.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        // Layout of the deformed vertices written for the GPU; position and normal interleaved.
+        struct deformed_vertex {
+            glm::f32vec3 position;
+            glm::f32vec3 normal;
+        };
+        ELECTROSLAG_STATIC_CHECK(sizeof(deformed_vertex) == 6 * sizeof(float), "Deformed vertices must be tightly packed");
+
+        // Joint palette entry j takes a bind pose vertex to where joint j has moved it,
+        // relative to the mesh's own node: inverse(mesh world) * joint world * inverse bind.
+        void compute_joint_palette(
+            transform_hierarchy const* hierarchy,
+            int mesh_node,
+            int const* joint_nodes,
+            skin_descriptor const* skin,
+            glm::f32mat4x4* out_palette
+            );
+
+        // Blend the listed morph targets, then skin with the palette (if not null) for the
+        // vertices in [begin, end). Each vertex is computed in a fixed order from its own
+        // inputs, so results do not depend on how a mesh is split in to ranges.
+        void deform_vertices(
+            deformation_descriptor const* desc,
+            int morph_count,
+            int const* morph_targets,
+            float const* morph_weights,
+            glm::f32mat4x4 const* palette,
+            int begin,
+            int end,
+            deformed_vertex* out_vertices
+            );
+
+        // Recomputes one instance's deformed vertices each frame in to the frame's dynamic
+        // buffer, in chunks handed to the frame thread pool. Meshes on the instance draw
+        // from them in place of their own positions and normals.
+        class deformer : public referenced_object {
+        public:
+            typedef reference<deformer> ref;
+
+            static int const chunk_vertices = 2048;
+
+            // The skin is optional; if present joint_nodes has one hierarchy node per joint.
+            static ref create(
+                deformation_descriptor::ref const& desc,
+                skin_descriptor::ref const& skin,
+                transform_hierarchy const* hierarchy,
+                int mesh_node,
+                int const* joint_nodes
+                )
+            {
+                return (ref(new deformer(desc, skin, hierarchy, mesh_node, joint_nodes)));
+            }
+
+            virtual ~deformer()
+            {}
+
+            // The buffer holding stream's positions must be laid out as deformed_vertex,
+            // with one element per deformed vertex, for a mesh to draw from a deformer.
+            static void check_vertex_layout(
+                deformation_descriptor const* desc,
+                graphics::primitive_stream_descriptor const* stream
+                );
+
+            deformation_descriptor::ref const& get_deformation() const
+            {
+                return (m_desc);
+            }
+
+            int get_mesh_node() const
+            {
+                return (m_mesh_node);
+            }
+
+            // Morph weights may only be changed on the frame thread, outside of deformation.
+            float get_morph_weight(int target) const
+            {
+                return (m_morph_weights[target]);
+            }
+
+            void set_morph_weight(int target, float weight)
+            {
+                m_morph_weights[target] = weight;
+            }
+
+            // Called on the frame thread after the hierarchy update. Appends this frame's
+            // work to items; the caller waits for them before finish_work_items.
+            void make_work_items(frame_details* this_frame_details, frame_work_item_vector* items);
+            void finish_work_items(frame_details* this_frame_details);
+
+            // Offset of a frame's deformed_vertex array in the frame's dynamic buffer,
+            // or -1 if nothing was deformed for that frame.
+            int get_dynamic_offset(int frame_index) const
+            {
+                ELECTROSLAG_CHECK(frame_index >= 0 && frame_index < max_frames_in_flight);
+                return (m_frame_deformed[frame_index] ? m_dynamic_offset : -1);
+            }
+
+        private:
+            class deform_work_item : public frame_work_item {
+            public:
+                deform_work_item(
+                    deformer const* this_deformer,
+                    deformed_vertex* out_vertices,
+                    int begin,
+                    int end
+                    )
+                    : m_deformer(this_deformer)
+                    , m_out_vertices(out_vertices)
+                    , m_begin(begin)
+                    , m_end(end)
+                {}
+
+                virtual void execute()
+                {
+                    m_deformer->deform_range(m_out_vertices, m_begin, m_end);
+                }
+
+            private:
+                deformer const* m_deformer;
+                deformed_vertex* m_out_vertices;
+                int m_begin;
+                int m_end;
+
+                // Disallowed operations:
+                deform_work_item();
+                explicit deform_work_item(deform_work_item const&);
+                deform_work_item& operator =(deform_work_item const&);
+            };
+
+            deformer(
+                deformation_descriptor::ref const& desc,
+                skin_descriptor::ref const& skin,
+                transform_hierarchy const* hierarchy,
+                int mesh_node,
+                int const* joint_nodes
+                );
+
+            void deform_range(deformed_vertex* out_vertices, int begin, int end) const
+            {
+                deform_vertices(
+                    m_desc.get_pointer(),
+                    static_cast<int>(m_active_targets.size()),
+                    m_active_targets.data(),
+                    m_active_weights.data(),
+                    m_palette.empty() ? 0 : m_palette.data(),
+                    begin,
+                    end,
+                    out_vertices
+                    );
+            }
+
+            deformation_descriptor::ref m_desc;
+            skin_descriptor::ref m_skin;
+
+            transform_hierarchy const* m_hierarchy;
+            int m_mesh_node;
+            std::vector<int> m_joint_nodes;
+
+            // Rebuilt each frame before any chunk runs; read only while chunks run.
+            std::vector<glm::f32mat4x4> m_palette;
+            std::vector<int> m_active_targets;
+            std::vector<float> m_active_weights;
+
+            std::vector<float> m_morph_weights;
+
+            // Space in the per-frame dynamic buffer, the same offset in every frame slot.
+            // The render thread may still be drawing an earlier frame, so each frame slot
+            // records whether it was written.
+            int m_dynamic_size;
+            int m_dynamic_offset;
+            bool m_frame_deformed[max_frames_in_flight];
+
+            // Disallowed operations:
+            deformer();
+            explicit deformer(deformer const&);
+            deformer& operator =(deformer const&);
+        };
+    }
+}
@@ -0,0 +1,168 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/logger.hpp"
+#include "electroslag/renderer/deformer.hpp"
+#include "electroslag/renderer/deformer_check.hpp"
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+namespace electroslag {
+    namespace renderer {
+        static bool check_deformed_vertices(
+            char const* test_name,
+            deformed_vertex const* vertices,
+            deformed_vertex const* expected,
+            int vertex_count
+            )
+        {
+            static float const tolerance = 1.0e-5f;
+
+            bool passed = true;
+            for (int v = 0; v < vertex_count; ++v) {
+                glm::f32vec3 position_error(glm::abs(vertices[v].position - expected[v].position));
+                glm::f32vec3 normal_error(glm::abs(vertices[v].normal - expected[v].normal));
+                if (max(position_error.x, max(position_error.y, position_error.z)) > tolerance ||
+                    max(normal_error.x, max(normal_error.y, normal_error.z)) > tolerance) {
+                    ELECTROSLAG_LOG_ERROR(
+                        "deformation check %s - vertex %d at (%g, %g, %g) normal (%g, %g, %g), expected (%g, %g, %g) normal (%g, %g, %g)",
+                        test_name,
+                        v,
+                        static_cast<double>(vertices[v].position.x),
+                        static_cast<double>(vertices[v].position.y),
+                        static_cast<double>(vertices[v].position.z),
+                        static_cast<double>(vertices[v].normal.x),
+                        static_cast<double>(vertices[v].normal.y),
+                        static_cast<double>(vertices[v].normal.z),
+                        static_cast<double>(expected[v].position.x),
+                        static_cast<double>(expected[v].position.y),
+                        static_cast<double>(expected[v].position.z),
+                        static_cast<double>(expected[v].normal.x),
+                        static_cast<double>(expected[v].normal.y),
+                        static_cast<double>(expected[v].normal.z)
+                        );
+                    passed = false;
+                }
+            }
+            return (passed);
+        }
+
+        bool check_deformation()
+        {
+            static int const vertex_count = 3;
+            static float const half_sqrt2 = 0.70710678f;
+
+            // Vertex 0 follows joint 0, vertex 1 follows joint 1, vertex 2 is split evenly.
+            float const positions[vertex_count * 3] = {
+                0.0f, 0.0f, 0.0f,
+                0.0f, 3.0f, 0.0f,
+                1.0f, 2.0f, 0.0f
+            };
+            float const normals[vertex_count * 3] = {
+                0.0f, 0.0f, 1.0f,
+                1.0f, 0.0f, 0.0f,
+                1.0f, 0.0f, 0.0f
+            };
+            uint16_t const joints[vertex_count * deformation_descriptor::joints_per_vertex] = {
+                0, 0, 0, 0,
+                1, 0, 0, 0,
+                0, 1, 0, 0
+            };
+            float const weights[vertex_count * deformation_descriptor::joints_per_vertex] = {
+                1.0f, 0.0f, 0.0f, 0.0f,
+                1.0f, 0.0f, 0.0f, 0.0f,
+                1.0f, 1.0f, 0.0f, 0.0f
+            };
+
+            // The morph target raises vertex 1 and tips vertex 0's normal.
+            float const position_deltas[vertex_count * 3] = {
+                0.0f, 0.0f, 0.0f,
+                0.0f, 1.0f, 0.0f,
+                0.0f, 0.0f, 0.0f
+            };
+            float const normal_deltas[vertex_count * 3] = {
+                1.0f, 0.0f, -1.0f,
+                0.0f, 0.0f, 0.0f,
+                0.0f, 0.0f, 0.0f
+            };
+
+            deformation_descriptor::ref desc(deformation_descriptor::create(vertex_count, positions, normals));
+            desc->set_skin_weights(joints, weights);
+            desc->insert_morph_target(position_deltas, normal_deltas, 0.0f);
+
+            // The mesh node is moved away from the origin, so the palette has to bring
+            // the joints back in to mesh space. Joint 1 sits at (0, 2, 0) in the bind pose.
+            transform_hierarchy hierarchy;
+            int mesh_node = hierarchy.insert_node(transform_hierarchy::no_parent, transform_descriptor::create());
+            int joint_nodes[2];
+            joint_nodes[0] = hierarchy.insert_node(mesh_node, transform_descriptor::create());
+            joint_nodes[1] = hierarchy.insert_node(mesh_node, transform_descriptor::create());
+
+            glm::f32quat const identity_rotation(1.0f, 0.0f, 0.0f, 0.0f);
+            glm::f32vec3 const unit_scale(1.0f, 1.0f, 1.0f);
+            hierarchy.set_local_transform(mesh_node, identity_rotation, unit_scale, glm::f32vec3(10.0f, 0.0f, 0.0f));
+            hierarchy.set_local_transform(joint_nodes[0], identity_rotation, unit_scale, glm::f32vec3(0.0f, 0.0f, 0.0f));
+            hierarchy.set_local_transform(joint_nodes[1], identity_rotation, unit_scale, glm::f32vec3(0.0f, 2.0f, 0.0f));
+
+            skin_descriptor::ref skin(skin_descriptor::create());
+            skin->insert_joint(hash_string_runtime("joint_0"), glm::f32mat4x4(1.0f));
+            skin->insert_joint(hash_string_runtime("joint_1"), glm::translate(glm::f32vec3(0.0f, -2.0f, 0.0f)));
+
+            // Turn joint 1 a quarter turn about z.
+            hierarchy.set_local_rotation(joint_nodes[1], glm::f32quat(half_sqrt2, 0.0f, 0.0f, half_sqrt2));
+            hierarchy.update();
+
+            glm::f32mat4x4 palette[2];
+            compute_joint_palette(&hierarchy, mesh_node, joint_nodes, skin.get_pointer(), palette);
+
+            deformed_vertex vertices[vertex_count];
+            bool passed = true;
+
+            // Skinned only.
+            deformed_vertex const skinned[vertex_count] = {
+                { glm::f32vec3(0.0f, 0.0f, 0.0f), glm::f32vec3(0.0f, 0.0f, 1.0f) },
+                { glm::f32vec3(-1.0f, 2.0f, 0.0f), glm::f32vec3(0.0f, 1.0f, 0.0f) },
+                { glm::f32vec3(0.5f, 2.5f, 0.0f), glm::f32vec3(half_sqrt2, half_sqrt2, 0.0f) }
+            };
+            deform_vertices(desc.get_pointer(), 0, 0, 0, palette, 0, vertex_count, vertices);
+            passed = check_deformed_vertices("skinned", vertices, skinned, vertex_count) && passed;
+
+            // Morphed then skinned, computed in two ranges to show the split has no effect.
+            int const morph_target = 0;
+            float const morph_weight = 0.5f;
+            deformed_vertex const morphed[vertex_count] = {
+                { glm::f32vec3(0.0f, 0.0f, 0.0f), glm::f32vec3(half_sqrt2, 0.0f, half_sqrt2) },
+                { glm::f32vec3(-1.5f, 2.0f, 0.0f), glm::f32vec3(0.0f, 1.0f, 0.0f) },
+                { glm::f32vec3(0.5f, 2.5f, 0.0f), glm::f32vec3(half_sqrt2, half_sqrt2, 0.0f) }
+            };
+            deform_vertices(desc.get_pointer(), 1, &morph_target, &morph_weight, palette, 0, 1, vertices);
+            deform_vertices(desc.get_pointer(), 1, &morph_target, &morph_weight, palette, 1, vertex_count, vertices + 1);
+            passed = check_deformed_vertices("morphed and skinned", vertices, morphed, vertex_count) && passed;
+
+            // Morphed without a skin leaves everything in the bind pose but the morph.
+            deformed_vertex const morphed_only[vertex_count] = {
+                { glm::f32vec3(0.0f, 0.0f, 0.0f), glm::f32vec3(half_sqrt2, 0.0f, half_sqrt2) },
+                { glm::f32vec3(0.0f, 3.5f, 0.0f), glm::f32vec3(1.0f, 0.0f, 0.0f) },
+                { glm::f32vec3(1.0f, 2.0f, 0.0f), glm::f32vec3(1.0f, 0.0f, 0.0f) }
+            };
+            deform_vertices(desc.get_pointer(), 1, &morph_target, &morph_weight, 0, 0, vertex_count, vertices);
+            passed = check_deformed_vertices("morphed", vertices, morphed_only, vertex_count) && passed;
+
+            ELECTROSLAG_LOG_MESSAGE("deformation check - %s", passed ? "passed" : "FAILED");
+            return (passed);
+        }
+    }
+}
+#endif
@@ -15,6 +15,10 @@
 
 #include "electroslag/precomp.hpp"
 #include "electroslag/renderer/geometry_descriptor.hpp"
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+#include "electroslag/mesh/quadric_simplifier.hpp"
+#include "electroslag/mesh/meshlet_builder.hpp"
+#endif
 
 namespace electroslag {
     namespace renderer {
@@ -41,6 +45,23 @@ namespace electroslag {
             if (!ar->read_buffer("aabb", &m_aabb, sizeof(m_aabb))) {
                 compute_aabb();
             }
+
+            // Older archives have no coarser levels of detail.
+            int32_t coarser_lod_count = 0;
+            if (ar->read_int32("coarser_lod_count", &coarser_lod_count) && coarser_lod_count > 0) {
+                m_coarser_lods.resize(coarser_lod_count);
+                if (!ar->read_buffer("coarser_lods", m_coarser_lods.data(), coarser_lod_count * sizeof(coarser_lod))) {
+                    throw load_object_failure("coarser_lods");
+                }
+            }
+
+            int32_t meshlet_count = 0;
+            if (ar->read_int32("meshlet_count", &meshlet_count) && meshlet_count > 0) {
+                m_meshlets.resize(meshlet_count);
+                if (!ar->read_buffer("meshlets", m_meshlets.data(), meshlet_count * sizeof(meshlet))) {
+                    throw load_object_failure("meshlets");
+                }
+            }
         }
 
         void geometry_descriptor::save_to_archive(serialize::archive_writer_interface* ar)
@@ -54,39 +75,189 @@ namespace electroslag {
             ar->write_int32("index_offset", m_index_buffer_start_offset);
             ar->write_int32("index_value_offset", m_index_value_offset);
             ar->write_buffer("aabb", &m_aabb, sizeof(m_aabb));
+
+            int coarser_lod_count = static_cast<int>(m_coarser_lods.size());
+            ar->write_int32("coarser_lod_count", coarser_lod_count);
+            if (coarser_lod_count > 0) {
+                ar->write_buffer("coarser_lods", m_coarser_lods.data(), coarser_lod_count * sizeof(coarser_lod));
+            }
+
+            int meshlet_count = static_cast<int>(m_meshlets.size());
+            ar->write_int32("meshlet_count", meshlet_count);
+            if (meshlet_count > 0) {
+                ar->write_buffer("meshlets", m_meshlets.data(), meshlet_count * sizeof(meshlet));
+            }
         }
 
-        void geometry_descriptor::compute_aabb()
+        void geometry_descriptor::insert_lod(int element_count, int index_buffer_start_offset, float geometric_error)
+        {
+            if (element_count <= 0) {
+                throw parameter_failure("element_count");
+            }
+
+            if (index_buffer_start_offset < 0) {
+                throw parameter_failure("index_buffer_start_offset");
+            }
+
+            if (geometric_error < get_lod_geometric_error(get_lod_count() - 1)) {
+                throw parameter_failure("geometric_error");
+            }
+
+            coarser_lod lod;
+            lod.element_count = element_count;
+            lod.index_buffer_start_offset = index_buffer_start_offset;
+            lod.geometric_error = geometric_error;
+            m_coarser_lods.emplace_back(lod);
+        }
+
+        void geometry_descriptor::generate_lod_chain(int max_levels)
         {
 #if !defined(ELECTROSLAG_BUILD_SHIP)
-            // Find the position shader field.
-            graphics::shader_field const* field = 0;
-            graphics::shader_field_map::ref const& field_map(m_primitive_stream->get_fields());
-            graphics::shader_field_map::const_iterator f(field_map->begin());
-            while (f != field_map->end()) {
-                field = f->second;
-                if (field->get_kind() == graphics::field_kind::field_kind_attribute_position) {
-                    break;
+            if (m_primitive_stream->get_prim_type() != graphics::primitive_type_triangle) {
+                throw parameter_failure("levels of detail need a triangle list");
+            }
+
+            std::vector<float> positions;
+            std::vector<uint32_t> index_values;
+            std::vector<uint32_t> indices;
+            gather_level_zero(&positions, &index_values, &indices);
+            int element_count = static_cast<int>(indices.size());
+
+            graphics::buffer_descriptor::ref ibo_desc(m_primitive_stream->get_index_buffer());
+            referenced_buffer_interface::ref ibo(ibo_desc->get_initialized_data());
+            int sizeof_index = m_primitive_stream->get_sizeof_index();
+
+            std::vector<mesh::simplified_lod> lods;
+            mesh::build_lod_chain(
+                positions.data(),
+                static_cast<int>(index_values.size()),
+                indices.data(),
+                element_count,
+                max_levels,
+                &lods
+                );
+            if (lods.empty()) {
+                return;
+            }
+
+            // Copy the index buffer with every level's indices appended.
+            int appended_count = 0;
+            std::vector<mesh::simplified_lod>::const_iterator l(lods.begin());
+            while (l != lods.end()) {
+                appended_count += static_cast<int>(l->indices.size());
+                ++l;
+            }
+
+            referenced_buffer_interface::ref new_ibo;
+            {
+                referenced_buffer_interface::accessor old_accessor(ibo);
+                int ibo_sizeof = old_accessor.get_sizeof();
+
+                new_ibo = referenced_buffer_from_sizeof::create(ibo_sizeof + (appended_count * sizeof_index));
+                referenced_buffer_interface::accessor new_accessor(new_ibo);
+                memcpy(new_accessor.get_pointer(), old_accessor.get_pointer(), ibo_sizeof);
+
+                byte* index_pointer = static_cast<byte*>(new_accessor.get_pointer()) + ibo_sizeof;
+                int index_buffer_start_offset = ibo_sizeof / sizeof_index;
+
+                l = lods.begin();
+                while (l != lods.end()) {
+                    int lod_element_count = static_cast<int>(l->indices.size());
+                    insert_lod(lod_element_count, index_buffer_start_offset, l->geometric_error);
+
+                    for (int i = 0; i < lod_element_count; ++i) {
+                        write_index_value(index_pointer, sizeof_index, index_values[l->indices[i]]);
+                        index_pointer += sizeof_index;
+                    }
+
+                    index_buffer_start_offset += lod_element_count;
+                    ++l;
                 }
-                ++f;
             }
-            if (f == field_map->end()) {
-                throw load_object_failure("Cannot compute aabb without vertex positions");
+
+            ibo_desc->set_initialized_data(new_ibo);
+#else
+            UNREFERENCED_PARAMETER(max_levels);
+            throw std::runtime_error("levels of detail");
+#endif
+        }
+
+        void geometry_descriptor::generate_meshlets(int max_triangles)
+        {
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            if (m_primitive_stream->get_prim_type() != graphics::primitive_type_triangle) {
+                throw parameter_failure("meshlets need a triangle list");
             }
 
-            // Find the position vertex attribute attached to the field.
-            graphics::vertex_attribute const* attrib = 0;
-            graphics::primitive_stream_descriptor::const_attribute_iterator a(m_primitive_stream->begin_attributes());
-            while (a != m_primitive_stream->end_attributes()) {
-                attrib = *a;
-                if (*attrib->get_field() == *field) {
-                    break;
+            std::vector<float> positions;
+            std::vector<uint32_t> index_values;
+            std::vector<uint32_t> indices;
+            gather_level_zero(&positions, &index_values, &indices);
+
+            std::vector<uint32_t> meshlet_indices;
+            std::vector<mesh::meshlet> meshlets;
+            mesh::build_meshlets(
+                positions.data(),
+                static_cast<int>(index_values.size()),
+                indices.data(),
+                static_cast<int>(indices.size()),
+                max_triangles,
+                &meshlet_indices,
+                &meshlets
+                );
+
+            // Level 0 keeps its place in a copy of the index buffer; only the order of its
+            // triangles changes, so coarser levels and the bounds are unaffected.
+            graphics::buffer_descriptor::ref ibo_desc(m_primitive_stream->get_index_buffer());
+            referenced_buffer_interface::ref ibo(ibo_desc->get_initialized_data());
+            int sizeof_index = m_primitive_stream->get_sizeof_index();
+
+            referenced_buffer_interface::ref new_ibo;
+            {
+                referenced_buffer_interface::accessor old_accessor(ibo);
+                int ibo_sizeof = old_accessor.get_sizeof();
+
+                new_ibo = referenced_buffer_from_sizeof::create(ibo_sizeof);
+                referenced_buffer_interface::accessor new_accessor(new_ibo);
+                memcpy(new_accessor.get_pointer(), old_accessor.get_pointer(), ibo_sizeof);
+
+                byte* index_pointer = static_cast<byte*>(new_accessor.get_pointer()) + (m_index_buffer_start_offset * sizeof_index);
+                std::vector<uint32_t>::const_iterator i(meshlet_indices.begin());
+                while (i != meshlet_indices.end()) {
+                    write_index_value(index_pointer, sizeof_index, index_values[*i]);
+                    index_pointer += sizeof_index;
+                    ++i;
                 }
-                ++a;
             }
-            if (a == m_primitive_stream->end_attributes()) {
-                throw load_object_failure("Cannot compute aabb without vertex positions");
+
+            ibo_desc->set_initialized_data(new_ibo);
+
+            m_meshlets.clear();
+            m_meshlets.reserve(meshlets.size());
+            std::vector<mesh::meshlet>::const_iterator m(meshlets.begin());
+            while (m != meshlets.end()) {
+                meshlet new_meshlet;
+                new_meshlet.element_count = m->index_count;
+                new_meshlet.index_buffer_start_offset = m_index_buffer_start_offset + m->first_index;
+                new_meshlet.center = m->center;
+                new_meshlet.radius = m->radius;
+                new_meshlet.cone_axis = m->cone_axis;
+                new_meshlet.cone_cutoff = m->cone_cutoff;
+                m_meshlets.emplace_back(new_meshlet);
+                ++m;
             }
+#else
+            UNREFERENCED_PARAMETER(max_triangles);
+            throw std::runtime_error("meshlets");
+#endif
+        }
+
+        void geometry_descriptor::compute_aabb()
+        {
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            graphics::shader_field const* field = 0;
+            graphics::vertex_attribute const* attrib = 0;
+            find_positions(&field, &attrib);
 
             // Get access to the VBO and IBO for the primitive stream.
             graphics::buffer_descriptor::ref ibo_desc(m_primitive_stream->get_index_buffer());
@@ -146,5 +317,157 @@ namespace electroslag {
             throw load_object_failure("aabb");
 #endif
         }
+
+        void geometry_descriptor::read_triangles(std::vector<float>* out_positions, std::vector<uint32_t>* out_indices) const
+        {
+            if (m_primitive_stream->get_prim_type() != graphics::primitive_type_triangle) {
+                throw load_object_failure("Geometry is not a triangle list");
+            }
+
+            std::vector<uint32_t> index_values;
+            gather_level_zero(out_positions, &index_values, out_indices);
+        }
+
+        void geometry_descriptor::find_positions(
+            graphics::shader_field const** out_field,
+            graphics::vertex_attribute const** out_attrib
+            ) const
+        {
+            // Find the position shader field.
+            graphics::shader_field const* field = 0;
+            graphics::shader_field_map::ref const& field_map(m_primitive_stream->get_fields());
+            graphics::shader_field_map::const_iterator f(field_map->begin());
+            while (f != field_map->end()) {
+                field = f->second;
+                if (field->get_kind() == graphics::field_kind::field_kind_attribute_position) {
+                    break;
+                }
+                ++f;
+            }
+            if (f == field_map->end()) {
+                throw load_object_failure("Geometry has no vertex positions");
+            }
+
+            // Find the position vertex attribute attached to the field.
+            graphics::vertex_attribute const* attrib = 0;
+            graphics::primitive_stream_descriptor::const_attribute_iterator a(m_primitive_stream->begin_attributes());
+            while (a != m_primitive_stream->end_attributes()) {
+                attrib = *a;
+                if (*attrib->get_field() == *field) {
+                    break;
+                }
+                ++a;
+            }
+            if (a == m_primitive_stream->end_attributes()) {
+                throw load_object_failure("Geometry has no vertex positions");
+            }
+
+            // Positions are read here as floats; quantized geometry must come with its aabb.
+            if (attrib->get_component_type() != graphics::attribute_component_type_float) {
+                throw load_object_failure("Geometry vertex positions are quantized");
+            }
+
+            *out_field = field;
+            *out_attrib = attrib;
+        }
+        void geometry_descriptor::gather_level_zero(
+            std::vector<float>* out_positions,
+            std::vector<uint32_t>* out_index_values,
+            std::vector<uint32_t>* out_indices
+            ) const
+        {
+            graphics::shader_field const* field = 0;
+            graphics::vertex_attribute const* attrib = 0;
+            find_positions(&field, &attrib);
+
+            graphics::buffer_descriptor::ref ibo_desc(m_primitive_stream->get_index_buffer());
+            ELECTROSLAG_CHECK(ibo_desc->has_initialized_data());
+            referenced_buffer_interface::ref const& ibo(ibo_desc->get_initialized_data());
+
+            graphics::buffer_descriptor::ref vbo_desc(attrib->get_buffer());
+            ELECTROSLAG_CHECK(vbo_desc->has_initialized_data());
+            referenced_buffer_interface::ref const& vbo(vbo_desc->get_initialized_data());
+
+            int sizeof_index = m_primitive_stream->get_sizeof_index();
+            int element_count = m_element_count;
+            if (element_count <= 0) {
+                element_count = graphics::primitive_type_util::get_element_count(
+                    m_primitive_stream->get_prim_type(),
+                    m_primitive_stream->get_prim_count()
+                    );
+            }
+
+            out_positions->clear();
+            out_index_values->clear();
+            out_indices->resize(element_count);
+
+            std::unordered_map<uint32_t, uint32_t> compact_vertices;
+            {
+                referenced_buffer_interface::accessor index_accessor(ibo);
+                referenced_buffer_interface::accessor vertex_accessor(vbo);
+
+                byte const* index_data = static_cast<byte const*>(index_accessor.get_pointer());
+                byte const* vertex_data = static_cast<byte const*>(vertex_accessor.get_pointer());
+                if (!index_data || !vertex_data) {
+                    throw load_object_failure("Geometry buffers are locked");
+                }
+
+                for (int i = 0; i < element_count; ++i) {
+                    byte const* index_pointer = index_data + ((m_index_buffer_start_offset + i) * sizeof_index);
+                    uint32_t index_value = 0;
+                    switch (sizeof_index) {
+                    case 1:
+                        index_value = *index_pointer;
+                        break;
+
+                    case 2:
+                        index_value = *reinterpret_cast<uint16_t const*>(index_pointer);
+                        break;
+
+                    case 4:
+                        index_value = *reinterpret_cast<uint32_t const*>(index_pointer);
+                        break;
+
+                    default:
+                        throw load_object_failure("Cannot read geometry with unknown index size");
+                    }
+
+                    std::pair<std::unordered_map<uint32_t, uint32_t>::iterator, bool> inserted(compact_vertices.insert(
+                        std::make_pair(index_value, static_cast<uint32_t>(out_index_values->size()))
+                        ));
+                    if (inserted.second) {
+                        out_index_values->emplace_back(index_value);
+
+                        glm::f32vec3 const* position = reinterpret_cast<glm::f32vec3 const*>(
+                            vertex_data + (attrib->get_stride() * (index_value + m_index_value_offset)) + field->get_offset()
+                            );
+                        out_positions->insert(out_positions->end(), &position->x, &position->x + 3);
+                    }
+                    (*out_indices)[i] = inserted.first->second;
+                }
+            }
+        }
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+        // static
+        void geometry_descriptor::write_index_value(byte* index_pointer, int sizeof_index, uint32_t index_value)
+        {
+            switch (sizeof_index) {
+            case 1:
+                *index_pointer = static_cast<uint8_t>(index_value);
+                break;
+
+            case 2: {
+                uint16_t narrowed = static_cast<uint16_t>(index_value);
+                memcpy(index_pointer, &narrowed, sizeof(narrowed));
+                break;
+            }
+
+            default:
+                memcpy(index_pointer, &index_value, sizeof(index_value));
+                break;
+            }
+        }
+#endif
     }
 }
@@ -93,7 +93,82 @@ namespace electroslag {
 
             void compute_aabb();
 
+            // Level 0 is the subset selected above. Coarser levels index the same vertices,
+            // each with the largest distance its simplification moved the surface, in
+            // local units; errors must increase with each level.
+            int get_lod_count() const
+            {
+                return (static_cast<int>(m_coarser_lods.size()) + 1);
+            }
+
+            int get_lod_element_count(int lod) const
+            {
+                return ((lod == 0) ? m_element_count : m_coarser_lods[lod - 1].element_count);
+            }
+
+            int get_lod_index_buffer_start_offset(int lod) const
+            {
+                return ((lod == 0) ? m_index_buffer_start_offset : m_coarser_lods[lod - 1].index_buffer_start_offset);
+            }
+
+            float get_lod_geometric_error(int lod) const
+            {
+                return ((lod == 0) ? 0.0f : m_coarser_lods[lod - 1].geometric_error);
+            }
+
+            void insert_lod(int element_count, int index_buffer_start_offset, float geometric_error);
+
+            // Simplify level 0 and append the coarser levels' indices to the index buffer.
+            // Import time only; the index buffer must not have been created yet.
+            void generate_lod_chain(int max_levels);
+
+            // Level 0 may be split in to meshlets, each a contiguous range of its indices
+            // that is culled on its own. Bounds are in local units; see mesh::meshlet for
+            // the meaning of the normal cone.
+            struct meshlet {
+                int element_count;
+                int index_buffer_start_offset;
+                glm::f32vec3 center;
+                float radius;
+                glm::f32vec3 cone_axis;
+                float cone_cutoff;
+            };
+
+            int get_meshlet_count() const
+            {
+                return (static_cast<int>(m_meshlets.size()));
+            }
+
+            meshlet const& get_meshlet(int index) const
+            {
+                return (m_meshlets[index]);
+            }
+
+            // Reorder level 0's indices in to meshlets of at most max_triangles each.
+            // Import time only; the index buffer must not have been created yet.
+            void generate_meshlets(int max_triangles);
+
+            // Copy level 0 out as a triangle list of its own, three floats per vertex.
+            void read_triangles(std::vector<float>* out_positions, std::vector<uint32_t>* out_indices) const;
+
         private:
+            void find_positions(
+                graphics::shader_field const** out_field,
+                graphics::vertex_attribute const** out_attrib
+                ) const;
+
+            // Read level 0 with its vertices numbered from zero, as the mesh tools want them.
+            // index_values maps each compact vertex back to its value in the index buffer.
+            void gather_level_zero(
+                std::vector<float>* out_positions,
+                std::vector<uint32_t>* out_index_values,
+                std::vector<uint32_t>* out_indices
+                ) const;
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+            static void write_index_value(byte* index_pointer, int sizeof_index, uint32_t index_value);
+#endif
+
             geometry_descriptor()
                 : m_element_count(0)
                 , m_index_buffer_start_offset(0)
@@ -104,10 +179,23 @@ namespace electroslag {
 
             // Select a subset of the stream
             int m_element_count;
-            int m_index_buffer_start_offset; // Offset into the IBO
+            int m_index_buffer_start_offset; // Offset into the IBO, in indices
             int m_index_value_offset; // Value to add to each index read from the IBO
             math::f32aabb m_aabb;
 
+            struct coarser_lod {
+                int element_count;
+                int index_buffer_start_offset;
+                float geometric_error;
+            };
+            ELECTROSLAG_STATIC_CHECK(sizeof(coarser_lod) == 12, "Archived level of detail layout changed");
+            typedef std::vector<coarser_lod> coarser_lod_vector;
+            coarser_lod_vector m_coarser_lods;
+
+            ELECTROSLAG_STATIC_CHECK(sizeof(meshlet) == 40, "Archived meshlet layout changed");
+            typedef std::vector<meshlet> meshlet_vector;
+            meshlet_vector m_meshlets;
+
             // Disallowed operations:
             explicit geometry_descriptor(geometry_descriptor const&);
             geometry_descriptor& operator =(geometry_descriptor const&);
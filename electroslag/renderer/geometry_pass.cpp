@@ -115,10 +115,11 @@ namespace electroslag {
             frame_details* this_frame_details
             )
         {
-            return (threading::get_frame_thread_pool()->enqueue_work_item<geometry_pass_render_work_item>(
+            m_render_items[this_frame_details->frame_index] = threading::get_frame_thread_pool()->enqueue_work_item<geometry_pass_render_work_item>(
                 this,
                 this_frame_details
-                ).cast<pass_render_work_item>());
+                ).cast<pass_render_work_item>();
+            return (m_render_items[this_frame_details->frame_index]);
         }
 
         void geometry_pass::geometry_pass_render_work_item::execute()
@@ -137,6 +138,32 @@ namespace electroslag {
                 this_pass,
                 m_this_frame_details
                 );
+
+            this_pass->rasterize_occluders(m_this_frame_details);
+        }
+
+        void geometry_pass::rasterize_occluders(frame_details* this_frame_details)
+        {
+            // The camera and occluder transforms were enqueued ahead of this work item,
+            // so waiting on them cannot deadlock the frame thread pool.
+            frame_work_item_vector::const_iterator c(this_frame_details->camera_transforms.begin());
+            while (c != this_frame_details->camera_transforms.end()) {
+                (*c)->wait_for_done();
+                ++c;
+            }
+
+            occlusion_buffer* buffer = &m_occlusion_buffers[this_frame_details->frame_index];
+            buffer->clear();
+
+            glm::f32mat4x4 const& world_to_clip = m_camera->get_world_to_clip();
+            frame_occluder_vector::const_iterator o(this_frame_details->occluders.begin());
+            while (o != this_frame_details->occluders.end()) {
+                o->transform->wait_for_done();
+                o->mesh->rasterize_occluder(buffer, world_to_clip);
+                ++o;
+            }
+
+            buffer->build_hierarchy();
         }
 
         void geometry_pass::on_scene_created(scene::ref const& new_scene)
@@ -169,8 +196,29 @@ namespace electroslag {
                 return;
             }
 
+            // Skip meshes hidden behind the occluders before spending any UBO space or draw calls on them.
+            m_render_items[this_frame_details->frame_index]->wait_for_done();
+            if (!mesh->is_skybox() && m_occlusion_buffers[this_frame_details->frame_index].is_occluded(
+                mesh->get_world_aabb(),
+                m_camera->get_world_to_clip()
+                )) {
+                return;
+            }
+
             mesh->compute_local_to_clip(pipeline_type_forward_geometry, m_camera->get_world_to_clip());
 
+            mesh->request_texture_detail(pipeline_type_forward_geometry, m_camera->compute_screen_size(mesh, camera_distance));
+
+            mesh->select_level_of_detail(
+                pipeline_type_forward_geometry,
+                m_camera->compute_pixels_per_unit(camera_distance),
+                this_frame_details
+                );
+
+            cluster_cull_view view;
+            m_camera->get_cluster_cull_view(&view);
+            mesh->cull_clusters(pipeline_type_forward_geometry, &view, this_frame_details);
+
             mesh->write_dynamic_ubo(pipeline_type_forward_geometry, this_frame_details);
 
             if (mesh->is_semi_transparent(pipeline_type_forward_geometry)) {
@@ -193,7 +241,6 @@ namespace electroslag {
                     q = opaque_depth_skybox;
                 }
                 else {
-                    // TODO: Levels of detail
                     if (camera_distance < depth_thresholds[opaque_depth_near]) {
                         q = opaque_depth_near;
                     }
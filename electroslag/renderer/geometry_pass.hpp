@@ -19,6 +19,7 @@
 #include "electroslag/renderer/mesh_interface.hpp"
 #include "electroslag/renderer/pass_interface.hpp"
 #include "electroslag/renderer/camera.hpp"
+#include "electroslag/renderer/occlusion_buffer.hpp"
 #include "electroslag/renderer/renderer.hpp"
 
 namespace electroslag {
@@ -109,6 +110,8 @@ namespace electroslag {
                 frame_details* this_frame_details
                 );
 
+            void rasterize_occluders(frame_details* this_frame_details);
+
             // Depth sorting ranges
             enum opaque_depth {
                 opaque_depth_unknown = -1,
@@ -134,6 +137,11 @@ namespace electroslag {
             unsigned long long m_camera_hash;
             camera::ref m_camera;
 
+            // Mesh render items test against the occlusion buffer of their frame,
+            // once the pass render item for that frame has finished filling it.
+            occlusion_buffer m_occlusion_buffers[max_frames_in_flight];
+            pass_render_work_item::ref m_render_items[max_frames_in_flight];
+
             typedef std::vector<graphics::frame_buffer_interface::ref> frame_buffer_vector;
             frame_buffer_vector m_input_buffers;
             frame_buffer_vector m_output_buffers;
@@ -45,9 +45,21 @@ namespace electroslag {
                 m_instance_renderable = serialize::get_database()->find_object_ref<renderable_descriptor>(renderable_hash);
             }
 
+            // Deformation and skin are optional, and absent from older archives.
+            unsigned long long deformation_hash = 0;
+            if (ar->read_name_hash("deformation", &deformation_hash) && deformation_hash) {
+                m_instance_deformation = serialize::get_database()->find_object_ref<deformation_descriptor>(deformation_hash);
+            }
+
+            unsigned long long skin_hash = 0;
+            if (ar->read_name_hash("skin", &skin_hash) && skin_hash) {
+                m_instance_skin = serialize::get_database()->find_object_ref<skin_descriptor>(skin_hash);
+            }
+
             // Children instances
             int32_t child_count = 0;
-            if (!ar->read_int32("child_count", &child_count) || child_count <= 0) {
+            // Leaf instances in a hierarchy have no children.
+            if (!ar->read_int32("child_count", &child_count) || child_count < 0) {
                 throw load_object_failure("child_count");
             }
             m_child_instances.reserve(child_count);
@@ -88,6 +100,14 @@ namespace electroslag {
                 m_instance_renderable->save_to_archive(ar);
             }
 
+            if (m_instance_deformation.is_valid()) {
+                m_instance_deformation->save_to_archive(ar);
+            }
+
+            if (m_instance_skin.is_valid()) {
+                m_instance_skin->save_to_archive(ar);
+            }
+
             instance_vector::iterator i(m_child_instances.begin());
             while (i != m_child_instances.end()) {
                 (*i)->save_to_archive(ar);
@@ -111,6 +131,14 @@ namespace electroslag {
                 ar->write_name_hash("renderable", 0);
             }
 
+            if (m_instance_deformation.is_valid()) {
+                ar->write_name_hash("deformation", m_instance_deformation->get_hash());
+            }
+
+            if (m_instance_skin.is_valid()) {
+                ar->write_name_hash("skin", m_instance_skin->get_hash());
+            }
+
             int child_count = static_cast<int>(m_child_instances.size());
             ar->write_int32("child_count", child_count);
 
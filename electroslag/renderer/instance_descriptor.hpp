@@ -18,6 +18,8 @@
 #include "electroslag/serialize/archive_interface.hpp"
 #include "electroslag/renderer/transform_descriptor.hpp"
 #include "electroslag/renderer/renderable_descriptor.hpp"
+#include "electroslag/renderer/deformation_descriptor.hpp"
+#include "electroslag/renderer/skin_descriptor.hpp"
 
 namespace electroslag {
     namespace renderer {
@@ -87,8 +89,42 @@ namespace electroslag {
                 m_instance_transform = t;
             }
 
+            renderable_descriptor::ref const& get_renderable() const
+            {
+                return (m_instance_renderable);
+            }
+
+            void set_renderable(renderable_descriptor::ref const& r)
+            {
+                m_instance_renderable = r;
+            }
+
+            // Vertices recomputed on the CPU for this instance, optionally skinned to
+            // other instances in the same scene.
+            deformation_descriptor::ref const& get_deformation() const
+            {
+                return (m_instance_deformation);
+            }
+
+            void set_deformation(deformation_descriptor::ref const& d)
+            {
+                m_instance_deformation = d;
+            }
+
+            skin_descriptor::ref const& get_skin() const
+            {
+                return (m_instance_skin);
+            }
+
+            void set_skin(skin_descriptor::ref const& s)
+            {
+                m_instance_skin = s;
+            }
+
         private:
             renderable_descriptor::ref m_instance_renderable;
+            deformation_descriptor::ref m_instance_deformation;
+            skin_descriptor::ref m_instance_skin;
             transform_descriptor::ref m_instance_transform;
 
             instance_vector m_child_instances;
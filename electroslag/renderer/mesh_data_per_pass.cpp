@@ -26,6 +26,7 @@ namespace electroslag {
             )
             : m_pass(pass)
             , m_dynamic_ubo_offset(-1)
+            , m_level_of_detail(0)
         {
             m_pipeline = get_renderer_internal()->get_pipeline_manager()->get_pipeline(
                 pipeline_desc,
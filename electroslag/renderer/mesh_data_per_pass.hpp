@@ -61,6 +61,61 @@ namespace electroslag {
                 m_local_to_clip = local_to_clip;
             }
 
+            // The level chosen for the most recent frame, where the next selection starts.
+            // Draws read the level from their own frame slot's draw list instead.
+            int get_level_of_detail() const
+            {
+                return (m_level_of_detail);
+            }
+
+            void set_level_of_detail(int level_of_detail)
+            {
+                ELECTROSLAG_CHECK(level_of_detail >= 0);
+                m_level_of_detail = level_of_detail;
+            }
+
+            // The level of detail and index ranges left after cluster culling that a frame
+            // draws. Each frame slot has its own list, as the render thread may still be
+            // drawing an earlier frame.
+            struct cluster_draw_list {
+                cluster_draw_list()
+                    : level_of_detail(0)
+                    , active(false)
+                {}
+
+                // Add a range of indices to draw, extending the last range when they touch.
+                void append_range(int element_count, int index_buffer_start_offset)
+                {
+                    if (!element_counts.empty() &&
+                        index_buffer_start_offsets.back() + element_counts.back() == index_buffer_start_offset) {
+                        element_counts.back() += element_count;
+                    }
+                    else {
+                        element_counts.emplace_back(element_count);
+                        index_buffer_start_offsets.emplace_back(index_buffer_start_offset);
+                    }
+                }
+
+                int level_of_detail;
+
+                // When false the selected level of detail is drawn whole.
+                bool active;
+                std::vector<int> element_counts;
+                std::vector<int> index_buffer_start_offsets;
+            };
+
+            cluster_draw_list const& get_cluster_draws(int frame_index) const
+            {
+                ELECTROSLAG_CHECK(frame_index >= 0 && frame_index < max_frames_in_flight);
+                return (m_cluster_draws[frame_index]);
+            }
+
+            cluster_draw_list& get_cluster_draws(int frame_index)
+            {
+                ELECTROSLAG_CHECK(frame_index >= 0 && frame_index < max_frames_in_flight);
+                return (m_cluster_draws[frame_index]);
+            }
+
             void set_dynamic_ubo_offset(int ubo_offset)
             {
                 ELECTROSLAG_CHECK(ubo_offset >= 0);
@@ -76,6 +131,16 @@ namespace electroslag {
                     memcpy(base_pointer + d->field_offset, d->field_source, d->size);
                     ++d;
                 }
+
+                // The writes are sorted, so the first and last bound the dirty span.
+                if (!m_dynamic_ubo_writes.empty()) {
+                    dynamic_ubo_field_write const& first = m_dynamic_ubo_writes.front();
+                    dynamic_ubo_field_write const& last = m_dynamic_ubo_writes.back();
+                    this_frame_details->dynamic_ubo->flush_cpu_writes(
+                        m_dynamic_ubo_offset + first.field_offset,
+                        last.field_offset + last.size - first.field_offset
+                        );
+                }
             }
 
             void bind(graphics::context_interface* context, frame_details* this_frame_details)
@@ -105,6 +170,8 @@ namespace electroslag {
             glm::f32mat4x4 m_local_to_clip;
             pipeline_interface::ref m_pipeline;
             int m_dynamic_ubo_offset;
+            int m_level_of_detail;
+            cluster_draw_list m_cluster_draws[max_frames_in_flight];
 
             // Dynamic UBOs are populated in an optimized loop; reaching out all
             // over the place!
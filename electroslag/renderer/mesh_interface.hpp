@@ -16,6 +16,7 @@
 #pragma once
 #include "electroslag/named_object.hpp"
 #include "electroslag/math/aabb.hpp"
+#include "electroslag/math/plane.hpp"
 #include "electroslag/graphics/command_queue_interface.hpp"
 #include "electroslag/animation/animated_object.hpp"
 #include "electroslag/renderer/renderer_types.hpp"
@@ -24,6 +25,19 @@
 namespace electroslag {
     namespace renderer {
         class scene;
+        class occlusion_buffer;
+
+        // What a mesh needs to cull its own clusters; all in world space. Points on the
+        // inside of every frustum plane have a positive signed distance.
+        struct cluster_cull_view {
+            math::plane const* frustum_planes;
+            int frustum_plane_count;
+            glm::f32vec3 eye_position;
+
+            // Back facing clusters are only found when the eye is a point.
+            bool perspective;
+        };
+
         class mesh_interface
             : public animation::animated_object
             , public named_object
@@ -38,12 +52,36 @@ namespace electroslag {
             virtual bool is_semi_transparent(pipeline_type type) const = 0;
             virtual bool is_skybox() const = 0;
 
+            // Occluders are rasterized in to each pass's occlusion buffer before other
+            // meshes are tested against it.
+            virtual bool is_occluder() const = 0;
+            virtual void rasterize_occluder(occlusion_buffer* buffer, glm::f32mat4x4 const& world_to_clip) const = 0;
+
             // Meshes are expected to have a world space representation.
             virtual math::f32aabb const& get_world_aabb() const = 0;
 
             // Compute the local to clip space transformation on behalf of a pass.
             virtual void compute_local_to_clip(pipeline_type type, glm::f32mat4x4 const& world_to_clip) = 0;
 
+            // Pass on the mesh's size on screen to the textures used by the given pipeline.
+            virtual void request_texture_detail(pipeline_type type, float screen_pixels) = 0;
+
+            // Choose the geometry level of detail a pass will draw in the given frame, given
+            // the pixels covered by one world unit at the mesh's distance.
+            virtual void select_level_of_detail(
+                pipeline_type type,
+                float pixels_per_unit,
+                frame_details* this_frame_details
+                ) = 0;
+
+            // Cull the clusters of the selected level of detail, if it has any, leaving the
+            // ranges a pass will draw in the given frame.
+            virtual void cull_clusters(
+                pipeline_type type,
+                cluster_cull_view const* view,
+                frame_details* this_frame_details
+                ) = 0;
+
             // All mesh items bulk enqueue a work item as part of the transformation
             // process; called by scene.
             class mesh_transform_work_item : public frame_work_item {
@@ -0,0 +1,266 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/renderer/occlusion_buffer.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        ELECTROSLAG_STATIC_CHECK((occlusion_buffer::width >> (occlusion_buffer::level_count - 1)) % 4 == 0, "Every occlusion level must be a multiple of 4 wide");
+        ELECTROSLAG_STATIC_CHECK((occlusion_buffer::height >> (occlusion_buffer::level_count - 1)) > 0, "Occlusion buffer too short for its levels");
+
+        occlusion_buffer::occlusion_buffer()
+            : m_empty(true)
+        {
+            for (int level = 0; level < level_count; ++level) {
+                m_levels[level].resize(level_width(level) * level_height(level), 1.0f);
+            }
+        }
+
+        void occlusion_buffer::clear()
+        {
+            // Coarser levels are rewritten by build_hierarchy.
+            std::fill(m_levels[0].begin(), m_levels[0].end(), 1.0f);
+            m_empty = true;
+        }
+
+        void occlusion_buffer::rasterize_triangles(
+            glm::f32mat4x4 const& local_to_clip,
+            float const* positions,
+            int vertex_count,
+            uint32_t const* indices,
+            int index_count
+            )
+        {
+            if (!positions || vertex_count <= 0) {
+                throw parameter_failure("positions");
+            }
+
+            if (!indices || index_count % 3) {
+                throw parameter_failure("indices");
+            }
+
+            // Four wide transform; each vertex is the sum of the matrix columns scaled by
+            // its coordinates.
+            __m128 column_0 = _mm_loadu_ps(&local_to_clip[0].x);
+            __m128 column_1 = _mm_loadu_ps(&local_to_clip[1].x);
+            __m128 column_2 = _mm_loadu_ps(&local_to_clip[2].x);
+            __m128 column_3 = _mm_loadu_ps(&local_to_clip[3].x);
+
+            m_clip_vertices.resize(vertex_count);
+            for (int v = 0; v < vertex_count; ++v) {
+                float const* p = positions + (v * 3);
+                __m128 clip = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(column_0, _mm_set1_ps(p[0])), _mm_mul_ps(column_1, _mm_set1_ps(p[1]))),
+                    _mm_add_ps(_mm_mul_ps(column_2, _mm_set1_ps(p[2])), column_3)
+                    );
+                _mm_storeu_ps(&m_clip_vertices[v].x, clip);
+            }
+
+            uint32_t vertex_limit = static_cast<uint32_t>(vertex_count);
+            for (int i = 0; i < index_count; i += 3) {
+                if (indices[i] >= vertex_limit || indices[i + 1] >= vertex_limit || indices[i + 2] >= vertex_limit) {
+                    throw parameter_failure("index out of range");
+                }
+
+                rasterize_triangle(
+                    &m_clip_vertices[indices[i]],
+                    &m_clip_vertices[indices[i + 1]],
+                    &m_clip_vertices[indices[i + 2]]
+                    );
+            }
+        }
+
+        void occlusion_buffer::rasterize_triangle(glm::f32vec4 const* v0, glm::f32vec4 const* v1, glm::f32vec4 const* v2)
+        {
+            static float const min_w = 1e-5f;
+            if (v0->w <= min_w || v1->w <= min_w || v2->w <= min_w) {
+                return;
+            }
+
+            // Screen space, in pixels, with pixel centers at half coordinates.
+            float const half_width = width * 0.5f;
+            float const half_height = height * 0.5f;
+            glm::f32vec3 s0(((v0->x / v0->w) + 1.0f) * half_width, ((v0->y / v0->w) + 1.0f) * half_height, v0->z / v0->w);
+            glm::f32vec3 s1(((v1->x / v1->w) + 1.0f) * half_width, ((v1->y / v1->w) + 1.0f) * half_height, v1->z / v1->w);
+            glm::f32vec3 s2(((v2->x / v2->w) + 1.0f) * half_width, ((v2->y / v2->w) + 1.0f) * half_height, v2->z / v2->w);
+
+            // The whole triangle takes its farthest depth.
+            float depth = max(s0.z, max(s1.z, s2.z));
+            if (depth >= 1.0f || min(s0.z, min(s1.z, s2.z)) < 0.0f) {
+                return;
+            }
+
+            // Both facings are drawn; wind every triangle the same way.
+            float area = ((s1.x - s0.x) * (s2.y - s0.y)) - ((s2.x - s0.x) * (s1.y - s0.y));
+            if (area == 0.0f) {
+                return;
+            }
+            else if (area < 0.0f) {
+                std::swap(s1, s2);
+            }
+
+            int min_x = max(static_cast<int>(std::floor(min(s0.x, min(s1.x, s2.x)))), 0);
+            int max_x = min(static_cast<int>(std::ceil(max(s0.x, max(s1.x, s2.x)))), width - 1);
+            int min_y = max(static_cast<int>(std::floor(min(s0.y, min(s1.y, s2.y)))), 0);
+            int max_y = min(static_cast<int>(std::ceil(max(s0.y, max(s1.y, s2.y)))), height - 1);
+            if (min_x > max_x || min_y > max_y) {
+                return;
+            }
+
+            // Edge functions e = a * x + b * y + c, positive inside.
+            float a0 = s0.y - s1.y, b0 = s1.x - s0.x, c0 = (s0.x * s1.y) - (s0.y * s1.x);
+            float a1 = s1.y - s2.y, b1 = s2.x - s1.x, c1 = (s1.x * s2.y) - (s1.y * s2.x);
+            float a2 = s2.y - s0.y, b2 = s0.x - s2.x, c2 = (s2.x * s0.y) - (s2.y * s0.x);
+
+            // Four pixels at a time, from a multiple of four.
+            min_x &= ~3;
+            __m128 pixel_offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+            __m128 step_0 = _mm_set1_ps(a0 * 4.0f);
+            __m128 step_1 = _mm_set1_ps(a1 * 4.0f);
+            __m128 step_2 = _mm_set1_ps(a2 * 4.0f);
+            __m128 triangle_depth = _mm_set1_ps(depth);
+            __m128 zero = _mm_setzero_ps();
+
+            for (int y = min_y; y <= max_y; ++y) {
+                float pixel_y = y + 0.5f;
+                __m128 xs = _mm_add_ps(_mm_set1_ps(static_cast<float>(min_x)), pixel_offsets);
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), xs), _mm_set1_ps((b0 * pixel_y) + c0));
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), xs), _mm_set1_ps((b1 * pixel_y) + c1));
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), xs), _mm_set1_ps((b2 * pixel_y) + c2));
+
+                float* row = m_levels[0].data() + (y * width);
+                for (int x = min_x; x <= max_x; x += 4) {
+                    __m128 inside = _mm_and_ps(
+                        _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                        _mm_cmpge_ps(e2, zero)
+                        );
+
+                    if (_mm_movemask_ps(inside)) {
+                        __m128 old_depth = _mm_loadu_ps(row + x);
+                        __m128 new_depth = _mm_min_ps(old_depth, triangle_depth);
+                        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, new_depth), _mm_andnot_ps(inside, old_depth)));
+                        m_empty = false;
+                    }
+
+                    e0 = _mm_add_ps(e0, step_0);
+                    e1 = _mm_add_ps(e1, step_1);
+                    e2 = _mm_add_ps(e2, step_2);
+                }
+            }
+        }
+
+        void occlusion_buffer::build_hierarchy()
+        {
+            if (m_empty) {
+                return;
+            }
+
+            // Each texel keeps the farthest of the four beneath it, four texels at a time.
+            for (int level = 1; level < level_count; ++level) {
+                int source_width = level_width(level - 1);
+                int target_width = level_width(level);
+                int target_height = level_height(level);
+
+                for (int y = 0; y < target_height; ++y) {
+                    float const* row_0 = m_levels[level - 1].data() + ((y * 2) * source_width);
+                    float const* row_1 = row_0 + source_width;
+                    float* target = m_levels[level].data() + (y * target_width);
+
+                    for (int x = 0; x < target_width; x += 4) {
+                        __m128 left = _mm_max_ps(_mm_loadu_ps(row_0 + (x * 2)), _mm_loadu_ps(row_1 + (x * 2)));
+                        __m128 right = _mm_max_ps(_mm_loadu_ps(row_0 + (x * 2) + 4), _mm_loadu_ps(row_1 + (x * 2) + 4));
+                        __m128 even = _mm_shuffle_ps(left, right, _MM_SHUFFLE(2, 0, 2, 0));
+                        __m128 odd = _mm_shuffle_ps(left, right, _MM_SHUFFLE(3, 1, 3, 1));
+                        _mm_storeu_ps(target + x, _mm_max_ps(even, odd));
+                    }
+                }
+            }
+        }
+
+        bool occlusion_buffer::is_occluded(math::f32aabb const& world_aabb, glm::f32mat4x4 const& world_to_clip) const
+        {
+            if (m_empty) {
+                return (false);
+            }
+
+            glm::f32vec3 const& aabb_min = world_aabb.get_min_corner();
+            glm::f32vec3 const& aabb_max = world_aabb.get_max_corner();
+
+            // Screen rectangle and nearest depth of the corners. A box reaching past the
+            // near plane is never occluded.
+            float min_x = std::numeric_limits<float>::max();
+            float min_y = std::numeric_limits<float>::max();
+            float max_x = -std::numeric_limits<float>::max();
+            float max_y = -std::numeric_limits<float>::max();
+            float nearest_depth = 1.0f;
+            for (int corner = 0; corner < 8; ++corner) {
+                glm::f32vec4 clip(world_to_clip * glm::f32vec4(
+                    (corner & 1) ? aabb_max.x : aabb_min.x,
+                    (corner & 2) ? aabb_max.y : aabb_min.y,
+                    (corner & 4) ? aabb_max.z : aabb_min.z,
+                    1.0f
+                    ));
+
+                if (clip.w <= 1e-5f) {
+                    return (false);
+                }
+
+                float depth = clip.z / clip.w;
+                if (depth < 0.0f) {
+                    return (false);
+                }
+
+                float x = ((clip.x / clip.w) + 1.0f) * (width * 0.5f);
+                float y = ((clip.y / clip.w) + 1.0f) * (height * 0.5f);
+                min_x = min(min_x, x);
+                min_y = min(min_y, y);
+                max_x = max(max_x, x);
+                max_y = max(max_y, y);
+                nearest_depth = min(nearest_depth, depth);
+            }
+
+            int first_x = max(static_cast<int>(std::floor(min_x)), 0);
+            int last_x = min(static_cast<int>(std::floor(max_x)), width - 1);
+            int first_y = max(static_cast<int>(std::floor(min_y)), 0);
+            int last_y = min(static_cast<int>(std::floor(max_y)), height - 1);
+            if (first_x > last_x || first_y > last_y) {
+                return (false);
+            }
+
+            // The coarsest level at which the rectangle still spans only a few texels.
+            int level = 0;
+            while (level < level_count - 1 && max(last_x - first_x, last_y - first_y) >= 4) {
+                first_x >>= 1;
+                last_x >>= 1;
+                first_y >>= 1;
+                last_y >>= 1;
+                ++level;
+            }
+
+            int texels_wide = level_width(level);
+            for (int y = first_y; y <= last_y; ++y) {
+                float const* row = m_levels[level].data() + (y * texels_wide);
+                for (int x = first_x; x <= last_x; ++x) {
+                    if (row[x] >= nearest_depth) {
+                        return (false);
+                    }
+                }
+            }
+
+            return (true);
+        }
+    }
+}
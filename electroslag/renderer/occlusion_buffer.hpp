@@ -0,0 +1,78 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/math/aabb.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        // A small software depth buffer for occlusion culling. Occluder triangles are
+        // rasterized at low resolution, each at the depth of its farthest vertex, so the
+        // buffer never holds anything nearer than the true surface. Coarser levels keep the
+        // farthest depth of the texels beneath them, so a box can be tested against a few
+        // texels at whichever level it spans. Depths are clip space z, 0 near and 1 far.
+        class occlusion_buffer {
+        public:
+            static constexpr int const width = 256;
+            static constexpr int const height = 128;
+            static constexpr int const level_count = 5;
+
+            occlusion_buffer();
+
+            void clear();
+
+            // Positions are three floats per vertex; indices form a triangle list. Triangles
+            // that cross the eye plane are skipped rather than clipped.
+            void rasterize_triangles(
+                glm::f32mat4x4 const& local_to_clip,
+                float const* positions,
+                int vertex_count,
+                uint32_t const* indices,
+                int index_count
+                );
+
+            // Build the coarser levels once every occluder is rasterized.
+            void build_hierarchy();
+
+            // True only if the whole box lies behind occluders.
+            bool is_occluded(math::f32aabb const& world_aabb, glm::f32mat4x4 const& world_to_clip) const;
+
+        private:
+            static constexpr int level_width(int level)
+            {
+                return (width >> level);
+            }
+
+            static constexpr int level_height(int level)
+            {
+                return (height >> level);
+            }
+
+            void rasterize_triangle(glm::f32vec4 const* v0, glm::f32vec4 const* v1, glm::f32vec4 const* v2);
+
+            typedef std::vector<float> depth_vector;
+            depth_vector m_levels[level_count];
+
+            // Transformed vertices, kept between calls to save the allocation.
+            std::vector<glm::f32vec4> m_clip_vertices;
+
+            bool m_empty;
+
+            // Disallowed operations:
+            explicit occlusion_buffer(occlusion_buffer const&);
+            occlusion_buffer& operator =(occlusion_buffer const&);
+        };
+    }
+}
@@ -0,0 +1,89 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/logger.hpp"
+#include "electroslag/renderer/occlusion_buffer.hpp"
+#include "electroslag/renderer/occlusion_buffer_check.hpp"
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+namespace electroslag {
+    namespace renderer {
+        static bool check_box(
+            occlusion_buffer const& buffer,
+            char const* test_name,
+            glm::f32vec3 const& box_min,
+            glm::f32vec3 const& box_max,
+            bool expected
+            )
+        {
+            // Clip space is world space, so boxes are placed directly in normalized device
+            // coordinates.
+            bool occluded = buffer.is_occluded(math::f32aabb(box_min, box_max), glm::f32mat4x4(1.0f));
+            if (occluded != expected) {
+                ELECTROSLAG_LOG_ERROR("occlusion buffer check - %s box is %s, expected %s",
+                    test_name,
+                    occluded ? "occluded" : "visible",
+                    expected ? "occluded" : "visible");
+                return (false);
+            }
+            return (true);
+        }
+
+        bool check_occlusion_buffer()
+        {
+            // A quad at half depth covering pixels 64 to 185 across and 32 to 95 down. The
+            // right edge is not on a texel boundary at any coarser level.
+            static float const quad_positions[] = {
+                -0.5f, -0.5f, 0.5f,
+                0.45f, -0.5f, 0.5f,
+                0.45f, 0.5f, 0.5f,
+                -0.5f, 0.5f, 0.5f
+            };
+            static uint32_t const quad_indices[] = { 0, 1, 2, 0, 2, 3 };
+
+            occlusion_buffer buffer;
+            bool passed = check_box(buffer, "empty buffer", glm::f32vec3(-0.1f, -0.1f, 0.6f), glm::f32vec3(0.1f, 0.1f, 0.8f), false);
+
+            buffer.rasterize_triangles(glm::f32mat4x4(1.0f), quad_positions, 4, quad_indices, 6);
+            buffer.build_hierarchy();
+
+            // Small enough to be tested at the finest level.
+            passed = check_box(buffer, "small behind", glm::f32vec3(-0.01f, -0.01f, 0.6f), glm::f32vec3(0.01f, 0.01f, 0.8f), true) && passed;
+            passed = check_box(buffer, "small in front", glm::f32vec3(-0.01f, -0.01f, 0.2f), glm::f32vec3(0.01f, 0.01f, 0.4f), false) && passed;
+            passed = check_box(buffer, "small past edge", glm::f32vec3(0.4f, -0.01f, 0.6f), glm::f32vec3(0.5f, 0.01f, 0.8f), false) && passed;
+            passed = check_box(buffer, "small straddling", glm::f32vec3(-0.01f, -0.01f, 0.4f), glm::f32vec3(0.01f, 0.01f, 0.6f), false) && passed;
+
+            // Large enough to be tested at the coarsest level, which only holds the quad's
+            // depth if build_hierarchy ran.
+            passed = check_box(buffer, "large behind", glm::f32vec3(-0.25f, -0.25f, 0.6f), glm::f32vec3(0.25f, 0.25f, 0.8f), true) && passed;
+            passed = check_box(buffer, "large in front", glm::f32vec3(-0.25f, -0.25f, 0.2f), glm::f32vec3(0.25f, 0.25f, 0.4f), false) && passed;
+
+            // Reaches a few pixels past the quad's right edge, inside a coarse texel that
+            // the quad partly covers. Only keeping the farthest depth of the texels beneath
+            // leaves that texel open.
+            passed = check_box(buffer, "large past edge", glm::f32vec3(-0.4f, -0.3f, 0.6f), glm::f32vec3(0.48f, 0.3f, 0.8f), false) && passed;
+
+            // Clearing empties the buffer again.
+            buffer.clear();
+            buffer.build_hierarchy();
+            passed = check_box(buffer, "cleared", glm::f32vec3(-0.25f, -0.25f, 0.6f), glm::f32vec3(0.25f, 0.25f, 0.8f), false) && passed;
+
+            ELECTROSLAG_LOG_MESSAGE("occlusion buffer check - %s", passed ? "passed" : "FAILED");
+            return (passed);
+        }
+    }
+}
+#endif
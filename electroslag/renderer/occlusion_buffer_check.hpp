@@ -0,0 +1,28 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+
+#if !defined(ELECTROSLAG_BUILD_SHIP)
+namespace electroslag {
+    namespace renderer {
+        // Rasterizes a single quad in to an occlusion buffer and tests boxes behind it,
+        // in front of it and reaching past its edge, including one large enough to be
+        // tested against the coarser levels. Logs each wrong answer; returns false if
+        // there were any.
+        bool check_occlusion_buffer();
+    }
+}
+#endif
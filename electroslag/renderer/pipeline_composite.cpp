@@ -31,6 +31,7 @@ namespace electroslag {
             : m_initialization_step(initialization_step_create_shaders)
             , m_desc(desc)
             , m_vertex_attrib_field_map(vertex_attrib_field_map)
+            , m_uses_texture_table(false)
             , m_dynamic_ubo_size(0)
             , m_depth_test(*desc->get_depth_test_params())
             , m_blending(*desc->get_blending_params())
@@ -51,7 +52,9 @@ namespace electroslag {
                 break;
 
             case initialization_step_wait_for_shaders:
-                if (m_sync_operation->is_signaled()) {
+                // The sync only says the create command ran; with parallel compile the
+                // program may still be building on a driver thread.
+                if (m_sync_operation->is_signaled() && m_shader->is_finished()) {
                     m_initialization_step = initialization_step_create_textures;
                     // Intentional fall through!
                 }
@@ -84,7 +87,7 @@ namespace electroslag {
             }
 
             case initialization_step_wait_for_textures:
-                if (m_sync_operation->is_signaled()) {
+                if (m_sync_operation->is_signaled() && are_textures_finished()) {
                     m_initialization_step = initialization_step_create_ubo;
                     // Intentional fall through!
                 }
@@ -131,6 +134,35 @@ namespace electroslag {
             }
         }
 
+        bool pipeline_composite::are_textures_finished()
+        {
+            // Reverse iteration allows us to erase from the vector sanely.
+            int pending_count = static_cast<int>(m_pending_textures.size());
+            for (int t = pending_count - 1; t >= 0; --t) {
+                if (m_pending_textures[t]->is_finished()) {
+                    m_pending_textures.erase(m_pending_textures.begin() + t);
+                }
+            }
+
+            int pending_table_count = static_cast<int>(m_pending_table_textures.size());
+            for (int t = pending_table_count - 1; t >= 0; --t) {
+                if (m_pending_table_textures[t]->is_in_table()) {
+                    m_pending_table_textures.erase(m_pending_table_textures.begin() + t);
+                }
+            }
+
+            return (m_pending_textures.empty() && m_pending_table_textures.empty());
+        }
+
+        void pipeline_composite::request_texture_detail(float screen_pixels)
+        {
+            streamed_texture_vector::iterator t(m_streamed_textures.begin());
+            while (t != m_streamed_textures.end()) {
+                (*t)->request_screen_size(screen_pixels);
+                ++t;
+            }
+        }
+
         bool pipeline_composite::locate_field_source(graphics::shader_field const* field, void const** field_source) const
         {
             // Look up the initializer for this field.
@@ -169,6 +201,11 @@ namespace electroslag {
             context->set_depth_test(&m_depth_test);
             context->bind_shader_program(m_shader);
 
+            // The table can be replaced as it grows; each frame binds the one current when it began.
+            if (m_uses_texture_table) {
+                context->bind_shader_storage_buffer(this_frame_details->texture_table, texture_manager::table_binding);
+            }
+
             ubo_binding_vector::const_iterator u(m_ubo_bindings.begin());
             while (u != m_ubo_bindings.end()) {
                 context->bind_uniform_buffer(u->buffer, u->binding);
@@ -208,7 +245,8 @@ namespace electroslag {
                     while (f != ubo_field_map->end()) {
                         graphics::shader_field const* field = f->second;
 
-                        if (field->get_field_type() == graphics::field_type_texture_handle) {
+                        graphics::field_type type = field->get_field_type();
+                        if (type == graphics::field_type_texture_handle || type == graphics::field_type_texture_index) {
 
                             // Look up the initializer for this field.
                             unsigned long long field_obj_hash = 0;
@@ -219,8 +257,18 @@ namespace electroslag {
                                 graphics::texture_descriptor::ref texture_desc(
                                     serialize::get_database()->find_object_ref<graphics::texture_descriptor>(field_obj_hash)
                                     );
-                                texture_manager->get_texture(texture_desc);
+                                texture_manager::streamed_texture::ref const& texture(
+                                    texture_manager->get_texture(texture_desc)
+                                    );
+                                m_pending_textures.emplace_back(texture->get_texture());
+                                m_streamed_textures.emplace_back(texture);
                                 need_wait = true;
+
+                                if (type == graphics::field_type_texture_index) {
+                                    texture_manager->add_table_entry(texture);
+                                    m_pending_table_textures.emplace_back(texture);
+                                    m_uses_texture_table = true;
+                                }
                             }
                         }
                         ++f;
@@ -316,17 +364,33 @@ namespace electroslag {
             graphics::buffer_interface::ref static_ubo(ubo_manager->get_buffer(ubo_hash));
 
             if (!static_ubo.is_valid()) {
+                referenced_buffer_from_sizeof::ref initializer_data(referenced_buffer_from_sizeof::create(ubo_desc->get_size()));
+                texture_handle_vector texture_handles;
+                create_static_ubo_initializer(initializer_data, field_initializer, ubo_desc, &texture_handles);
+
                 graphics::buffer_descriptor::ref initializer(graphics::buffer_descriptor::create());
                 initializer->set_hash(ubo_hash);
-                initializer->set_buffer_memory_caching(graphics::buffer_memory_caching_static);
-                initializer->set_buffer_memory_map(graphics::buffer_memory_map_static);
-
-                referenced_buffer_from_sizeof::ref initializer_data(referenced_buffer_from_sizeof::create(ubo_desc->get_size()));
-                create_static_ubo_initializer(initializer_data, field_initializer, ubo_desc);
+                if (texture_handles.empty()) {
+                    initializer->set_buffer_memory_caching(graphics::buffer_memory_caching_static);
+                    initializer->set_buffer_memory_map(graphics::buffer_memory_map_static);
+                }
+                else {
+                    // Streamed textures are replaced as their residency changes, and the
+                    // handles in this UBO are rewritten in place when that happens.
+                    initializer->set_buffer_memory_caching(graphics::buffer_memory_caching_coherent);
+                    initializer->set_buffer_memory_map(graphics::buffer_memory_map_write);
+                }
                 initializer->set_initialized_data(initializer_data);
 
                 static_ubo = ubo_manager->get_buffer(initializer);
                 need_wait = true;
+
+                texture_manager* texture_manager = get_renderer_internal()->get_texture_manager();
+                texture_handle_vector::const_iterator t(texture_handles.begin());
+                while (t != texture_handles.end()) {
+                    texture_manager->add_handle_reference(t->texture, static_ubo, t->offset);
+                    ++t;
+                }
             }
 
             m_ubo_bindings.emplace_back(static_ubo, ubo_desc->get_binding());
@@ -337,7 +401,8 @@ namespace electroslag {
         void pipeline_composite::create_static_ubo_initializer(
             referenced_buffer_from_sizeof::ref& initializer_data,
             serialize::serializable_map::ref const& field_initializer,
-            graphics::uniform_buffer_descriptor::ref const& ubo_desc
+            graphics::uniform_buffer_descriptor::ref const& ubo_desc,
+            texture_handle_vector* out_texture_handles
             )
         {
             referenced_buffer_from_sizeof::accessor data_accessor(initializer_data);
@@ -399,15 +464,43 @@ namespace electroslag {
                             );
 
                         // Assumes texture creation is done by now!
-                        graphics::texture_interface::ref texture(texture_manager->get_texture(
+                        texture_manager::streamed_texture::ref texture(texture_manager->get_texture(
                             connected_texture_desc
                             ));
 
-                        graphics::field_structs::texture_handle handle(texture->get_handle());
+                        graphics::field_structs::texture_handle handle(texture->get_texture()->get_handle());
                         field->write_uniform(
                             static_cast<byte*>(data_accessor.get_pointer()),
                             &handle
                             );
+
+                        if (texture->is_streamable()) {
+                            out_texture_handles->emplace_back(texture, field->get_offset());
+                        }
+                    }
+                    break;
+                }
+
+                case graphics::field_type_texture_index: {
+                    unsigned long long field_obj_hash = 0;
+                    if (field_initializer->locate_value(field->get_hash(), &field_obj_hash)) {
+                        graphics::texture_descriptor::ref connected_texture_desc(
+                            serialize::get_database()->find_object_ref<graphics::texture_descriptor>(field_obj_hash)
+                            );
+
+                        // The table slot never changes as the texture streams, so unlike a
+                        // handle, an index leaves the UBO static.
+                        texture_manager::streamed_texture::ref texture(texture_manager->get_texture(
+                            connected_texture_desc
+                            ));
+
+                        ELECTROSLAG_CHECK(texture->get_table_index() >= 0);
+                        graphics::field_structs::texture_index index;
+                        index.i = static_cast<uint32_t>(texture->get_table_index());
+                        field->write_uniform(
+                            static_cast<byte*>(data_accessor.get_pointer()),
+                            &index
+                            );
                     }
                     break;
                 }
@@ -15,8 +15,10 @@
 
 #pragma once
 #include "electroslag/graphics/shader_field_map.hpp"
+#include "electroslag/graphics/texture_interface.hpp"
 #include "electroslag/renderer/pipeline_interface.hpp"
 #include "electroslag/renderer/pipeline_descriptor.hpp"
+#include "electroslag/renderer/texture_manager.hpp"
 
 namespace electroslag {
     namespace renderer {
@@ -58,6 +60,8 @@ namespace electroslag {
                 int dynamic_ubo_base_offset
                 ) const;
 
+            virtual void request_texture_detail(float screen_pixels);
+
         private:
             template<class T>
             void write_field(
@@ -88,6 +92,7 @@ namespace electroslag {
             bool create_stage_textures(
                 graphics::shader_stage_descriptor::ref const& stage
                 );
+            bool are_textures_finished();
             bool create_stage_ubo(
                 graphics::shader_stage_descriptor::ref const& stage,
                 int min_ubo_alignmen
@@ -100,10 +105,26 @@ namespace electroslag {
             bool create_static_ubo(
                 graphics::uniform_buffer_descriptor::ref const& ubo_desc
                 );
+            // Where a streamed texture's handle was written in a static UBO initializer.
+            struct texture_handle_location {
+                texture_handle_location(
+                    texture_manager::streamed_texture::ref const& new_texture,
+                    int new_offset
+                    )
+                    : texture(new_texture)
+                    , offset(new_offset)
+                {}
+
+                texture_manager::streamed_texture::ref texture;
+                int offset;
+            };
+            typedef std::vector<texture_handle_location> texture_handle_vector;
+
             void create_static_ubo_initializer(
                 referenced_buffer_from_sizeof::ref& initializer_data,
                 serialize::serializable_map::ref const& field_initializer,
-                graphics::uniform_buffer_descriptor::ref const& ubo_desc
+                graphics::uniform_buffer_descriptor::ref const& ubo_desc,
+                texture_handle_vector* out_texture_handles
                 );
 
             // Initialization data.
@@ -125,6 +146,21 @@ namespace electroslag {
             // Shader.
             graphics::shader_program_interface::ref m_shader;
 
+            // Textures still streaming in; their handles can't be written to
+            // UBOs until they are finished.
+            typedef std::vector<graphics::texture_interface::ref> texture_vector;
+            texture_vector m_pending_textures;
+
+            // Every texture the static UBOs reference; meshes report their screen size
+            // through the pipeline to drive mip streaming.
+            typedef std::vector<texture_manager::streamed_texture::ref> streamed_texture_vector;
+            streamed_texture_vector m_streamed_textures;
+
+            // Textures referenced by index into the bindless texture table; they must be
+            // in the table before the pipeline can draw with them.
+            streamed_texture_vector m_pending_table_textures;
+            bool m_uses_texture_table;
+
             // All of the necessary static UBO bindings.
             struct ubo_binding {
                 ubo_binding(
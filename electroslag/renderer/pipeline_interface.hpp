@@ -46,6 +46,10 @@ namespace electroslag {
                 int dynamic_ubo_base_offset
                 ) const = 0;
 
+            // Called by meshes that passed culling with their approximate size on screen,
+            // in pixels, so the textures they sample can stream in the levels needed.
+            virtual void request_texture_detail(float screen_pixels) = 0;
+
         protected:
             pipeline_interface()
             {}
@@ -76,6 +76,12 @@ namespace electroslag {
             return ((*p).second);
         }
 
+        bool pipeline_manager::has_pending_pipelines() const
+        {
+            threading::lock_guard pipeline_manager_lock(&m_mutex);
+            return (!m_not_ready_pipelines.empty());
+        }
+
         void pipeline_manager::prepare_pipelines_for_frame(frame_details*)
         {
             // This method is called once a frame to pump pipeline initialization stepping.
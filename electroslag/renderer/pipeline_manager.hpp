@@ -38,6 +38,8 @@ namespace electroslag {
 
             void prepare_pipelines_for_frame(frame_details*);
 
+            bool has_pending_pipelines() const;
+
         private:
             mutable threading::mutex m_mutex;
 
@@ -39,6 +39,10 @@ namespace electroslag {
             , m_frame_delegate(0)
             , m_geometry_pass_count(0)
             , m_current_frame_index(0)
+            , m_frames_in_flight(max_frames_in_flight)
+            , m_frame_pacing_mode(frame_pacing_mode_throughput)
+            , m_stats_mutex(ELECTROSLAG_STRING_AND_HASH("m:renderer_stats"))
+            , m_last_present_nanoseconds(0)
             , m_initialized(false)
         {}
 
@@ -69,8 +73,10 @@ namespace electroslag {
             m_shader_program_manager.initialize();
 
             // Setup per-frame data
-            for (int i = 0; i < per_frame_count; ++i) {
+            for (int i = 0; i < max_frames_in_flight; ++i) {
                 m_per_frame_details[i].reset();
+                m_per_frame_details[i].frame_index = i;
+                m_per_frame_details[i].in_flight.store(false);
                 m_per_frame_details[i].sync = graphics::get_graphics()->create_sync();
             }
 
@@ -191,7 +197,71 @@ namespace electroslag {
 
         }
 
-        void renderer::on_window_frame(int millisec_elapsed)
+        double renderer::get_fixed_step_millisec() const
+        {
+            threading::lock_guard renderer_lock(&m_mutex);
+            return (m_fixed_step.get_step_millisec());
+        }
+
+        void renderer::set_fixed_step_millisec(double step_millisec)
+        {
+            threading::lock_guard renderer_lock(&m_mutex);
+            m_fixed_step.set_step_millisec(step_millisec);
+        }
+
+        frame_pacing_mode renderer::get_frame_pacing_mode() const
+        {
+            threading::lock_guard renderer_lock(&m_mutex);
+            return (m_frame_pacing_mode);
+        }
+
+        int renderer::get_frames_in_flight() const
+        {
+            threading::lock_guard renderer_lock(&m_mutex);
+            return (m_frames_in_flight);
+        }
+
+        void renderer::set_frame_pacing(frame_pacing_mode mode, int frames_in_flight)
+        {
+            if (mode <= frame_pacing_mode_unknown || mode >= frame_pacing_mode_count) {
+                throw parameter_failure("mode");
+            }
+            if (frames_in_flight < 1 || frames_in_flight > max_frames_in_flight) {
+                throw parameter_failure("frames_in_flight");
+            }
+
+            threading::lock_guard renderer_lock(&m_mutex);
+
+            // Let every outstanding frame finish so slot rotation can restart cleanly.
+            for (int i = 0; i < max_frames_in_flight; ++i) {
+                wait_for_frame(&m_per_frame_details[i], &renderer_lock);
+            }
+
+            m_frame_pacing_mode = mode;
+            m_frames_in_flight = frames_in_flight;
+            m_current_frame_index = 0;
+        }
+
+        frame_timing_stats renderer::get_frame_timing_stats() const
+        {
+            threading::lock_guard stats_lock(&m_stats_mutex);
+            return (m_frame_timing_stats);
+        }
+
+        // static
+        void renderer::wait_for_frame(frame_details* this_frame_details, threading::lock_guard* renderer_lock)
+        {
+            // A slot is in flight from the moment it is handed out, so this also waits
+            // out any work items still reading it.
+            if (this_frame_details->in_flight.load(std::memory_order_acquire)) {
+                while (!this_frame_details->sync->is_signaled()) {
+                    this_frame_details->sync->wait(renderer_lock);
+                }
+                this_frame_details->in_flight.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        void renderer::on_window_frame(double millisec_elapsed)
         {
             threading::lock_guard renderer_lock(&m_mutex);
             check_initialized();
@@ -201,30 +271,50 @@ namespace electroslag {
                 return;
             }
 
+            ui::timer_interface* timer = ui::get_ui()->get_timer();
+            long long wait_begin = timer->read_nanoseconds();
+
+            // In low latency mode nothing is queued behind the previous frame, so
+            // this frame's input and animation reflect the latest possible state.
+            if (m_frame_pacing_mode == frame_pacing_mode_low_latency) {
+                wait_for_frame(&m_per_frame_details[m_current_frame_index], &renderer_lock);
+            }
+
             // Rotate through the per-frame data structures.
             m_current_frame_index++;
-            if (m_current_frame_index == per_frame_count) {
+            if (m_current_frame_index >= m_frames_in_flight) {
                 m_current_frame_index = 0;
             }
             frame_details* this_frame_details = &m_per_frame_details[m_current_frame_index];
-            this_frame_details->reset();
-            this_frame_details->millisec_elapsed = millisec_elapsed;
-            this_frame_details->r = this;
 
             // Ensure the per-frame data we intend to use is no longer in use by the GPU.
-            if (this_frame_details->sync->is_set()) {
-                this_frame_details->sync->wait(&renderer_lock);
-            }
+            wait_for_frame(this_frame_details, &renderer_lock);
             this_frame_details->sync->clear();
 
+            long long wait_end = timer->read_nanoseconds();
+
+            this_frame_details->reset();
+            this_frame_details->in_flight.store(true, std::memory_order_release);
+            this_frame_details->time = m_fixed_step.advance(millisec_elapsed);
+            this_frame_details->time.frame_slot = this_frame_details->frame_index;
+            this_frame_details->r = this;
+            this_frame_details->fence_wait_nanoseconds = wait_end - wait_begin;
+            this_frame_details->submit_begin_nanoseconds = wait_end;
+
             // Tick any pipelines still working on initialization.
             m_pipeline_manager.prepare_pipelines_for_frame(this_frame_details);
 
+            // Swap in and start loading textures based on what was on screen last frame.
+            m_texture_manager.stream_textures_for_frame(this_frame_details);
+
             // Wait for UBO space to be available. (Likely the fence is already passed.)
             m_ubo_manager.prepare_dynamic_ubo_for_frame(this_frame_details);
 
-            // Apply all pending controller modifications.
-            animation::get_property_manager_internal()->apply_controller_changes();
+            // Apply all pending controller modifications, then evaluate pooled properties
+            // before any mesh or camera reads them.
+            animation::property_manager* pm = animation::get_property_manager_internal();
+            pm->apply_controller_changes();
+            pm->evaluate_property_pools(this_frame_details->time);
 
             // Generate a thread pool work item to update and transform all scenes.
             scene_vector::iterator s(m_scenes.begin());
@@ -245,29 +335,90 @@ namespace electroslag {
                 (*s)->make_render_work_item(this_frame_details);
                 ++s;
             }
+
+            // With no mesh left to finish it, the frame still has to signal its sync.
+            if (this_frame_details->total_meshes == 0) {
+                finish_frame(this_frame_details);
+            }
         }
 
         void renderer::finish_rendering_mesh(frame_details* this_frame_details)
         {
             int completed_meshes = this_frame_details->completed_meshes.fetch_add(1);
             if (completed_meshes + 1 == this_frame_details->total_meshes) {
-                // Spawn a last command that will execute at the end of the frame.
-                this_frame_details->r->m_post_frame_queue->enqueue_command<finish_drawing_command>(this_frame_details);
-
-                // Send all graphics commands generated by the frame handlers to the render thread.
-                graphics::get_graphics()->flush_commands();
+                finish_frame(this_frame_details);
             }
         }
 
+        void renderer::finish_frame(frame_details* this_frame_details)
+        {
+            this_frame_details->cpu_submit_nanoseconds =
+                ui::get_ui()->get_timer()->read_nanoseconds() - this_frame_details->submit_begin_nanoseconds;
+
+            // Spawn a last command that will execute at the end of the frame.
+            m_post_frame_queue->enqueue_command<finish_drawing_command>(this_frame_details);
+
+            // Send all graphics commands generated by the frame handlers to the render thread.
+            graphics::get_graphics()->flush_commands();
+        }
+
         void renderer::finish_drawing_command::execute(graphics::context_interface* context)
         {
             // The execution of all drawing commands by the graphics API calls should be done.
 
+            // Once the sync point is set the frame slot may be re-used; read it first.
+            renderer* r = m_this_frame_details->r;
+            long long fence_wait_nanoseconds = m_this_frame_details->fence_wait_nanoseconds;
+            long long cpu_submit_nanoseconds = m_this_frame_details->cpu_submit_nanoseconds;
+
             // The UBO allocator uses a fence to track when the UBO space is ready to re-use, set it.
             context->set_sync_point(m_this_frame_details->sync);
 
             // Swap all drawing on screen!
             context->swap();
+
+            r->record_frame_timing(fence_wait_nanoseconds, cpu_submit_nanoseconds);
+        }
+
+        void renderer::record_frame_timing(long long fence_wait_nanoseconds, long long cpu_submit_nanoseconds)
+        {
+            static double const smoothing = 0.1;
+            static long long const log_interval = 300;
+
+            long long present_nanoseconds = ui::get_ui()->get_timer()->read_nanoseconds();
+
+            threading::lock_guard stats_lock(&m_stats_mutex);
+
+            double fence_wait = static_cast<double>(fence_wait_nanoseconds) / 1000000.0;
+            double cpu_submit = static_cast<double>(cpu_submit_nanoseconds) / 1000000.0;
+            double present_interval = 0.0;
+            if (m_last_present_nanoseconds) {
+                present_interval = static_cast<double>(present_nanoseconds - m_last_present_nanoseconds) / 1000000.0;
+            }
+            m_last_present_nanoseconds = present_nanoseconds;
+
+            frame_timing_stats* stats = &m_frame_timing_stats;
+            if (stats->frame_count == 0) {
+                stats->fence_wait_millisec = fence_wait;
+                stats->cpu_submit_millisec = cpu_submit;
+                stats->present_interval_millisec = present_interval;
+            }
+            else {
+                stats->fence_wait_millisec += (fence_wait - stats->fence_wait_millisec) * smoothing;
+                stats->cpu_submit_millisec += (cpu_submit - stats->cpu_submit_millisec) * smoothing;
+                stats->present_interval_millisec += (present_interval - stats->present_interval_millisec) * smoothing;
+            }
+            stats->frame_count++;
+
+            if ((stats->frame_count % log_interval) == 0) {
+                ELECTROSLAG_LOG_GFX(
+                    "frame_timing - [frames:%lld] [cpu_submit:%.3fms] [fence_wait:%.3fms] [present_interval:%.3fms]",
+                    stats->frame_count,
+                    stats->cpu_submit_millisec,
+                    stats->fence_wait_millisec,
+                    stats->present_interval_millisec
+                    );
+            }
         }
     }
 }
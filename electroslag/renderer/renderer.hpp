@@ -54,6 +54,30 @@ namespace electroslag {
 
             virtual scene::ref create_instances(instance_descriptor::ref const& desc);
 
+            virtual double get_fixed_step_millisec() const;
+            virtual void set_fixed_step_millisec(double step_millisec);
+
+            virtual frame_pacing_mode get_frame_pacing_mode() const;
+            virtual int get_frames_in_flight() const;
+            virtual void set_frame_pacing(frame_pacing_mode mode, int frames_in_flight);
+
+            virtual frame_timing_stats get_frame_timing_stats() const;
+
+            virtual float get_texture_memory_megabytes() const
+            {
+                return (static_cast<float>(m_texture_manager.get_budget_bytes()) / (1024.0f * 1024.0f));
+            }
+
+            virtual void set_texture_memory_megabytes(float megabytes)
+            {
+                m_texture_manager.set_budget_bytes(static_cast<long long>(megabytes * 1024.0f * 1024.0f));
+            }
+
+            virtual bool has_pending_pipelines() const
+            {
+                return (m_pipeline_manager.has_pending_pipelines());
+            }
+
             typedef event<void, scene::ref const&> scene_created_event;
             typedef scene_created_event::bound_delegate scene_created_delegate;
             mutable scene_created_event scene_created;
@@ -137,7 +161,13 @@ namespace electroslag {
             void on_window_destroyed();
             void on_window_size_changed(ui::window_dimensions const* dimensions);
             void on_window_paused_changed(bool paused);
-            void on_window_frame(int millisec_elapsed);
+            void on_window_frame(double millisec_elapsed);
+
+            static void wait_for_frame(frame_details* this_frame_details, threading::lock_guard* renderer_lock);
+            void finish_frame(frame_details* this_frame_details);
+
+            // Called on the render thread after each swap.
+            void record_frame_timing(long long fence_wait_nanoseconds, long long cpu_submit_nanoseconds);
 
             mutable threading::mutex m_mutex;
 
@@ -161,10 +191,18 @@ namespace electroslag {
             shader_program_manager m_shader_program_manager;
             pipeline_manager m_pipeline_manager;
 
-            static constexpr int const per_frame_count = graphics::context_interface::display_buffer_count + 1;
-            frame_details m_per_frame_details[per_frame_count];
+            frame_details m_per_frame_details[max_frames_in_flight];
 
             int m_current_frame_index;
+            int m_frames_in_flight;
+            frame_pacing_mode m_frame_pacing_mode;
+
+            animation::fixed_step_accumulator m_fixed_step;
+
+            // Written by the render thread.
+            mutable threading::mutex m_stats_mutex;
+            frame_timing_stats m_frame_timing_stats;
+            long long m_last_present_nanoseconds;
 
             bool m_initialized;
 
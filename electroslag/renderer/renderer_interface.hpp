@@ -43,6 +43,28 @@ namespace electroslag {
 
             virtual scene::ref create_instances(instance_descriptor::ref const& desc) = 0;
 
+            // Animate in fixed steps of this many milliseconds, interpolating between
+            // steps for display. Zero (the default) animates by the frame's elapsed time.
+            virtual double get_fixed_step_millisec() const = 0;
+            virtual void set_fixed_step_millisec(double step_millisec) = 0;
+
+            // Throughput mode lets up to frames_in_flight frames queue on the GPU.
+            // Low latency mode waits for the previous frame before starting the next,
+            // so input is sampled as close to display as possible.
+            virtual frame_pacing_mode get_frame_pacing_mode() const = 0;
+            virtual int get_frames_in_flight() const = 0;
+            virtual void set_frame_pacing(frame_pacing_mode mode, int frames_in_flight) = 0;
+
+            virtual frame_timing_stats get_frame_timing_stats() const = 0;
+
+            // Memory budget for streamed texture mip levels. Textures start with only their
+            // smallest levels and load more as meshes using them get larger on screen.
+            virtual float get_texture_memory_megabytes() const = 0;
+            virtual void set_texture_memory_megabytes(float megabytes) = 0;
+
+            // True while any pipeline is still compiling or otherwise not ready to draw.
+            virtual bool has_pending_pipelines() const = 0;
+
             typedef event<void> destroyed_event;
             typedef destroyed_event::bound_delegate destroyed_delegate;
             mutable destroyed_event destroyed;
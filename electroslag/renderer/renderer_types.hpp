@@ -15,8 +15,10 @@
 
 #pragma once
 #include "electroslag/threading/work_item_interface.hpp"
+#include "electroslag/animation/frame_time.hpp"
 #include "electroslag/graphics/sync_interface.hpp"
 #include "electroslag/graphics/buffer_interface.hpp"
+#include "electroslag/graphics/context_interface.hpp"
 
 namespace electroslag {
     namespace renderer {
@@ -91,41 +93,127 @@ namespace electroslag {
             "camera_render_target_fbo"
         };
 
+        enum frame_pacing_mode {
+            frame_pacing_mode_unknown = -1,
+            frame_pacing_mode_throughput,  // Wait only when every frame slot is in flight.
+            frame_pacing_mode_low_latency, // Wait for the previous frame before sampling input.
+
+            frame_pacing_mode_count // Ensure this is the last enum entry
+        };
+
+        static char const* const frame_pacing_mode_strings[frame_pacing_mode_count] = {
+            "frame_pacing_mode_throughput",
+            "frame_pacing_mode_low_latency"
+        };
+
+        static constexpr int const max_frames_in_flight = graphics::context_interface::display_buffer_count + 1;
+        ELECTROSLAG_STATIC_CHECK(max_frames_in_flight <= animation::max_frame_slots, "Animation keeps too few frame slots");
+
+        // Smoothed over recent frames, in milliseconds.
+        struct frame_timing_stats {
+            frame_timing_stats()
+                : frame_count(0)
+                , cpu_submit_millisec(0.0)
+                , fence_wait_millisec(0.0)
+                , present_interval_millisec(0.0)
+            {}
+
+            long long frame_count;
+
+            // From the end of the fence wait until the frame's commands are flushed.
+            double cpu_submit_millisec;
+
+            // Time the frame thread spent blocked on earlier frames' fences.
+            double fence_wait_millisec;
+
+            // Time between successive swaps on the render thread.
+            double present_interval_millisec;
+        };
+
+        typedef threading::work_item_interface frame_work_item;
+        typedef frame_work_item::work_item_vector frame_work_item_vector;
+
         class renderer;
+        class mesh_interface;
+
+        // A mesh that hides others, with the work item that places it this frame.
+        struct frame_occluder {
+            frame_occluder(mesh_interface* new_mesh, frame_work_item::ref const& new_transform)
+                : mesh(new_mesh)
+                , transform(new_transform)
+            {}
+
+            mesh_interface* mesh;
+            frame_work_item::ref transform;
+        };
+        typedef std::vector<frame_occluder> frame_occluder_vector;
+
         struct frame_details {
+            frame_details()
+                : frame_index(0)
+                , in_flight(false)
+            {
+                reset();
+            }
+
             void reset()
             {
-                millisec_elapsed = 0;
+                time = animation::frame_time();
                 r = 0;
 
                 dynamic_ubo_size = 0;
                 dynamic_ubo.reset();
                 mapped_dynamic_ubo = 0;
 
+                texture_table.reset();
+
                 total_meshes = 0;
                 completed_meshes.store(0);
 
-                // Don't reset the sync object; its re-used frame to frame.
+                camera_transforms.clear();
+                occluders.clear();
+
+                fence_wait_nanoseconds = 0;
+                submit_begin_nanoseconds = 0;
+                cpu_submit_nanoseconds = 0;
+
+                // Don't reset the sync object or slot tracking; they're re-used frame to frame.
             }
 
             // High level details about the frame.
-            int millisec_elapsed;
+            animation::frame_time time;
             renderer* r;
 
+            // Which frame slot this is; other per-frame resources rotate in step with it.
+            int frame_index;
+
             // Sync object the GPU signals when done rendering the frame.
             graphics::sync_interface::ref sync;
 
+            // Set when the slot is handed out for a frame, cleared once its sync is signaled.
+            std::atomic<bool> in_flight;
+
+            // Frame pacing timings, on the ui timer clock.
+            long long fence_wait_nanoseconds;
+            long long submit_begin_nanoseconds;
+            long long cpu_submit_nanoseconds;
+
             // Per-frame (aka "dynamic") UBOs are created from this one single buffer.
             int dynamic_ubo_size;
             graphics::buffer_interface::ref dynamic_ubo;
             byte* mapped_dynamic_ubo;
 
+            // The bindless texture table as of the start of the frame; holding it here keeps
+            // a replaced table alive until the frames using it are done.
+            graphics::buffer_interface::ref texture_table;
+
             // Track mesh render work item completion.
             int total_meshes;
             std::atomic<int> completed_meshes;
-        };
 
-        typedef threading::work_item_interface frame_work_item;
-        typedef frame_work_item::work_item_vector frame_work_item_vector;
+            // Occlusion culling has to wait until the cameras and occluders are placed.
+            frame_work_item_vector camera_transforms;
+            frame_occluder_vector occluders;
+        };
     }
 }
@@ -18,36 +18,169 @@
 #include "electroslag/renderer/scene.hpp"
 #include "electroslag/renderer/static_mesh.hpp"
 #include "electroslag/renderer/camera.hpp"
+#include "electroslag/animation/keyframe_controller.hpp"
 
 namespace electroslag {
     namespace renderer {
         scene::scene(instance_descriptor::ref const& scene_desc)
-            : m_visible(false)
+            : m_clip_mutex(ELECTROSLAG_STRING_AND_HASH("m:scene_clips"))
+            , m_stop_clips(false)
+            , m_visible(false)
+            , m_visible_this_frame(false)
         {
-            load_instance(scene_desc, transform_desciptor::ref::null_ref);
+            load_hierarchy(scene_desc);
 
             m_mesh_transforms.resize(m_meshes.size());
             m_camera_transforms.resize(m_cameras.size());
         }
 
+        void scene::load_hierarchy(instance_descriptor::ref const& scene_desc)
+        {
+            // Walk the instances breadth first so the hierarchy is built level by level.
+            struct pending_instance {
+                pending_instance(instance_descriptor::ref const& new_desc, int new_parent_node)
+                    : desc(new_desc)
+                    , parent_node(new_parent_node)
+                {}
+
+                instance_descriptor::ref desc;
+                int parent_node;
+            };
+            std::deque<pending_instance> pending;
+            pending.emplace_back(scene_desc, transform_hierarchy::no_parent);
+
+            // Skins can name joints anywhere in the scene, so deformers wait for every node.
+            typedef std::vector<std::pair<instance_descriptor::ref, int> > deformed_vector;
+            deformed_vector deformed;
+
+            while (!pending.empty()) {
+                pending_instance this_instance(pending.front());
+                pending.pop_front();
+
+                int node = m_hierarchy.insert_node(this_instance.parent_node, this_instance.desc->get_transform());
+                m_node_map.emplace(this_instance.desc->get_hash(), node);
+                load_instance(this_instance.desc, node);
+
+                if (this_instance.desc->get_deformation().is_valid()) {
+                    deformed.emplace_back(std::make_pair(this_instance.desc, node));
+                }
+
+                instance_descriptor::const_instance_iterator c(this_instance.desc->begin_child_instances());
+                while (c != this_instance.desc->end_child_instances()) {
+                    pending.emplace_back(*c, node);
+                    ++c;
+                }
+            }
+
+            deformed_vector::const_iterator d(deformed.begin());
+            while (d != deformed.end()) {
+                load_deformer(d->first, d->second);
+                ++d;
+            }
+        }
+
+        void scene::load_deformer(instance_descriptor::ref const& instance_desc, int hierarchy_node)
+        {
+            skin_descriptor::ref const& skin = instance_desc->get_skin();
+
+            std::vector<int> joint_nodes;
+            if (skin.is_valid()) {
+                int joint_count = skin->get_joint_count();
+                joint_nodes.reserve(joint_count);
+                for (int j = 0; j < joint_count; ++j) {
+                    node_map::const_iterator n(m_node_map.find(skin->get_joint_hash(j)));
+                    if (n == m_node_map.end()) {
+                        throw load_object_failure("skin joint");
+                    }
+                    joint_nodes.emplace_back(n->second);
+                }
+            }
+
+            deformer::ref new_deformer(deformer::create(
+                instance_desc->get_deformation(),
+                skin,
+                &m_hierarchy,
+                hierarchy_node,
+                joint_nodes.data()
+                ));
+            m_deformers.emplace_back(new_deformer);
+
+            // The instance's mesh draws the deformed vertices in place of its own.
+            renderable_descriptor::ref const& renderable_desc = instance_desc->get_renderable();
+            if (renderable_desc.is_valid() && static_mesh::supported_component_bits(renderable_desc->get_component_bits())) {
+                deformer::check_vertex_layout(
+                    instance_desc->get_deformation().get_pointer(),
+                    renderable_desc->get_geometry_component()->get_primitive_stream().get_pointer()
+                    );
+                find_mesh(instance_desc->get_hash()).cast<static_mesh>()->set_deformer(new_deformer);
+            }
+        }
+
+        deformer::ref const& scene::find_deformer(unsigned long long instance_hash) const
+        {
+            node_map::const_iterator n(m_node_map.find(instance_hash));
+            if (n != m_node_map.end()) {
+                deformer_vector::const_iterator d(m_deformers.begin());
+                while (d != m_deformers.end()) {
+                    if ((*d)->get_mesh_node() == n->second) {
+                        return (*d);
+                    }
+                    ++d;
+                }
+            }
+            return (deformer::ref::null_ref);
+        }
+
+        bool scene::locate_morph_target(
+            int hierarchy_node,
+            unsigned long long property_hash,
+            deformer** out_deformer,
+            int* out_target
+            )
+        {
+            deformer_vector::iterator d(m_deformers.begin());
+            while (d != m_deformers.end()) {
+                if ((*d)->get_mesh_node() == hierarchy_node) {
+                    int morph_target_count = (*d)->get_deformation()->get_morph_target_count();
+                    for (int t = 0; t < morph_target_count; ++t) {
+                        if (deformation_descriptor::get_morph_weight_hash(t) == property_hash) {
+                            *out_deformer = d->get_pointer();
+                            *out_target = t;
+                            return (true);
+                        }
+                    }
+                    return (false);
+                }
+                ++d;
+            }
+            return (false);
+        }
+
         void scene::load_instance(
             instance_descriptor::ref const& instance_desc,
-            transform_descriptor::ref const& parent_transform_desc
+            int hierarchy_node
             )
         {
-            int component_bits = r->descriptor->get_component_bits();
+            // Instances without a renderable only group and transform their children.
+            renderable_descriptor::ref const& renderable_desc = instance_desc->get_renderable();
+            if (!renderable_desc.is_valid()) {
+                return;
+            }
+
+            int component_bits = renderable_desc->get_component_bits();
             if (static_mesh::supported_component_bits(component_bits)) {
                 m_meshes.emplace_back(static_mesh::create(
-                    r->descriptor,
-                    r->transform,
-                    r->name_hash
+                    renderable_desc,
+                    &m_hierarchy,
+                    hierarchy_node,
+                    instance_desc->get_hash()
                     ).cast<mesh_interface>());
             }
             else if (camera::supported_component_bits(component_bits)) {
                 m_cameras.emplace_back(camera::create(
-                    r->descriptor,
-                    r->transform,
-                    r->name_hash
+                    renderable_desc,
+                    instance_desc->get_transform(),
+                    instance_desc->get_hash()
                     ));
             }
             else {
@@ -65,14 +198,160 @@ namespace electroslag {
             m_visible.store(false);
         }
 
+        void scene::play_animation_clip(animation::animation_clip::ref const& clip, bool loop)
+        {
+            threading::lock_guard clip_lock(&m_clip_mutex);
+            m_pending_clip_players.emplace_back(clip, loop);
+        }
+
+        void scene::stop_animation_clips()
+        {
+            threading::lock_guard clip_lock(&m_clip_mutex);
+            m_pending_clip_players.clear();
+            m_stop_clips = true;
+        }
+
+        void scene::animate_clips(frame_details* this_frame_details)
+        {
+            {
+                threading::lock_guard clip_lock(&m_clip_mutex);
+                if (m_stop_clips) {
+                    m_clip_players.clear();
+                    m_stop_clips = false;
+                }
+
+                // Resolve channel targets to hierarchy nodes once, when a clip starts.
+                clip_player_vector::iterator p(m_pending_clip_players.begin());
+                while (p != m_pending_clip_players.end()) {
+                    animation::animation_clip::const_channel_iterator c(p->clip->begin_channels());
+                    while (c != p->clip->end_channels()) {
+                        node_map::const_iterator n(m_node_map.find(c->target_hash));
+                        int node = (n != m_node_map.end()) ? n->second : transform_hierarchy::no_parent;
+                        p->nodes.emplace_back(node);
+                        p->tracks.emplace_back(c->track.get_pointer());
+
+                        deformer* morph_deformer = 0;
+                        int morph_target = -1;
+                        if (node != transform_hierarchy::no_parent) {
+                            locate_morph_target(node, c->property_hash, &morph_deformer, &morph_target);
+                        }
+                        p->morph_deformers.emplace_back(morph_deformer);
+                        p->morph_targets.emplace_back(morph_target);
+                        ++c;
+                    }
+                    p->cursors.resize(p->tracks.size());
+                    p->values.resize(p->tracks.size() * animation::keyframe_track::max_components);
+
+                    m_clip_players.emplace_back(*p);
+                    ++p;
+                }
+                m_pending_clip_players.clear();
+            }
+
+            float seconds_elapsed = static_cast<float>(this_frame_details->time.millisec_elapsed / 1000.0);
+
+            // Reverse iteration allows us to erase from the vector sanely.
+            int clip_count = static_cast<int>(m_clip_players.size());
+            for (int i = clip_count - 1; i >= 0; --i) {
+                clip_player* p = &m_clip_players[i];
+
+                bool finished = false;
+                float duration = p->clip->get_duration();
+                p->time += seconds_elapsed;
+                if (p->time > duration) {
+                    if (p->loop && duration > 0.0f) {
+                        p->time = std::fmod(p->time, duration);
+                    }
+                    else {
+                        p->time = duration;
+                        finished = true;
+                    }
+                }
+
+                // Every channel of a clip is sampled at the same time in one batch.
+                int channel_count = static_cast<int>(p->tracks.size());
+                m_clip_value_pointers.resize(channel_count);
+                for (int c = 0; c < channel_count; ++c) {
+                    m_clip_value_pointers[c] = &p->values[c * animation::keyframe_track::max_components];
+                }
+
+                animation::keyframe_track::sample_tracks(
+                    channel_count,
+                    p->tracks.data(),
+                    p->time,
+                    p->cursors.data(),
+                    m_clip_value_pointers.data()
+                    );
+
+                animation::animation_clip::const_channel_iterator channel(p->clip->begin_channels());
+                for (int c = 0; c < channel_count; ++c, ++channel) {
+                    int node = p->nodes[c];
+                    if (node == transform_hierarchy::no_parent) {
+                        continue;
+                    }
+
+                    float const* v = m_clip_value_pointers[c];
+                    switch (channel->property_hash) {
+                    case hash_string("rotation"): {
+                        glm::f32quat rotation;
+                        animation::keyframe_value_from_floats(v, &rotation);
+                        m_hierarchy.set_local_rotation(node, rotation);
+                        break;
+                    }
+
+                    case hash_string("scale"): {
+                        glm::f32vec3 scale;
+                        animation::keyframe_value_from_floats(v, &scale);
+                        m_hierarchy.set_local_scale(node, scale);
+                        break;
+                    }
+
+                    case hash_string("translate"): {
+                        glm::f32vec3 translate;
+                        animation::keyframe_value_from_floats(v, &translate);
+                        m_hierarchy.set_local_translate(node, translate);
+                        break;
+                    }
+
+                    default:
+                        // Weights are set before this frame's deformers are run.
+                        if (p->morph_deformers[c]) {
+                            p->morph_deformers[c]->set_morph_weight(p->morph_targets[c], v[0]);
+                        }
+                        break;
+                    }
+                }
+
+                if (finished) {
+                    m_clip_players.erase(m_clip_players.begin() + i);
+                }
+            }
+        }
+
         void scene::make_transform_work_item(frame_details* this_frame_details)
         {
+            // The frame only counts, and waits for, the meshes that will be rendered.
+            m_visible_this_frame = m_visible.load();
+
+            // Node world matrices must be current before any mesh reads them.
+            animate_clips(this_frame_details);
+            m_hierarchy.update();
+
+            // Deformation only reads the hierarchy, so it overlaps the mesh transforms.
+            m_deform_items.clear();
+            deformer_vector::iterator d(m_deformers.begin());
+            while (d != m_deformers.end()) {
+                (*d)->make_work_items(this_frame_details, &m_deform_items);
+                ++d;
+            }
+
             m_camera_transforms.clear();
             camera_vector::iterator c(m_cameras.begin());
             while (c != m_cameras.end()) {
                 m_camera_transforms.emplace_back((*c)->make_transform_work_item(
                     this_frame_details
                     ).cast<frame_work_item>());
+                this_frame_details->camera_transforms.emplace_back(m_camera_transforms.back());
                 ++c;
             }
 
@@ -83,15 +362,35 @@ namespace electroslag {
                     this_frame_details
                     ).cast<frame_work_item>());
 
-                this_frame_details->total_meshes++;
+                if (m_visible_this_frame) {
+                    if ((*m)->is_occluder()) {
+                        this_frame_details->occluders.emplace_back(m->get_pointer(), m_mesh_transforms.back());
+                    }
+
+                    this_frame_details->total_meshes++;
+                }
 
                 ++m;
             }
+
+            // Deformed vertices have to be written before any of the frame's draws are submitted.
+            frame_work_item_vector::const_iterator i(m_deform_items.begin());
+            while (i != m_deform_items.end()) {
+                (*i)->wait_for_done();
+                ++i;
+            }
+            m_deform_items.clear();
+
+            d = m_deformers.begin();
+            while (d != m_deformers.end()) {
+                (*d)->finish_work_items(this_frame_details);
+                ++d;
+            }
         }
 
         void scene::make_render_work_item(frame_details* this_frame_details)
         {
-            if (m_visible.load()) {
+            if (m_visible_this_frame) {
                 for (int m = 0; m < m_meshes.size(); ++m) {
                     m_meshes[m]->make_render_work_item(m_mesh_transforms[m], this_frame_details);
                 }
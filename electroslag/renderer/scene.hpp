@@ -14,8 +14,12 @@
 //  limitations under the License.
 
 #pragma once
+#include "electroslag/threading/mutex.hpp"
+#include "electroslag/animation/animation_clip.hpp"
 #include "electroslag/renderer/renderer_types.hpp"
 #include "electroslag/renderer/instance_descriptor.hpp"
+#include "electroslag/renderer/transform_hierarchy.hpp"
+#include "electroslag/renderer/deformer.hpp"
 #include "electroslag/renderer/mesh_interface.hpp"
 #include "electroslag/renderer/camera.hpp"
 
@@ -141,6 +145,27 @@ namespace electroslag {
                 return (static_cast<int>(m_cameras.size()));
             }
 
+            // Node transforms for every instance in the scene.
+            transform_hierarchy* get_transform_hierarchy()
+            {
+                return (&m_hierarchy);
+            }
+
+            transform_hierarchy const* get_transform_hierarchy() const
+            {
+                return (&m_hierarchy);
+            }
+
+            // Deformed vertices of the named instance, if it has any. Morph weights may be
+            // changed on the frame thread.
+            deformer::ref const& find_deformer(unsigned long long instance_hash) const;
+
+            // Play a clip on the scene's instance nodes; channels target instances by name
+            // and drive their "rotation", "scale" or "translate", or a deformed instance's
+            // morph target weights. Takes effect next frame.
+            void play_animation_clip(animation::animation_clip::ref const& clip, bool loop);
+            void stop_animation_clips();
+
         private:
             static ref create(instance_descriptor::ref const& scene_desc)
             {
@@ -149,21 +174,77 @@ namespace electroslag {
 
             explicit scene(instance_descriptor::ref const& scene_desc);
 
+            void load_hierarchy(instance_descriptor::ref const& scene_desc);
+            void load_deformer(instance_descriptor::ref const& instance_desc, int hierarchy_node);
             void load_instance(
                 instance_descriptor::ref const& instance_desc,
-                transform_descriptor::ref const& parent_transform_desc
+                int hierarchy_node
+                );
+
+            // Find the deformer on a node and which of its morph targets a clip channel's
+            // property hash names, if any.
+            bool locate_morph_target(
+                int hierarchy_node,
+                unsigned long long property_hash,
+                deformer** out_deformer,
+                int* out_target
                 );
 
+            void animate_clips(frame_details* this_frame_details);
+
             void make_transform_work_item(frame_details* this_frame_details);
             void make_render_work_item(frame_details* this_frame_details);
 
             mesh_vector m_meshes;
             camera_vector m_cameras;
 
+            transform_hierarchy m_hierarchy;
+
+            // Instance name hash to hierarchy node.
+            typedef std::unordered_map<unsigned long long, int, prehashed_key<unsigned long long> > node_map;
+            node_map m_node_map;
+
+            typedef std::vector<deformer::ref> deformer_vector;
+            deformer_vector m_deformers;
+            frame_work_item_vector m_deform_items;
+
+            // Clips being played, only touched on the frame thread.
+            struct clip_player {
+                clip_player(animation::animation_clip::ref const& new_clip, bool new_loop)
+                    : clip(new_clip)
+                    , loop(new_loop)
+                    , time(0.0f)
+                {}
+
+                animation::animation_clip::ref clip;
+                bool loop;
+                float time;
+
+                // Per channel; node is transform_hierarchy::no_parent if the target is not in this scene.
+                std::vector<int> nodes;
+                std::vector<animation::keyframe_track const*> tracks;
+
+                // Per channel; the deformer and morph target a weight channel drives, or null and -1.
+                std::vector<deformer*> morph_deformers;
+                std::vector<int> morph_targets;
+
+                std::vector<animation::keyframe_cursor> cursors;
+                std::vector<float> values;
+            };
+            typedef std::vector<clip_player> clip_player_vector;
+            clip_player_vector m_clip_players;
+            std::vector<float*> m_clip_value_pointers;
+
+            // Requests from other threads, picked up at the next frame.
+            threading::mutex m_clip_mutex;
+            clip_player_vector m_pending_clip_players;
+            bool m_stop_clips;
+
             frame_work_item_vector m_mesh_transforms;
             frame_work_item_vector m_camera_transforms;
 
             std::atomic<bool> m_visible;
+            bool m_visible_this_frame;
 
             // Disallowed operations:
             scene();
@@ -0,0 +1,49 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/renderer/skin_descriptor.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        skin_descriptor::skin_descriptor(serialize::archive_reader_interface* ar)
+        {
+            int32_t joint_count = 0;
+            if (!ar->read_int32("joint_count", &joint_count) || joint_count <= 0) {
+                throw load_object_failure("joint_count");
+            }
+
+            m_joint_hashes.resize(joint_count);
+            if (!ar->read_buffer("joints", m_joint_hashes.data(), joint_count * sizeof(unsigned long long))) {
+                throw load_object_failure("joints");
+            }
+
+            m_inverse_bind_matrices.resize(joint_count);
+            if (!ar->read_buffer("inverse_bind_matrices", m_inverse_bind_matrices.data(), joint_count * sizeof(glm::f32mat4x4))) {
+                throw load_object_failure("inverse_bind_matrices");
+            }
+        }
+
+        void skin_descriptor::save_to_archive(serialize::archive_writer_interface* ar)
+        {
+            serializable_object::save_to_archive(ar);
+
+            int joint_count = get_joint_count();
+            ar->write_int32("joint_count", joint_count);
+            ar->write_buffer("joints", m_joint_hashes.data(), joint_count * sizeof(unsigned long long));
+            ar->write_buffer("inverse_bind_matrices", m_inverse_bind_matrices.data(), joint_count * sizeof(glm::f32mat4x4));
+        }
+    }
+}
@@ -0,0 +1,73 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/serialize/serializable_object.hpp"
+#include "electroslag/serialize/archive_interface.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        // The joints of a skin, as instance hashes, each with the matrix that takes mesh
+        // space vertices in to that joint's space at bind time.
+        class skin_descriptor
+            : public referenced_object
+            , public serialize::serializable_object<skin_descriptor> {
+        public:
+            typedef reference<skin_descriptor> ref;
+
+            static ref create()
+            {
+                return (ref(new skin_descriptor()));
+            }
+
+            // Implement serializable_object
+            explicit skin_descriptor(serialize::archive_reader_interface* ar);
+            virtual void save_to_archive(serialize::archive_writer_interface* ar);
+
+            // skin_descriptor methods
+            void insert_joint(unsigned long long joint_hash, glm::f32mat4x4 const& inverse_bind_matrix)
+            {
+                m_joint_hashes.emplace_back(joint_hash);
+                m_inverse_bind_matrices.emplace_back(inverse_bind_matrix);
+            }
+
+            int get_joint_count() const
+            {
+                return (static_cast<int>(m_joint_hashes.size()));
+            }
+
+            unsigned long long get_joint_hash(int joint) const
+            {
+                return (m_joint_hashes[joint]);
+            }
+
+            glm::f32mat4x4 const& get_inverse_bind_matrix(int joint) const
+            {
+                return (m_inverse_bind_matrices[joint]);
+            }
+
+        private:
+            skin_descriptor()
+            {}
+
+            std::vector<unsigned long long> m_joint_hashes;
+            std::vector<glm::f32mat4x4> m_inverse_bind_matrices;
+
+            // Disallowed operations:
+            explicit skin_descriptor(skin_descriptor const&);
+            skin_descriptor& operator =(skin_descriptor const&);
+        };
+    }
+}
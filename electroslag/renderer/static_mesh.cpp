@@ -18,6 +18,7 @@
 #include "electroslag/graphics/graphics_interface.hpp"
 #include "electroslag/renderer/renderer_types.hpp"
 #include "electroslag/renderer/static_mesh.hpp"
+#include "electroslag/renderer/occlusion_buffer.hpp"
 #include "electroslag/renderer/renderer.hpp"
 #include "electroslag/renderer/pass_interface.hpp"
 
@@ -45,12 +46,14 @@ namespace electroslag {
 
         static_mesh::static_mesh(
             renderable_descriptor::ref const& desc,
-            transform_descriptor::ref const& transform,
+            transform_hierarchy const* hierarchy,
+            int hierarchy_node,
             unsigned long long name_hash
             )
             : mesh_interface(name_hash)
-            , m_element_count(0)
-            , m_index_buffer_start_offset(0)
+            , m_hierarchy(hierarchy)
+            , m_hierarchy_node(hierarchy_node)
+            , m_world_scale(1.0f)
             , m_index_value_offset(0)
             , m_dynamic_ubo_size(0)
             , m_dynamic_ubo_offset(0)
@@ -61,8 +64,19 @@ namespace electroslag {
 
             // Handle the geometry data.
             ELECTROSLAG_CHECK(desc->get_component_bits() & renderable_descriptor_component_bits_geometry);
-            m_element_count = desc->get_geometry_component()->get_element_count();
-            m_index_buffer_start_offset = desc->get_geometry_component()->get_index_buffer_start_offset();
+            geometry_descriptor::ref const& geometry_desc(desc->get_geometry_component());
+            int lod_count = geometry_desc->get_lod_count();
+            m_levels_of_detail.resize(lod_count);
+            for (int lod = 0; lod < lod_count; ++lod) {
+                m_levels_of_detail[lod].element_count = geometry_desc->get_lod_element_count(lod);
+                m_levels_of_detail[lod].index_buffer_start_offset = geometry_desc->get_lod_index_buffer_start_offset(lod);
+                m_levels_of_detail[lod].geometric_error = geometry_desc->get_lod_geometric_error(lod);
+            }
+            int meshlet_count = geometry_desc->get_meshlet_count();
+            m_meshlets.reserve(meshlet_count);
+            for (int m = 0; m < meshlet_count; ++m) {
+                m_meshlets.emplace_back(geometry_desc->get_meshlet(m));
+            }
             m_index_value_offset = desc->get_geometry_component()->get_index_value_offset();
             m_local_aabb = *(desc->get_geometry_component()->get_aabb());
 
@@ -70,21 +84,14 @@ namespace electroslag {
                 desc->get_geometry_component()->get_primitive_stream()
                 );
 
-            // Load transform data in to properties.
-            bool transform_component = (desc->get_component_bits() & renderable_descriptor_component_bits_transform) != 0;
-            bool transform_instance = transform.is_valid();
-            if (transform_component && transform_instance) {
-                // Quaternion rotation is not commutative. (Component rotation before instance.)
-                m_rotation.reset_value(transform->get_rotation() * desc->get_transform_component()->get_rotation());
-                m_scale.reset_value(transform->get_scale() * desc->get_transform_component()->get_scale());
-                m_translate.reset_value(transform->get_translate() * desc->get_transform_component()->get_translate());
-            }
-            else if (transform_instance) {
-                m_rotation.reset_value(transform->get_rotation());
-                m_scale.reset_value(transform->get_scale());
-                m_translate.reset_value(transform->get_translate());
-            }
-            else if (transform_component) {
+            // The shape is never drawn; it only hides other meshes.
+            if (desc->get_component_bits() & renderable_descriptor_component_bits_geometry_shape_only) {
+                desc->get_shape_component()->read_triangles(&m_occluder_positions, &m_occluder_indices);
+            }
+
+            // Load transform data in to properties. The instance transform lives in the hierarchy.
+            ELECTROSLAG_CHECK(m_hierarchy && m_hierarchy_node >= 0 && m_hierarchy_node < m_hierarchy->get_node_count());
+            if (desc->get_component_bits() & renderable_descriptor_component_bits_transform) {
                 m_rotation.reset_value(desc->get_transform_component()->get_rotation());
                 m_scale.reset_value(desc->get_transform_component()->get_scale());
                 m_translate.reset_value(desc->get_transform_component()->get_translate());
@@ -92,7 +99,7 @@ namespace electroslag {
             else {
                 m_rotation.reset_value(glm::f32quat(1.0f, 0.0f, 0.0f, 0.0f));
                 m_scale.reset_value(glm::f32vec3(1.0f, 1.0f, 1.0f));
-                m_translate.reset_value(glm::f32vec3(1.0f, 1.0f, 1.0f));
+                m_translate.reset_value(glm::f32vec3(0.0f, 0.0f, 0.0f));
             }
 
             // Load the pipelines we need for current passes that will need to render this
@@ -202,9 +209,120 @@ namespace electroslag {
             frame_details* this_frame_details
             )
         {
-            m_per_pass[type].bind(context, this_frame_details);
-            context->bind_primitive_stream(m_primitive_stream);
-            context->draw(m_element_count, m_index_buffer_start_offset, m_index_value_offset);
+            mesh_data_per_pass& pass_data = m_per_pass[type];
+            mesh_data_per_pass::cluster_draw_list const& cluster_draws = pass_data.get_cluster_draws(this_frame_details->frame_index);
+            if (cluster_draws.active && cluster_draws.element_counts.empty()) {
+                return;
+            }
+
+            pass_data.bind(context, this_frame_details);
+
+            // Fall back to the bind pose if the deformer skipped this frame.
+            int deformed_offset = -1;
+            if (m_deformer.is_valid()) {
+                deformed_offset = m_deformer->get_dynamic_offset(this_frame_details->frame_index);
+            }
+            if (deformed_offset >= 0) {
+                context->bind_primitive_stream(m_primitive_stream, this_frame_details->dynamic_ubo, deformed_offset);
+            }
+            else {
+                context->bind_primitive_stream(m_primitive_stream);
+            }
+
+            if (cluster_draws.active) {
+                context->draw_multiple(
+                    static_cast<int>(cluster_draws.element_counts.size()),
+                    cluster_draws.element_counts.data(),
+                    cluster_draws.index_buffer_start_offsets.data(),
+                    m_index_value_offset
+                    );
+            }
+            else {
+                level_of_detail const& lod = m_levels_of_detail[cluster_draws.level_of_detail];
+                context->draw(lod.element_count, lod.index_buffer_start_offset, m_index_value_offset);
+            }
+        }
+
+        float const static_mesh::lod_max_error_pixels = 1.0f;
+        float const static_mesh::lod_hysteresis = 0.75f;
+
+        void static_mesh::select_level_of_detail(
+            pipeline_type type,
+            float pixels_per_unit,
+            frame_details* this_frame_details
+            )
+        {
+            mesh_data_per_pass& pass_data = m_per_pass[type];
+            int lod = pass_data.get_level_of_detail();
+            int last_lod = static_cast<int>(m_levels_of_detail.size()) - 1;
+
+            // Errors are stored in local units; bring them to pixels.
+            float error_to_pixels = m_world_scale * pixels_per_unit;
+
+            // Refine while the current level shows too much error, then coarsen while the
+            // next level fits comfortably. The gap between the two thresholds is the hysteresis.
+            while (lod > 0 && m_levels_of_detail[lod].geometric_error * error_to_pixels > lod_max_error_pixels) {
+                --lod;
+            }
+            while (lod < last_lod &&
+                m_levels_of_detail[lod + 1].geometric_error * error_to_pixels <= lod_max_error_pixels * lod_hysteresis) {
+                ++lod;
+            }
+
+            pass_data.set_level_of_detail(lod);
+            pass_data.get_cluster_draws(this_frame_details->frame_index).level_of_detail = lod;
+        }
+
+        void static_mesh::cull_clusters(
+            pipeline_type type,
+            cluster_cull_view const* view,
+            frame_details* this_frame_details
+            )
+        {
+            mesh_data_per_pass& pass_data = m_per_pass[type];
+            mesh_data_per_pass::cluster_draw_list& cluster_draws = pass_data.get_cluster_draws(this_frame_details->frame_index);
+            cluster_draws.element_counts.clear();
+            cluster_draws.index_buffer_start_offsets.clear();
+
+            // Clusters only partition the finest level of detail, and their bounds and
+            // cones only hold for the bind pose.
+            cluster_draws.active = (!m_meshlets.empty() && !m_deformer.is_valid() && cluster_draws.level_of_detail == 0);
+            if (!cluster_draws.active) {
+                return;
+            }
+
+            // Facing is tested in local space, where the cones were built; that holds under
+            // any affine transform. The frustum is tested in world space with a sphere
+            // grown by the largest axis scale.
+            glm::f32vec3 local_eye(m_world_to_local * glm::f32vec4(view->eye_position, 1.0f));
+
+            meshlet_vector::const_iterator m(m_meshlets.begin());
+            while (m != m_meshlets.end()) {
+                bool culled = false;
+
+                if (view->perspective) {
+                    glm::f32vec3 eye_to_center(m->center - local_eye);
+                    culled = (glm::dot(eye_to_center, m->cone_axis) >= (m->cone_cutoff * glm::length(eye_to_center)) + m->radius);
+                }
+
+                if (!culled) {
+                    glm::f32vec3 world_center(m_local_to_world * glm::f32vec4(m->center, 1.0f));
+                    float world_radius = m->radius * m_world_scale;
+                    for (int plane = 0; plane < view->frustum_plane_count; ++plane) {
+                        if (view->frustum_planes[plane].signed_distance(world_center) < -world_radius) {
+                            culled = true;
+                            break;
+                        }
+                    }
+                }
+
+                // Meshlets are contiguous in the index buffer, so neighbors that both
+                // survive share one range.
+                if (!culled) {
+                    cluster_draws.append_range(m->element_count, m->index_buffer_start_offset);
+                }
+                ++m;
+            }
         }
 
         bool static_mesh::is_semi_transparent(pipeline_type type) const
@@ -217,11 +335,27 @@ namespace electroslag {
             return (false);
         }
 
+        void static_mesh::rasterize_occluder(occlusion_buffer* buffer, glm::f32mat4x4 const& world_to_clip) const
+        {
+            // Until the first transform there is no placement to draw at.
+            if (m_initialization_step.load(std::memory_order_acquire) != initialization_step_ready || m_occluder_indices.empty()) {
+                return;
+            }
+
+            buffer->rasterize_triangles(
+                world_to_clip * m_local_to_world,
+                m_occluder_positions.data(),
+                static_cast<int>(m_occluder_positions.size() / 3),
+                m_occluder_indices.data(),
+                static_cast<int>(m_occluder_indices.size())
+                );
+        }
+
         void static_mesh::initialize_step(frame_details* this_frame_details)
         {
             renderer* r = this_frame_details->r;
 
-            switch (m_initialization_step) {
+            switch (m_initialization_step.load(std::memory_order_relaxed)) {
             case initialization_step_wait_for_pipelines: {
                 // Wait for all of the pipelines to report they are ready; sum up dynamic ubo usage.
                 m_dynamic_ubo_size = 0;
@@ -241,7 +375,7 @@ namespace electroslag {
                 }
 
                 if (pipelines_ready) {
-                    m_initialization_step = initialization_step_request_ubo;
+                    m_initialization_step.store(initialization_step_request_ubo, std::memory_order_relaxed);
                 }
                 break;
             }
@@ -279,14 +413,15 @@ namespace electroslag {
                     ++p;
                 }
 
-                m_initialization_step = initialization_step_wait_for_ubo;
+                m_initialization_step.store(initialization_step_wait_for_ubo, std::memory_order_relaxed);
                 break;
             }
 
             case initialization_step_wait_for_ubo: {
                 if (m_dynamic_ubo_size + m_dynamic_ubo_offset <= this_frame_details->dynamic_ubo_size) {
-                    m_initialization_step = initialization_step_ready;
                     m_local_to_world_dirty = true;
+                    update_placement(this_frame_details);
+                    m_initialization_step.store(initialization_step_ready, std::memory_order_release);
                 }
                 break;
             }
@@ -295,35 +430,47 @@ namespace electroslag {
 
         void static_mesh::transform(frame_details* this_frame_details)
         {
-            if (m_initialization_step != initialization_step_ready) {
+            if (m_initialization_step.load(std::memory_order_relaxed) == initialization_step_ready) {
+                update_placement(this_frame_details);
+            }
+            else {
                 initialize_step(this_frame_details);
             }
+        }
 
-            if (m_initialization_step == initialization_step_ready) {
-                // Animate properties
-                m_local_to_world_dirty |= (m_translate.update(this_frame_details->millisec_elapsed) == animation::property_value_state_changed);
-                m_local_to_world_dirty |= (m_scale.update(this_frame_details->millisec_elapsed) == animation::property_value_state_changed);
-                m_local_to_world_dirty |= (m_rotation.update(this_frame_details->millisec_elapsed) == animation::property_value_state_changed);
-
-                // Update transformation matrices and world space coordinates if necessary.
-                if (m_local_to_world_dirty) {
-                    // Need to translate the mesh to be centered for correct scaling / rotation.
-                    // We could precompute this and keep a member variable. Not sure that is faster.
-                    glm::f32vec3 center_translate(
-                        ((m_local_aabb.get_max_corner() - m_local_aabb.get_min_corner()) / 2.0f) + m_local_aabb.get_min_corner()
-                        );
-
-                    // M = T * S * R * CT
-                    // Geometrically: center translate, rotate, then scale, then translate
-                    m_local_to_world = glm::translate(m_translate.get_value() + center_translate);
-                    m_local_to_world = glm::scale(m_local_to_world, m_scale.get_value());
-                    m_local_to_world = m_local_to_world * glm::mat4_cast(m_rotation.get_value());
-                    m_local_to_world = m_local_to_world * glm::translate(-center_translate);
-
-                    m_world_aabb = m_local_aabb * m_local_to_world;
-
-                    m_local_to_world_dirty = false;
-                }
+        void static_mesh::update_placement(frame_details* this_frame_details)
+        {
+            // Animate properties
+            m_local_to_world_dirty |= (m_translate.update(this_frame_details->time) == animation::property_value_state_changed);
+            m_local_to_world_dirty |= (m_scale.update(this_frame_details->time) == animation::property_value_state_changed);
+            m_local_to_world_dirty |= (m_rotation.update(this_frame_details->time) == animation::property_value_state_changed);
+            m_local_to_world_dirty |= m_hierarchy->was_world_changed(m_hierarchy_node);
+
+            // Update transformation matrices and world space coordinates if necessary.
+            if (m_local_to_world_dirty) {
+                // Need to translate the mesh to be centered for correct scaling / rotation.
+                // We could precompute this and keep a member variable. Not sure that is faster.
+                glm::f32vec3 center_translate(
+                    ((m_local_aabb.get_max_corner() - m_local_aabb.get_min_corner()) / 2.0f) + m_local_aabb.get_min_corner()
+                    );
+
+                // M = W * T * S * R * CT
+                // Geometrically: center translate, rotate, then scale, then translate, then the instance node
+                m_local_to_world = m_hierarchy->get_local_to_world(m_hierarchy_node) * glm::translate(m_translate.get_value() + center_translate);
+                m_local_to_world = glm::scale(m_local_to_world, m_scale.get_value());
+                m_local_to_world = m_local_to_world * glm::mat4_cast(m_rotation.get_value());
+                m_local_to_world = m_local_to_world * glm::translate(-center_translate);
+
+                m_world_to_local = glm::inverse(m_local_to_world);
+                m_world_aabb = m_local_aabb * m_local_to_world;
+
+                // Geometric errors scale with the longest axis.
+                m_world_scale = max(
+                    glm::length(glm::f32vec3(m_local_to_world[0])),
+                    max(glm::length(glm::f32vec3(m_local_to_world[1])), glm::length(glm::f32vec3(m_local_to_world[2])))
+                    );
+
+                m_local_to_world_dirty = false;
             }
         }
 
@@ -331,7 +478,7 @@ namespace electroslag {
             frame_details* this_frame_details
             )
         {
-            if (m_initialization_step == initialization_step_ready) {
+            if (m_initialization_step.load(std::memory_order_acquire) == initialization_step_ready) {
                 mesh_interface::ref this_ref(this);
                 per_pass_vector::iterator p(m_per_pass.begin());
                 while (p != m_per_pass.end()) {
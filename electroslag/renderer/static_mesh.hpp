@@ -23,6 +23,8 @@
 #include "electroslag/renderer/renderable_descriptor.hpp"
 #include "electroslag/renderer/pipeline_interface.hpp"
 #include "electroslag/renderer/mesh_data_per_pass.hpp"
+#include "electroslag/renderer/transform_hierarchy.hpp"
+#include "electroslag/renderer/deformer.hpp"
 
 namespace electroslag {
     namespace renderer {
@@ -32,11 +34,12 @@ namespace electroslag {
 
             static mesh_interface::ref create(
                 renderable_descriptor::ref const& desc,
-                transform_descriptor::ref const& transform,
+                transform_hierarchy const* hierarchy,
+                int hierarchy_node,
                 unsigned long long name_hash
                 )
             {
-                return (mesh_interface::ref(new static_mesh(desc, transform, name_hash)));
+                return (mesh_interface::ref(new static_mesh(desc, hierarchy, hierarchy_node, name_hash)));
             }
 
             virtual ~static_mesh()
@@ -107,6 +110,13 @@ namespace electroslag {
             virtual bool is_semi_transparent(pipeline_type type) const;
             virtual bool is_skybox() const;
 
+            virtual bool is_occluder() const
+            {
+                return (!m_occluder_indices.empty());
+            }
+
+            virtual void rasterize_occluder(occlusion_buffer* buffer, glm::f32mat4x4 const& world_to_clip) const;
+
             virtual math::f32aabb const& get_world_aabb() const
             {
                 return (m_world_aabb);
@@ -117,10 +127,42 @@ namespace electroslag {
                 m_per_pass[type].set_local_to_clip(world_to_clip * m_local_to_world);
             }
 
+            virtual void request_texture_detail(pipeline_type type, float screen_pixels)
+            {
+                m_per_pass[type].get_pipeline()->request_texture_detail(screen_pixels);
+            }
+
+            virtual void select_level_of_detail(
+                pipeline_type type,
+                float pixels_per_unit,
+                frame_details* this_frame_details
+                );
+
+            virtual void cull_clusters(
+                pipeline_type type,
+                cluster_cull_view const* view,
+                frame_details* this_frame_details
+                );
+
+            // Draw positions and normals from the deformer's vertices in frames it has
+            // written them. Set while loading, after deformer::check_vertex_layout.
+            void set_deformer(deformer::ref const& new_deformer)
+            {
+                m_deformer = new_deformer;
+            }
+
+            // Largest geometric error, in pixels, a level of detail may show on screen.
+            static float const lod_max_error_pixels;
+
+            // A coarser level must fit within this fraction of the error budget before
+            // it is chosen, so meshes near a threshold do not flicker between levels.
+            static float const lod_hysteresis;
+
         protected:
             static_mesh(
                 renderable_descriptor::ref const& desc,
-                transform_descriptor::ref const& transform,
+                transform_hierarchy const* hierarchy,
+                int hierarchy_node,
                 unsigned long long name_hash
                 );
 
@@ -130,6 +172,9 @@ namespace electroslag {
 
             void transform(frame_details* this_frame_details);
 
+            // Animate the placement properties and rebuild the matrices if they changed.
+            void update_placement(frame_details* this_frame_details);
+
             void render(frame_details* this_frame_details);
 
             // Mesh initialization is spread over steps that occur over multiple frames.
@@ -140,25 +185,49 @@ namespace electroslag {
                 initialization_step_wait_for_ubo = 2,
                 initialization_step_ready = 3
             };
-            initialization_step m_initialization_step;
+
+            // Only transform advances the steps. Ready is stored with release once the mesh
+            // is placed, so occluders rasterized for another frame in flight can load it
+            // with acquire and read the matrices.
+            std::atomic<initialization_step> m_initialization_step;
 
             // Spatial representation; shape defined by primitives, aabb, and transform.
             animation::quat_property<hash_string("rotation")> m_rotation;
             animation::vec3_property<hash_string("scale")> m_scale;
             animation::vec3_property<hash_string("translate")> m_translate;
 
+            // Instance node whose world matrix is applied after the mesh transform.
+            transform_hierarchy const* m_hierarchy;
+            int m_hierarchy_node;
+
             glm::f32mat4x4 m_local_to_world;
+            glm::f32mat4x4 m_world_to_local;
+            float m_world_scale;
 
             math::f32aabb m_local_aabb;
             math::f32aabb m_world_aabb;
 
             graphics::primitive_stream_interface::ref m_primitive_stream;
+            deformer::ref m_deformer;
 
-            // Draw call parameters.
-            int m_element_count;
-            int m_index_buffer_start_offset;
+            // Draw call parameters; one range of the index buffer per level of detail.
+            struct level_of_detail {
+                int element_count;
+                int index_buffer_start_offset;
+                float geometric_error;
+            };
+            typedef std::vector<level_of_detail> level_of_detail_vector;
+            level_of_detail_vector m_levels_of_detail;
             int m_index_value_offset;
 
+            // A shape component makes the mesh an occluder; its triangles, in local space.
+            std::vector<float> m_occluder_positions;
+            std::vector<uint32_t> m_occluder_indices;
+
+            // Clusters of level 0, in local space; empty if the geometry was not split.
+            typedef std::vector<geometry_descriptor::meshlet> meshlet_vector;
+            meshlet_vector m_meshlets;
+
             // Total dynamic UBO allocation details.
             int m_dynamic_ubo_size;
             int m_dynamic_ubo_offset;
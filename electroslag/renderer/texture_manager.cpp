@@ -21,6 +21,10 @@ namespace electroslag {
     namespace renderer {
         texture_manager::texture_manager()
             : m_mutex(ELECTROSLAG_STRING_AND_HASH("m:texture_manager"))
+            , m_mapped_table(0)
+            , m_table_buffer_capacity(0)
+            , m_growing_table_buffer_capacity(0)
+            , m_frame(0)
         {}
 
         texture_manager::~texture_manager()
@@ -30,15 +34,27 @@ namespace electroslag {
 
         void texture_manager::initialize()
         {
+            threading::lock_guard texture_manager_lock(&m_mutex);
+            create_table_buffer(initial_table_capacity);
         }
 
         void texture_manager::shutdown()
         {
             threading::lock_guard texture_manager_lock(&m_mutex);
+            m_retired_textures.clear();
+            m_streamed_textures.clear();
+            m_unwritten_table_entries.clear();
             m_texture_table.clear();
+
+            m_mapped_table = 0;
+            m_table_buffer_capacity = 0;
+            m_table_buffer.reset();
+            m_growing_table_buffer_capacity = 0;
+            m_growing_table_buffer.reset();
+            m_table_handles.clear();
         }
 
-        graphics::texture_interface::ref const& texture_manager::get_texture(
+        texture_manager::streamed_texture::ref const& texture_manager::get_texture(
             unsigned long long hash
             ) const
         {
@@ -48,26 +64,335 @@ namespace electroslag {
                 return ((*t).second);
             }
             else {
-                return (graphics::texture_interface::ref::null_ref);
+                return (streamed_texture::ref::null_ref);
             }
         }
 
-        graphics::texture_interface::ref const& texture_manager::get_texture(
+        texture_manager::streamed_texture::ref const& texture_manager::get_texture(
             graphics::texture_descriptor::ref& desc
             )
         {
             threading::lock_guard texture_manager_lock(&m_mutex);
             texture_table::const_iterator t(m_texture_table.find(desc->get_hash()));
             if (t == m_texture_table.end()) {
-                t = m_texture_table.insert(
-                    std::make_pair(
-                        desc->get_hash(),
-                        graphics::get_graphics()->create_texture(desc)
-                        )
-                    ).first;
+                streamed_texture::ref new_texture(new streamed_texture(desc));
+                initialize_streaming(new_texture.get_pointer());
+
+                if (new_texture->m_streamable) {
+                    // Start with just the tail; the rest is loaded once something asks for it.
+                    graphics::texture_descriptor::ref tail_desc(
+                        create_level_descriptor(desc, new_texture->m_state.tail_level)
+                        );
+                    new_texture->m_texture = graphics::get_graphics()->create_texture(tail_desc);
+                    m_streamed_textures.emplace_back(new_texture);
+                }
+                else {
+                    new_texture->m_texture = graphics::get_graphics()->create_texture(desc);
+                }
+
+                t = m_texture_table.insert(std::make_pair(desc->get_hash(), new_texture)).first;
             }
 
             return ((*t).second);
         }
+
+        void texture_manager::add_table_entry(streamed_texture::ref const& texture)
+        {
+            threading::lock_guard texture_manager_lock(&m_mutex);
+            if (texture->m_table_index >= 0) {
+                return;
+            }
+
+            texture->m_table_index = static_cast<int>(m_table_handles.size());
+            m_table_handles.emplace_back(0);
+            m_unwritten_table_entries.emplace_back(texture);
+
+            // Start on a larger table as soon as this one fills; entries past the end of
+            // the current table wait for it.
+            int capacity = max(m_table_buffer_capacity, m_growing_table_buffer_capacity);
+            if (static_cast<int>(m_table_handles.size()) > capacity) {
+                create_table_buffer(capacity * 2);
+            }
+        }
+
+        void texture_manager::add_handle_reference(
+            streamed_texture::ref const& texture,
+            graphics::buffer_interface::ref const& buffer,
+            int offset
+            )
+        {
+            threading::lock_guard texture_manager_lock(&m_mutex);
+            if (texture->m_streamable) {
+                texture->m_handle_references.emplace_back(buffer, offset);
+            }
+        }
+
+        long long texture_manager::get_budget_bytes() const
+        {
+            threading::lock_guard texture_manager_lock(&m_mutex);
+            return (m_policy.get_budget_bytes());
+        }
+
+        void texture_manager::set_budget_bytes(long long budget_bytes)
+        {
+            threading::lock_guard texture_manager_lock(&m_mutex);
+            m_policy.set_budget_bytes(budget_bytes);
+        }
+
+        void texture_manager::stream_textures_for_frame(frame_details* this_frame_details)
+        {
+            threading::lock_guard texture_manager_lock(&m_mutex);
+            ++m_frame;
+
+            // Reverse iteration allows us to erase from the vector sanely.
+            int retired_count = static_cast<int>(m_retired_textures.size());
+            for (int r = retired_count - 1; r >= 0; --r) {
+                if (m_frame - m_retired_textures[r].frame > max_frames_in_flight) {
+                    m_retired_textures.erase(m_retired_textures.begin() + r);
+                }
+            }
+
+            write_table_entries();
+            this_frame_details->texture_table = m_table_buffer;
+
+            // Fold in last frame's requests and finish any replacements that are ready.
+            m_states.clear();
+            streamed_texture_vector::iterator t(m_streamed_textures.begin());
+            while (t != m_streamed_textures.end()) {
+                streamed_texture* texture = t->get_pointer();
+                texture_residency_policy::texture_state& state = texture->m_state;
+
+                float requested_pixels = texture->m_requested_pixels.exchange(0.0f, std::memory_order_relaxed);
+                if (requested_pixels > 0.0f) {
+                    state.required_level = texture_residency_policy::compute_required_level(
+                        texture->m_desc->get_width(),
+                        texture->m_desc->get_height(),
+                        state.level_count,
+                        requested_pixels
+                        );
+                    state.last_required_frame = m_frame;
+                }
+
+                if (texture->m_loading_texture.is_valid()) {
+                    try_swap_texture(texture);
+                }
+
+                m_states.emplace_back(state);
+                ++t;
+            }
+
+            m_policy.plan(m_states, m_frame, &m_changes);
+
+            texture_residency_policy::residency_change_vector::const_iterator c(m_changes.begin());
+            while (c != m_changes.end()) {
+                streamed_texture* texture = m_streamed_textures[c->texture_index].get_pointer();
+                graphics::texture_descriptor::ref level_desc(
+                    create_level_descriptor(texture->m_desc, c->resident_level)
+                    );
+                texture->m_loading_texture = graphics::get_graphics()->create_texture(level_desc);
+                texture->m_state.loading_level = c->resident_level;
+                ++c;
+            }
+        }
+
+        void texture_manager::initialize_streaming(streamed_texture* texture)
+        {
+            graphics::texture_descriptor::ref const& desc = texture->m_desc;
+            texture_residency_policy::texture_state& state = texture->m_state;
+
+            // Only plain 2D mip mapped textures that carry every level can stream; anything
+            // else is created whole.
+            int level_count = desc->compute_mip_levels();
+            if (desc->get_type() != graphics::texture_type_flags_mipmap ||
+                desc->get_mip_level_generation_mode() != graphics::texture_level_generate_off ||
+                level_count < 2 || level_count > texture_residency_policy::max_levels) {
+                return;
+            }
+
+            bool have_level[texture_residency_policy::max_levels] = {};
+            graphics::texture_descriptor::const_image_iterator i(desc->begin_images());
+            while (i != desc->end_images()) {
+                if (!(*i)->has_pixels() || (*i)->get_mip_level() >= level_count) {
+                    return;
+                }
+                have_level[(*i)->get_mip_level()] = true;
+                state.level_bytes[(*i)->get_mip_level()] = (*i)->get_pixels()->get_sizeof();
+                ++i;
+            }
+            for (int l = 0; l < level_count; ++l) {
+                if (!have_level[l]) {
+                    return;
+                }
+            }
+
+            int tail_level = 0;
+            int largest_dimension = max(desc->get_width(), desc->get_height());
+            while (tail_level < level_count - 1 && (largest_dimension >> tail_level) > tail_texels) {
+                ++tail_level;
+            }
+            if (tail_level == 0) {
+                return;
+            }
+
+            state.level_count = level_count;
+            state.tail_level = tail_level;
+            state.resident_level = tail_level;
+            state.required_level = tail_level;
+            texture->m_streamable = true;
+        }
+
+        bool texture_manager::try_swap_texture(streamed_texture* texture)
+        {
+            if (!texture->m_loading_texture->is_finished()) {
+                return (false);
+            }
+
+            // UBOs that are still being created can't be patched yet.
+            streamed_texture::handle_reference_vector::iterator h(texture->m_handle_references.begin());
+            while (h != texture->m_handle_references.end()) {
+                if (!h->buffer->is_finished()) {
+                    return (false);
+                }
+                ++h;
+            }
+
+            m_retired_textures.emplace_back(texture->m_texture, m_frame);
+            texture->m_texture = texture->m_loading_texture;
+            texture->m_loading_texture.reset();
+
+            // The old handle stays valid until the retired texture is released, so frames
+            // in flight may see either handle. The handle is written with a single 64 bit
+            // store so a reader never sees half of each.
+            graphics::field_structs::texture_handle handle(texture->m_texture->get_handle());
+            h = texture->m_handle_references.begin();
+            while (h != texture->m_handle_references.end()) {
+                byte* mapped = h->buffer->map(h->offset, sizeof(handle.h));
+                *reinterpret_cast<uint64_t*>(mapped) = handle.h;
+                h->buffer->unmap(h->offset, sizeof(handle.h));
+                ++h;
+            }
+
+            // Textures only reach the table once their first handle is written; until
+            // then the pending entry picks up the new texture.
+            if (texture->m_in_table) {
+                write_table_entry(texture);
+            }
+
+            texture->m_state.resident_level = texture->m_state.loading_level;
+            texture->m_state.loading_level = -1;
+            return (true);
+        }
+
+        void texture_manager::write_table_entries()
+        {
+            // Swap in a grown table once it exists, carrying every handle written so far.
+            // The old table stays alive as long as a frame in flight holds it.
+            if (m_growing_table_buffer.is_valid() && m_growing_table_buffer->is_finished()) {
+                m_table_buffer = m_growing_table_buffer;
+                m_table_buffer_capacity = m_growing_table_buffer_capacity;
+                m_growing_table_buffer.reset();
+                m_growing_table_buffer_capacity = 0;
+
+                m_mapped_table = m_table_buffer->map();
+                memcpy(m_mapped_table, m_table_handles.data(), m_table_handles.size() * sizeof(uint64_t));
+            }
+
+            if (!m_mapped_table) {
+                if (!m_table_buffer->is_finished()) {
+                    return;
+                }
+                m_mapped_table = m_table_buffer->map();
+            }
+
+            // Reverse iteration allows us to erase from the vector sanely.
+            int unwritten_count = static_cast<int>(m_unwritten_table_entries.size());
+            for (int u = unwritten_count - 1; u >= 0; --u) {
+                if (write_table_entry(m_unwritten_table_entries[u].get_pointer())) {
+                    m_unwritten_table_entries.erase(m_unwritten_table_entries.begin() + u);
+                }
+            }
+        }
+
+        bool texture_manager::write_table_entry(streamed_texture* texture)
+        {
+            if (!m_mapped_table || texture->m_table_index >= m_table_buffer_capacity || !texture->m_texture->is_finished()) {
+                return (false);
+            }
+
+            // Same rules as the UBO handle patching in try_swap_texture.
+            graphics::field_structs::texture_handle handle(texture->m_texture->get_handle());
+            m_table_handles[texture->m_table_index] = handle.h;
+            *reinterpret_cast<uint64_t*>(m_mapped_table + (texture->m_table_index * sizeof(handle.h))) = handle.h;
+
+            texture->m_in_table = true;
+            return (true);
+        }
+
+        void texture_manager::create_table_buffer(int capacity)
+        {
+            // Handles are rewritten in place as textures stream, like static UBO handles.
+            graphics::buffer_descriptor::ref table_desc(graphics::buffer_descriptor::create());
+            table_desc->set_buffer_memory_caching(graphics::buffer_memory_caching_coherent);
+            table_desc->set_buffer_memory_map(graphics::buffer_memory_map_write);
+            table_desc->set_uninitialized_data_size(capacity * sizeof(graphics::field_structs::texture_handle));
+
+            if (m_table_buffer.is_valid()) {
+                m_growing_table_buffer = graphics::get_graphics()->create_buffer(table_desc);
+                m_growing_table_buffer_capacity = capacity;
+            }
+            else {
+                m_table_buffer = graphics::get_graphics()->create_buffer(table_desc);
+                m_table_buffer_capacity = capacity;
+            }
+        }
+
+        // static
+        graphics::texture_descriptor::ref texture_manager::create_level_descriptor(
+            graphics::texture_descriptor::ref const& desc,
+            int first_level
+            )
+        {
+            if (first_level == 0) {
+                return (desc);
+            }
+
+            // Same texture, with first_level as the new base level; the pixels are shared.
+            graphics::texture_descriptor::ref level_desc(graphics::texture_descriptor::create());
+            level_desc->set_hash(hash_bytes_runtime(&first_level, sizeof(first_level), desc->get_hash()));
+            level_desc->set_type(desc->get_type());
+            level_desc->set_color_format(desc->get_color_format());
+            level_desc->set_dimensions(
+                max(desc->get_width() >> first_level, 1),
+                max(desc->get_height() >> first_level, 1)
+                );
+            level_desc->set_mip_level_generation_mode(desc->get_mip_level_generation_mode());
+            level_desc->set_filter(
+                desc->get_magnification_filter(),
+                desc->get_minification_filter(),
+                desc->get_mip_filter()
+                );
+            level_desc->set_coord_wrap(
+                desc->get_s_wrap_mode(),
+                desc->get_t_wrap_mode(),
+                desc->get_u_wrap_mode()
+                );
+
+            graphics::texture_descriptor::const_image_iterator i(desc->begin_images());
+            while (i != desc->end_images()) {
+                if ((*i)->get_mip_level() >= first_level) {
+                    graphics::image_descriptor::ref level_image(graphics::image_descriptor::create());
+                    level_image->set_color_format((*i)->get_color_format());
+                    level_image->set_dimensions((*i)->get_width(), (*i)->get_height(), (*i)->get_stride());
+                    level_image->set_mip_level((*i)->get_mip_level() - first_level);
+                    level_image->set_cube_face((*i)->get_cube_face());
+                    level_image->set_slice((*i)->get_slice());
+                    level_image->set_pixels((*i)->get_pixels());
+                    level_desc->insert_image(level_image);
+                }
+                ++i;
+            }
+
+            return (level_desc);
+        }
     }
 }
@@ -17,36 +17,210 @@
 #include "electroslag/threading/mutex.hpp"
 #include "electroslag/graphics/texture_descriptor.hpp"
 #include "electroslag/graphics/texture_interface.hpp"
+#include "electroslag/graphics/buffer_interface.hpp"
+#include "electroslag/renderer/renderer_types.hpp"
+#include "electroslag/renderer/texture_residency_policy.hpp"
 
 namespace electroslag {
     namespace renderer {
         class texture_manager {
         public:
+            // The renderer's view of a texture. For textures that can stream, the graphics
+            // texture behind it is replaced as mip levels are loaded and evicted. Apart from
+            // request_screen_size, which may be called from any frame thread pool thread,
+            // streamed textures are only touched on the frame thread.
+            class streamed_texture : public referenced_object {
+            public:
+                typedef reference<streamed_texture> ref;
+
+                graphics::texture_descriptor::ref const& get_descriptor() const
+                {
+                    return (m_desc);
+                }
+
+                graphics::texture_interface::ref const& get_texture() const
+                {
+                    return (m_texture);
+                }
+
+                bool is_streamable() const
+                {
+                    return (m_streamable);
+                }
+
+                // Slot in the bindless texture table that holds this texture's current handle,
+                // or -1 if nothing has referenced the texture by index.
+                int get_table_index() const
+                {
+                    return (m_table_index);
+                }
+
+                // Has the current handle been written to the table slot yet?
+                bool is_in_table() const
+                {
+                    return (m_in_table);
+                }
+
+                // Note how many pixels across the texture covers on screen this frame.
+                void request_screen_size(float screen_pixels)
+                {
+                    float current_pixels = m_requested_pixels.load(std::memory_order_relaxed);
+                    while (screen_pixels > current_pixels &&
+                           !m_requested_pixels.compare_exchange_weak(current_pixels, screen_pixels, std::memory_order_relaxed)) {
+                    }
+                }
+
+            private:
+                explicit streamed_texture(graphics::texture_descriptor::ref const& desc)
+                    : m_desc(desc)
+                    , m_streamable(false)
+                    , m_table_index(-1)
+                    , m_in_table(false)
+                    , m_requested_pixels(0.0f)
+                {}
+
+                graphics::texture_descriptor::ref m_desc;
+                graphics::texture_interface::ref m_texture;
+                graphics::texture_interface::ref m_loading_texture;
+                bool m_streamable;
+                int m_table_index;
+                bool m_in_table;
+
+                std::atomic<float> m_requested_pixels;
+
+                // Static UBO locations that hold this texture's bindless handle.
+                struct handle_reference {
+                    handle_reference(
+                        graphics::buffer_interface::ref const& new_buffer,
+                        int new_offset
+                        )
+                        : buffer(new_buffer)
+                        , offset(new_offset)
+                    {}
+
+                    graphics::buffer_interface::ref buffer;
+                    int offset;
+                };
+                typedef std::vector<handle_reference> handle_reference_vector;
+                handle_reference_vector m_handle_references;
+
+                texture_residency_policy::texture_state m_state;
+
+                friend class texture_manager;
+
+                // Disallowed operations:
+                streamed_texture();
+                explicit streamed_texture(streamed_texture const&);
+                streamed_texture& operator =(streamed_texture const&);
+            };
+
             texture_manager();
             ~texture_manager();
 
             void initialize();
             void shutdown();
 
-            graphics::texture_interface::ref const& get_texture(
+            streamed_texture::ref const& get_texture(
                 unsigned long long hash
                 ) const;
 
-            graphics::texture_interface::ref const& get_texture(
+            streamed_texture::ref const& get_texture(
                 graphics::texture_descriptor::ref& desc
                 );
 
+            // The handle at offset in buffer will be rewritten whenever the texture is
+            // replaced. The buffer must be mappable for write with coherent caching.
+            void add_handle_reference(
+                streamed_texture::ref const& texture,
+                graphics::buffer_interface::ref const& buffer,
+                int offset
+                );
+
+            // Textures referenced by field_type_texture_index keep their bindless handle in
+            // one resident shader storage buffer, indexed by streamed_texture::get_table_index(),
+            // so materials only need to carry small index values. Shaders declare the table as:
+            //   layout(std430, binding = 0) readonly buffer texture_table { texture_handle handles[]; };
+            // frame_details::texture_table holds the buffer to bind for each frame.
+            static constexpr int const table_binding = 0;
+
+            // Give the texture a slot in the table, if it doesn't have one yet.
+            void add_table_entry(streamed_texture::ref const& texture);
+
+            // Memory budget for the mip levels of streamed textures.
+            long long get_budget_bytes() const;
+            void set_budget_bytes(long long budget_bytes);
+
+            // Swap in finished textures, release replaced ones, and start new loads and
+            // evictions based on the screen sizes requested last frame.
+            void stream_textures_for_frame(frame_details* this_frame_details);
+
         private:
+            void initialize_streaming(streamed_texture* texture);
+
+            bool try_swap_texture(streamed_texture* texture);
+
+            void write_table_entries();
+            bool write_table_entry(streamed_texture* texture);
+            void create_table_buffer(int capacity);
+
+            static graphics::texture_descriptor::ref create_level_descriptor(
+                graphics::texture_descriptor::ref const& desc,
+                int first_level
+                );
+
             mutable threading::mutex m_mutex;
 
             typedef std::unordered_map<
                 unsigned long long,
-                graphics::texture_interface::ref,
+                streamed_texture::ref,
                 prehashed_key<unsigned long long>,
                 std::equal_to<unsigned long long>
             > texture_table;
             texture_table m_texture_table;
 
+            // Streaming state; textures that can change residency, in a stable order the
+            // policy's state vector mirrors.
+            typedef std::vector<streamed_texture::ref> streamed_texture_vector;
+            streamed_texture_vector m_streamed_textures;
+
+            // The bindless texture table. Slots are handed out as textures are first referenced
+            // by index and never reused; a texture's slot is rewritten whenever the texture is
+            // replaced. When the slots outgrow the table, a buffer twice the size is created and
+            // takes over, with every handle copied across, once it is ready.
+            static constexpr int const initial_table_capacity = 1024;
+            graphics::buffer_interface::ref m_table_buffer;
+            byte* m_mapped_table;
+            int m_table_buffer_capacity;
+            graphics::buffer_interface::ref m_growing_table_buffer;
+            int m_growing_table_buffer_capacity;
+            std::vector<uint64_t> m_table_handles;
+            streamed_texture_vector m_unwritten_table_entries;
+
+            texture_residency_policy m_policy;
+            texture_residency_policy::texture_state_vector m_states;
+            texture_residency_policy::residency_change_vector m_changes;
+            long long m_frame;
+
+            // Replaced textures can still be sampled by frames in flight; hold on to them
+            // until those frames are done.
+            struct retired_texture {
+                retired_texture(
+                    graphics::texture_interface::ref const& new_texture,
+                    long long new_frame
+                    )
+                    : texture(new_texture)
+                    , frame(new_frame)
+                {}
+
+                graphics::texture_interface::ref texture;
+                long long frame;
+            };
+            typedef std::vector<retired_texture> retired_texture_vector;
+            retired_texture_vector m_retired_textures;
+
+            // Streamed textures start with only the levels no larger than this resident.
+            static constexpr int const tail_texels = 64;
+
             // Disallowed operations:
             explicit texture_manager(texture_manager const&);
             texture_manager& operator =(texture_manager const&);
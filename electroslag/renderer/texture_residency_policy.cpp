@@ -0,0 +1,174 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/renderer/texture_residency_policy.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        // static
+        int texture_residency_policy::compute_required_level(int width, int height, int level_count, float screen_pixels)
+        {
+            ELECTROSLAG_CHECK(width > 0 && height > 0 && level_count > 0 && level_count <= max_levels);
+            if (screen_pixels <= 0.0f) {
+                return (level_count - 1);
+            }
+
+            // Pick the smallest level that still has at least one texel per pixel.
+            float level_texels = static_cast<float>(max(width, height));
+            int level = 0;
+            while (level < level_count - 1 && (level_texels * 0.5f) >= screen_pixels) {
+                level_texels *= 0.5f;
+                ++level;
+            }
+            return (level);
+        }
+
+        // static
+        long long texture_residency_policy::compute_resident_bytes(texture_state const& state, int resident_level)
+        {
+            ELECTROSLAG_CHECK(resident_level >= 0 && resident_level < state.level_count);
+            long long bytes = 0;
+            for (int l = resident_level; l < state.level_count; ++l) {
+                bytes += state.level_bytes[l];
+            }
+            return (bytes);
+        }
+
+        // static
+        long long texture_residency_policy::compute_total_bytes(texture_state_vector const& states)
+        {
+            long long bytes = 0;
+            texture_state_vector::const_iterator s(states.begin());
+            while (s != states.end()) {
+                bytes += compute_resident_bytes(*s, s->resident_level);
+                if (s->loading_level >= 0) {
+                    bytes += compute_resident_bytes(*s, s->loading_level);
+                }
+                ++s;
+            }
+            return (bytes);
+        }
+
+        void texture_residency_policy::plan(
+            texture_state_vector const& states,
+            long long frame,
+            residency_change_vector* out_changes
+            ) const
+        {
+            out_changes->clear();
+
+            int state_count = static_cast<int>(states.size());
+            long long total_bytes = compute_total_bytes(states);
+
+            std::vector<int> desired_levels(state_count, -1);
+            std::vector<int> promotions;
+            std::vector<int> demotions;
+
+            // Textures nobody has needed lately go back to their tail.
+            for (int i = 0; i < state_count; ++i) {
+                texture_state const& s = states[i];
+                if (s.loading_level >= 0) {
+                    continue;
+                }
+
+                int desired_level = compute_desired_level(s, frame);
+                desired_levels[i] = desired_level;
+
+                if (desired_level > s.resident_level) {
+                    if (static_cast<int>(out_changes->size()) < m_max_changes_per_frame) {
+                        total_bytes -= compute_resident_bytes(s, s.resident_level) - compute_resident_bytes(s, desired_level);
+                        out_changes->emplace_back(i, desired_level);
+                    }
+                }
+                else {
+                    if (desired_level < s.resident_level) {
+                        promotions.emplace_back(i);
+                    }
+                    if (s.resident_level < s.tail_level) {
+                        demotions.emplace_back(i);
+                    }
+                }
+            }
+
+            if (total_bytes > m_budget_bytes) {
+                // Still over budget; the least recently used textures give up levels until
+                // everything fits. Nothing gets loaded this frame.
+                std::sort(demotions.begin(), demotions.end(), [&states](int a, int b) {
+                    return (states[a].last_required_frame < states[b].last_required_frame);
+                });
+
+                std::vector<int>::const_iterator d(demotions.begin());
+                while (d != demotions.end() &&
+                       total_bytes > m_budget_bytes &&
+                       static_cast<int>(out_changes->size()) < m_max_changes_per_frame) {
+                    texture_state const& s = states[*d];
+                    long long resident_bytes = compute_resident_bytes(s, s.resident_level);
+
+                    int target_level = s.resident_level + 1;
+                    while (target_level < s.tail_level &&
+                           (total_bytes - (resident_bytes - compute_resident_bytes(s, target_level))) > m_budget_bytes) {
+                        ++target_level;
+                    }
+
+                    total_bytes -= resident_bytes - compute_resident_bytes(s, target_level);
+                    out_changes->emplace_back(*d, target_level);
+                    ++d;
+                }
+                return;
+            }
+
+            // Load textures that are furthest from what they need first; ties go to the
+            // most recently requested.
+            std::sort(promotions.begin(), promotions.end(), [&states, &desired_levels](int a, int b) {
+                int a_distance = states[a].resident_level - desired_levels[a];
+                int b_distance = states[b].resident_level - desired_levels[b];
+                if (a_distance != b_distance) {
+                    return (a_distance > b_distance);
+                }
+                return (states[a].last_required_frame > states[b].last_required_frame);
+            });
+
+            std::vector<int>::const_iterator p(promotions.begin());
+            while (p != promotions.end() && static_cast<int>(out_changes->size()) < m_max_changes_per_frame) {
+                texture_state const& s = states[*p];
+                long long resident_bytes = compute_resident_bytes(s, s.resident_level);
+
+                // Settle for fewer levels than desired if the budget can't cover all of them.
+                int target_level = desired_levels[*p];
+                while (target_level < s.resident_level &&
+                       (total_bytes + (compute_resident_bytes(s, target_level) - resident_bytes)) > m_budget_bytes) {
+                    ++target_level;
+                }
+
+                if (target_level < s.resident_level) {
+                    total_bytes += compute_resident_bytes(s, target_level) - resident_bytes;
+                    out_changes->emplace_back(*p, target_level);
+                }
+                ++p;
+            }
+        }
+
+        int texture_residency_policy::compute_desired_level(texture_state const& state, long long frame) const
+        {
+            if (state.last_required_frame < 0 || (frame - state.last_required_frame) > m_idle_frames) {
+                return (state.tail_level);
+            }
+            else {
+                return (min(max(state.required_level, 0), state.tail_level));
+            }
+        }
+    }
+}
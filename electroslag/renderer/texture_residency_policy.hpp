@@ -0,0 +1,137 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+
+namespace electroslag {
+    namespace renderer {
+        // Decides which mip levels of streamed textures should be resident. The policy
+        // only looks at plain data so it can be exercised without a graphics context;
+        // texture_manager owns the actual textures and carries out the changes.
+        class texture_residency_policy {
+        public:
+            static constexpr int const max_levels = 17;
+
+            struct texture_state {
+                texture_state()
+                    : level_count(0)
+                    , tail_level(0)
+                    , resident_level(0)
+                    , loading_level(-1)
+                    , required_level(0)
+                    , last_required_frame(-1)
+                {
+                    for (int l = 0; l < max_levels; ++l) {
+                        level_bytes[l] = 0;
+                    }
+                }
+
+                // Size in bytes of each level; used to estimate video memory use.
+                long long level_bytes[max_levels];
+                int level_count;
+
+                // Levels at or past the tail level are always resident.
+                int tail_level;
+
+                // Finest level currently resident, and the finest level of a replacement
+                // texture that is still being created (or -1 if none.)
+                int resident_level;
+                int loading_level;
+
+                // Finest level any visible mesh asked for when last seen.
+                int required_level;
+                long long last_required_frame;
+            };
+            typedef std::vector<texture_state> texture_state_vector;
+
+            struct residency_change {
+                residency_change(int new_texture_index, int new_resident_level)
+                    : texture_index(new_texture_index)
+                    , resident_level(new_resident_level)
+                {}
+
+                int texture_index;
+                int resident_level;
+            };
+            typedef std::vector<residency_change> residency_change_vector;
+
+            texture_residency_policy()
+                : m_budget_bytes(256LL * 1024 * 1024)
+                , m_idle_frames(120)
+                , m_max_changes_per_frame(4)
+            {}
+
+            // Finest level worth sampling when a texture of this size covers
+            // screen_pixels pixels across; one texel per pixel is enough.
+            static int compute_required_level(int width, int height, int level_count, float screen_pixels);
+
+            // Bytes used by a texture when levels [resident_level, level_count) are resident.
+            static long long compute_resident_bytes(texture_state const& state, int resident_level);
+
+            // Bytes used by all textures, counting both textures while a change is loading.
+            static long long compute_total_bytes(texture_state_vector const& states);
+
+            long long get_budget_bytes() const
+            {
+                return (m_budget_bytes);
+            }
+
+            void set_budget_bytes(long long budget_bytes)
+            {
+                ELECTROSLAG_CHECK(budget_bytes > 0);
+                m_budget_bytes = budget_bytes;
+            }
+
+            // Textures nobody asked for in this many frames fall back to their tail.
+            int get_idle_frames() const
+            {
+                return (m_idle_frames);
+            }
+
+            void set_idle_frames(int idle_frames)
+            {
+                ELECTROSLAG_CHECK(idle_frames >= 0);
+                m_idle_frames = idle_frames;
+            }
+
+            int get_max_changes_per_frame() const
+            {
+                return (m_max_changes_per_frame);
+            }
+
+            void set_max_changes_per_frame(int max_changes)
+            {
+                ELECTROSLAG_CHECK(max_changes > 0);
+                m_max_changes_per_frame = max_changes;
+            }
+
+            // Produce the residency changes to start this frame. Evictions come first so
+            // the memory they release can pay for loads; textures with a load in flight
+            // are left alone.
+            void plan(
+                texture_state_vector const& states,
+                long long frame,
+                residency_change_vector* out_changes
+                ) const;
+
+        private:
+            int compute_desired_level(texture_state const& state, long long frame) const;
+
+            long long m_budget_bytes;
+            int m_idle_frames;
+            int m_max_changes_per_frame;
+        };
+    }
+}
@@ -0,0 +1,156 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/threading/thread_pool.hpp"
+#include "electroslag/renderer/transform_hierarchy.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        transform_hierarchy::transform_hierarchy()
+            : m_update(0)
+        {
+            m_level_begin.emplace_back(0);
+        }
+
+        int transform_hierarchy::insert_node(int parent, transform_descriptor::ref const& local_transform)
+        {
+            int node = get_node_count();
+            int level_count = static_cast<int>(m_level_dirty.size());
+
+            int depth = 0;
+            if (parent != no_parent) {
+                ELECTROSLAG_CHECK(parent >= 0 && parent < node);
+                depth = m_depth[parent] + 1;
+            }
+
+            // Breadth first insertion either extends the deepest level or starts a new one.
+            if (depth == level_count) {
+                m_level_begin.emplace_back(node + 1);
+                m_level_dirty.emplace_back(1);
+            }
+            else {
+                ELECTROSLAG_CHECK(depth == level_count - 1);
+                m_level_begin.back() = node + 1;
+                m_level_dirty[depth] = 1;
+            }
+
+            m_parent.emplace_back(parent);
+            m_depth.emplace_back(depth);
+
+            if (local_transform.is_valid()) {
+                m_local_rotation.emplace_back(local_transform->get_rotation());
+                m_local_scale.emplace_back(local_transform->get_scale());
+                m_local_translate.emplace_back(local_transform->get_translate());
+            }
+            else {
+                m_local_rotation.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+                m_local_scale.emplace_back(1.0f, 1.0f, 1.0f);
+                m_local_translate.emplace_back(0.0f, 0.0f, 0.0f);
+            }
+
+            m_local_to_world.emplace_back(1.0f);
+            m_local_dirty.emplace_back(1);
+            m_changed_update.emplace_back(0);
+
+            return (node);
+        }
+
+        void transform_hierarchy::set_local_transform(
+            int node,
+            glm::f32quat const& rotation,
+            glm::f32vec3 const& scale,
+            glm::f32vec3 const& translate
+            )
+        {
+            m_local_rotation[node] = rotation;
+            m_local_scale[node] = scale;
+            m_local_translate[node] = translate;
+            mark_local_dirty(node);
+        }
+
+        void transform_hierarchy::update()
+        {
+            ++m_update;
+
+            bool parent_level_changed = false;
+            int level_count = static_cast<int>(m_level_dirty.size());
+            for (int l = 0; l < level_count; ++l) {
+                // Nothing in a level can change unless one of its own nodes was set or
+                // the level above it changed.
+                if (!m_level_dirty[l] && !parent_level_changed) {
+                    continue;
+                }
+                m_level_dirty[l] = 0;
+
+                int begin = m_level_begin[l];
+                int end = m_level_begin[l + 1];
+
+                if (end - begin <= chunk_nodes) {
+                    parent_level_changed = update_range(begin, end);
+                }
+                else {
+                    threading::thread_pool* pool = threading::get_frame_thread_pool();
+
+                    m_chunk_items.clear();
+                    for (int c = begin; c < end; c += chunk_nodes) {
+                        m_chunk_items.emplace_back(pool->enqueue_work_item<update_work_item>(
+                            this,
+                            c,
+                            min(c + chunk_nodes, end)
+                            ));
+                    }
+
+                    parent_level_changed = false;
+                    update_work_item_vector::const_iterator i(m_chunk_items.begin());
+                    while (i != m_chunk_items.end()) {
+                        (*i)->wait_for_done();
+                        parent_level_changed |= (*i)->get_changed();
+                        ++i;
+                    }
+                    m_chunk_items.clear();
+                }
+            }
+        }
+
+        bool transform_hierarchy::update_range(int begin, int end)
+        {
+            bool changed = false;
+            for (int n = begin; n < end; ++n) {
+                int parent = m_parent[n];
+                bool parent_changed = (parent != no_parent) && (m_changed_update[parent] == m_update);
+
+                if (m_local_dirty[n] || parent_changed) {
+                    // M = T * R * S
+                    glm::f32mat4x4 local_matrix(glm::translate(m_local_translate[n]));
+                    local_matrix = local_matrix * glm::mat4_cast(m_local_rotation[n]);
+                    local_matrix = glm::scale(local_matrix, m_local_scale[n]);
+
+                    if (parent != no_parent) {
+                        m_local_to_world[n] = m_local_to_world[parent] * local_matrix;
+                    }
+                    else {
+                        m_local_to_world[n] = local_matrix;
+                    }
+
+                    m_local_dirty[n] = 0;
+                    m_changed_update[n] = m_update;
+                    changed = true;
+                }
+            }
+            return (changed);
+        }
+    }
+}
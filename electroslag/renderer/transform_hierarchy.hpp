@@ -0,0 +1,180 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+#include "electroslag/threading/work_item_interface.hpp"
+#include "electroslag/renderer/transform_descriptor.hpp"
+
+namespace electroslag {
+    namespace renderer {
+        // A scene's node transforms, kept as parallel arrays sorted by depth. Each level
+        // of the hierarchy is contiguous and parents always come before their children,
+        // so world matrices are propagated one level at a time; large levels are split
+        // into chunks for the frame thread pool. Only subtrees under a changed local
+        // transform are recomputed.
+        class transform_hierarchy {
+        public:
+            static int const no_parent = -1;
+
+            transform_hierarchy();
+            ~transform_hierarchy()
+            {}
+
+            // Nodes must be inserted breadth first; a node's depth is never less than
+            // the node inserted before it. Returns the new node's index.
+            int insert_node(int parent, transform_descriptor::ref const& local_transform);
+
+            int get_node_count() const
+            {
+                return (static_cast<int>(m_parent.size()));
+            }
+
+            int get_parent(int node) const
+            {
+                return (m_parent[node]);
+            }
+
+            // Local transforms may only be changed on the frame thread, outside of update.
+            void set_local_transform(
+                int node,
+                glm::f32quat const& rotation,
+                glm::f32vec3 const& scale,
+                glm::f32vec3 const& translate
+                );
+
+            void set_local_rotation(int node, glm::f32quat const& rotation)
+            {
+                m_local_rotation[node] = rotation;
+                mark_local_dirty(node);
+            }
+
+            void set_local_scale(int node, glm::f32vec3 const& scale)
+            {
+                m_local_scale[node] = scale;
+                mark_local_dirty(node);
+            }
+
+            void set_local_translate(int node, glm::f32vec3 const& translate)
+            {
+                m_local_translate[node] = translate;
+                mark_local_dirty(node);
+            }
+
+            glm::f32quat const& get_local_rotation(int node) const
+            {
+                return (m_local_rotation[node]);
+            }
+
+            glm::f32vec3 const& get_local_scale(int node) const
+            {
+                return (m_local_scale[node]);
+            }
+
+            glm::f32vec3 const& get_local_translate(int node) const
+            {
+                return (m_local_translate[node]);
+            }
+
+            glm::f32mat4x4 const& get_local_to_world(int node) const
+            {
+                return (m_local_to_world[node]);
+            }
+
+            // Did the most recent update change this node's world matrix?
+            bool was_world_changed(int node) const
+            {
+                return (m_changed_update[node] == m_update);
+            }
+
+            // Recompute the world matrices of changed subtrees. Called on the frame
+            // thread, which waits for any chunks handed to the frame thread pool.
+            void update();
+
+        private:
+            class update_work_item : public threading::work_item_interface {
+            public:
+                typedef reference<update_work_item> ref;
+
+                update_work_item(
+                    transform_hierarchy* hierarchy,
+                    int begin,
+                    int end
+                    )
+                    : m_hierarchy(hierarchy)
+                    , m_begin(begin)
+                    , m_end(end)
+                    , m_changed(false)
+                {}
+
+                virtual void execute()
+                {
+                    m_changed = m_hierarchy->update_range(m_begin, m_end);
+                }
+
+                bool get_changed() const
+                {
+                    return (m_changed);
+                }
+
+            private:
+                transform_hierarchy* m_hierarchy;
+                int m_begin;
+                int m_end;
+                bool m_changed;
+
+                // Disallowed operations:
+                update_work_item();
+                explicit update_work_item(update_work_item const&);
+                update_work_item& operator =(update_work_item const&);
+            };
+
+            void mark_local_dirty(int node)
+            {
+                m_local_dirty[node] = 1;
+                m_level_dirty[m_depth[node]] = 1;
+            }
+
+            // Returns true if any node in the range changed.
+            bool update_range(int begin, int end);
+
+            // Levels with more nodes than this are updated in parallel chunks of this size.
+            static int const chunk_nodes = 1024;
+
+            // Per node arrays, all indexed by node.
+            std::vector<int> m_parent;
+            std::vector<int> m_depth;
+            std::vector<glm::f32quat> m_local_rotation;
+            std::vector<glm::f32vec3> m_local_scale;
+            std::vector<glm::f32vec3> m_local_translate;
+            std::vector<glm::f32mat4x4> m_local_to_world;
+            std::vector<byte> m_local_dirty;
+            std::vector<unsigned int> m_changed_update;
+
+            // Per level arrays; m_level_begin has one extra entry that ends the last level.
+            std::vector<int> m_level_begin;
+            std::vector<byte> m_level_dirty;
+
+            // Incremented by every update; nodes record the update that last changed them.
+            unsigned int m_update;
+
+            typedef std::vector<update_work_item::ref> update_work_item_vector;
+            update_work_item_vector m_chunk_items;
+
+            // Disallowed operations:
+            explicit transform_hierarchy(transform_hierarchy const&);
+            transform_hierarchy& operator =(transform_hierarchy const&);
+        };
+    }
+}
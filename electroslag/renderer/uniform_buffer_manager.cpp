@@ -22,7 +22,6 @@ namespace electroslag {
     namespace renderer {
         uniform_buffer_manager::uniform_buffer_manager()
             : m_mutex(ELECTROSLAG_STRING_AND_HASH("m:uniform_buffer_manager"))
-            , m_current_frame_index(0)
             , m_allocated_ubo_size(0)
         {}
 
@@ -40,7 +39,7 @@ namespace electroslag {
             threading::lock_guard uniform_buffer_manager_lock(&m_mutex);
             m_buffer_table.clear();
 
-            for (int i = 0; i < per_frame_count; ++i) {
+            for (int i = 0; i < max_frames_in_flight; ++i) {
                 m_per_frame_buffers[i].buffer.reset();
                 m_per_frame_buffers[i].current_size = 0;
             }
@@ -90,12 +89,8 @@ namespace electroslag {
         {
             threading::lock_guard uniform_buffer_manager_lock(&m_mutex);
 
-            // Rotate through the per-frame data structures.
-            m_current_frame_index++;
-            if (m_current_frame_index == per_frame_count) {
-                m_current_frame_index = 0;
-            }
-            per_frame_dynamic_ubo* this_frame_ubo = &m_per_frame_buffers[m_current_frame_index];
+            // The renderer has already waited for this slot's previous frame.
+            per_frame_dynamic_ubo* this_frame_ubo = &m_per_frame_buffers[this_frame_details->frame_index];
 
             // See if there is a completed buffer resize for this frame.
             if (this_frame_ubo->pending_buffer.is_valid() &&
@@ -114,7 +109,8 @@ namespace electroslag {
             // Allow pending resize requests to finish before starting a new one.
             if (this_frame_ubo->current_size < m_allocated_ubo_size && !this_frame_ubo->pending_buffer.is_valid()) {
                 graphics::buffer_descriptor::ref buffer_desc(graphics::buffer_descriptor::create());
-                buffer_desc->set_buffer_memory_caching(graphics::buffer_memory_caching_coherent);
+                // Noncoherent; each mesh marks the span it writes and only those spans are flushed.
+                buffer_desc->set_buffer_memory_caching(graphics::buffer_memory_caching_noncoherent);
                 buffer_desc->set_buffer_memory_map(graphics::buffer_memory_map_write);
                 buffer_desc->set_uninitialized_data_size(m_allocated_ubo_size);
 
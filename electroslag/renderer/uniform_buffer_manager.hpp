@@ -57,9 +57,7 @@ namespace electroslag {
             > buffer_table;
             buffer_table m_buffer_table;
 
-            // Dynamic UBO tracking.
-            static constexpr int const per_frame_count = graphics::context_interface::display_buffer_count + 1;
-
+            // Dynamic UBO tracking; indexed by frame_details::frame_index.
             struct per_frame_dynamic_ubo {
                 per_frame_dynamic_ubo()
                     : current_size(0)
@@ -71,9 +69,8 @@ namespace electroslag {
 
                 graphics::buffer_interface::ref pending_buffer;
                 int pending_size;
-            } m_per_frame_buffers[per_frame_count];
+            } m_per_frame_buffers[max_frames_in_flight];
 
-            int m_current_frame_index;
             int m_allocated_ubo_size;
 
             // Disallowed operations:
@@ -457,7 +457,7 @@ namespace electroslag {
 
             std::string object_name;
             if (obj->has_name_string()) {
-                object_name = obj->get_name();
+                object_name = obj->get_name().str();
             }
             else {
                 object_name = "<unnamed>";
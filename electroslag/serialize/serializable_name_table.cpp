@@ -69,7 +69,7 @@ namespace electroslag {
                 enumeration_namer namer(name_count, 'n');
                 while (i != ar->get_saved_object_vector().end()) {
                     if (nt->contains(*i)) {
-                        ar->write_string(namer.get_next_name(), nt->lookup(*i));
+                        ar->write_string(namer.get_next_name(), nt->lookup(*i).str());
                     }
                     ++i;
                 }
@@ -63,6 +63,12 @@ namespace electroslag {
             m_io_thread_pool = 0;
         }
 
+        // IO items can wait on decode items, so the decode pool outlives them.
+        if (m_decode_thread_pool) {
+            m_decode_thread_pool->~thread_pool();
+            m_decode_thread_pool = 0;
+        }
+
         if (m_logger) {
             m_logger->~logger();
             m_logger = 0;
@@ -34,6 +34,7 @@ namespace electroslag {
             , m_thread_local_map(0)
             , m_frame_thread_pool(0)
             , m_io_thread_pool(0)
+            , m_decode_thread_pool(0)
             , m_database(0)
             , m_ui_win32(0)
             , m_graphics_opengl(0)
@@ -53,6 +54,11 @@ namespace electroslag {
             return (m_name_table);
         }
 
+        bool has_logger() const
+        {
+            return (m_logger != 0);
+        }
+
         logger* get_logger()
         {
             if (!m_logger) {
@@ -87,12 +93,27 @@ namespace electroslag {
         {
             if (!m_io_thread_pool) {
                 ELECTROSLAG_CHECK(!m_destruction);
+
+                // Decode work is queued from IO items, which could race to create the decode
+                // pool lazily; create it here, before any IO item can run.
+                get_decode_thread_pool();
+
                 m_io_thread_pool = reinterpret_cast<threading::thread_pool*>(m_system_buffer + io_thread_pool_offset);
                 new (m_io_thread_pool) threading::thread_pool("io");
             }
             return (m_io_thread_pool);
         }
 
+        threading::thread_pool* get_decode_thread_pool()
+        {
+            if (!m_decode_thread_pool) {
+                ELECTROSLAG_CHECK(!m_destruction);
+                m_decode_thread_pool = reinterpret_cast<threading::thread_pool*>(m_system_buffer + decode_thread_pool_offset);
+                new (m_decode_thread_pool) threading::thread_pool("decode", threading::thread::hardware_concurrency());
+            }
+            return (m_decode_thread_pool);
+        }
+
         serialize::database* get_database()
         {
             if (!m_database) {
@@ -144,16 +165,17 @@ namespace electroslag {
         }
 
     private:
-        static unsigned int const name_table_offset        = 0;
-        static unsigned int const logger_offset            = align_up(name_table_offset + sizeof(name_table), alignof(logger));
-        static unsigned int const thread_local_map_offset  = align_up(logger_offset + sizeof(logger), alignof(threading::thread_local_map));
-        static unsigned int const frame_thread_pool_offset = align_up(thread_local_map_offset + sizeof(threading::thread_local_map), alignof(threading::thread_pool));
-        static unsigned int const io_thread_pool_offset    = align_up(frame_thread_pool_offset + sizeof(threading::thread_pool), alignof(threading::thread_pool));
-        static unsigned int const database_offset          = align_up(io_thread_pool_offset + sizeof(threading::thread_pool), alignof(serialize::database));
-        static unsigned int const ui_win32_offset          = align_up(database_offset + sizeof(serialize::database), alignof(ui::ui_win32));
-        static unsigned int const graphics_opengl_offset   = align_up(ui_win32_offset + sizeof(ui::ui_win32), alignof(graphics::graphics_opengl));
-        static unsigned int const property_manager_offset  = align_up(graphics_opengl_offset + sizeof(graphics::graphics_opengl), alignof(animation::property_manager));
-        static unsigned int const renderer_offset          = align_up(property_manager_offset + sizeof(animation::property_manager), alignof(renderer::renderer));
+        static unsigned int const name_table_offset         = 0;
+        static unsigned int const logger_offset             = align_up(name_table_offset + sizeof(name_table), alignof(logger));
+        static unsigned int const thread_local_map_offset   = align_up(logger_offset + sizeof(logger), alignof(threading::thread_local_map));
+        static unsigned int const frame_thread_pool_offset  = align_up(thread_local_map_offset + sizeof(threading::thread_local_map), alignof(threading::thread_pool));
+        static unsigned int const io_thread_pool_offset     = align_up(frame_thread_pool_offset + sizeof(threading::thread_pool), alignof(threading::thread_pool));
+        static unsigned int const decode_thread_pool_offset = align_up(io_thread_pool_offset + sizeof(threading::thread_pool), alignof(threading::thread_pool));
+        static unsigned int const database_offset           = align_up(decode_thread_pool_offset + sizeof(threading::thread_pool), alignof(serialize::database));
+        static unsigned int const ui_win32_offset           = align_up(database_offset + sizeof(serialize::database), alignof(ui::ui_win32));
+        static unsigned int const graphics_opengl_offset    = align_up(ui_win32_offset + sizeof(ui::ui_win32), alignof(graphics::graphics_opengl));
+        static unsigned int const property_manager_offset   = align_up(graphics_opengl_offset + sizeof(graphics::graphics_opengl), alignof(animation::property_manager));
+        static unsigned int const renderer_offset           = align_up(property_manager_offset + sizeof(animation::property_manager), alignof(renderer::renderer));
 
         static unsigned int const system_buffer_size = renderer_offset + sizeof(renderer::renderer);
 
@@ -162,6 +184,7 @@ namespace electroslag {
         threading::thread_local_map* m_thread_local_map;
         threading::thread_pool* m_frame_thread_pool;
         threading::thread_pool* m_io_thread_pool;
+        threading::thread_pool* m_decode_thread_pool;
         serialize::database* m_database;
         ui::ui_win32* m_ui_win32;
         graphics::graphics_opengl* m_graphics_opengl;
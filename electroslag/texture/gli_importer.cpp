@@ -25,10 +25,11 @@ namespace electroslag {
             std::string const& object_name,
             serialize::load_record::ref& record,
             graphics::sampler_params const* sampler,
-            graphics::texture_level_generate generate_mip_levels
+            graphics::texture_level_generate generate_mip_levels,
+            block_compression compression
             )
         {
-            import(file_name, object_name, record, sampler, generate_mip_levels);
+            import(file_name, object_name, record, sampler, generate_mip_levels, compression);
         }
         
         gli_importer::gli_importer(serialize::archive_reader_interface* ar)
@@ -53,6 +54,9 @@ namespace electroslag {
             graphics::texture_level_generate generate_mip_levels = graphics::texture_level_generate_off;
             ar->read_enumeration("generate_mip_levels", &generate_mip_levels, graphics::texture_level_generate_strings);
 
+            block_compression compression = block_compression_none;
+            ar->read_enumeration("compression", &compression, block_compression_strings);
+
             graphics::sampler_params sampler;
             unsigned long long sampler_name_hash = 0;
             if (ar->read_name_hash("sampler", &sampler_name_hash)) {
@@ -62,7 +66,7 @@ namespace electroslag {
                 sampler = serialized_params->get();
             }
 
-            import(dir.string(), object_name, ar->get_load_record(), &sampler, generate_mip_levels);
+            import(dir.string(), object_name, ar->get_load_record(), &sampler, generate_mip_levels, compression);
         }
 
         void gli_importer::save_to_archive(serialize::archive_writer_interface*)
@@ -82,7 +86,8 @@ namespace electroslag {
             std::string const& object_name,
             serialize::load_record::ref& record,
             graphics::sampler_params const* sampler,
-            graphics::texture_level_generate generate_mip_levels
+            graphics::texture_level_generate generate_mip_levels,
+            block_compression compression
             )
         {
             m_async_loader = threading::get_io_thread_pool()->enqueue_work_item<async_texture_loader>(
@@ -91,7 +96,8 @@ namespace electroslag {
                 object_name,
                 record,
                 sampler,
-                generate_mip_levels
+                generate_mip_levels,
+                compression
                 ).cast<import_future>();
         }
 
@@ -141,6 +147,7 @@ namespace electroslag {
 
             // Color format.
             graphics::texture_color_format color_format = graphics::texture_color_format_none;
+            bool swap_red_blue = false;
             gli::format gli_format = gli_texture.format();
             switch (gli_format) {
             // RGBA formats
@@ -171,23 +178,23 @@ namespace electroslag {
 
             // BGRA formats; convert to RGBA.
             case gli::FORMAT_BGR8_UNORM_PACK8:
-                gli_texture.swizzle<glm::u8vec4>(gli::swizzles(gli::SWIZZLE_BLUE, gli::SWIZZLE_GREEN, gli::SWIZZLE_RED, gli::SWIZZLE_ALPHA));
                 color_format = graphics::texture_color_format_r8g8b8;
+                swap_red_blue = true;
                 break;
 
             case gli::FORMAT_BGR8_SRGB_PACK8:
-                gli_texture.swizzle<glm::u8vec4>(gli::swizzles(gli::SWIZZLE_BLUE, gli::SWIZZLE_GREEN, gli::SWIZZLE_RED, gli::SWIZZLE_ALPHA));
                 color_format = graphics::texture_color_format_r8g8b8_srgb;
+                swap_red_blue = true;
                 break;
 
             case gli::FORMAT_BGRA8_UNORM_PACK8:
-                gli_texture.swizzle<glm::u8vec4>(gli::swizzles(gli::SWIZZLE_BLUE, gli::SWIZZLE_GREEN, gli::SWIZZLE_RED, gli::SWIZZLE_ALPHA));
                 color_format = graphics::texture_color_format_r8g8b8a8;
+                swap_red_blue = true;
                 break;
 
             case gli::FORMAT_BGRA8_SRGB_PACK8:
-                gli_texture.swizzle<glm::u8vec4>(gli::swizzles(gli::SWIZZLE_BLUE, gli::SWIZZLE_GREEN, gli::SWIZZLE_RED, gli::SWIZZLE_ALPHA));
                 color_format = graphics::texture_color_format_r8g8b8a8_srgb;
+                swap_red_blue = true;
                 break;
 
             // Compressed formats.
@@ -258,47 +265,84 @@ namespace electroslag {
             default:
                 throw load_object_failure("gli::format");
             }
-            texture_desc->set_color_format(color_format);
+            // Uncompressed 8 bit formats can be processed here rather than at load time.
+            m_source_block_size = static_cast<int>(gli::block_size(gli_format));
+            m_bytes_per_texel = texture_processing::get_bytes_per_texel(color_format);
 
-            // Texture dimensions
             gli::extent3d extent(gli_texture.extent());
             texture_desc->set_dimensions(extent.x, extent.y, extent.z);
 
+            bool generate_levels = false;
+            if (m_generate_mip_levels != graphics::texture_level_generate_off &&
+                gli_texture.levels() == 1 &&
+                m_bytes_per_texel > 0 &&
+                extent.z == 1) {
+                generate_levels = true;
+                texture_desc->set_mip_level_generation_mode(graphics::texture_level_generate_off);
+            }
+
+            if (m_bytes_per_texel < 3) {
+                m_compression = block_compression_none;
+            }
+            texture_desc->set_color_format(texture_processing::get_compressed_format(color_format, m_compression));
+
+            mip_filter filter = ((m_generate_mip_levels == graphics::texture_level_generate_favor_quality) ?
+                mip_filter_kaiser :
+                mip_filter_box);
+
             // Import the texture's images.
+            std::vector<byte> source_pixels;
+            std::vector<byte> level_pixels;
             for (int slice = 0; slice < gli_texture.layers(); ++slice) {
                 for (int face_number = 0; face_number < gli_texture.faces(); ++face_number) {
+                    graphics::texture_cube_face face = (gli::is_target_cube(gli_texture.target()) ?
+                        static_cast<graphics::texture_cube_face>(face_number) :
+                        graphics::texture_cube_face_normal);
+
                     for (int level = 0; level < gli_texture.levels(); ++level) {
                         gli::extent3d level_extent(gli_texture.extent(level));
-
-                        graphics::image_descriptor::ref image(graphics::image_descriptor::create());
-
-                        std::string image_name;
-                        formatted_string_append(image_name, "%s::s%02.2d::f%02.2d::l%02.2d", m_object_name.c_str(), slice, face_number, level);
-                        image->set_name(image_name);
-                        image->set_color_format(color_format);
-                        image->set_mip_level(level);
-                        image->set_slice(slice);
-
-                        graphics::texture_cube_face face = (gli::is_target_cube(gli_texture.target()) ?
-                            static_cast<graphics::texture_cube_face>(face_number) :
-                            graphics::texture_cube_face_normal);
-                        image->set_cube_face(face);
-
-                        int stride = static_cast<int>(level_extent.x * gli::block_size(gli_format));
-                        image->set_dimensions(level_extent.x, level_extent.y, stride);
-
                         int image_sizeof = static_cast<int>(gli_texture.size(level));
-                        referenced_buffer_interface::ref pixels = referenced_buffer_from_sizeof::create(
-                            image_sizeof
-                            );
-                        {
-                            referenced_buffer_interface::accessor pixel_accessor(pixels);
-                            memcpy(pixel_accessor.get_pointer(), gli_texture.data(slice, face_number, level), image_sizeof);
+                        byte const* image_pixels = static_cast<byte const*>(gli_texture.data(slice, face_number, level));
+
+                        if (swap_red_blue) {
+                            source_pixels.assign(image_pixels, image_pixels + image_sizeof);
+                            texture_processing::swizzle_red_blue(
+                                source_pixels.data(),
+                                image_sizeof / m_bytes_per_texel,
+                                m_bytes_per_texel
+                                );
+                            image_pixels = source_pixels.data();
                         }
-                        image->set_pixels(pixels);
 
-                        m_load_record->insert_object(image);
-                        texture_desc->insert_image(image);
+                        insert_image(texture_desc, slice, face_number, face, level, level_extent.x, level_extent.y, image_pixels, image_sizeof);
+
+                        if (generate_levels) {
+                            texture_processing::mip_chain_builder builder(
+                                image_pixels,
+                                level_extent.x,
+                                level_extent.y,
+                                color_format,
+                                filter
+                                );
+                            level_pixels.resize(image_sizeof);
+
+                            int generated_level = 1;
+                            while (builder.has_next_level()) {
+                                builder.next_level(level_pixels.data());
+                                insert_image(
+                                    texture_desc,
+                                    slice,
+                                    face_number,
+                                    face,
+                                    generated_level,
+                                    builder.get_width(),
+                                    builder.get_height(),
+                                    level_pixels.data(),
+                                    builder.get_width() * builder.get_height() * m_bytes_per_texel
+                                    );
+                                ++generated_level;
+                            }
+                        }
                     }
                 }
             }
@@ -312,6 +356,60 @@ namespace electroslag {
             return (texture_desc);
         }
 
+        void gli_importer::async_texture_loader::insert_image(
+            graphics::texture_descriptor::ref& texture_desc,
+            int slice,
+            int face_number,
+            graphics::texture_cube_face face,
+            int level,
+            int width,
+            int height,
+            byte const* pixels,
+            int pixels_sizeof
+            )
+        {
+            graphics::image_descriptor::ref image(graphics::image_descriptor::create());
+
+            std::string image_name;
+            formatted_string_append(image_name, "%s::s%02.2d::f%02.2d::l%02.2d", m_object_name.c_str(), slice, face_number, level);
+            image->set_name(image_name);
+            image->set_color_format(texture_desc->get_color_format());
+            image->set_mip_level(level);
+            image->set_slice(slice);
+            image->set_cube_face(face);
+
+            referenced_buffer_interface::ref image_pixels;
+            if (m_compression != block_compression_none) {
+                // Stride is the size of one row of blocks.
+                image->set_dimensions(width, height, texture_processing::get_compressed_sizeof(width, 4, m_compression));
+
+                image_pixels = referenced_buffer_from_sizeof::create(
+                    texture_processing::get_compressed_sizeof(width, height, m_compression)
+                    );
+                referenced_buffer_interface::accessor pixel_accessor(image_pixels);
+                texture_processing::compress_image(
+                    pixels,
+                    width,
+                    height,
+                    m_bytes_per_texel,
+                    m_compression,
+                    static_cast<byte*>(pixel_accessor.get_pointer())
+                    );
+            }
+            else {
+                int stride = width * m_source_block_size;
+                image->set_dimensions(width, height, stride);
+
+                image_pixels = referenced_buffer_from_sizeof::create(pixels_sizeof);
+                referenced_buffer_interface::accessor pixel_accessor(image_pixels);
+                memcpy(pixel_accessor.get_pointer(), pixels, pixels_sizeof);
+            }
+            image->set_pixels(image_pixels);
+
+            m_load_record->insert_object(image);
+            texture_desc->insert_image(image);
+        }
+
         gli::texture gli_importer::async_texture_loader::convert(gli::texture const& gli_texture, gli::format dest_format)
         {
             switch (gli_texture.target()) {
@@ -26,6 +26,7 @@
 #include "electroslag/graphics/graphics_types.hpp"
 #include "electroslag/graphics/texture_descriptor.hpp"
 #include "electroslag/threading/future_interface.hpp"
+#include "electroslag/texture/texture_processing.hpp"
 
 namespace electroslag {
     namespace texture {
@@ -40,10 +41,11 @@ namespace electroslag {
                 std::string const& object_name,
                 serialize::load_record::ref& record,
                 graphics::sampler_params const* sampler,
-                graphics::texture_level_generate generate_mip_levels = graphics::texture_level_generate_off
+                graphics::texture_level_generate generate_mip_levels = graphics::texture_level_generate_off,
+                block_compression compression = block_compression_none
                 )
             {
-                return (ref(new gli_importer(file_name, object_name, record, sampler, generate_mip_levels)));
+                return (ref(new gli_importer(file_name, object_name, record, sampler, generate_mip_levels, compression)));
             }
 
             virtual ~gli_importer()
@@ -75,7 +77,8 @@ namespace electroslag {
                     std::string const& object_name,
                     serialize::load_record::ref& record,
                     graphics::sampler_params const* sampler,
-                    graphics::texture_level_generate generate_mip_levels
+                    graphics::texture_level_generate generate_mip_levels,
+                    block_compression compression
                     )
                     : m_this_importer(importer)
                     , m_file_name(file_name)
@@ -83,6 +86,9 @@ namespace electroslag {
                     , m_load_record(record)
                     , m_sampler(*sampler)
                     , m_generate_mip_levels(generate_mip_levels)
+                    , m_compression(compression)
+                    , m_source_block_size(0)
+                    , m_bytes_per_texel(0)
                 {}
                 virtual ~async_texture_loader()
                 {}
@@ -92,12 +98,30 @@ namespace electroslag {
             private:
                 gli::texture convert(gli::texture const& gli_texture, gli::format dest_format);
 
+                void insert_image(
+                    graphics::texture_descriptor::ref& texture_desc,
+                    int slice,
+                    int face_number,
+                    graphics::texture_cube_face face,
+                    int level,
+                    int width,
+                    int height,
+                    byte const* pixels,
+                    int pixels_sizeof
+                    );
+
                 gli_importer::ref m_this_importer;
                 std::string m_file_name;
                 std::string m_object_name;
                 serialize::load_record::ref m_load_record;
                 graphics::sampler_params m_sampler;
                 graphics::texture_level_generate m_generate_mip_levels;
+                block_compression m_compression;
+
+                // Details of the source format; texel processing only applies to the
+                // uncompressed 8 bit formats.
+                int m_source_block_size;
+                int m_bytes_per_texel;
             };
 
             gli_importer(
@@ -105,7 +129,8 @@ namespace electroslag {
                 std::string const& object_name,
                 serialize::load_record::ref& record,
                 graphics::sampler_params const* sampler,
-                graphics::texture_level_generate generate_mip_levels
+                graphics::texture_level_generate generate_mip_levels,
+                block_compression compression
                 );
 
             void import(
@@ -113,7 +138,8 @@ namespace electroslag {
                 std::string const& object_name,
                 serialize::load_record::ref& record,
                 graphics::sampler_params const* sampler,
-                graphics::texture_level_generate generate_mip_levels
+                graphics::texture_level_generate generate_mip_levels,
+                block_compression compression
                 );
 
             import_future::ref m_async_loader;
@@ -0,0 +1,676 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "electroslag/precomp.hpp"
+#include "electroslag/texture/texture_processing.hpp"
+
+namespace electroslag {
+    namespace texture {
+        namespace texture_processing {
+            // sRGB conversion tables. Decoding covers every byte value; encoding is indexed
+            // by linear value quantized to 12 bits, which is finer than any step in the
+            // 8 bit sRGB curve.
+            static int const srgb_encode_table_size = 4096;
+
+            struct srgb_tables {
+                srgb_tables()
+                {
+                    for (int i = 0; i < 256; ++i) {
+                        float c = static_cast<float>(i) / 255.0f;
+                        decode[i] = (c <= 0.04045f) ? (c / 12.92f) : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                    }
+                    for (int i = 0; i < srgb_encode_table_size; ++i) {
+                        float l = static_cast<float>(i) / static_cast<float>(srgb_encode_table_size - 1);
+                        float c = (l <= 0.0031308f) ? (l * 12.92f) : (1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f);
+                        encode[i] = static_cast<byte>(c * 255.0f + 0.5f);
+                    }
+                }
+
+                float decode[256];
+                byte encode[srgb_encode_table_size];
+            };
+
+            static srgb_tables const& get_srgb_tables()
+            {
+                static srgb_tables const tables;
+                return (tables);
+            }
+
+            int get_bytes_per_texel(graphics::texture_color_format format)
+            {
+                switch (format) {
+                case graphics::texture_color_format_r8:
+                    return (1);
+
+                case graphics::texture_color_format_r8g8b8:
+                case graphics::texture_color_format_r8g8b8_srgb:
+                    return (3);
+
+                case graphics::texture_color_format_r8g8b8a8:
+                case graphics::texture_color_format_r8g8b8a8_srgb:
+                    return (4);
+
+                default:
+                    return (0);
+                }
+            }
+
+            bool is_srgb(graphics::texture_color_format format)
+            {
+                return (format == graphics::texture_color_format_r8g8b8_srgb ||
+                        format == graphics::texture_color_format_r8g8b8a8_srgb);
+            }
+
+            void swizzle_red_blue(byte* pixels, int texel_count, int bytes_per_texel)
+            {
+                int t = 0;
+                if (bytes_per_texel == 4) {
+                    // Four texels at a time; move bytes 0 and 2 of each texel past each other.
+                    __m128i const green_alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+                    __m128i const red_blue_mask = _mm_set1_epi32(0x00FF00FF);
+                    for (; t + 4 <= texel_count; t += 4) {
+                        __m128i* p = reinterpret_cast<__m128i*>(pixels + t * 4);
+                        __m128i texels = _mm_loadu_si128(p);
+                        __m128i red_blue = _mm_and_si128(texels, red_blue_mask);
+                        red_blue = _mm_or_si128(_mm_slli_epi32(red_blue, 16), _mm_srli_epi32(red_blue, 16));
+                        _mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(texels, green_alpha_mask), red_blue));
+                    }
+                }
+                else {
+                    ELECTROSLAG_CHECK(bytes_per_texel == 3);
+                }
+
+                for (; t < texel_count; ++t) {
+                    byte* texel = pixels + t * bytes_per_texel;
+                    std::swap(texel[0], texel[2]);
+                }
+            }
+
+            mip_chain_builder::mip_chain_builder(
+                byte const* level0_pixels,
+                int width,
+                int height,
+                graphics::texture_color_format format,
+                mip_filter filter
+                )
+                : m_width(width)
+                , m_height(height)
+                , m_bytes_per_texel(get_bytes_per_texel(format))
+                , m_srgb(is_srgb(format))
+                , m_filter(filter)
+            {
+                ELECTROSLAG_CHECK(m_bytes_per_texel > 0);
+                ELECTROSLAG_CHECK(filter > mip_filter_unknown && filter < mip_filter_count);
+
+                srgb_tables const& tables = get_srgb_tables();
+                int texel_count = width * height;
+                m_level.resize(texel_count * 4);
+
+                byte const* src = level0_pixels;
+                float* dest = m_level.data();
+                for (int t = 0; t < texel_count; ++t) {
+                    for (int c = 0; c < 4; ++c) {
+                        if (c >= m_bytes_per_texel) {
+                            dest[c] = ((c == 3) ? 1.0f : 0.0f);
+                        }
+                        else if (m_srgb && c < 3) {
+                            dest[c] = tables.decode[src[c]];
+                        }
+                        else {
+                            dest[c] = static_cast<float>(src[c]) / 255.0f;
+                        }
+                    }
+                    src += m_bytes_per_texel;
+                    dest += 4;
+                }
+            }
+
+            void mip_chain_builder::next_level(byte* pixels)
+            {
+                ELECTROSLAG_CHECK(has_next_level());
+                int dest_width = max(m_width / 2, 1);
+                int dest_height = max(m_height / 2, 1);
+
+                if (m_filter == mip_filter_kaiser) {
+                    downsample_kaiser(dest_width, dest_height);
+                }
+                else {
+                    downsample_box(dest_width, dest_height);
+                }
+                m_width = dest_width;
+                m_height = dest_height;
+
+                // Quantize; sharpening filters can overshoot, so clamp first.
+                srgb_tables const& tables = get_srgb_tables();
+                __m128 const zero = _mm_setzero_ps();
+                __m128 const one = _mm_set1_ps(1.0f);
+                __m128 const byte_scale = _mm_set1_ps(255.0f);
+                __m128 const table_scale = _mm_set1_ps(static_cast<float>(srgb_encode_table_size - 1));
+
+                int texel_count = m_width * m_height;
+                float const* src = m_level.data();
+                byte* dest = pixels;
+                for (int t = 0; t < texel_count; ++t) {
+                    __m128 texel = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src), zero), one);
+
+                    alignas(16) int linear_bytes[4];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(linear_bytes), _mm_cvtps_epi32(_mm_mul_ps(texel, byte_scale)));
+
+                    if (m_srgb) {
+                        alignas(16) int table_index[4];
+                        _mm_store_si128(reinterpret_cast<__m128i*>(table_index), _mm_cvtps_epi32(_mm_mul_ps(texel, table_scale)));
+                        for (int c = 0; c < m_bytes_per_texel; ++c) {
+                            dest[c] = ((c < 3) ? tables.encode[table_index[c]] : static_cast<byte>(linear_bytes[c]));
+                        }
+                    }
+                    else {
+                        for (int c = 0; c < m_bytes_per_texel; ++c) {
+                            dest[c] = static_cast<byte>(linear_bytes[c]);
+                        }
+                    }
+                    src += 4;
+                    dest += m_bytes_per_texel;
+                }
+            }
+
+            void mip_chain_builder::downsample_box(int dest_width, int dest_height)
+            {
+                m_scratch.resize(dest_width * dest_height * 4);
+                __m128 const quarter = _mm_set1_ps(0.25f);
+
+                float* dest = m_scratch.data();
+                for (int y = 0; y < dest_height; ++y) {
+                    // Odd sizes (and 1 texel wide or tall levels) reuse the last row or column.
+                    float const* row0 = m_level.data() + min(y * 2, m_height - 1) * m_width * 4;
+                    float const* row1 = m_level.data() + min(y * 2 + 1, m_height - 1) * m_width * 4;
+                    for (int x = 0; x < dest_width; ++x) {
+                        int x0 = min(x * 2, m_width - 1) * 4;
+                        int x1 = min(x * 2 + 1, m_width - 1) * 4;
+                        __m128 sum = _mm_add_ps(
+                            _mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)),
+                            _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1))
+                            );
+                        _mm_storeu_ps(dest, _mm_mul_ps(sum, quarter));
+                        dest += 4;
+                    }
+                }
+                m_level.swap(m_scratch);
+            }
+
+            // Kaiser windowed sinc for a 2:1 reduction; six taps at half texel offsets from
+            // the destination texel center.
+            static int const kaiser_tap_count = 6;
+
+            struct kaiser_weights {
+                kaiser_weights()
+                {
+                    float const alpha = 4.0f;
+                    float const radius = static_cast<float>(kaiser_tap_count) / 2.0f;
+                    float sum = 0.0f;
+                    for (int i = 0; i < kaiser_tap_count; ++i) {
+                        float d = static_cast<float>(i) - radius + 0.5f;
+                        float x = d / 2.0f;
+                        float sinc = (x == 0.0f) ? 1.0f : (std::sin(glm::pi<float>() * x) / (glm::pi<float>() * x));
+                        float t = d / radius;
+                        float window = bessel_i0(alpha * std::sqrt(max(1.0f - t * t, 0.0f))) / bessel_i0(alpha);
+                        w[i] = sinc * window;
+                        sum += w[i];
+                    }
+                    for (int i = 0; i < kaiser_tap_count; ++i) {
+                        w[i] /= sum;
+                    }
+                }
+
+                static float bessel_i0(float x)
+                {
+                    // Power series; converges quickly for the small arguments used here.
+                    float sum = 1.0f;
+                    float term = 1.0f;
+                    float half_x_squared = (x * x) / 4.0f;
+                    for (int k = 1; k < 16; ++k) {
+                        term *= half_x_squared / static_cast<float>(k * k);
+                        sum += term;
+                    }
+                    return (sum);
+                }
+
+                float w[kaiser_tap_count];
+            };
+
+            static kaiser_weights const& get_kaiser_weights()
+            {
+                static kaiser_weights const weights;
+                return (weights);
+            }
+
+            void mip_chain_builder::downsample_kaiser(int dest_width, int dest_height)
+            {
+                kaiser_weights const& weights = get_kaiser_weights();
+                __m128 tap_weights[kaiser_tap_count];
+                for (int i = 0; i < kaiser_tap_count; ++i) {
+                    tap_weights[i] = _mm_set1_ps(weights.w[i]);
+                }
+                int const first_tap = -(kaiser_tap_count / 2) + 1;
+
+                // Horizontal pass into scratch; a one texel wide level is copied through.
+                if (dest_width != m_width) {
+                    m_scratch.resize(dest_width * m_height * 4);
+                    float* dest = m_scratch.data();
+                    for (int y = 0; y < m_height; ++y) {
+                        float const* row = m_level.data() + y * m_width * 4;
+                        for (int x = 0; x < dest_width; ++x) {
+                            __m128 sum = _mm_setzero_ps();
+                            for (int i = 0; i < kaiser_tap_count; ++i) {
+                                int sx = min(max(x * 2 + first_tap + i, 0), m_width - 1);
+                                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(row + sx * 4), tap_weights[i]));
+                            }
+                            _mm_storeu_ps(dest, sum);
+                            dest += 4;
+                        }
+                    }
+                }
+                else {
+                    m_scratch = m_level;
+                }
+
+                // Vertical pass back in to the level.
+                if (dest_height != m_height) {
+                    m_level.resize(dest_width * dest_height * 4);
+                    float* dest = m_level.data();
+                    for (int y = 0; y < dest_height; ++y) {
+                        for (int x = 0; x < dest_width; ++x) {
+                            __m128 sum = _mm_setzero_ps();
+                            for (int i = 0; i < kaiser_tap_count; ++i) {
+                                int sy = min(max(y * 2 + first_tap + i, 0), m_height - 1);
+                                float const* src = m_scratch.data() + (sy * dest_width + x) * 4;
+                                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src), tap_weights[i]));
+                            }
+                            _mm_storeu_ps(dest, sum);
+                            dest += 4;
+                        }
+                    }
+                }
+                else {
+                    m_level.swap(m_scratch);
+                }
+            }
+
+            graphics::texture_color_format get_compressed_format(
+                graphics::texture_color_format format,
+                block_compression compression
+                )
+            {
+                bool srgb = is_srgb(format);
+                switch (compression) {
+                case block_compression_bc1:
+                    return (srgb ? graphics::texture_color_format_dxt1_srgb : graphics::texture_color_format_dxt1);
+
+                case block_compression_bc3:
+                    return (srgb ? graphics::texture_color_format_dxt5_srgb : graphics::texture_color_format_dxt5);
+
+                case block_compression_bc7:
+                    return (srgb ? graphics::texture_color_format_bptc_srgb : graphics::texture_color_format_bptc);
+
+                default:
+                    return (format);
+                }
+            }
+
+            int get_compressed_sizeof(int width, int height, block_compression compression)
+            {
+                int block_count = ((width + 3) / 4) * ((height + 3) / 4);
+                return (block_count * ((compression == block_compression_bc1) ? 8 : 16));
+            }
+
+            // Block encoders work on 16 RGBA texels in row order.
+            static int const block_texels = 16;
+
+            static void fetch_block(
+                byte const* pixels,
+                int width,
+                int height,
+                int bytes_per_texel,
+                int block_x,
+                int block_y,
+                byte* rgba
+                )
+            {
+                for (int y = 0; y < 4; ++y) {
+                    int sy = min(block_y * 4 + y, height - 1);
+                    for (int x = 0; x < 4; ++x) {
+                        int sx = min(block_x * 4 + x, width - 1);
+                        byte const* texel = pixels + (sy * width + sx) * bytes_per_texel;
+                        rgba[0] = texel[0];
+                        rgba[1] = texel[1];
+                        rgba[2] = texel[2];
+                        rgba[3] = ((bytes_per_texel == 4) ? texel[3] : 255);
+                        rgba += 4;
+                    }
+                }
+            }
+
+            // Pick the bounding box diagonal the texels lie along, relative to green, for
+            // each of the channels given.
+            static void fit_bounding_box(byte const* rgba, int channel_count, int* low, int* high)
+            {
+                int mean[4] = {};
+                for (int c = 0; c < channel_count; ++c) {
+                    low[c] = 255;
+                    high[c] = 0;
+                }
+                for (int t = 0; t < block_texels; ++t) {
+                    for (int c = 0; c < channel_count; ++c) {
+                        int v = rgba[t * 4 + c];
+                        low[c] = min(low[c], v);
+                        high[c] = max(high[c], v);
+                        mean[c] += v;
+                    }
+                }
+
+                int covariance[4] = {};
+                for (int t = 0; t < block_texels; ++t) {
+                    int green = rgba[t * 4 + 1] * block_texels - mean[1];
+                    for (int c = 0; c < channel_count; ++c) {
+                        covariance[c] += (rgba[t * 4 + c] * block_texels - mean[c]) * green;
+                    }
+                }
+                for (int c = 0; c < channel_count; ++c) {
+                    if (c != 1 && covariance[c] < 0) {
+                        std::swap(low[c], high[c]);
+                    }
+                }
+            }
+
+            static int color_distance(byte const* a, int const* b, int channel_count)
+            {
+                int distance = 0;
+                for (int c = 0; c < channel_count; ++c) {
+                    int d = a[c] - b[c];
+                    distance += d * d;
+                }
+                return (distance);
+            }
+
+            static void write_le16(byte* dest, unsigned int value)
+            {
+                dest[0] = static_cast<byte>(value & 0xFF);
+                dest[1] = static_cast<byte>((value >> 8) & 0xFF);
+            }
+
+            static unsigned int pack_565(int const* color)
+            {
+                return (((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+            }
+
+            static void unpack_565(unsigned int packed, int* color)
+            {
+                int r = (packed >> 11) & 0x1F;
+                int g = (packed >> 5) & 0x3F;
+                int b = packed & 0x1F;
+                color[0] = (r << 3) | (r >> 2);
+                color[1] = (g << 2) | (g >> 4);
+                color[2] = (b << 3) | (b >> 2);
+            }
+
+            static void encode_bc1_color(byte const* rgba, byte* block)
+            {
+                int high[3];
+                int low[3];
+                fit_bounding_box(rgba, 3, low, high);
+
+                // Inset the box a little; the extremes are usually outliers.
+                for (int c = 0; c < 3; ++c) {
+                    int inset = (high[c] - low[c]) / 16;
+                    high[c] -= inset;
+                    low[c] += inset;
+                }
+
+                unsigned int c0 = pack_565(high);
+                unsigned int c1 = pack_565(low);
+                if (c0 < c1) {
+                    std::swap(c0, c1);
+                }
+                write_le16(block, c0);
+                write_le16(block + 2, c1);
+
+                unsigned int indices = 0;
+                if (c0 != c1) {
+                    // Four color mode requires c0 > c1.
+                    int palette[4][3];
+                    unpack_565(c0, palette[0]);
+                    unpack_565(c1, palette[1]);
+                    for (int c = 0; c < 3; ++c) {
+                        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                    }
+
+                    for (int t = 0; t < block_texels; ++t) {
+                        int best_index = 0;
+                        int best_distance = color_distance(rgba + t * 4, palette[0], 3);
+                        for (int p = 1; p < 4; ++p) {
+                            int distance = color_distance(rgba + t * 4, palette[p], 3);
+                            if (distance < best_distance) {
+                                best_distance = distance;
+                                best_index = p;
+                            }
+                        }
+                        indices |= static_cast<unsigned int>(best_index) << (t * 2);
+                    }
+                }
+                write_le16(block + 4, indices & 0xFFFF);
+                write_le16(block + 6, indices >> 16);
+            }
+
+            static void encode_bc3_alpha(byte const* rgba, byte* block)
+            {
+                // No inset; exact 0 and 255 matter for cut outs.
+                int a0 = 0;
+                int a1 = 255;
+                for (int t = 0; t < block_texels; ++t) {
+                    a0 = max(a0, static_cast<int>(rgba[t * 4 + 3]));
+                    a1 = min(a1, static_cast<int>(rgba[t * 4 + 3]));
+                }
+                block[0] = static_cast<byte>(a0);
+                block[1] = static_cast<byte>(a1);
+
+                unsigned long long indices = 0;
+                if (a0 != a1) {
+                    // Eight alpha mode, since a0 > a1.
+                    int palette[8];
+                    palette[0] = a0;
+                    palette[1] = a1;
+                    for (int p = 1; p < 7; ++p) {
+                        palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+                    }
+
+                    for (int t = 0; t < block_texels; ++t) {
+                        int alpha = rgba[t * 4 + 3];
+                        int best_index = 0;
+                        int best_distance = std::abs(alpha - palette[0]);
+                        for (int p = 1; p < 8; ++p) {
+                            int distance = std::abs(alpha - palette[p]);
+                            if (distance < best_distance) {
+                                best_distance = distance;
+                                best_index = p;
+                            }
+                        }
+                        indices |= static_cast<unsigned long long>(best_index) << (t * 3);
+                    }
+                }
+                for (int b = 0; b < 6; ++b) {
+                    block[2 + b] = static_cast<byte>((indices >> (b * 8)) & 0xFF);
+                }
+            }
+
+            // BC7 is encoded in mode 6 only: one subset, RGBA endpoints with 7 bits per
+            // channel plus a p-bit each, and 4 bit indices. Not the best BC7 can do, but
+            // never worse than BC3 and simple enough to run at import time.
+            class bc7_bit_writer {
+            public:
+                explicit bc7_bit_writer(byte* block)
+                    : m_block(block)
+                    , m_bit(0)
+                {
+                    memset(m_block, 0, 16);
+                }
+
+                void write(unsigned int value, int bit_count)
+                {
+                    for (int b = 0; b < bit_count; ++b) {
+                        if (value & (1U << b)) {
+                            m_block[m_bit >> 3] |= static_cast<byte>(1U << (m_bit & 7));
+                        }
+                        ++m_bit;
+                    }
+                }
+
+            private:
+                byte* m_block;
+                int m_bit;
+            };
+
+            static void quantize_bc7_mode6_endpoint(int const* color, int* quantized, int* p_bit)
+            {
+                // Try both p-bits; keep whichever lands closer across all four channels.
+                int best_error = INT_MAX;
+                for (int p = 0; p < 2; ++p) {
+                    int error = 0;
+                    int q[4];
+                    for (int c = 0; c < 4; ++c) {
+                        q[c] = min(max((color[c] - p + 1) / 2, 0), 127);
+                        int d = ((q[c] << 1) | p) - color[c];
+                        error += d * d;
+                    }
+                    if (error < best_error) {
+                        best_error = error;
+                        *p_bit = p;
+                        for (int c = 0; c < 4; ++c) {
+                            quantized[c] = q[c];
+                        }
+                    }
+                }
+            }
+
+            static void encode_bc7(byte const* rgba, byte* block)
+            {
+                static int const weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+                int high[4];
+                int low[4];
+                fit_bounding_box(rgba, 4, low, high);
+
+                int q0[4];
+                int q1[4];
+                int p0 = 0;
+                int p1 = 0;
+                quantize_bc7_mode6_endpoint(low, q0, &p0);
+                quantize_bc7_mode6_endpoint(high, q1, &p1);
+
+                int e0[4];
+                int e1[4];
+                int palette[16][4];
+                for (int c = 0; c < 4; ++c) {
+                    e0[c] = (q0[c] << 1) | p0;
+                    e1[c] = (q1[c] << 1) | p1;
+                }
+                for (int i = 0; i < 16; ++i) {
+                    for (int c = 0; c < 4; ++c) {
+                        palette[i][c] = ((64 - weights[i]) * e0[c] + weights[i] * e1[c] + 32) >> 6;
+                    }
+                }
+
+                int indices[block_texels];
+                for (int t = 0; t < block_texels; ++t) {
+                    int best_index = 0;
+                    int best_distance = color_distance(rgba + t * 4, palette[0], 4);
+                    for (int i = 1; i < 16; ++i) {
+                        int distance = color_distance(rgba + t * 4, palette[i], 4);
+                        if (distance < best_distance) {
+                            best_distance = distance;
+                            best_index = i;
+                        }
+                    }
+                    indices[t] = best_index;
+                }
+
+                // The first index is stored without its top bit, which must be zero; swap
+                // the endpoints if it isn't.
+                if (indices[0] & 0x8) {
+                    for (int c = 0; c < 4; ++c) {
+                        std::swap(q0[c], q1[c]);
+                    }
+                    std::swap(p0, p1);
+                    for (int t = 0; t < block_texels; ++t) {
+                        indices[t] = 15 - indices[t];
+                    }
+                }
+
+                bc7_bit_writer writer(block);
+                writer.write(1 << 6, 7);
+                for (int c = 0; c < 4; ++c) {
+                    writer.write(q0[c], 7);
+                    writer.write(q1[c], 7);
+                }
+                writer.write(p0, 1);
+                writer.write(p1, 1);
+                writer.write(indices[0], 3);
+                for (int t = 1; t < block_texels; ++t) {
+                    writer.write(indices[t], 4);
+                }
+            }
+
+            void compress_image(
+                byte const* pixels,
+                int width,
+                int height,
+                int bytes_per_texel,
+                block_compression compression,
+                byte* blocks
+                )
+            {
+                ELECTROSLAG_CHECK(bytes_per_texel == 3 || bytes_per_texel == 4);
+                ELECTROSLAG_CHECK(compression > block_compression_none && compression < block_compression_count);
+
+                int blocks_wide = (width + 3) / 4;
+                int blocks_high = (height + 3) / 4;
+                byte rgba[block_texels * 4];
+
+                for (int block_y = 0; block_y < blocks_high; ++block_y) {
+                    for (int block_x = 0; block_x < blocks_wide; ++block_x) {
+                        fetch_block(pixels, width, height, bytes_per_texel, block_x, block_y, rgba);
+
+                        switch (compression) {
+                        case block_compression_bc1:
+                            encode_bc1_color(rgba, blocks);
+                            blocks += 8;
+                            break;
+
+                        case block_compression_bc3:
+                            encode_bc3_alpha(rgba, blocks);
+                            encode_bc1_color(rgba, blocks + 8);
+                            blocks += 16;
+                            break;
+
+                        case block_compression_bc7:
+                            encode_bc7(rgba, blocks);
+                            blocks += 16;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
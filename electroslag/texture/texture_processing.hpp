@@ -0,0 +1,130 @@
+//  Electroslag Interactive Graphics System
+//  Copyright 2018 Joshua Buckman
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#pragma once
+
+#if defined(ELECTROSLAG_BUILD_SHIP)
+#error texture processing not to be included in SHIP build!
+#endif
+
+#include "electroslag/graphics/graphics_types.hpp"
+
+namespace electroslag {
+    namespace texture {
+        // CPU side texture work done while importing, so textures arrive ready to upload.
+        enum mip_filter {
+            mip_filter_unknown = -1,
+            mip_filter_box,
+            mip_filter_kaiser,
+            mip_filter_count // Ensure this is the last enum entry
+        };
+
+        enum block_compression {
+            block_compression_unknown = -1,
+            block_compression_none,
+            block_compression_bc1,
+            block_compression_bc3,
+            block_compression_bc7,
+            block_compression_count // Ensure this is the last enum entry
+        };
+
+        static char const* const block_compression_strings[block_compression_count] = {
+            "block_compression_none",
+            "block_compression_bc1",
+            "block_compression_bc3",
+            "block_compression_bc7"
+        };
+
+        namespace texture_processing {
+            // Texel size of the uncompressed formats processing understands, or zero.
+            int get_bytes_per_texel(graphics::texture_color_format format);
+
+            bool is_srgb(graphics::texture_color_format format);
+
+            // Swap the red and blue channels in place; for BGR(A) source images.
+            void swizzle_red_blue(byte* pixels, int texel_count, int bytes_per_texel);
+
+            // Images are tightly packed rows of texels in one of the formats above.
+            class mip_chain_builder {
+            public:
+                mip_chain_builder(
+                    byte const* level0_pixels,
+                    int width,
+                    int height,
+                    graphics::texture_color_format format,
+                    mip_filter filter
+                    );
+
+                int get_width() const
+                {
+                    return (m_width);
+                }
+
+                int get_height() const
+                {
+                    return (m_height);
+                }
+
+                bool has_next_level() const
+                {
+                    return (m_width > 1 || m_height > 1);
+                }
+
+                // Filter the current level down to the next one and write it out, which must
+                // have room for get_width() * get_height() texels afterwards.
+                void next_level(byte* pixels);
+
+            private:
+                void downsample_box(int dest_width, int dest_height);
+                void downsample_kaiser(int dest_width, int dest_height);
+
+                // The current level, four linear floats per texel; kept between levels so
+                // quantizing errors don't accumulate down the chain.
+                std::vector<float> m_level;
+                std::vector<float> m_scratch;
+
+                int m_width;
+                int m_height;
+                int m_bytes_per_texel;
+                bool m_srgb;
+                mip_filter m_filter;
+
+                // Disallowed operations:
+                mip_chain_builder();
+                explicit mip_chain_builder(mip_chain_builder const&);
+                mip_chain_builder& operator =(mip_chain_builder const&);
+            };
+
+            // The format a compressed image ends up in, given the uncompressed source format.
+            graphics::texture_color_format get_compressed_format(
+                graphics::texture_color_format format,
+                block_compression compression
+                );
+
+            int get_compressed_sizeof(int width, int height, block_compression compression);
+
+            // Compress an image with 3 or 4 bytes per texel into 4x4 blocks. Partial blocks
+            // at the right and bottom edges repeat the last texel.
+            void compress_image(
+                byte const* pixels,
+                int width,
+                int height,
+                int bytes_per_texel,
+                block_compression compression,
+                byte* blocks
+                );
+        }
+    }
+}
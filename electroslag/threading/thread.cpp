@@ -14,6 +14,7 @@
 //  limitations under the License.
 
 #include "electroslag/precomp.hpp"
+#include "electroslag/systems.hpp"
 #include "electroslag/threading/thread.hpp"
 
 namespace electroslag {
@@ -136,6 +137,13 @@ namespace electroslag {
             std::unique_ptr<entry_point_wrapper_param> param(reinterpret_cast<entry_point_wrapper_param*>(argument));
             this_thread::set(param->this_thread);
             param->entry_point(param->argument);
+
+            // Don't create a logger just to tell it this thread had nothing to say.
+            systems* sys = get_systems();
+            if (sys->has_logger()) {
+                sys->get_logger()->on_thread_exit();
+            }
+
             this_thread::cleanup_on_exit();
             return (0);
         }
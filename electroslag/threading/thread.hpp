@@ -60,7 +60,12 @@ namespace electroslag {
 
             std::string get_thread_name() const
             {
-                return (get_name());
+                return (get_name().str());
+            }
+
+            unsigned long long get_thread_name_hash() const
+            {
+                return (get_hash());
             }
 
         private:
@@ -28,6 +28,11 @@ namespace electroslag {
             return (get_systems()->get_io_thread_pool());
         }
 
+        thread_pool* get_decode_thread_pool()
+        {
+            return (get_systems()->get_decode_thread_pool());
+        }
+
         thread_pool::thread_pool(std::string const& base_name, int total_threads)
             : m_next_worker(0)
         {
@@ -58,5 +58,9 @@ namespace electroslag {
 
         thread_pool* get_frame_thread_pool();
         thread_pool* get_io_thread_pool();
+
+        // CPU bound work for loaders, such as converting asset data, kept off the
+        // frame pool so it can't delay frames. Its items must not wait on other items.
+        thread_pool* get_decode_thread_pool();
     }
 }
@@ -22,6 +22,9 @@ namespace electroslag {
             // Milliseconds since context initialize.
             // Don't use for real time; will wrap every 49 days.
             virtual unsigned int read_milliseconds() const = 0;
+
+            // Monotonic nanoseconds since context initialize; use this for frame deltas.
+            virtual long long read_nanoseconds() const = 0;
         };
     }
 }
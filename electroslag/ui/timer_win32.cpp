@@ -18,6 +18,22 @@
 
 namespace electroslag {
     namespace ui {
+        timer_win32::timer_win32()
+            : m_first_counter(0)
+            , m_counter_frequency(0)
+            , m_high_precision(false)
+        {
+            LARGE_INTEGER frequency;
+            if (!QueryPerformanceFrequency(&frequency)) {
+                throw win32_api_failure("QueryPerformanceFrequency");
+            }
+            m_counter_frequency = frequency.QuadPart;
+
+            LARGE_INTEGER counter;
+            QueryPerformanceCounter(&counter);
+            m_first_counter = counter.QuadPart;
+        }
+
         void timer_win32::initialize(window_win32* window)
         {
             ELECTROSLAG_CHECK(!m_high_precision);
@@ -39,8 +55,21 @@ namespace electroslag {
 
         unsigned int timer_win32::read_milliseconds() const
         {
-            ELECTROSLAG_CHECK(m_first_reading > 0);
-            return (timeGetTime() - m_first_reading);
+            return (static_cast<unsigned int>(read_nanoseconds() / 1000000));
+        }
+
+        long long timer_win32::read_nanoseconds() const
+        {
+            ELECTROSLAG_CHECK(m_counter_frequency > 0);
+
+            LARGE_INTEGER counter;
+            QueryPerformanceCounter(&counter);
+            long long elapsed = counter.QuadPart - m_first_counter;
+
+            // Split the conversion to avoid overflowing 64 bits.
+            long long seconds = elapsed / m_counter_frequency;
+            long long remainder = elapsed % m_counter_frequency;
+            return ((seconds * 1000000000LL) + ((remainder * 1000000000LL) / m_counter_frequency));
         }
 
         void timer_win32::on_window_state_changed(window_state new_state)
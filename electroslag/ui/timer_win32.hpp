@@ -21,10 +21,7 @@ namespace electroslag {
     namespace ui {
         class timer_win32 : public timer_interface {
         public:
-            timer_win32()
-                : m_first_reading(timeGetTime())
-                , m_high_precision(false)
-            {}
+            timer_win32();
             virtual ~timer_win32()
             {
                 shutdown();
@@ -35,11 +32,13 @@ namespace electroslag {
 
             // Implement timer_interface
             virtual unsigned int read_milliseconds() const;
+            virtual long long read_nanoseconds() const;
 
         private:
             void on_window_state_changed(window_state new_state);
 
-            unsigned int m_first_reading;
+            long long m_first_counter;
+            long long m_counter_frequency;
             bool m_high_precision;
 
             // Disallowed operations:
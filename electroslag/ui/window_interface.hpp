@@ -93,6 +93,9 @@ namespace electroslag {
             virtual void set_dimensions(window_dimensions const* new_dimensions) = 0;
             virtual void set_paused(bool new_paused) = 0;
 
+            // Asks the window to close as if the user had; safe from any thread.
+            virtual void close() = 0;
+
             // TODO: Thread safety for these events?
             typedef event<void> destroyed_event;
             typedef destroyed_event::bound_delegate destroyed_delegate;
@@ -115,7 +118,8 @@ namespace electroslag {
             typedef paused_changed_event::bound_delegate paused_changed_delegate;
             mutable paused_changed_event paused_changed;
 
-            typedef event<void, int> frame_event;
+            // Milliseconds elapsed since the previous frame, at nanosecond resolution.
+            typedef event<void, double> frame_event;
             typedef frame_event::bound_delegate frame_delegate;
             mutable frame_event frame;
         };
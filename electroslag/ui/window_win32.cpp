@@ -237,8 +237,8 @@ namespace electroslag {
             timer_interface* timer = ui::get_ui()->get_timer();
             MSG msg = { 0 };
 
-            unsigned int frame_time = 0;
-            unsigned int prev_frame_time = timer->read_milliseconds();
+            long long frame_time = 0;
+            long long prev_frame_time = timer->read_nanoseconds();
 
             int sleep_time = 0;
 
@@ -251,8 +251,8 @@ namespace electroslag {
             while (run_loop && !paused) {
                 {
                     if (do_frame) {
-                        frame_time = timer->read_milliseconds();
-                        handle_frame(frame_time - prev_frame_time);
+                        frame_time = timer->read_nanoseconds();
+                        handle_frame(static_cast<double>(frame_time - prev_frame_time) / 1000000.0);
                         prev_frame_time = frame_time;
 
                         do_frame = false;
@@ -281,7 +281,7 @@ namespace electroslag {
                 do_sleep = (run_loop && !paused);
                 if (do_sleep) {
                     // Figure out how much time to sleep off, if any
-                    sleep_time = total_frame_time - static_cast<int>(timer->read_milliseconds() - frame_time);
+                    sleep_time = total_frame_time - static_cast<int>((timer->read_nanoseconds() - frame_time) / 1000000);
                     if (sleep_time <= pad_frame_time) {
                         do_sleep = false;
                         do_frame = true;
@@ -459,6 +459,16 @@ namespace electroslag {
             }
         }
 
+        void window_win32::close()
+        {
+            threading::lock_guard window_lock(&m_mutex);
+            ELECTROSLAG_CHECK(m_hwnd);
+
+            if (!PostMessage(m_hwnd, WM_CLOSE, 0, 0)) {
+                throw win32_api_failure("PostMessage");
+            }
+        }
+
         void window_win32::set_internal_paused(
             bool new_internal_paused
             )
@@ -708,7 +718,7 @@ namespace electroslag {
 
             // While we are paused, we need to draw the frames here.
             if (get_overall_paused()) {
-                handle_frame(0); // Time does not elapse while paused, hence 0
+                handle_frame(0.0); // Time does not elapse while paused, hence 0
             }
 
             return (0);
@@ -769,7 +779,7 @@ namespace electroslag {
         }
 
         void window_win32::handle_frame(
-            int milliseconds_elapsed
+            double milliseconds_elapsed
             )
         {
             frame.signal(milliseconds_elapsed);
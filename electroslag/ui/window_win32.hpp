@@ -40,6 +40,8 @@ namespace electroslag {
             virtual void set_dimensions(window_dimensions const* new_dimensions);
             virtual void set_paused(bool new_paused);
 
+            virtual void close();
+
             // Windows specific
             HWND get_hwnd() const;
             bool get_internal_paused() const;
@@ -117,7 +119,7 @@ namespace electroslag {
             void handle_resize(int new_width, int new_height);
             void handle_reposition(int new_x, int new_y);
             void handle_paused(bool new_paused, bool new_internal_paused);
-            void handle_frame(int milliseconds_elapsed);
+            void handle_frame(double milliseconds_elapsed);
 
             mutable threading::mutex m_mutex;
 
@@ -185,6 +185,21 @@ namespace electroslag {
         return (hash_string_runtime(s.c_str()));
     }
 
+    // Hash an arbitrary block of bytes; pass a previous result as the seed to chain.
+    inline unsigned long long hash_bytes_runtime(
+        void const* bytes,
+        std::size_t size,
+        unsigned long long hash = fnv1a::basis
+        )
+    {
+        unsigned char const* b = static_cast<unsigned char const*>(bytes);
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= b[i];
+            hash *= fnv1a::prime;
+        }
+        return (hash);
+    }
+
     // Helpers for running under a debugger.
     bool being_debugged();
 }